@@ -0,0 +1,174 @@
+// Throughput of the hardware and soft-float backends, through both the scalar
+// and batched exports, for the basic operations on floats and doubles and the
+// elementary functions, and of the batched basic operations for each instruction
+// set variant, of the conversions between floats and integers in each rounding
+// mode, and of the parallel reductions on one thread and on every core.
+mod common;
+
+use common::{bench, normal_inputs, normal_inputs64, small_inputs, Rng};
+use std::hint::black_box;
+use unity_rust::arith::{dfloat_set_backend, BACKEND_HARDWARE, BACKEND_SOFT};
+use unity_rust::convert::*;
+use unity_rust::ddouble::*;
+use unity_rust::dispatch::{dfloat_set_dispatch_variant, VARIANTS};
+use unity_rust::dmath::*;
+use unity_rust::reduce::{float_dot, float_sum, thread_count};
+use unity_rust::*;
+
+const LEN: usize = 4096;
+const REDUCE_LEN: usize = 1 << 22;
+
+type Scalar = unsafe extern "C" fn(u32, u32) -> u32;
+type Batch = unsafe extern "C" fn(*const u32, *const u32, *mut u32, usize);
+type UnaryBatch = unsafe extern "C" fn(*const u32, *mut u32, usize);
+type Scalar64 = unsafe extern "C" fn(u64, u64) -> u64;
+type Batch64 = unsafe extern "C" fn(*const u64, *const u64, *mut u64, usize);
+
+fn main() {
+	let mut rng = Rng(0x9e37_79b9_7f4a_7c15);
+	let a = normal_inputs(&mut rng, LEN);
+	let b = normal_inputs(&mut rng, LEN);
+	let small = small_inputs(&mut rng, LEN);
+	let positive: Vec<u32> = small.iter().map(|x| x & 0x7fff_ffff).collect();
+	let a64 = normal_inputs64(&mut rng, LEN);
+	let b64 = normal_inputs64(&mut rng, LEN);
+	let mut out = vec![0u32; LEN];
+	let mut out64 = vec![0u64; LEN];
+	let int_inputs: Vec<i32> = a.iter().map(|&x| x as i32).collect();
+	let long_inputs: Vec<i64> = a64.iter().map(|&x| x as i64).collect();
+	let mut ints = vec![0i32; LEN];
+	let mut longs = vec![0i64; LEN];
+
+	let ops: [(&str, Scalar, Batch); 4] = [
+		("add", float_add, batch::float_add_batch),
+		("sub", float_sub, batch::float_sub_batch),
+		("mul", float_mul, batch::float_mul_batch),
+		("div", float_div, batch::float_div_batch),
+	];
+
+	let ops64: [(&str, Scalar64, Batch64); 4] = [
+		("add", double_add, double_add_batch),
+		("sub", double_sub, double_sub_batch),
+		("mul", double_mul, double_mul_batch),
+		("div", double_div, double_div_batch),
+	];
+
+	let functions: [(&str, UnaryBatch, &Vec<u32>); 5] = [
+		("sqrt", float_sqrt_batch, &positive),
+		("sin", float_sin_batch, &small),
+		("cos", float_cos_batch, &small),
+		("exp", float_exp_batch, &small),
+		("log", float_log_batch, &positive),
+	];
+
+	for &(backend, backend_name) in &[(BACKEND_HARDWARE, "hardware"), (BACKEND_SOFT, "soft")] {
+		dfloat_set_backend(backend);
+
+		for &(name, scalar, batched) in &ops {
+			bench(&format!("{} {} scalar", backend_name, name), LEN, || {
+				for i in 0..LEN {
+					out[i] = unsafe { scalar(black_box(a[i]), black_box(b[i])) };
+				}
+				black_box(&out);
+			});
+
+			bench(&format!("{} {} batch", backend_name, name), LEN, || {
+				unsafe { batched(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN) };
+				black_box(&out);
+			});
+		}
+
+		for &(name, scalar, batched) in &ops64 {
+			bench(&format!("{} {} double scalar", backend_name, name), LEN, || {
+				for i in 0..LEN {
+					out64[i] = unsafe { scalar(black_box(a64[i]), black_box(b64[i])) };
+				}
+				black_box(&out64);
+			});
+
+			bench(&format!("{} {} double batch", backend_name, name), LEN, || {
+				unsafe { batched(a64.as_ptr(), b64.as_ptr(), out64.as_mut_ptr(), LEN) };
+				black_box(&out64);
+			});
+		}
+
+		for &(name, batched, x) in &functions {
+			bench(&format!("{} {} batch", backend_name, name), LEN, || {
+				unsafe { batched(x.as_ptr(), out.as_mut_ptr(), LEN) };
+				black_box(&out);
+			});
+		}
+
+		bench(&format!("{} atan2 batch", backend_name), LEN, || {
+			unsafe { float_atan2_batch(small.as_ptr(), a.as_ptr(), out.as_mut_ptr(), LEN) };
+			black_box(&out);
+		});
+
+		for &(mode, mode_name) in &[(ROUND_TRUNCATE, "truncate"), (ROUND_HALF_EVEN, "half even"), (ROUND_FLOOR, "floor")] {
+			bench(&format!("{} to i32 {} scalar", backend_name, mode_name), LEN, || {
+				for i in 0..LEN {
+					ints[i] = float_to_i32(black_box(small[i]), mode);
+				}
+				black_box(&ints);
+			});
+
+			bench(&format!("{} to i32 {} batch", backend_name, mode_name), LEN, || {
+				unsafe { float_to_i32_batch(small.as_ptr(), ints.as_mut_ptr(), LEN, mode) };
+				black_box(&ints);
+			});
+
+			bench(&format!("{} to i64 {} batch", backend_name, mode_name), LEN, || {
+				unsafe { float_to_i64_batch(small.as_ptr(), longs.as_mut_ptr(), LEN, mode) };
+				black_box(&longs);
+			});
+
+			bench(&format!("{} from i32 {} batch", backend_name, mode_name), LEN, || {
+				unsafe { float_from_i32_batch(int_inputs.as_ptr(), out.as_mut_ptr(), LEN, mode) };
+				black_box(&out);
+			});
+
+			bench(&format!("{} from i64 {} batch", backend_name, mode_name), LEN, || {
+				unsafe { float_from_i64_batch(long_inputs.as_ptr(), out.as_mut_ptr(), LEN, mode) };
+				black_box(&out);
+			});
+		}
+	}
+
+	let selected = dfloat_set_dispatch_variant(0);
+
+	for variant in VARIANTS.iter().filter(|v| (v.detect)()) {
+		dfloat_set_dispatch_variant(variant.id);
+
+		for &(backend, backend_name) in &[(BACKEND_HARDWARE, "hardware"), (BACKEND_SOFT, "soft")] {
+			dfloat_set_backend(backend);
+
+			for &(name, _, batched) in &ops {
+				bench(&format!("variant {} {} {} batch", variant.id, backend_name, name), LEN, || {
+					unsafe { batched(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN) };
+					black_box(&out);
+				});
+			}
+		}
+	}
+
+	dfloat_set_dispatch_variant(selected);
+
+	let x = normal_inputs(&mut rng, REDUCE_LEN);
+	let y = normal_inputs(&mut rng, REDUCE_LEN);
+
+	for &(backend, backend_name) in &[(BACKEND_HARDWARE, "hardware"), (BACKEND_SOFT, "soft")] {
+		dfloat_set_backend(backend);
+
+		for &threads in &[1, thread_count(0)] {
+			bench(&format!("{} sum {} threads", backend_name, threads), REDUCE_LEN, || {
+				black_box(unsafe { float_sum(x.as_ptr(), REDUCE_LEN, threads) });
+			});
+
+			bench(&format!("{} dot {} threads", backend_name, threads), REDUCE_LEN, || {
+				black_box(unsafe { float_dot(x.as_ptr(), y.as_ptr(), REDUCE_LEN, threads) });
+			});
+		}
+	}
+
+	dfloat_set_backend(BACKEND_HARDWARE);
+}
@@ -0,0 +1,65 @@
+#![allow(dead_code)]
+
+use std::time::{Duration, Instant};
+
+// Minimum wall time to spend measuring each benchmark.
+const TARGET: Duration = Duration::from_millis(500);
+
+// Runs f repeatedly for about TARGET and prints the mean time per operation,
+// where each call of f performs ops operations.
+pub fn bench<F: FnMut()>(name: &str, ops: usize, mut f: F) {
+	f();
+
+	let mut iterations = 0u64;
+	let start = Instant::now();
+
+	while start.elapsed() < TARGET {
+		f();
+		iterations += 1;
+	}
+
+	let elapsed = start.elapsed();
+	let ns_per_op = elapsed.as_nanos() as f64 / (iterations as f64 * ops as f64);
+
+	println!("{:<40} {:>10.3} ns/op {:>10.1} Mops/s", name, ns_per_op, 1000.0 / ns_per_op);
+}
+
+// xorshift64, so inputs are identical on every run and platform.
+pub struct Rng(pub u64);
+
+impl Rng {
+	pub fn next(&mut self) -> u64 {
+		self.0 ^= self.0 << 13;
+		self.0 ^= self.0 >> 7;
+		self.0 ^= self.0 << 17;
+		return self.0;
+	}
+
+	pub fn next_u32(&mut self) -> u32 {
+		return (self.next() >> 32) as u32;
+	}
+}
+
+// Random finite floats with magnitudes between roughly 2^-32 and 2^32.
+pub fn normal_inputs(rng: &mut Rng, len: usize) -> Vec<u32> {
+	return (0..len).map(|_| {
+		let bits = rng.next_u32();
+		(bits & 0x807f_ffff) | ((0x5f + (bits >> 23) % 0x40) << 23)
+	}).collect();
+}
+
+// Random finite floats in (-16, 16), the useful range of the elementary functions.
+pub fn small_inputs(rng: &mut Rng, len: usize) -> Vec<u32> {
+	return (0..len).map(|_| {
+		let bits = rng.next_u32();
+		(bits & 0x807f_ffff) | ((0x70 + (bits >> 23) % 0x13) << 23)
+	}).collect();
+}
+
+// Random finite doubles with magnitudes between roughly 2^-32 and 2^32.
+pub fn normal_inputs64(rng: &mut Rng, len: usize) -> Vec<u64> {
+	return (0..len).map(|_| {
+		let bits = rng.next();
+		(bits & 0x800f_ffff_ffff_ffff) | ((0x3df + (bits >> 52) % 0x40) << 52)
+	}).collect();
+}
@@ -0,0 +1,199 @@
+// Runs the same workloads through hardware dfloat, soft-float dfloat and fixed
+// point, and reports throughput and the error of each against the same formulas in
+// f64. Inputs are kept to magnitudes between 1/16 and 64, which Q16.16 can hold
+// along with the products and quotients of any two of them.
+mod common;
+
+use common::{bench, Rng};
+use std::hint::black_box;
+use unity_rust::arith::{dfloat_set_backend, BACKEND_HARDWARE, BACKEND_SOFT};
+use unity_rust::batch::*;
+use unity_rust::dmath::float_sqrt_batch;
+use unity_rust::fixed::*;
+
+const LEN: usize = 4096;
+
+// Steps of the spring workload.
+const STEPS: usize = 64;
+
+type Binary<T> = unsafe extern "C" fn(*const T, *const T, *mut T, usize);
+type Unary<T> = unsafe extern "C" fn(*const T, *mut T, usize);
+
+struct Numbers<T> {
+	name: &'static str,
+	backend: u32,
+	add: Binary<T>,
+	sub: Binary<T>,
+	mul: Binary<T>,
+	div: Binary<T>,
+	sqrt: Unary<T>,
+	from: fn(f64) -> T,
+	to: fn(T) -> f64,
+}
+
+struct Workload {
+	name: &'static str,
+	// Evaluates the workload in f64 for element i.
+	reference: fn(&Inputs, usize) -> f64,
+}
+
+struct Inputs {
+	a: Vec<f64>,
+	b: Vec<f64>,
+	c: Vec<f64>,
+}
+
+const K: f64 = 4.0;
+const DT: f64 = 1.0 / 64.0;
+
+// Semi-implicit Euler on a unit mass spring: v -= p * k * dt, p += v * dt.
+fn spring(p: f64, v: f64) -> f64 {
+	let (mut p, mut v) = (p, v);
+
+	for _ in 0..STEPS {
+		v = v - p * K * DT;
+		p = p + v * DT;
+	}
+
+	return p;
+}
+
+const WORKLOADS: [Workload; 4] = [
+	Workload { name: "mul add", reference: |x, i| x.a[i] * x.b[i] + x.c[i] },
+	Workload { name: "div", reference: |x, i| x.a[i] / x.b[i] },
+	Workload { name: "sqrt", reference: |x, i| x.a[i].abs().sqrt() },
+	Workload { name: "spring", reference: |x, i| spring(x.a[i], x.b[i]) },
+];
+
+// Runs workload w on inputs already converted to T, leaving the results in out.
+unsafe fn run<T: Copy + Default>(n: &Numbers<T>, w: usize, a: &[T], b: &[T], c: &[T], abs_a: &[T], out: &mut [T], tmp: &mut [T]) {
+	match w {
+		0 => {
+			(n.mul)(a.as_ptr(), b.as_ptr(), tmp.as_mut_ptr(), LEN);
+			(n.add)(tmp.as_ptr(), c.as_ptr(), out.as_mut_ptr(), LEN);
+		}
+		1 => (n.div)(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN),
+		2 => (n.sqrt)(abs_a.as_ptr(), out.as_mut_ptr(), LEN),
+		_ => {
+			let k_dt = vec![(n.from)(K * DT); LEN];
+			let dt = vec![(n.from)(DT); LEN];
+			let mut v = b.to_vec();
+			out.copy_from_slice(a);
+
+			for _ in 0..STEPS {
+				(n.mul)(out.as_ptr(), k_dt.as_ptr(), tmp.as_mut_ptr(), LEN);
+				(n.sub)(v.as_ptr(), tmp.as_ptr(), v.as_mut_ptr(), LEN);
+				(n.mul)(v.as_ptr(), dt.as_ptr(), tmp.as_mut_ptr(), LEN);
+				(n.add)(out.as_ptr(), tmp.as_ptr(), out.as_mut_ptr(), LEN);
+			}
+		}
+	}
+}
+
+fn measure<T: Copy + Default>(n: &Numbers<T>, inputs: &Inputs) {
+	dfloat_set_backend(n.backend);
+
+	let a: Vec<T> = inputs.a.iter().map(|&x| (n.from)(x)).collect();
+	let b: Vec<T> = inputs.b.iter().map(|&x| (n.from)(x)).collect();
+	let c: Vec<T> = inputs.c.iter().map(|&x| (n.from)(x)).collect();
+	let abs_a: Vec<T> = inputs.a.iter().map(|&x| (n.from)(x.abs())).collect();
+	let mut out = vec![T::default(); LEN];
+	let mut tmp = vec![T::default(); LEN];
+
+	for (w, workload) in WORKLOADS.iter().enumerate() {
+		let ops = if w == 3 { LEN * STEPS } else { LEN };
+
+		bench(&format!("{} {}", n.name, workload.name), ops, || {
+			unsafe { run(n, w, &a, &b, &c, &abs_a, &mut out, &mut tmp) };
+			black_box(&out);
+		});
+
+		let mut max_error = 0f64;
+		let mut sum_squares = 0f64;
+
+		for i in 0..LEN {
+			let error = ((n.to)(out[i]) - (workload.reference)(inputs, i)).abs();
+			max_error = max_error.max(error);
+			sum_squares += error * error;
+		}
+
+		println!("{:<40} max abs error {:.3e}, rms {:.3e}", "", max_error, (sum_squares / LEN as f64).sqrt());
+	}
+}
+
+// Magnitudes from 1/16 to 64, with either sign.
+fn inputs(rng: &mut Rng) -> Vec<f64> {
+	return (0..LEN).map(|_| {
+		let magnitude = 2f64.powf((rng.next_u32() as f64 / u32::MAX as f64) * 10.0 - 4.0);
+		if rng.next() & 1 == 0 { magnitude } else { -magnitude }
+	}).collect();
+}
+
+fn main() {
+	let mut rng = Rng(0x9e37_79b9_7f4a_7c15);
+	let inputs = Inputs { a: inputs(&mut rng), b: inputs(&mut rng), c: inputs(&mut rng) };
+
+	for &(backend, name) in &[(BACKEND_HARDWARE, "hardware dfloat"), (BACKEND_SOFT, "soft dfloat")] {
+		measure(&Numbers::<u32> {
+			name,
+			backend,
+			add: float_add_batch,
+			sub: float_sub_batch,
+			mul: float_mul_batch,
+			div: float_div_batch,
+			sqrt: float_sqrt_batch,
+			from: |x| (x as f32).to_bits(),
+			to: |x| f32::from_bits(x) as f64,
+		}, &inputs);
+	}
+
+	measure(&Numbers::<i32> {
+		name: "Q16.16 saturating",
+		backend: BACKEND_HARDWARE,
+		add: fixed16_add_saturating_batch,
+		sub: fixed16_sub_saturating_batch,
+		mul: fixed16_mul_saturating_batch,
+		div: fixed16_div_saturating_batch,
+		sqrt: fixed16_sqrt_batch,
+		from: |x| (x * 65536.0).round() as i32,
+		to: |x| x as f64 / 65536.0,
+	}, &inputs);
+
+	measure(&Numbers::<i32> {
+		name: "Q16.16 wrapping",
+		backend: BACKEND_HARDWARE,
+		add: fixed16_add_wrapping_batch,
+		sub: fixed16_sub_wrapping_batch,
+		mul: fixed16_mul_wrapping_batch,
+		div: fixed16_div_wrapping_batch,
+		sqrt: fixed16_sqrt_batch,
+		from: |x| (x * 65536.0).round() as i32,
+		to: |x| x as f64 / 65536.0,
+	}, &inputs);
+
+	measure(&Numbers::<i64> {
+		name: "Q32.32 saturating",
+		backend: BACKEND_HARDWARE,
+		add: fixed32_add_saturating_batch,
+		sub: fixed32_sub_saturating_batch,
+		mul: fixed32_mul_saturating_batch,
+		div: fixed32_div_saturating_batch,
+		sqrt: fixed32_sqrt_batch,
+		from: |x| (x * 4294967296.0).round() as i64,
+		to: |x| x as f64 / 4294967296.0,
+	}, &inputs);
+
+	measure(&Numbers::<i64> {
+		name: "Q32.32 wrapping",
+		backend: BACKEND_HARDWARE,
+		add: fixed32_add_wrapping_batch,
+		sub: fixed32_sub_wrapping_batch,
+		mul: fixed32_mul_wrapping_batch,
+		div: fixed32_div_wrapping_batch,
+		sqrt: fixed32_sqrt_batch,
+		from: |x| (x * 4294967296.0).round() as i64,
+		to: |x| x as f64 / 4294967296.0,
+	}, &inputs);
+
+	dfloat_set_backend(BACKEND_HARDWARE);
+}
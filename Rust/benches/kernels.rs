@@ -0,0 +1,569 @@
+// Every export, scalar and batched, on each class of input (normal, denormal,
+// infinite, NaN, and a mix of all four and zeros), for both backends, compared
+// with a saved baseline:
+//
+//   cargo bench --bench kernels -- [filter] [--baseline NAME] [--save-baseline NAME] [--noise PERCENT] [--quick]
+//
+// Each benchmark is measured as SAMPLES samples of the time per operation, and
+// reported as their median. Against a baseline, the samples are compared with a
+// Mann-Whitney U test, and a benchmark is only reported as regressed or improved
+// if the difference is significant (p < 0.05) and its median moved by more than
+// NOISE (or --noise), so ordinary run to run jitter doesn't count as a change.
+//
+// With no options each run is compared with the previous one, and then replaces
+// it. --baseline compares with a baseline saved earlier with --save-baseline, and
+// doesn't overwrite anything unless --save-baseline is also given. Baselines are
+// kept in target/bench-baselines, one line of samples per benchmark. A filter
+// runs only the benchmarks whose names contain it.
+mod common;
+
+use common::{normal_inputs, normal_inputs64, Rng};
+use std::hint::black_box;
+use std::path::PathBuf;
+use std::time::{Duration, Instant};
+use std::{env, fs};
+use unity_rust::arith::{dfloat_set_backend, BACKEND_HARDWARE, BACKEND_SOFT};
+use unity_rust::convert::*;
+use unity_rust::corpus::dfloat_random_fill_corpus;
+use unity_rust::ddouble::*;
+use unity_rust::dispatch::{dfloat_set_dispatch_variant, VARIANTS};
+use unity_rust::dmath::*;
+use unity_rust::fixed::*;
+use unity_rust::hash::*;
+use unity_rust::matrix::*;
+use unity_rust::oracle::float_oracle_batch;
+use unity_rust::random::*;
+use unity_rust::trace::{dfloat_trace_start, dfloat_trace_stop};
+use unity_rust::vector::*;
+use unity_rust::*;
+
+const LEN: usize = 4096;
+
+// Vectors and matrices in the structure-of-arrays benchmarks, so that 16 planes
+// of them fit in LEN elements.
+const SOA_COUNT: usize = LEN / 16;
+
+const SAMPLES: usize = 20;
+const SAMPLE_TIME: Duration = Duration::from_millis(5);
+const QUICK_SAMPLES: usize = 10;
+const QUICK_SAMPLE_TIME: Duration = Duration::from_millis(1);
+
+// Smallest change in the median that counts as a regression or improvement.
+const NOISE: f64 = 0.05;
+const SIGNIFICANCE: f64 = 0.05;
+
+const CLASSES: [&str; 5] = ["normal", "denormal", "inf", "nan", "mixed"];
+
+type Scalar = unsafe extern "C" fn(u32, u32) -> u32;
+type UnaryScalar = extern "C" fn(u32) -> u32;
+type Batch = unsafe extern "C" fn(*const u32, *const u32, *mut u32, usize);
+type UnaryBatch = unsafe extern "C" fn(*const u32, *mut u32, usize);
+type Scalar64 = unsafe extern "C" fn(u64, u64) -> u64;
+type Batch64 = unsafe extern "C" fn(*const u64, *const u64, *mut u64, usize);
+
+// Class 1 to 3 of CLASSES for each bit pattern, or a random one of them, normals
+// or zeros for mixed.
+fn classify(bits: u32, class: usize, choice: u32) -> u32 {
+	let sign_frac = bits & 0x807f_ffff;
+
+	return match if class == 4 { choice % 5 } else { class as u32 } {
+		1 => sign_frac | 1,
+		2 => (bits & 0x8000_0000) | 0x7f80_0000,
+		3 => sign_frac | 0x7f80_0001,
+		4 => bits & 0x8000_0000,
+		_ => (sign_frac) | ((0x5f + (bits >> 23) % 0x40) << 23),
+	};
+}
+
+fn class_inputs(rng: &mut Rng, class: usize, len: usize) -> Vec<u32> {
+	if class == 0 {
+		return normal_inputs(rng, len);
+	}
+
+	return (0..len).map(|_| classify(rng.next_u32(), class, rng.next_u32())).collect();
+}
+
+// The same classes for doubles, with the float's class in the high half.
+fn class_inputs64(rng: &mut Rng, class: usize, len: usize) -> Vec<u64> {
+	if class == 0 {
+		return normal_inputs64(rng, len);
+	}
+
+	return (0..len)
+		.map(|_| {
+			let high = classify(rng.next_u32(), class, rng.next_u32()) as u64;
+			let exponent = (high >> 20) & 0x7ff;
+			// Widen the float's 8 bit exponent to the double's 11 bits.
+			let widened = match exponent & 0x7f8 {
+				0 => 0,
+				0x7f8 => 0x7ff,
+				_ => exponent + 0x380,
+			};
+			(high & 0x8000_0000) << 32 | widened << 52 | (high & 0x7ffff) << 33 | rng.next() >> 31 | (exponent == 0x7f8) as u64
+		})
+		.collect();
+}
+
+// The unary and single matrix kernels in the shape of the others, ignoring b or
+// reading a's first 16 elements as the matrix.
+unsafe extern "C" fn normalize(v: *const u32, _: *const u32, out: *mut u32, len: usize) {
+	dvec3_normalize_batch(v, out, len);
+}
+
+unsafe extern "C" fn transform_points(m: *const u32, p: *const u32, out: *mut u32, count: usize) {
+	dmat4_transform_points_soa(m as *const [u32; 16], p, out, count);
+}
+
+struct Options {
+	filter: Option<String>,
+	baseline: String,
+	save: Option<String>,
+	noise: f64,
+	samples: usize,
+	sample_time: Duration,
+}
+
+fn parse_options() -> Options {
+	let mut options = Options { filter: None, baseline: "previous".to_string(), save: Some("previous".to_string()), noise: NOISE, samples: SAMPLES, sample_time: SAMPLE_TIME };
+	let mut args = env::args().skip(1);
+
+	while let Some(arg) = args.next() {
+		match arg.as_str() {
+			// Passed by cargo bench.
+			"--bench" => {}
+			"--quick" => {
+				options.samples = QUICK_SAMPLES;
+				options.sample_time = QUICK_SAMPLE_TIME;
+			}
+			"--baseline" => {
+				options.baseline = args.next().expect("--baseline needs a name");
+				if options.save.as_deref() == Some("previous") {
+					options.save = None;
+				}
+			}
+			"--noise" => options.noise = args.next().and_then(|n| n.parse::<f64>().ok()).expect("--noise needs a percentage") / 100.0,
+			"--save-baseline" => options.save = Some(args.next().expect("--save-baseline needs a name")),
+			_ => options.filter = Some(arg),
+		}
+	}
+
+	return options;
+}
+
+fn baseline_path(name: &str) -> PathBuf {
+	return PathBuf::from(env!("CARGO_MANIFEST_DIR")).join("target").join("bench-baselines").join(format!("{}.txt", name));
+}
+
+// Benchmark name, a tab, and its samples in ns/op, per line.
+fn load_baseline(name: &str) -> Vec<(String, Vec<f64>)> {
+	let text = fs::read_to_string(baseline_path(name)).unwrap_or_default();
+
+	return text
+		.lines()
+		.filter_map(|line| {
+			let (name, samples) = line.split_once('\t')?;
+			Some((name.to_string(), samples.split(' ').filter_map(|s| s.parse().ok()).collect()))
+		})
+		.collect();
+}
+
+fn save_baseline(name: &str, results: &[(String, Vec<f64>)]) {
+	let path = baseline_path(name);
+	let mut text = String::new();
+
+	for (bench, samples) in results {
+		let samples: Vec<String> = samples.iter().map(|s| format!("{:.4}", s)).collect();
+		text += &format!("{}\t{}\n", bench, samples.join(" "));
+	}
+
+	match fs::create_dir_all(path.parent().unwrap()).and_then(|_| fs::write(&path, text)) {
+		Ok(()) => println!("saved baseline {}", path.display()),
+		Err(error) => println!("failed to save baseline {}: {}", path.display(), error),
+	}
+}
+
+fn median(samples: &[f64]) -> f64 {
+	let mut sorted = samples.to_vec();
+	sorted.sort_by(|a, b| a.partial_cmp(b).unwrap());
+	let n = sorted.len();
+	return if n % 2 == 1 { sorted[n / 2] } else { (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0 };
+}
+
+// Abramowitz and Stegun 7.1.26, for x >= 0; accurate to 1.5e-7.
+fn erfc(x: f64) -> f64 {
+	let t = 1.0 / (1.0 + 0.327_591_1 * x);
+	let poly = t * (0.254_829_592 + t * (-0.284_496_736 + t * (1.421_413_741 + t * (-1.453_152_027 + t * 1.061_405_429))));
+	return poly * (-x * x).exp();
+}
+
+// Two-sided p-value of the Mann-Whitney U test that a and b come from the same
+// distribution, with the normal approximation, which is good for 10 or more
+// samples each.
+fn mann_whitney(a: &[f64], b: &[f64]) -> f64 {
+	let mut all: Vec<(f64, bool)> = a.iter().map(|&x| (x, true)).chain(b.iter().map(|&x| (x, false))).collect();
+	all.sort_by(|x, y| x.0.partial_cmp(&y.0).unwrap());
+
+	let mut rank_sum = 0.0;
+	let mut i = 0;
+
+	while i < all.len() {
+		// Tied samples share the mean of their ranks.
+		let mut j = i;
+
+		while j + 1 < all.len() && all[j + 1].0 == all[i].0 {
+			j += 1;
+		}
+
+		let rank = (i + j) as f64 / 2.0 + 1.0;
+		rank_sum += rank * all[i..=j].iter().filter(|s| s.1).count() as f64;
+		i = j + 1;
+	}
+
+	let (n1, n2) = (a.len() as f64, b.len() as f64);
+	let u = rank_sum - n1 * (n1 + 1.0) / 2.0;
+	let sd = (n1 * n2 * (n1 + n2 + 1.0) / 12.0).sqrt();
+	return erfc((u - n1 * n2 / 2.0).abs() / sd / std::f64::consts::SQRT_2);
+}
+
+struct Runner {
+	options: Options,
+	baseline: Vec<(String, Vec<f64>)>,
+	results: Vec<(String, Vec<f64>)>,
+	regressions: usize,
+	improvements: usize,
+}
+
+impl Runner {
+	// Measures f, which performs ops operations per call, and prints its median
+	// time per operation and any change from the baseline.
+	fn bench<F: FnMut()>(&mut self, name: &str, ops: usize, mut f: F) {
+		if let Some(filter) = &self.options.filter {
+			if !name.contains(filter.as_str()) {
+				return;
+			}
+		}
+
+		let warm = Instant::now();
+
+		while warm.elapsed() < self.options.sample_time {
+			f();
+		}
+
+		let mut samples = Vec::with_capacity(self.options.samples);
+
+		for _ in 0..self.options.samples {
+			let mut iterations = 0u64;
+			let start = Instant::now();
+
+			while start.elapsed() < self.options.sample_time {
+				f();
+				iterations += 1;
+			}
+
+			samples.push(start.elapsed().as_nanos() as f64 / (iterations as f64 * ops as f64));
+		}
+
+		let estimate = median(&samples);
+		let mut line = format!("{:<48} {:>10.3} ns/op {:>10.1} Mops/s", name, estimate, 1000.0 / estimate);
+
+		if let Some((_, base)) = self.baseline.iter().find(|b| b.0 == name) {
+			let change = estimate / median(base) - 1.0;
+			let p = mann_whitney(&samples, base);
+
+			let verdict = if p >= SIGNIFICANCE || change.abs() <= self.options.noise {
+				"no change"
+			} else if change > 0.0 {
+				self.regressions += 1;
+				"REGRESSED"
+			} else {
+				self.improvements += 1;
+				"improved"
+			};
+
+			line += &format!(" {:>+7.1}% p={:.3} {}", change * 100.0, p, verdict);
+		}
+
+		println!("{}", line);
+		self.results.push((name.to_string(), samples));
+	}
+}
+
+fn main() {
+	let options = parse_options();
+	let baseline = load_baseline(&options.baseline);
+
+	if baseline.is_empty() {
+		println!("no baseline {} to compare with", options.baseline);
+	}
+
+	let mut runner = Runner { options, baseline, results: Vec::new(), regressions: 0, improvements: 0 };
+	let mut rng = Rng(0x9e37_79b9_7f4a_7c15);
+	let mut out = vec![0u32; LEN];
+	let mut out64 = vec![0u64; LEN];
+	let mut ints = vec![0i32; LEN];
+
+	let ops: [(&str, Scalar, Batch, u32); 4] = [
+		("add", float_add, batch::float_add_batch, 0),
+		("sub", float_sub, batch::float_sub_batch, 1),
+		("mul", float_mul, batch::float_mul_batch, 2),
+		("div", float_div, batch::float_div_batch, 3),
+	];
+
+	let functions: [(&str, UnaryScalar, UnaryBatch); 5] = [
+		("sqrt", float_sqrt, float_sqrt_batch),
+		("sin", float_sin, float_sin_batch),
+		("cos", float_cos, float_cos_batch),
+		("exp", float_exp, float_exp_batch),
+		("log", float_log, float_log_batch),
+	];
+
+	let ops64: [(&str, Scalar64, Batch64); 4] = [
+		("add", double_add, double_add_batch),
+		("sub", double_sub, double_sub_batch),
+		("mul", double_mul, double_mul_batch),
+		("div", double_div, double_div_batch),
+	];
+
+	let soa: [(&str, Batch); 7] = [
+		("dvec3 dot", dvec3_dot_batch),
+		("dvec3 cross", dvec3_cross_batch),
+		("dquat mul", dquat_mul_batch),
+		("dquat rotate", dquat_rotate_batch),
+		("dmat4 mul", dmat4_mul_batch_soa),
+		("dvec3 normalize", normalize),
+		("dmat4 transform points", transform_points),
+	];
+
+	for (class, class_name) in CLASSES.iter().enumerate() {
+		let a = class_inputs(&mut rng, class, LEN);
+		let b = class_inputs(&mut rng, class, LEN);
+		let a64 = class_inputs64(&mut rng, class, LEN);
+		let b64 = class_inputs64(&mut rng, class, LEN);
+
+		for &(backend, backend_name) in &[(BACKEND_HARDWARE, "hardware"), (BACKEND_SOFT, "soft")] {
+			dfloat_set_backend(backend);
+			let prefix = format!("{} {}", backend_name, class_name);
+
+			for &(name, scalar, batched, op) in &ops {
+				runner.bench(&format!("{} {} scalar", prefix, name), LEN, || {
+					for i in 0..LEN {
+						out[i] = unsafe { scalar(black_box(a[i]), black_box(b[i])) };
+					}
+					black_box(&out);
+				});
+
+				runner.bench(&format!("{} {} batch", prefix, name), LEN, || {
+					unsafe { batched(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN) };
+					black_box(&out);
+				});
+
+				runner.bench(&format!("{} {} oracle", prefix, name), LEN, || {
+					unsafe { float_oracle_batch(op, a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN) };
+					black_box(&out);
+				});
+			}
+
+			let selected = dfloat_set_dispatch_variant(0);
+
+			for variant in VARIANTS.iter().filter(|v| (v.detect)()) {
+				dfloat_set_dispatch_variant(variant.id);
+
+				for &(name, _, batched, _) in &ops {
+					runner.bench(&format!("{} {} variant {} batch", prefix, name, variant.id), LEN, || {
+						unsafe { batched(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN) };
+						black_box(&out);
+					});
+				}
+			}
+
+			dfloat_set_dispatch_variant(selected);
+
+			for &(name, scalar, batched) in &functions {
+				runner.bench(&format!("{} {} scalar", prefix, name), LEN, || {
+					for i in 0..LEN {
+						out[i] = scalar(black_box(a[i]));
+					}
+					black_box(&out);
+				});
+
+				runner.bench(&format!("{} {} batch", prefix, name), LEN, || {
+					unsafe { batched(a.as_ptr(), out.as_mut_ptr(), LEN) };
+					black_box(&out);
+				});
+			}
+
+			runner.bench(&format!("{} atan2 scalar", prefix), LEN, || {
+				for i in 0..LEN {
+					out[i] = float_atan2(black_box(a[i]), black_box(b[i]));
+				}
+				black_box(&out);
+			});
+
+			runner.bench(&format!("{} atan2 batch", prefix), LEN, || {
+				unsafe { float_atan2_batch(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN) };
+				black_box(&out);
+			});
+
+			for &(name, scalar, batched) in &ops64 {
+				runner.bench(&format!("{} {} double scalar", prefix, name), LEN, || {
+					for i in 0..LEN {
+						out64[i] = unsafe { scalar(black_box(a64[i]), black_box(b64[i])) };
+					}
+					black_box(&out64);
+				});
+
+				runner.bench(&format!("{} {} double batch", prefix, name), LEN, || {
+					unsafe { batched(a64.as_ptr(), b64.as_ptr(), out64.as_mut_ptr(), LEN) };
+					black_box(&out64);
+				});
+			}
+
+			runner.bench(&format!("{} to i32 scalar", prefix), LEN, || {
+				for i in 0..LEN {
+					ints[i] = float_to_i32(black_box(a[i]), ROUND_HALF_EVEN);
+				}
+				black_box(&ints);
+			});
+
+			runner.bench(&format!("{} to i32 batch", prefix), LEN, || {
+				unsafe { float_to_i32_batch(a.as_ptr(), ints.as_mut_ptr(), LEN, ROUND_HALF_EVEN) };
+				black_box(&ints);
+			});
+
+			for &(name, batched) in &soa {
+				runner.bench(&format!("{} {} batch", prefix, name), SOA_COUNT, || {
+					unsafe { batched(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), SOA_COUNT) };
+					black_box(&out);
+				});
+			}
+		}
+	}
+
+	// The fixed-point kernels don't depend on the backend or on floating point
+	// classes, so run once on plain integers.
+	let x: Vec<i32> = (0..LEN).map(|_| rng.next_u32() as i32 >> 8).collect();
+	let y: Vec<i32> = (0..LEN).map(|_| (rng.next_u32() as i32 >> 8) | 1).collect();
+	let x64: Vec<i64> = x.iter().map(|&v| (v as i64) << 16).collect();
+	let y64: Vec<i64> = y.iter().map(|&v| (v as i64) << 16).collect();
+	let mut fixed = vec![0i32; LEN];
+	let mut fixed64 = vec![0i64; LEN];
+
+	let fixed_ops: [(&str, unsafe extern "C" fn(*const i32, *const i32, *mut i32, usize), unsafe extern "C" fn(*const i64, *const i64, *mut i64, usize)); 4] = [
+		("add saturating", fixed16_add_saturating_batch, fixed32_add_saturating_batch),
+		("sub saturating", fixed16_sub_saturating_batch, fixed32_sub_saturating_batch),
+		("mul saturating", fixed16_mul_saturating_batch, fixed32_mul_saturating_batch),
+		("div saturating", fixed16_div_saturating_batch, fixed32_div_saturating_batch),
+	];
+
+	for &(name, batch16, batch32) in &fixed_ops {
+		runner.bench(&format!("q16.16 {} batch", name), LEN, || {
+			unsafe { batch16(x.as_ptr(), y.as_ptr(), fixed.as_mut_ptr(), LEN) };
+			black_box(&fixed);
+		});
+
+		runner.bench(&format!("q32.32 {} batch", name), LEN, || {
+			unsafe { batch32(x64.as_ptr(), y64.as_ptr(), fixed64.as_mut_ptr(), LEN) };
+			black_box(&fixed64);
+		});
+	}
+
+	runner.bench("q16.16 sqrt batch", LEN, || {
+		unsafe { fixed16_sqrt_batch(x.as_ptr(), fixed.as_mut_ptr(), LEN) };
+		black_box(&fixed);
+	});
+
+	runner.bench("q32.32 sqrt batch", LEN, || {
+		unsafe { fixed32_sqrt_batch(x64.as_ptr(), fixed64.as_mut_ptr(), LEN) };
+		black_box(&fixed64);
+	});
+
+	let words = normal_inputs(&mut rng, LEN);
+	let words64 = normal_inputs64(&mut rng, LEN);
+	let mut hashes = vec![0u64; LEN / 256];
+	let mut dirty = vec![1u8; LEN / 256];
+
+	for &(flags, flags_name) in &[(0, "hash"), (HASH_CANONICAL_NANS, "hash canonical")] {
+		runner.bench(&format!("dfloat {}", flags_name), LEN, || {
+			black_box(unsafe { dfloat_hash(words.as_ptr(), LEN, flags, 0) });
+		});
+
+		runner.bench(&format!("ddouble {}", flags_name), LEN, || {
+			black_box(unsafe { ddouble_hash(words64.as_ptr(), LEN, flags, 0) });
+		});
+	}
+
+	// One chunk in 16 changed since the last hash.
+	runner.bench("dfloat hash chunks 1/16 dirty", LEN, || {
+		for i in (0..dirty.len()).step_by(16) {
+			dirty[i] = 1;
+		}
+
+		black_box(unsafe { dfloat_hash_chunks(words.as_ptr(), LEN, 256, 0, dirty.as_mut_ptr(), hashes.as_mut_ptr()) });
+	});
+
+	let mut random = Random::new(1);
+
+	runner.bench("random scalar", LEN, || {
+		for i in 0..LEN {
+			out[i] = unsafe { dfloat_random_next(&mut random) };
+		}
+		black_box(&out);
+	});
+
+	runner.bench("random fill", LEN, || {
+		unsafe { dfloat_random_fill(&mut random, out.as_mut_ptr(), LEN) };
+		black_box(&out);
+	});
+
+	runner.bench("random fill unit", LEN, || {
+		unsafe { dfloat_random_fill_unit(&mut random, out.as_mut_ptr(), LEN) };
+		black_box(&out);
+	});
+
+	runner.bench("random fill corpus", LEN, || {
+		unsafe { dfloat_random_fill_corpus(&mut random, std::ptr::null(), 0, out.as_mut_ptr(), LEN) };
+		black_box(&out);
+	});
+
+	for &(backend, backend_name) in &[(BACKEND_HARDWARE, "hardware"), (BACKEND_SOFT, "soft")] {
+		dfloat_set_backend(backend);
+
+		runner.bench(&format!("{} random fill range", backend_name), LEN, || {
+			unsafe { dfloat_random_fill_range(&mut random, out.as_mut_ptr(), LEN, (-10.0f32).to_bits(), 10.0f32.to_bits()) };
+			black_box(&out);
+		});
+	}
+
+	dfloat_set_backend(BACKEND_HARDWARE);
+
+	// The untraced exports are the benchmarks above.
+	let a = normal_inputs(&mut rng, LEN);
+	let b = normal_inputs(&mut rng, LEN);
+	dfloat_trace_start(LEN);
+
+	runner.bench("traced add scalar", LEN, || {
+		for i in 0..LEN {
+			out[i] = unsafe { float_add(black_box(a[i]), black_box(b[i])) };
+		}
+		black_box(&out);
+	});
+
+	runner.bench("traced add batch", LEN, || {
+		unsafe { batch::float_add_batch(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN) };
+		black_box(&out);
+	});
+
+	dfloat_trace_stop();
+
+	if !runner.baseline.is_empty() {
+		println!("{} regressed, {} improved against baseline {}", runner.regressions, runner.improvements, runner.options.baseline);
+	}
+
+	if let Some(name) = &runner.options.save {
+		// A filtered run keeps the baseline's other benchmarks.
+		let mut results = load_baseline(name);
+		results.retain(|r| !runner.results.iter().any(|n| n.0 == r.0));
+		results.extend(runner.results.drain(..));
+		save_baseline(name, &results);
+	}
+}
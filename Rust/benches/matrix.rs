@@ -0,0 +1,130 @@
+// Matrix products and point transforms: the same formulas as sequences of scalar
+// float_mul/float_add calls (what C# does with Mathd.Mul/Mathd.Add, minus the
+// P/Invoke overhead), one dmat4 call per element, and the batched AoS and SoA
+// kernels. Every path must give the same bits, which is checked before timing.
+mod common;
+
+use common::{bench, normal_inputs, Rng};
+use std::hint::black_box;
+use unity_rust::arith::{dfloat_set_backend, BACKEND_HARDWARE, BACKEND_SOFT};
+use unity_rust::matrix::*;
+use unity_rust::*;
+
+const COUNT: usize = 1024;
+
+unsafe fn mul_scalar_calls(a: &[u32], b: &[u32], out: &mut [u32]) {
+	for i in 0..COUNT {
+		let (x, y) = (&a[i * 16..], &b[i * 16..]);
+
+		for c in 0..4 {
+			for r in 0..4 {
+				let mut sum = float_mul(x[r], y[c * 4]);
+
+				for k in 1..4 {
+					sum = float_add(sum, float_mul(x[k * 4 + r], y[c * 4 + k]));
+				}
+
+				out[i * 16 + c * 4 + r] = sum;
+			}
+		}
+	}
+}
+
+unsafe fn transform_scalar_calls(m: &[u32; 16], p: &[u32], out: &mut [u32]) {
+	for i in 0..COUNT {
+		for r in 0..3 {
+			let mut sum = float_mul(m[r], p[i * 3]);
+			sum = float_add(sum, float_mul(m[4 + r], p[i * 3 + 1]));
+			sum = float_add(sum, float_mul(m[8 + r], p[i * 3 + 2]));
+			out[i * 3 + r] = float_add(sum, m[12 + r]);
+		}
+	}
+}
+
+// Converts count elements of c components between AoS and SoA.
+fn transpose(aos: &[u32], c: usize) -> Vec<u32> {
+	let count = aos.len() / c;
+	return (0..aos.len()).map(|j| aos[(j % count) * c + j / count]).collect();
+}
+
+fn main() {
+	let mut rng = Rng(0x2545_f491_4f6c_dd1d);
+	// Small magnitudes so products of products stay finite.
+	let a: Vec<u32> = normal_inputs(&mut rng, COUNT * 16).iter().map(|x| (x & 0x807f_ffff) | 0x3f00_0000).collect();
+	let b: Vec<u32> = normal_inputs(&mut rng, COUNT * 16).iter().map(|x| (x & 0x807f_ffff) | 0x3f00_0000).collect();
+	let p = normal_inputs(&mut rng, COUNT * 3);
+	let mut m = [0u32; 16];
+	m.copy_from_slice(&a[..16]);
+
+	let (a_soa, b_soa, p_soa) = (transpose(&a, 16), transpose(&b, 16), transpose(&p, 3));
+	let mut expected = vec![0u32; COUNT * 16];
+	let mut out = vec![0u32; COUNT * 16];
+
+	for &(backend, backend_name) in &[(BACKEND_HARDWARE, "hardware"), (BACKEND_SOFT, "soft")] {
+		dfloat_set_backend(backend);
+
+		unsafe {
+			mul_scalar_calls(&a, &b, &mut expected);
+
+			for i in 0..COUNT {
+				let r = out[i * 16..].as_mut_ptr() as *mut [u32; 16];
+				dmat4_mul(a[i * 16..].as_ptr() as *const [u32; 16], b[i * 16..].as_ptr() as *const [u32; 16], r);
+			}
+			assert_eq!(out, expected);
+
+			dmat4_mul_batch(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), COUNT);
+			assert_eq!(out, expected);
+
+			dmat4_mul_batch_soa(a_soa.as_ptr(), b_soa.as_ptr(), out.as_mut_ptr(), COUNT);
+			assert_eq!(out, transpose(&expected, 16));
+
+			transform_scalar_calls(&m, &p, &mut expected[..COUNT * 3]);
+
+			dmat4_transform_points(&m, p.as_ptr(), out.as_mut_ptr(), COUNT);
+			assert_eq!(out[..COUNT * 3], expected[..COUNT * 3]);
+
+			dmat4_transform_points_soa(&m, p_soa.as_ptr(), out.as_mut_ptr(), COUNT);
+			assert_eq!(out[..COUNT * 3], transpose(&expected[..COUNT * 3], 3)[..]);
+		}
+
+		bench(&format!("{} mat mul scalar calls", backend_name), COUNT, || {
+			unsafe { mul_scalar_calls(&a, &b, &mut out) };
+			black_box(&out);
+		});
+
+		bench(&format!("{} mat mul dmat4_mul", backend_name), COUNT, || {
+			for i in 0..COUNT {
+				let r = out[i * 16..].as_mut_ptr() as *mut [u32; 16];
+				unsafe { dmat4_mul(a[i * 16..].as_ptr() as *const [u32; 16], b[i * 16..].as_ptr() as *const [u32; 16], r) };
+			}
+			black_box(&out);
+		});
+
+		bench(&format!("{} mat mul batch aos", backend_name), COUNT, || {
+			unsafe { dmat4_mul_batch(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), COUNT) };
+			black_box(&out);
+		});
+
+		bench(&format!("{} mat mul batch soa", backend_name), COUNT, || {
+			unsafe { dmat4_mul_batch_soa(a_soa.as_ptr(), b_soa.as_ptr(), out.as_mut_ptr(), COUNT) };
+			black_box(&out);
+		});
+
+		bench(&format!("{} transform point scalar calls", backend_name), COUNT, || {
+			unsafe { transform_scalar_calls(&m, &p, &mut out) };
+			black_box(&out);
+		});
+
+		bench(&format!("{} transform points batch aos", backend_name), COUNT, || {
+			unsafe { dmat4_transform_points(&m, p.as_ptr(), out.as_mut_ptr(), COUNT) };
+			black_box(&out);
+		});
+
+		bench(&format!("{} transform points batch soa", backend_name), COUNT, || {
+			unsafe { dmat4_transform_points_soa(&m, p_soa.as_ptr(), out.as_mut_ptr(), COUNT) };
+			black_box(&out);
+		});
+	}
+
+	dfloat_set_backend(BACKEND_HARDWARE);
+}
@@ -0,0 +1,93 @@
+// Cost of canonicalizing NaN results (dfloat_set_nan_mode) in the batched
+// operations, on normal inputs and on inputs where one element in four is a NaN
+// with a random payload. Canonicalizing is a compare and a select per lane, so
+// the cost should not depend on how many results are NaN.
+mod common;
+
+use common::{bench, normal_inputs, small_inputs, Rng};
+use std::hint::black_box;
+use unity_rust::arith::*;
+use unity_rust::batch::*;
+use unity_rust::dmath::*;
+use unity_rust::matrix::*;
+use unity_rust::vector::*;
+
+const LEN: usize = 4096;
+
+type Batch = unsafe extern "C" fn(*const u32, *const u32, *mut u32, usize);
+
+// xs with one element in four replaced by a NaN of either sign and random payload.
+fn with_nans(rng: &mut Rng, xs: &[u32]) -> Vec<u32> {
+	return xs.iter().enumerate().map(|(i, &x)| {
+		let bits = rng.next_u32();
+		if i % 4 == 3 { (bits & 0x807f_ffff) | 0x7f80_0001 } else { x }
+	}).collect();
+}
+
+fn main() {
+	let mut rng = Rng(0x9e37_79b9_7f4a_7c15);
+	let normal = (normal_inputs(&mut rng, LEN), normal_inputs(&mut rng, LEN));
+	let nans = (with_nans(&mut rng, &normal.0), with_nans(&mut rng, &normal.1));
+	let small = small_inputs(&mut rng, LEN);
+	let small_nans = with_nans(&mut rng, &small);
+	let mut out = vec![0u32; LEN];
+	let mut out3 = vec![0u32; 3 * LEN];
+
+	// Structure-of-arrays vectors and a transform with one NaN in its translation.
+	let v3 = normal_inputs(&mut rng, 3 * LEN);
+	let mut m = [0u32; 16];
+	m.copy_from_slice(&normal_inputs(&mut rng, 16));
+	let mut m_nan = m;
+	m_nan[12] = 0x7fa0_0001;
+
+	let ops: [(&str, Batch); 4] = [
+		("add", float_add_batch),
+		("sub", float_sub_batch),
+		("mul", float_mul_batch),
+		("div", float_div_batch),
+	];
+
+	// (name, backend, NaN mode)
+	let configs = [
+		("hardware preserve", BACKEND_HARDWARE, NANS_PRESERVE),
+		("hardware canonical", BACKEND_HARDWARE, NANS_CANONICAL),
+		("soft preserve", BACKEND_SOFT, NANS_PRESERVE),
+		("soft canonical", BACKEND_SOFT, NANS_CANONICAL),
+	];
+
+	for &(name, backend, mode) in configs.iter() {
+		dfloat_set_backend(backend);
+		dfloat_set_nan_mode(mode);
+
+		for &(op, f) in ops.iter() {
+			for (inputs, (a, b)) in [("normal", &normal), ("nan", &nans)] {
+				bench(&format!("{} {} {}", name, op, inputs), LEN, || {
+					unsafe { f(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), LEN) };
+					black_box(&out);
+				});
+			}
+		}
+
+		for (inputs, x) in [("normal", &small), ("nan", &small_nans)] {
+			bench(&format!("{} exp {}", name, inputs), LEN, || {
+				unsafe { float_exp_batch(x.as_ptr(), out.as_mut_ptr(), LEN) };
+				black_box(&out);
+			});
+		}
+
+		bench(&format!("{} dvec3 normalize", name), LEN, || {
+			unsafe { dvec3_normalize_batch(v3.as_ptr(), out3.as_mut_ptr(), LEN) };
+			black_box(&out3);
+		});
+
+		for (inputs, m) in [("normal", &m), ("nan", &m_nan)] {
+			bench(&format!("{} transform points {}", name, inputs), LEN, || {
+				unsafe { dmat4_transform_points_soa(m, v3.as_ptr(), out3.as_mut_ptr(), LEN) };
+				black_box(&out3);
+			});
+		}
+	}
+
+	dfloat_set_backend(BACKEND_HARDWARE);
+	dfloat_set_nan_mode(NANS_PRESERVE);
+}
@@ -0,0 +1,560 @@
+// A particle simulation stepped the way a lockstep game steps its state every
+// tick, to measure sim throughput rather than single operations:
+//
+//   cargo bench --bench particles -- [--n N] [--ticks TICKS] [--threads THREADS] [--seed SEED]
+//
+// N discs of diameter 1 start at random positions and velocities in a square box
+// with room for about 2N of them, and bounce off the walls and each other
+// elastically, so every tick does about as much work as the last. Each tick moves
+// the discs, finds the pairs that overlap through a grid of unit cells, and moves
+// each disc of a pair half of their overlap apart and reflects its share of their
+// closing velocity. Each disc averages the responses of its contacts, summed in
+// the order the grid lists them, from the state before any is applied, so the
+// result doesn't depend on how the discs are split between threads.
+//
+// The state is in SoA dfloat buffers, and every arithmetic operation on it goes
+// through the library, in one of three ways: one scalar export call per element
+// and operation, as a C# caller without the batched API would; the batched
+// kernels; and the batched kernels with the discs split between threads, one per
+// core by default. Comparisons, and truncating positions to grid cells, are exact
+// on every platform and done natively.
+//
+// Each run prints its ticks per second and the hash of the final state. Every
+// run, with either backend, must end with the same hash, and for the same N,
+// ticks and seed the hash is the same on every platform, so the benchmark exits
+// with an error if the runs disagree, and its output can be compared between
+// machines as a determinism check.
+use std::env;
+use std::process;
+use std::sync::Barrier;
+use std::thread;
+use std::time::Instant;
+use unity_rust::arith::{dfloat_set_backend, BACKEND_HARDWARE, BACKEND_SOFT};
+use unity_rust::batch::*;
+use unity_rust::dmath::{float_sqrt, float_sqrt_batch};
+use unity_rust::hash::{hash_floats, HASH_CANONICAL_NANS};
+use unity_rust::random::{dfloat_random_fill_range, Random};
+use unity_rust::{float_add, float_div, float_mul, float_sub};
+
+const N: usize = 4096;
+const TICKS: usize = 512;
+const SEED: u64 = 0x9e37_79b9_7f4a_7c15;
+
+// The diameter of a disc is 1, the size of a grid cell, so a disc can only
+// overlap discs in its own and the eight neighbouring cells.
+const DIAMETER: f32 = 1.0;
+const RADIUS: f32 = 0.5;
+const DT: f32 = 1.0 / 64.0;
+const SPEED: f32 = 4.0;
+const NEGATIVE_ZERO: u32 = 0x8000_0000;
+
+type Binary = unsafe extern "C" fn(*const u32, *const u32, *mut u32, usize);
+type Unary = unsafe extern "C" fn(*const u32, *mut u32, usize);
+
+struct Kernels {
+	add: Binary,
+	sub: Binary,
+	mul: Binary,
+	div: Binary,
+	sqrt: Unary,
+}
+
+macro_rules! scalar_binary {
+	($name:ident, $op:ident) => {
+		unsafe extern "C" fn $name(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+			for i in 0..len {
+				*out.add(i) = $op(*a.add(i), *b.add(i));
+			}
+		}
+	};
+}
+
+scalar_binary!(scalar_add, float_add);
+scalar_binary!(scalar_sub, float_sub);
+scalar_binary!(scalar_mul, float_mul);
+scalar_binary!(scalar_div, float_div);
+
+unsafe extern "C" fn scalar_sqrt(x: *const u32, out: *mut u32, len: usize) {
+	for i in 0..len {
+		*out.add(i) = float_sqrt(*x.add(i));
+	}
+}
+
+const SCALAR: Kernels = Kernels { add: scalar_add, sub: scalar_sub, mul: scalar_mul, div: scalar_div, sqrt: scalar_sqrt };
+const BATCHED: Kernels = Kernels { add: float_add_batch, sub: float_sub_batch, mul: float_mul_batch, div: float_div_batch, sqrt: float_sqrt_batch };
+
+struct World {
+	n: usize,
+	// Grid cells per side of the box, which is as many units wide.
+	side: usize,
+	x: Vec<u32>,
+	y: Vec<u32>,
+	vx: Vec<u32>,
+	vy: Vec<u32>,
+	// The grid cell of each disc, the discs sorted by cell and then index, and the
+	// index in order of the first disc of each cell, with one more for the end.
+	cell: Vec<u32>,
+	order: Vec<u32>,
+	start: Vec<u32>,
+	// The summed contact responses of each disc: n velocity changes in x, then in
+	// y, then n position changes in x, then in y.
+	response: Vec<u32>,
+}
+
+// Pointers to a world's buffers, shared between the threads of a run. Each phase
+// writes only the elements of the discs in its range, apart from sort, which one
+// thread runs while the others wait.
+#[derive(Clone, Copy)]
+struct Buffers {
+	n: usize,
+	side: usize,
+	x: *mut u32,
+	y: *mut u32,
+	vx: *mut u32,
+	vy: *mut u32,
+	cell: *mut u32,
+	order: *mut u32,
+	start: *mut u32,
+	response: *mut u32,
+}
+
+unsafe impl Send for Buffers {}
+unsafe impl Sync for Buffers {}
+
+impl World {
+	fn new(n: usize, seed: u64) -> World {
+		let side = ((2 * n) as f64).sqrt().ceil().max(2.0) as usize;
+		let mut random = Random::new(seed);
+		let mut fill = |min: f32, max: f32| {
+			let mut x = vec![0; n];
+			unsafe { dfloat_random_fill_range(&mut random, x.as_mut_ptr(), n, min.to_bits(), max.to_bits()) };
+			x
+		};
+
+		let far = side as f32 - RADIUS;
+		let (x, y, vx, vy) = (fill(RADIUS, far), fill(RADIUS, far), fill(-SPEED, SPEED), fill(-SPEED, SPEED));
+
+		return World { n, side, x, y, vx, vy, cell: vec![0; n], order: vec![0; n], start: vec![0; side * side + 1], response: vec![0; 4 * n] };
+	}
+
+	fn buffers(&mut self) -> Buffers {
+		return Buffers {
+			n: self.n,
+			side: self.side,
+			x: self.x.as_mut_ptr(),
+			y: self.y.as_mut_ptr(),
+			vx: self.vx.as_mut_ptr(),
+			vy: self.vy.as_mut_ptr(),
+			cell: self.cell.as_mut_ptr(),
+			order: self.order.as_mut_ptr(),
+			start: self.start.as_mut_ptr(),
+			response: self.response.as_mut_ptr(),
+		};
+	}
+
+	fn hash(&self) -> u64 {
+		let mut hash = 0;
+
+		for buffer in &[&self.x, &self.y, &self.vx, &self.vy] {
+			hash = hash_floats(buffer, HASH_CANONICAL_NANS, hash);
+		}
+
+		return hash;
+	}
+}
+
+// Per-thread temporaries, kept between ticks.
+#[derive(Default)]
+struct Scratch {
+	// The candidate pairs (i, j) and then the contacts of the thread's discs, in
+	// order of i.
+	pairs: Vec<(u32, u32)>,
+	contacts: Vec<(u32, u32)>,
+	a: Vec<u32>,
+	b: Vec<u32>,
+	c: Vec<u32>,
+	d: Vec<u32>,
+	e: Vec<u32>,
+	f: Vec<u32>,
+	// Operands that are the same for every element.
+	dt: Vec<u32>,
+	bounce: Vec<u32>,
+	half: Vec<u32>,
+	diameter: Vec<u32>,
+}
+
+fn grow(buffer: &mut Vec<u32>, len: usize) -> *mut u32 {
+	if buffer.len() < len {
+		buffer.resize(len, 0);
+	}
+
+	return buffer.as_mut_ptr();
+}
+
+fn splat(buffer: &mut Vec<u32>, value: f32, len: usize) -> *const u32 {
+	if buffer.len() < len {
+		buffer.resize(len, value.to_bits());
+	}
+
+	return buffer.as_ptr();
+}
+
+// Puts a disc past a wall at p back against it, and reverses its velocity v into
+// the wall, already negated in bounced.
+fn wall(p: &mut u32, v: &mut u32, bounced: u32, far: f32) {
+	let (position, velocity) = (f32::from_bits(*p), f32::from_bits(*v));
+
+	if position < RADIUS {
+		*p = RADIUS.to_bits();
+
+		if velocity < 0.0 {
+			*v = bounced;
+		}
+	} else if position > far {
+		*p = far.to_bits();
+
+		if velocity > 0.0 {
+			*v = bounced;
+		}
+	}
+}
+
+// Motion and walls for discs lo..hi, and their grid cells.
+unsafe fn integrate(w: Buffers, k: &Kernels, s: &mut Scratch, lo: usize, hi: usize) {
+	let len = hi - lo;
+	let (x, y, vx, vy) = (w.x.add(lo), w.y.add(lo), w.vx.add(lo), w.vy.add(lo));
+	let (dt, bounce) = (splat(&mut s.dt, DT, len), splat(&mut s.bounce, -1.0, len));
+	let (a, b) = (grow(&mut s.a, len), grow(&mut s.b, len));
+
+	(k.mul)(vx, dt, a, len);
+	(k.add)(x, a, x, len);
+	(k.mul)(vy, dt, a, len);
+	(k.add)(y, a, y, len);
+
+	(k.mul)(vx, bounce, a, len);
+	(k.mul)(vy, bounce, b, len);
+
+	let far = w.side as f32 - RADIUS;
+
+	for i in 0..len {
+		wall(&mut *x.add(i), &mut *vx.add(i), *a.add(i), far);
+		wall(&mut *y.add(i), &mut *vy.add(i), *b.add(i), far);
+
+		// Truncation saturates, so a disc pushed past a wall is in the cell beside it.
+		let cx = (f32::from_bits(*x.add(i)) as usize).min(w.side - 1);
+		let cy = (f32::from_bits(*y.add(i)) as usize).min(w.side - 1);
+		*w.cell.add(lo + i) = (cy * w.side + cx) as u32;
+	}
+}
+
+// A counting sort of the discs by cell, stable so each cell lists its discs in
+// index order.
+unsafe fn sort(w: Buffers) {
+	let cells = w.side * w.side;
+	let start = std::slice::from_raw_parts_mut(w.start, cells + 1);
+	let cell = std::slice::from_raw_parts(w.cell, w.n);
+	let order = std::slice::from_raw_parts_mut(w.order, w.n);
+
+	start.iter_mut().for_each(|s| *s = 0);
+
+	for &c in cell {
+		start[c as usize + 1] += 1;
+	}
+
+	for c in 0..cells {
+		start[c + 1] += start[c];
+	}
+
+	// Fills each cell from its end, counting its start back down to where it was.
+	for i in (0..w.n).rev() {
+		let c = cell[i] as usize;
+		start[c + 1] -= 1;
+		order[start[c + 1] as usize] = i as u32;
+	}
+
+	// start[c + 1] now holds the start of c, so shift everything down by one.
+	start.copy_within(1..cells + 1, 0);
+	start[cells] = w.n as u32;
+}
+
+// Finds the contacts of discs lo..hi and sums their responses, reading the state
+// of any disc but writing only the responses of lo..hi.
+unsafe fn contacts(w: Buffers, k: &Kernels, s: &mut Scratch, lo: usize, hi: usize) {
+	let side = w.side;
+
+	s.pairs.clear();
+
+	for i in lo..hi {
+		let c = *w.cell.add(i) as usize;
+		let (cx, cy) = (c % side, c / side);
+
+		for ny in cy.saturating_sub(1)..(cy + 2).min(side) {
+			for nx in cx.saturating_sub(1)..(cx + 2).min(side) {
+				let n = ny * side + nx;
+
+				for o in *w.start.add(n)..*w.start.add(n + 1) {
+					let j = *w.order.add(o as usize);
+
+					if j as usize != i {
+						s.pairs.push((i as u32, j));
+					}
+				}
+			}
+		}
+	}
+
+	// The offset from i to j and its squared length, for every candidate pair.
+	let m = s.pairs.len();
+	let (a, b, dx, dy, d2, t) = (grow(&mut s.a, m), grow(&mut s.b, m), grow(&mut s.c, m), grow(&mut s.d, m), grow(&mut s.e, m), grow(&mut s.f, m));
+
+	let offsets = |p: *const u32, out: *mut u32| {
+		for (q, &(i, j)) in s.pairs.iter().enumerate() {
+			*a.add(q) = *p.add(j as usize);
+			*b.add(q) = *p.add(i as usize);
+		}
+
+		(k.sub)(a, b, out, m);
+	};
+
+	offsets(w.x, dx);
+	offsets(w.y, dy);
+	(k.mul)(dx, dx, d2, m);
+	(k.mul)(dy, dy, t, m);
+	(k.add)(d2, t, d2, m);
+
+	// Keeps the overlapping pairs, compacted in place. Discs exactly on top of each
+	// other have no normal to separate along and are left alone.
+	s.contacts.clear();
+
+	for q in 0..m {
+		let distance2 = f32::from_bits(*d2.add(q));
+
+		if distance2 > 0.0 && distance2 < DIAMETER * DIAMETER {
+			let r = s.contacts.len();
+			*dx.add(r) = *dx.add(q);
+			*dy.add(r) = *dy.add(q);
+			*d2.add(r) = *d2.add(q);
+			s.contacts.push(s.pairs[q]);
+		}
+	}
+
+	let m = s.contacts.len();
+	let (half, diameter) = (splat(&mut s.half, 0.5, m), splat(&mut s.diameter, DIAMETER, m));
+	// Each response is m elements, in the order of response.
+	let responses = grow(&mut s.f, 4 * m);
+	let (dvx, dvy, px, py) = (responses, responses.add(m), responses.add(2 * m), responses.add(3 * m));
+
+	// The unit normal from i to j, in dx and dy, and the distance, in d2.
+	(k.sqrt)(d2, d2, m);
+	(k.div)(dx, d2, dx, m);
+	(k.div)(dy, d2, dy, m);
+
+	// The closing velocity along the normal, negative when the discs approach, and
+	// zero when they separate, which leaves their velocities alone. Each disc of
+	// an elastic pair of equal masses takes half of twice that.
+	let relative = |p: *const u32, out: *mut u32| {
+		for (q, &(i, j)) in s.contacts.iter().enumerate() {
+			*a.add(q) = *p.add(j as usize);
+			*b.add(q) = *p.add(i as usize);
+		}
+
+		(k.sub)(a, b, out, m);
+	};
+
+	relative(w.vx, dvx);
+	relative(w.vy, dvy);
+	(k.mul)(dvx, dx, a, m);
+	(k.mul)(dvy, dy, b, m);
+	(k.add)(a, b, a, m);
+
+	for q in 0..m {
+		if f32::from_bits(*a.add(q)) > 0.0 {
+			*a.add(q) = 0;
+		}
+	}
+
+	(k.mul)(dx, a, dvx, m);
+	(k.mul)(dy, a, dvy, m);
+
+	// Half the overlap, negative, along the normal moves i away from j.
+	(k.sub)(d2, diameter, b, m);
+	(k.mul)(b, half, b, m);
+	(k.mul)(dx, b, px, m);
+	(k.mul)(dy, b, py, m);
+
+	// Sums each disc's responses in contact order, one contact of every disc per
+	// round, from -0, which leaves the first response as it is.
+	for r in 0..4 {
+		for i in lo..hi {
+			*w.response.add(r * w.n + i) = NEGATIVE_ZERO;
+		}
+	}
+
+	let mut first = 0;
+	let mut runs = Vec::new();
+
+	while first < m {
+		let i = s.contacts[first].0;
+		let count = s.contacts[first..].iter().take_while(|c| c.0 == i).count();
+		runs.push((i as usize, first, count));
+		first += count;
+	}
+
+	// Averages each disc's responses, as their sum overshoots when a disc is pushed
+	// from several sides at once.
+	let counts = grow(&mut s.e, hi - lo);
+
+	for i in lo..hi {
+		*counts.add(i - lo) = 1.0f32.to_bits();
+	}
+
+	for &(i, _, count) in &runs {
+		*counts.add(i - lo) = (count as f32).to_bits();
+	}
+
+	for round in 0.. {
+		let current: Vec<(usize, usize)> = runs.iter().filter(|r| r.2 > round).map(|r| (r.0, r.1 + round)).collect();
+		let len = current.len();
+
+		if len == 0 {
+			break;
+		}
+
+		let (a, b) = (grow(&mut s.a, 4 * len), grow(&mut s.b, 4 * len));
+
+		for r in 0..4 {
+			for (q, &(i, c)) in current.iter().enumerate() {
+				*a.add(r * len + q) = *w.response.add(r * w.n + i);
+				*b.add(r * len + q) = *responses.add(r * m + c);
+			}
+		}
+
+		(k.add)(a, b, a, 4 * len);
+
+		for r in 0..4 {
+			for (q, &(i, _)) in current.iter().enumerate() {
+				*w.response.add(r * w.n + i) = *a.add(r * len + q);
+			}
+		}
+	}
+
+	for r in 0..4 {
+		let response = w.response.add(r * w.n + lo);
+		(k.div)(response, counts, response, hi - lo);
+	}
+}
+
+// Applies the summed responses of discs lo..hi.
+unsafe fn apply(w: Buffers, k: &Kernels, lo: usize, hi: usize) {
+	let len = hi - lo;
+
+	for (r, p) in [w.vx, w.vy, w.x, w.y].iter().enumerate() {
+		(k.add)(p.add(lo), w.response.add(r * w.n + lo), p.add(lo), len);
+	}
+}
+
+// Steps the world on threads threads, or on the calling thread if 1, and returns
+// the elapsed seconds.
+fn run(world: &mut World, k: &Kernels, ticks: usize, threads: usize) -> f64 {
+	let w = world.buffers();
+	let start = Instant::now();
+
+	if threads == 1 {
+		let mut s = Scratch::default();
+
+		for _ in 0..ticks {
+			unsafe {
+				integrate(w, k, &mut s, 0, w.n);
+				sort(w);
+				contacts(w, k, &mut s, 0, w.n);
+				apply(w, k, 0, w.n);
+			}
+		}
+	} else {
+		let barrier = Barrier::new(threads);
+
+		let step = |t: usize| {
+			let (lo, hi) = (t * w.n / threads, (t + 1) * w.n / threads);
+			let mut s = Scratch::default();
+
+			for _ in 0..ticks {
+				unsafe {
+					integrate(w, k, &mut s, lo, hi);
+					barrier.wait();
+
+					if t == 0 {
+						sort(w);
+					}
+
+					barrier.wait();
+					contacts(w, k, &mut s, lo, hi);
+					barrier.wait();
+					apply(w, k, lo, hi);
+				}
+			}
+		};
+
+		thread::scope(|scope| {
+			for t in 1..threads {
+				let step = &step;
+				scope.spawn(move || step(t));
+			}
+
+			step(0);
+		});
+	}
+
+	return start.elapsed().as_secs_f64();
+}
+
+fn main() {
+	let (mut n, mut ticks, mut threads, mut seed) = (N, TICKS, 0, SEED);
+	let mut args = env::args().skip(1);
+
+	while let Some(arg) = args.next() {
+		let mut value = || args.next().and_then(|v| v.parse::<u64>().ok()).unwrap_or_else(|| panic!("{} needs a number", arg));
+
+		match arg.as_str() {
+			// Passed by cargo bench.
+			"--bench" => {}
+			"--n" => n = value() as usize,
+			"--ticks" => ticks = value() as usize,
+			"--threads" => threads = value() as usize,
+			"--seed" => seed = value(),
+			_ => panic!("unknown option {}", arg),
+		}
+	}
+
+	if threads == 0 {
+		threads = thread::available_parallelism().map_or(1, |t| t.get());
+	}
+
+	threads = threads.clamp(1, n.max(1));
+
+	println!("{} discs, {} ticks, seed {:#x}", n, ticks, seed);
+
+	let threaded = format!("batched, {} thread{}", threads, if threads == 1 { "" } else { "s" });
+	let mut expected = None;
+	let mut agree = true;
+
+	for &(backend, backend_name) in &[(BACKEND_HARDWARE, "hardware"), (BACKEND_SOFT, "soft")] {
+		dfloat_set_backend(backend);
+
+		for &(name, k, threads) in &[("scalar calls", &SCALAR, 1), ("batched", &BATCHED, 1), (threaded.as_str(), &BATCHED, threads)] {
+			let mut world = World::new(n, seed);
+			let seconds = run(&mut world, k, ticks, threads);
+			let hash = world.hash();
+
+			println!("{:<40} {:>10.1} ticks/s   hash {:016x}", format!("{} {}", backend_name, name), ticks as f64 / seconds, hash);
+
+			agree &= *expected.get_or_insert(hash) == hash;
+		}
+	}
+
+	dfloat_set_backend(BACKEND_HARDWARE);
+
+	if !agree {
+		println!("The runs ended with different states.");
+		process::exit(1);
+	}
+}
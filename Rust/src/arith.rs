@@ -0,0 +1,748 @@
+use crate::convert::{self, ROUND_FLOOR, ROUND_HALF_EVEN, ROUND_TRUNCATE};
+use crate::{from_bits, soft, soft64, to_bits};
+use std::marker::PhantomData;
+use std::ops::{Add, Div, Mul, Neg, Sub};
+use std::sync::atomic::{AtomicU32, Ordering};
+
+// The basic operations on dfloat bit patterns. Kernels are generic over this trait
+// and monomorphized per backend, so selecting a backend costs one branch per call
+// rather than one per element.
+pub trait Arith {
+	// The same arithmetic without canonicalizing NaNs, for the intermediate results
+	// of longer computations. A NaN operand always gives a NaN result, so
+	// canonicalizing only the final result gives the same bits as canonicalizing
+	// every operation.
+	type Uncanonical: Arith;
+
+	fn add(a: u32, b: u32) -> u32;
+	fn sub(a: u32, b: u32) -> u32;
+	fn mul(a: u32, b: u32) -> u32;
+	fn div(a: u32, b: u32) -> u32;
+
+	// The same on binary64 bit patterns, for ddouble.
+	fn add64(a: u64, b: u64) -> u64;
+	fn sub64(a: u64, b: u64) -> u64;
+	fn mul64(a: u64, b: u64) -> u64;
+	fn div64(a: u64, b: u64) -> u64;
+
+	// N operations at once. Must give the same bits as the scalar versions.
+	#[inline(always)]
+	fn add_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return lanes(a, b, Self::add);
+	}
+
+	#[inline(always)]
+	fn sub_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return lanes(a, b, Self::sub);
+	}
+
+	#[inline(always)]
+	fn mul_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return lanes(a, b, Self::mul);
+	}
+
+	#[inline(always)]
+	fn div_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return lanes(a, b, Self::div);
+	}
+
+	// x as the operations read it: unchanged, unless denormals are flushed.
+	#[inline(always)]
+	fn flush(x: u32) -> u32 {
+		return x;
+	}
+
+	// x as the operations return it: unchanged, unless NaNs are canonicalized.
+	#[inline(always)]
+	fn canonical(x: u32) -> u32 {
+		return x;
+	}
+
+	#[inline(always)]
+	fn canonical_lanes<const N: usize>(x: [u32; N]) -> [u32; N] {
+		return x;
+	}
+
+	// Conversions to and from integers, rounding with one of the convert::ROUND_*
+	// modes. convert.rs defines the results, and its integer-only versions are the
+	// default.
+	#[inline(always)]
+	fn to_i32<const MODE: u32>(x: u32) -> i32 {
+		return convert::to_i32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn to_u32<const MODE: u32>(x: u32) -> u32 {
+		return convert::to_u32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn to_i64<const MODE: u32>(x: u32) -> i64 {
+		return convert::to_i64::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn from_i32<const MODE: u32>(x: i32) -> u32 {
+		return convert::from_i32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn from_u32<const MODE: u32>(x: u32) -> u32 {
+		return convert::from_u32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn from_i64<const MODE: u32>(x: i64) -> u32 {
+		return convert::from_i64::<MODE>(x);
+	}
+}
+
+#[inline(always)]
+pub fn lanes<T: Copy + Default, const N: usize, F: Fn(T, T) -> T>(a: [T; N], b: [T; N], op: F) -> [T; N] {
+	let mut r = [T::default(); N];
+
+	for l in 0..N {
+		r[l] = op(a[l], b[l]);
+	}
+
+	return r;
+}
+
+// The FPU's f32 arithmetic.
+pub struct Hardware;
+
+// Integer-only arithmetic from soft.rs.
+pub struct Soft;
+
+// A's arithmetic with denormals flushed to zero, defined in software rather than
+// by the FPU's flush modes, which differ between platforms (x86 checks for a tiny
+// result after rounding, ARM before, and ARMv7 NEON always flushes). Denormal
+// inputs are read as zero of the same sign, the operation is rounded as usual,
+// and a denormal result is replaced by zero of the same sign. The FPU is never
+// given a denormal input, which is what makes denormals slow on x86.
+pub struct FlushDenormals<A>(PhantomData<A>);
+
+// A's arithmetic with every NaN result replaced by DEFAULT_NAN. Which NaN operand
+// an operation returns depends on the platform's propagation rules and on the
+// order the compiler puts commutative operands in, so NaN payloads are the one
+// part of a result that can differ between runs. With this, results can be
+// compared and hashed bit for bit.
+pub struct CanonicalNaNs<A>(PhantomData<A>);
+
+// A's arithmetic as it is, so with_backend! can name both NaN modes the same way.
+pub type PreserveNaNs<A> = A;
+
+impl Arith for Hardware {
+	type Uncanonical = Self;
+
+	#[inline(always)]
+	fn add(a: u32, b: u32) -> u32 {
+		return unsafe { to_bits(from_bits(a) + from_bits(b)) };
+	}
+
+	#[inline(always)]
+	fn sub(a: u32, b: u32) -> u32 {
+		return unsafe { to_bits(from_bits(a) - from_bits(b)) };
+	}
+
+	#[inline(always)]
+	fn mul(a: u32, b: u32) -> u32 {
+		return unsafe { to_bits(from_bits(a) * from_bits(b)) };
+	}
+
+	#[inline(always)]
+	fn div(a: u32, b: u32) -> u32 {
+		return unsafe { to_bits(from_bits(a) / from_bits(b)) };
+	}
+
+	#[inline(always)]
+	fn add64(a: u64, b: u64) -> u64 {
+		return (f64::from_bits(a) + f64::from_bits(b)).to_bits();
+	}
+
+	#[inline(always)]
+	fn sub64(a: u64, b: u64) -> u64 {
+		return (f64::from_bits(a) - f64::from_bits(b)).to_bits();
+	}
+
+	#[inline(always)]
+	fn mul64(a: u64, b: u64) -> u64 {
+		return (f64::from_bits(a) * f64::from_bits(b)).to_bits();
+	}
+
+	#[inline(always)]
+	fn div64(a: u64, b: u64) -> u64 {
+		return (f64::from_bits(a) / f64::from_bits(b)).to_bits();
+	}
+
+	// Rust defines float to integer casts as truncating and saturating with NaN
+	// giving 0, and integer to float casts as rounding to nearest even, which is
+	// what convert.rs specifies.
+	#[inline(always)]
+	fn to_i32<const MODE: u32>(x: u32) -> i32 {
+		let f = hardware_round::<MODE>(x);
+
+		// The same as f as i32, in a form LLVM vectorizes: clamping first makes the
+		// unchecked conversion defined, and the clamp's upper bound is the largest
+		// float below 2^31.
+		let i = unsafe { f.max(-2147483648.0).min(2147483520.0).to_int_unchecked::<i32>() };
+		return if f >= 2147483648.0 { i32::MAX } else if f != f { 0 } else { i };
+	}
+
+	#[inline(always)]
+	fn to_u32<const MODE: u32>(x: u32) -> u32 {
+		return hardware_round::<MODE>(x) as u32;
+	}
+
+	#[inline(always)]
+	fn to_i64<const MODE: u32>(x: u32) -> i64 {
+		return hardware_round::<MODE>(x) as i64;
+	}
+
+	#[inline(always)]
+	fn from_i32<const MODE: u32>(x: i32) -> u32 {
+		return if MODE == ROUND_HALF_EVEN { unsafe { to_bits(x as f32) } } else { convert::from_i32::<MODE>(x) };
+	}
+
+	#[inline(always)]
+	fn from_u32<const MODE: u32>(x: u32) -> u32 {
+		return if MODE == ROUND_HALF_EVEN { unsafe { to_bits(x as f32) } } else { convert::from_u32::<MODE>(x) };
+	}
+
+	#[inline(always)]
+	fn from_i64<const MODE: u32>(x: i64) -> u32 {
+		return if MODE == ROUND_HALF_EVEN { unsafe { to_bits(x as f32) } } else { convert::from_i64::<MODE>(x) };
+	}
+}
+
+// x rounded to an integer in MODE, except that truncation is left to the
+// conversion. Magnitudes below 2^23 are rounded to nearest even by adding and
+// subtracting 2^23, where the spacing of floats is 1; larger ones are integers
+// already. This avoids the library calls f32::round_ties_even and f32::floor
+// become without SSE4.1.
+#[inline(always)]
+fn hardware_round<const MODE: u32>(x: u32) -> f32 {
+	let f = unsafe { from_bits(x) };
+
+	if MODE == ROUND_TRUNCATE {
+		return f;
+	}
+
+	let magnitude = f.abs();
+	let even = if magnitude < 8388608.0 { (magnitude + 8388608.0) - 8388608.0 } else { magnitude }.copysign(f);
+
+	return if MODE == ROUND_FLOOR && even > f { even - 1.0 } else { even };
+}
+
+impl Arith for Soft {
+	type Uncanonical = Self;
+
+	#[inline(always)]
+	fn add(a: u32, b: u32) -> u32 {
+		return soft::add(a, b);
+	}
+
+	#[inline(always)]
+	fn sub(a: u32, b: u32) -> u32 {
+		return soft::sub(a, b);
+	}
+
+	#[inline(always)]
+	fn mul(a: u32, b: u32) -> u32 {
+		return soft::mul(a, b);
+	}
+
+	#[inline(always)]
+	fn div(a: u32, b: u32) -> u32 {
+		return soft::div(a, b);
+	}
+
+	#[inline(always)]
+	fn add64(a: u64, b: u64) -> u64 {
+		return soft64::add(a, b);
+	}
+
+	#[inline(always)]
+	fn sub64(a: u64, b: u64) -> u64 {
+		return soft64::sub(a, b);
+	}
+
+	#[inline(always)]
+	fn mul64(a: u64, b: u64) -> u64 {
+		return soft64::mul(a, b);
+	}
+
+	#[inline(always)]
+	fn div64(a: u64, b: u64) -> u64 {
+		return soft64::div(a, b);
+	}
+
+	#[inline(always)]
+	fn add_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return soft::add_lanes(a, b);
+	}
+
+	#[inline(always)]
+	fn sub_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return soft::sub_lanes(a, b);
+	}
+
+	#[inline(always)]
+	fn mul_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return soft::mul_lanes(a, b);
+	}
+}
+
+// Emits nothing, but LLVM cannot vectorize a loop containing it. The block loops
+// in batch.rs are already vectorized by their lanes, and with the flushing masks
+// LLVM otherwise vectorizes them a second time across blocks, transposing every
+// block in and out at several times the cost of the arithmetic.
+#[inline(always)]
+fn keep_blocks() {
+	#[cfg(any(target_arch = "x86", target_arch = "x86_64", target_arch = "aarch64"))]
+	unsafe {
+		std::arch::asm!("", options(nomem, nostack, preserves_flags));
+	}
+}
+
+#[inline(always)]
+fn flush_lanes<const N: usize>(x: [u32; N]) -> [u32; N] {
+	let mut r = [0; N];
+
+	// All ones unless the exponent is zero, then masking off all but the sign.
+	for l in 0..N {
+		let normal = !(((x[l] & soft::EXP_MASK).wrapping_sub(1) as i32 >> 31) as u32);
+		r[l] = x[l] & (normal | soft::SIGN);
+	}
+
+	keep_blocks();
+
+	return r;
+}
+
+// DEFAULT_NAN where x is a NaN, selected with a mask so it stays vectorized.
+#[inline(always)]
+fn canonical_lanes<const N: usize>(x: [u32; N]) -> [u32; N] {
+	let mut r = [0; N];
+
+	// All ones if the magnitude is above infinity.
+	for l in 0..N {
+		let nan = ((soft::INFINITY as i32).wrapping_sub((x[l] & !soft::SIGN) as i32) >> 31) as u32;
+		r[l] = (x[l] & !nan) | (soft::DEFAULT_NAN & nan);
+	}
+
+	keep_blocks();
+
+	return r;
+}
+
+impl<A: Arith> Arith for FlushDenormals<A> {
+	type Uncanonical = FlushDenormals<A::Uncanonical>;
+
+	#[inline(always)]
+	fn add(a: u32, b: u32) -> u32 {
+		return soft::flush(A::add(soft::flush(a), soft::flush(b)));
+	}
+
+	#[inline(always)]
+	fn sub(a: u32, b: u32) -> u32 {
+		return soft::flush(A::sub(soft::flush(a), soft::flush(b)));
+	}
+
+	#[inline(always)]
+	fn mul(a: u32, b: u32) -> u32 {
+		return soft::flush(A::mul(soft::flush(a), soft::flush(b)));
+	}
+
+	#[inline(always)]
+	fn div(a: u32, b: u32) -> u32 {
+		return soft::flush(A::div(soft::flush(a), soft::flush(b)));
+	}
+
+	#[inline(always)]
+	fn add64(a: u64, b: u64) -> u64 {
+		return soft64::flush(A::add64(soft64::flush(a), soft64::flush(b)));
+	}
+
+	#[inline(always)]
+	fn sub64(a: u64, b: u64) -> u64 {
+		return soft64::flush(A::sub64(soft64::flush(a), soft64::flush(b)));
+	}
+
+	#[inline(always)]
+	fn mul64(a: u64, b: u64) -> u64 {
+		return soft64::flush(A::mul64(soft64::flush(a), soft64::flush(b)));
+	}
+
+	#[inline(always)]
+	fn div64(a: u64, b: u64) -> u64 {
+		return soft64::flush(A::div64(soft64::flush(a), soft64::flush(b)));
+	}
+
+	#[inline(always)]
+	fn add_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return flush_lanes(A::add_lanes(flush_lanes(a), flush_lanes(b)));
+	}
+
+	#[inline(always)]
+	fn sub_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return flush_lanes(A::sub_lanes(flush_lanes(a), flush_lanes(b)));
+	}
+
+	#[inline(always)]
+	fn mul_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return flush_lanes(A::mul_lanes(flush_lanes(a), flush_lanes(b)));
+	}
+
+	#[inline(always)]
+	fn div_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return flush_lanes(A::div_lanes(flush_lanes(a), flush_lanes(b)));
+	}
+
+	#[inline(always)]
+	fn flush(x: u32) -> u32 {
+		return soft::flush(x);
+	}
+
+	// Integers never convert to denormals.
+	#[inline(always)]
+	fn to_i32<const MODE: u32>(x: u32) -> i32 {
+		return A::to_i32::<MODE>(soft::flush(x));
+	}
+
+	#[inline(always)]
+	fn to_u32<const MODE: u32>(x: u32) -> u32 {
+		return A::to_u32::<MODE>(soft::flush(x));
+	}
+
+	#[inline(always)]
+	fn to_i64<const MODE: u32>(x: u32) -> i64 {
+		return A::to_i64::<MODE>(soft::flush(x));
+	}
+
+	#[inline(always)]
+	fn from_i32<const MODE: u32>(x: i32) -> u32 {
+		return A::from_i32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn from_u32<const MODE: u32>(x: u32) -> u32 {
+		return A::from_u32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn from_i64<const MODE: u32>(x: i64) -> u32 {
+		return A::from_i64::<MODE>(x);
+	}
+}
+
+impl<A: Arith> Arith for CanonicalNaNs<A> {
+	type Uncanonical = A::Uncanonical;
+
+	#[inline(always)]
+	fn add(a: u32, b: u32) -> u32 {
+		return soft::canonical(A::add(a, b));
+	}
+
+	#[inline(always)]
+	fn sub(a: u32, b: u32) -> u32 {
+		return soft::canonical(A::sub(a, b));
+	}
+
+	#[inline(always)]
+	fn mul(a: u32, b: u32) -> u32 {
+		return soft::canonical(A::mul(a, b));
+	}
+
+	#[inline(always)]
+	fn div(a: u32, b: u32) -> u32 {
+		return soft::canonical(A::div(a, b));
+	}
+
+	#[inline(always)]
+	fn add64(a: u64, b: u64) -> u64 {
+		return soft64::canonical(A::add64(a, b));
+	}
+
+	#[inline(always)]
+	fn sub64(a: u64, b: u64) -> u64 {
+		return soft64::canonical(A::sub64(a, b));
+	}
+
+	#[inline(always)]
+	fn mul64(a: u64, b: u64) -> u64 {
+		return soft64::canonical(A::mul64(a, b));
+	}
+
+	#[inline(always)]
+	fn div64(a: u64, b: u64) -> u64 {
+		return soft64::canonical(A::div64(a, b));
+	}
+
+	#[inline(always)]
+	fn add_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return canonical_lanes(A::add_lanes(a, b));
+	}
+
+	#[inline(always)]
+	fn sub_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return canonical_lanes(A::sub_lanes(a, b));
+	}
+
+	#[inline(always)]
+	fn mul_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return canonical_lanes(A::mul_lanes(a, b));
+	}
+
+	#[inline(always)]
+	fn div_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+		return canonical_lanes(A::div_lanes(a, b));
+	}
+
+	#[inline(always)]
+	fn flush(x: u32) -> u32 {
+		return A::flush(x);
+	}
+
+	#[inline(always)]
+	fn canonical(x: u32) -> u32 {
+		return soft::canonical(x);
+	}
+
+	#[inline(always)]
+	fn canonical_lanes<const N: usize>(x: [u32; N]) -> [u32; N] {
+		return canonical_lanes(x);
+	}
+
+	// Integers are never NaN.
+	#[inline(always)]
+	fn to_i32<const MODE: u32>(x: u32) -> i32 {
+		return A::to_i32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn to_u32<const MODE: u32>(x: u32) -> u32 {
+		return A::to_u32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn to_i64<const MODE: u32>(x: u32) -> i64 {
+		return A::to_i64::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn from_i32<const MODE: u32>(x: i32) -> u32 {
+		return A::from_i32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn from_u32<const MODE: u32>(x: u32) -> u32 {
+		return A::from_u32::<MODE>(x);
+	}
+
+	#[inline(always)]
+	fn from_i64<const MODE: u32>(x: i64) -> u32 {
+		return A::from_i64::<MODE>(x);
+	}
+}
+
+pub const BACKEND_HARDWARE: u32 = 0;
+pub const BACKEND_SOFT: u32 = 1;
+
+pub const DENORMALS_PRESERVE: u32 = 0;
+pub const DENORMALS_FLUSH: u32 = 1;
+
+pub const NANS_PRESERVE: u32 = 0;
+pub const NANS_CANONICAL: u32 = 1;
+
+static BACKEND: AtomicU32 = AtomicU32::new(BACKEND_HARDWARE);
+static DENORMALS: AtomicU32 = AtomicU32::new(DENORMALS_PRESERVE);
+static NANS: AtomicU32 = AtomicU32::new(NANS_PRESERVE);
+
+#[inline(always)]
+pub fn backend() -> u32 {
+	return BACKEND.load(Ordering::Relaxed);
+}
+
+#[inline(always)]
+pub fn denormal_mode() -> u32 {
+	return DENORMALS.load(Ordering::Relaxed);
+}
+
+#[inline(always)]
+pub fn nan_mode() -> u32 {
+	return NANS.load(Ordering::Relaxed);
+}
+
+// Evaluates body with the type name A bound to the currently selected backend,
+// wrapped in FlushDenormals if denormals are flushed and in CanonicalNaNs if NaNs
+// are canonicalized, e.g. with_backend!(A => map2(a, b, out, len, A::add)).
+#[macro_export]
+macro_rules! with_backend {
+	($A:ident => $body:expr) => {
+		match $crate::arith::nan_mode() {
+			$crate::arith::NANS_CANONICAL => $crate::with_backend!(@modes $A, $crate::arith::CanonicalNaNs, $body),
+			_ => $crate::with_backend!(@modes $A, $crate::arith::PreserveNaNs, $body),
+		}
+	};
+	(@modes $A:ident, $($nans:ident)::+, $body:expr) => {
+		match ($crate::arith::backend(), $crate::arith::denormal_mode()) {
+			($crate::arith::BACKEND_SOFT, $crate::arith::DENORMALS_FLUSH) => {
+				type $A = $($nans)::+<$crate::arith::FlushDenormals<$crate::arith::Soft>>;
+				$body
+			}
+			($crate::arith::BACKEND_SOFT, _) => {
+				type $A = $($nans)::+<$crate::arith::Soft>;
+				$body
+			}
+			(_, $crate::arith::DENORMALS_FLUSH) => {
+				type $A = $($nans)::+<$crate::arith::FlushDenormals<$crate::arith::Hardware>>;
+				$body
+			}
+			_ => {
+				type $A = $($nans)::+<$crate::arith::Hardware>;
+				$body
+			}
+		}
+	};
+}
+
+// Selects the arithmetic used by every export in the library from now on, and
+// returns the previously selected backend. Unknown values are ignored.
+#[no_mangle]
+pub extern "C" fn dfloat_set_backend(backend: u32) -> u32 {
+	if backend != BACKEND_HARDWARE && backend != BACKEND_SOFT {
+		return self::backend();
+	}
+
+	return BACKEND.swap(backend, Ordering::Relaxed);
+}
+
+#[no_mangle]
+pub extern "C" fn dfloat_get_backend() -> u32 {
+	return backend();
+}
+
+// Selects whether every export from now on flushes denormals to zero
+// (DENORMALS_FLUSH) or handles them exactly (DENORMALS_PRESERVE), and returns the
+// previous mode. Unknown values are ignored.
+#[no_mangle]
+pub extern "C" fn dfloat_set_denormal_mode(mode: u32) -> u32 {
+	if mode != DENORMALS_PRESERVE && mode != DENORMALS_FLUSH {
+		return denormal_mode();
+	}
+
+	return DENORMALS.swap(mode, Ordering::Relaxed);
+}
+
+#[no_mangle]
+pub extern "C" fn dfloat_get_denormal_mode() -> u32 {
+	return denormal_mode();
+}
+
+// Selects whether every export from now on returns NaN results as the operations
+// produce them (NANS_PRESERVE) or replaces them all by DEFAULT_NAN
+// (NANS_CANONICAL), and returns the previous mode. Unknown values are ignored.
+#[no_mangle]
+pub extern "C" fn dfloat_set_nan_mode(mode: u32) -> u32 {
+	if mode != NANS_PRESERVE && mode != NANS_CANONICAL {
+		return nan_mode();
+	}
+
+	return NANS.swap(mode, Ordering::Relaxed);
+}
+
+#[no_mangle]
+pub extern "C" fn dfloat_get_nan_mode() -> u32 {
+	return nan_mode();
+}
+
+// A dfloat whose operators use backend A, so formulas can be written naturally.
+// Rust evaluates the operators in the order written and never fuses them, so
+// ((a * b) + c) is always two separately rounded operations.
+pub struct Float<A>(pub u32, PhantomData<A>);
+
+impl<A> Clone for Float<A> {
+	fn clone(&self) -> Self {
+		return *self;
+	}
+}
+
+impl<A> Copy for Float<A> {}
+
+impl<A: Arith> Float<A> {
+	#[inline(always)]
+	pub fn from_bits(bits: u32) -> Self {
+		return Float(bits, PhantomData);
+	}
+
+	// Constants are written as f32 literals, which the compiler parses exactly.
+	#[inline(always)]
+	pub fn c(value: f32) -> Self {
+		return Float(value.to_bits(), PhantomData);
+	}
+
+	#[inline(always)]
+	pub fn abs(self) -> Self {
+		return Float(self.0 & !soft::SIGN, PhantomData);
+	}
+
+	// Ordering of finite values and infinities, compared on the bits so it does
+	// not depend on how the FPU treats denormals. -0 equals +0.
+	#[inline(always)]
+	pub fn key(self) -> i32 {
+		let magnitude = (self.0 & !soft::SIGN) as i32;
+		return if self.0 & soft::SIGN != 0 { -magnitude } else { magnitude };
+	}
+
+	#[inline(always)]
+	pub fn lt(self, other: Self) -> bool {
+		return self.key() < other.key();
+	}
+}
+
+impl<A: Arith> Add for Float<A> {
+	type Output = Self;
+
+	#[inline(always)]
+	fn add(self, other: Self) -> Self {
+		return Float(A::add(self.0, other.0), PhantomData);
+	}
+}
+
+impl<A: Arith> Sub for Float<A> {
+	type Output = Self;
+
+	#[inline(always)]
+	fn sub(self, other: Self) -> Self {
+		return Float(A::sub(self.0, other.0), PhantomData);
+	}
+}
+
+impl<A: Arith> Mul for Float<A> {
+	type Output = Self;
+
+	#[inline(always)]
+	fn mul(self, other: Self) -> Self {
+		return Float(A::mul(self.0, other.0), PhantomData);
+	}
+}
+
+impl<A: Arith> Div for Float<A> {
+	type Output = Self;
+
+	#[inline(always)]
+	fn div(self, other: Self) -> Self {
+		return Float(A::div(self.0, other.0), PhantomData);
+	}
+}
+
+// Negation only flips the sign bit, as in IEEE-754.
+impl<A: Arith> Neg for Float<A> {
+	type Output = Self;
+
+	#[inline(always)]
+	fn neg(self) -> Self {
+		return Float(self.0 ^ soft::SIGN, PhantomData);
+	}
+}
@@ -0,0 +1,99 @@
+use crate::dispatch;
+use crate::trace;
+use crate::{float_add, float_div, float_mul, float_sub};
+use crate::LANES;
+
+// Applies op to each pair of elements of a and b, N elements at a time with
+// lanes_op and then one at a time for the remainder, writing the results to out.
+// out may be the same buffer as a or b, but must not partially overlap either.
+#[inline(always)]
+pub unsafe fn map2_blocks<T: Copy, const N: usize, L, F>(a: *const T, b: *const T, out: *mut T, len: usize, lanes_op: L, op: F)
+where
+	L: Fn([T; N], [T; N]) -> [T; N],
+	F: Fn(T, T) -> T,
+{
+	let mut i = 0;
+
+	while i + N <= len {
+		let x = (a.add(i) as *const [T; N]).read_unaligned();
+		let y = (b.add(i) as *const [T; N]).read_unaligned();
+		(out.add(i) as *mut [T; N]).write_unaligned(lanes_op(x, y));
+		i += N;
+	}
+
+	while i < len {
+		*out.add(i) = op(*a.add(i), *b.add(i));
+		i += 1;
+	}
+}
+
+#[inline(always)]
+pub unsafe fn map2<T: Copy, L, F>(a: *const T, b: *const T, out: *mut T, len: usize, lanes_op: L, op: F)
+where
+	L: Fn([T; LANES], [T; LANES]) -> [T; LANES],
+	F: Fn(T, T) -> T,
+{
+	map2_blocks::<T, LANES, L, F>(a, b, out, len, lanes_op, op);
+}
+
+// Applies op to each element of x, writing the results to out. out may be the
+// same buffer as x if T and U are the same size.
+#[inline(always)]
+pub unsafe fn map1<T: Copy, U: Copy + Default, F: Fn(T) -> U>(x: *const T, out: *mut U, len: usize, op: F) {
+	let mut i = 0;
+
+	while i + LANES <= len {
+		let v = (x.add(i) as *const [T; LANES]).read_unaligned();
+		let mut r = [U::default(); LANES];
+
+		for l in 0..LANES {
+			r[l] = op(v[l]);
+		}
+
+		(out.add(i) as *mut [U; LANES]).write_unaligned(r);
+		i += LANES;
+	}
+
+	while i < len {
+		*out.add(i) = op(*x.add(i));
+		i += 1;
+	}
+}
+
+// Run by the widest kernel variant the CPU supports, see dispatch.rs, or by the
+// scalar operations while tracing.
+#[no_mangle]
+pub unsafe extern "C" fn float_add_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each2(a, b, out, len, |a, b| float_add(a, b));
+	}
+
+	(dispatch::kernel(dispatch::KERNEL_ADD))(a, b, out, len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_sub_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each2(a, b, out, len, |a, b| float_sub(a, b));
+	}
+
+	(dispatch::kernel(dispatch::KERNEL_SUB))(a, b, out, len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_mul_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each2(a, b, out, len, |a, b| float_mul(a, b));
+	}
+
+	(dispatch::kernel(dispatch::KERNEL_MUL))(a, b, out, len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_div_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each2(a, b, out, len, |a, b| float_div(a, b));
+	}
+
+	(dispatch::kernel(dispatch::KERNEL_DIV))(a, b, out, len);
+}
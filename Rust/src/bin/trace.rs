@@ -0,0 +1,679 @@
+// Works with the operation traces dumped by Mathd.DumpTrace (see trace.rs):
+//
+//   cargo run --release --bin trace -- replay FILE [--thread N] [--examples N]
+//   cargo run --release --bin trace -- diff FILE FILE [--thread N]
+//
+// replay runs every recorded operation again through this machine's native
+// kernels, in the modes it was recorded in, and reports those whose result
+// differs from the recorded one, any NaN matching any NaN unless NaNs were
+// canonical. Consecutive operations with the same opcode and
+// modes are run as one call to the batched export, so a trace replays at batch
+// speed rather than one FFI call per operation. Calls of composite exports are
+// skipped, as their inputs are not recorded.
+//
+// diff finds the first operation where two traces differ, e.g. from two devices
+// that desynced. Each thread's section of one file is compared with the section
+// at the same position in the other. The block hashes chain, so the first block
+// whose hashes differ is found by binary search, reading O(log n) index entries
+// and then only that block from each file. Results are printed as DeterminismTest
+// prints them, value : bits : integer.
+use std::fmt::LowerExp;
+use std::fs::File;
+use std::io::{self, Read, Seek, SeekFrom};
+use std::str::FromStr;
+use std::time::Instant;
+use std::{env, process};
+use unity_rust::arith::{dfloat_set_backend, dfloat_set_denormal_mode, dfloat_set_nan_mode};
+use unity_rust::batch::*;
+use unity_rust::convert::*;
+use unity_rust::ddouble::*;
+use unity_rust::dmath::*;
+use unity_rust::trace::*;
+use unity_rust::vm::*;
+
+const USAGE: &str = "usage: trace replay FILE [options]
+       trace diff FILE FILE [options]
+
+  --thread N       only the section of thread N (default: all)
+  --examples N     differences printed per thread by replay (default: 8)";
+
+// Operations replayed per batched call at most.
+const RUN: usize = 1 << 16;
+
+// A thread's section of a trace.
+struct Section {
+	thread: u32,
+	count: u64,
+	dropped: u64,
+	bytes: u64,
+	// File offsets of the block index and of the first record.
+	index: u64,
+	records: u64,
+}
+
+struct Trace {
+	path: String,
+	file: File,
+	block: u64,
+	sections: Vec<Section>,
+	// Reads of the index and of records, for diff to report.
+	index_reads: u64,
+	block_reads: u64,
+}
+
+fn invalid(path: &str, message: &str) -> io::Error {
+	return io::Error::new(io::ErrorKind::InvalidData, format!("{}: {}", path, message));
+}
+
+impl Trace {
+	fn open(path: &str) -> io::Result<Trace> {
+		let mut file = File::open(path)?;
+		let length = file.metadata()?.len();
+		let header = read_words::<4>(&mut file, 4)?;
+
+		if header[0] != MAGIC as u64 {
+			return Err(invalid(path, "not a trace"));
+		}
+
+		if header[1] != VERSION as u64 {
+			return Err(invalid(path, &format!("version {} is not supported", header[1])));
+		}
+
+		let block = header[3];
+		let mut sections = Vec::new();
+		let mut offset = 16;
+
+		for _ in 0..header[2] {
+			file.seek(SeekFrom::Start(offset))?;
+			let thread = read_words::<1>(&mut file, 4)?[0] as u32;
+			let [count, dropped, bytes] = read_words::<3>(&mut file, 8)?;
+			let blocks = (count + block - 1) / block.max(1);
+			let index = offset + 28;
+			let records = index + blocks * 16;
+
+			if block == 0 || records.checked_add(bytes).map_or(true, |end| end > length) {
+				return Err(invalid(path, "truncated"));
+			}
+
+			sections.push(Section { thread, count, dropped, bytes, index, records });
+			offset = records + bytes;
+		}
+
+		return Ok(Trace { path: path.to_string(), file, block, sections, index_reads: 0, block_reads: 0 });
+	}
+
+	fn blocks(&self, s: usize) -> u64 {
+		return (self.sections[s].count + self.block - 1) / self.block;
+	}
+
+	// The offset of block k's first record, and the hash of the records up to its end.
+	fn index_entry(&mut self, s: usize, k: u64) -> io::Result<(u64, u64)> {
+		self.index_reads += 1;
+		self.file.seek(SeekFrom::Start(self.sections[s].index + k * 16))?;
+		let [offset, hash] = read_words::<2>(&mut self.file, 8)?;
+		return Ok((offset, hash));
+	}
+
+	fn block_hash(&mut self, s: usize, k: u64) -> io::Result<u64> {
+		return Ok(self.index_entry(s, k)?.1);
+	}
+
+	fn read_records(&mut self, s: usize, start: u64, end: u64) -> io::Result<Vec<Record>> {
+		let section = &self.sections[s];
+
+		if start > end || end > section.bytes {
+			return Err(invalid(&self.path, "corrupt block index"));
+		}
+
+		let mut bytes = vec![0; (end - start) as usize];
+		self.file.seek(SeekFrom::Start(section.records + start))?;
+		self.file.read_exact(&mut bytes)?;
+
+		let mut records = Vec::new();
+		let mut at = 0;
+
+		while at < bytes.len() {
+			let (record, size) = Record::decode(&bytes[at..]).ok_or_else(|| invalid(&self.path, "truncated record"))?;
+			records.push(record);
+			at += size;
+		}
+
+		return Ok(records);
+	}
+
+	fn block(&mut self, s: usize, k: u64) -> io::Result<Vec<Record>> {
+		let start = self.index_entry(s, k)?.0;
+		let end = if k + 1 < self.blocks(s) { self.index_entry(s, k + 1)?.0 } else { self.sections[s].bytes };
+		self.block_reads += 1;
+		return self.read_records(s, start, end);
+	}
+}
+
+fn read_words<const N: usize>(file: &mut File, size: usize) -> io::Result<[u64; N]> {
+	let mut bytes = [0u8; 64];
+	file.read_exact(&mut bytes[..N * size])?;
+
+	let mut words = [0; N];
+
+	for i in 0..N {
+		let mut w = [0; 8];
+		w[..size].copy_from_slice(&bytes[i * size..(i + 1) * size]);
+		words[i] = u64::from_le_bytes(w);
+	}
+
+	return Ok(words);
+}
+
+fn op_name(op: u8) -> &'static str {
+	if is_call(op) {
+		return call_name(op).unwrap_or("Unknown");
+	}
+
+	if conversion(op) {
+		return ["ToI32", "ToU32", "ToI64", "FromI32", "FromU32", "FromI64"][(op - TRACE_TO_I32) as usize];
+	}
+
+	return match op & !TRACE_DOUBLE {
+		OP_ADD => "Add",
+		OP_SUB => "Sub",
+		OP_MUL => "Mul",
+		OP_DIV => "Div",
+		OP_SQRT => "Sqrt",
+		OP_SIN => "Sin",
+		OP_COS => "Cos",
+		OP_ATAN2 => "Atan2",
+		OP_EXP => "Exp",
+		OP_LOG => "Log",
+		_ => "Unknown",
+	};
+}
+
+fn unary(op: u8) -> bool {
+	return matches!(op & !TRACE_DOUBLE, OP_SQRT | OP_SIN | OP_COS | OP_EXP | OP_LOG);
+}
+
+fn conversion(op: u8) -> bool {
+	return (TRACE_TO_I32..=TRACE_FROM_I64).contains(&op);
+}
+
+// The shortest digits that round trip to x, and the exponent of the first, as
+// .NET Core picks them: where two candidates are equally close to x, the one
+// ending in an even digit, where Rust rounds up.
+fn shortest_digits<T: LowerExp + FromStr + PartialEq + Copy>(x: T) -> (String, i32) {
+	let split = |s: String| {
+		let (mantissa, exponent) = s.split_once('e').unwrap();
+		let digits: String = mantissa.chars().filter(|c| c.is_ascii_digit()).collect();
+		return (digits, exponent.parse::<i32>().unwrap());
+	};
+
+	let shortest = format!("{:e}", x);
+	let sign = if shortest.starts_with('-') { "-" } else { "" };
+	let (digits, exponent) = split(shortest);
+	// x's exact decimal expansion, which is at most 767 digits long.
+	let (exact, exact_exponent) = split(format!("{:.800e}", x));
+	let n = digits.len();
+
+	if exact_exponent != exponent || &exact[n..n + 1] != "5" || exact[n + 1..].chars().any(|c| c != '0') {
+		return (digits, exponent);
+	}
+
+	// A tie between the exact digits truncated and rounded up.
+	let down = exact[..n].to_string();
+	let up = (down.parse::<u128>().unwrap() + 1).to_string();
+	let even = if down.ends_with(|c: char| (c as u8 - b'0') % 2 == 0) { down } else { up };
+	let round_trips = even.len() == n && format!("{}{}.{}e{}", sign, &even[..1], &even[1..], exponent).parse::<T>().map_or(false, |y| y == x);
+
+	return if round_trips { (even, exponent) } else { (digits, exponent) };
+}
+
+// A float or double as .NET Core formats it with ToString(): the shortest digits
+// that round trip, in scientific notation if the exponent is below -4 or at least
+// precision (9 for float, 17 for double).
+fn dotnet_string<T: LowerExp + FromStr + PartialEq + Copy + Into<f64>>(x: T, precision: i32) -> String {
+	let value: f64 = x.into();
+
+	if value.is_nan() {
+		return "NaN".to_string();
+	}
+
+	if value.is_infinite() {
+		return if value < 0.0 { "-Infinity" } else { "Infinity" }.to_string();
+	}
+
+	let sign = if value.is_sign_negative() { "-" } else { "" };
+	let (digits, exponent) = shortest_digits(x);
+
+	if exponent < -4 || exponent >= precision {
+		let fraction = if digits.len() > 1 { format!(".{}", &digits[1..]) } else { String::new() };
+		let exponent_sign = if exponent < 0 { '-' } else { '+' };
+		return format!("{}{}{}E{}{:02}", sign, &digits[..1], fraction, exponent_sign, exponent.abs());
+	}
+
+	if exponent < 0 {
+		return format!("{}0.{}{}", sign, "0".repeat((-exponent - 1) as usize), digits);
+	}
+
+	let whole = exponent as usize + 1;
+
+	if digits.len() <= whole {
+		return format!("{}{}{}", sign, digits, "0".repeat(whole - digits.len()));
+	}
+
+	return format!("{}{}.{}", sign, &digits[..whole], &digits[whole..]);
+}
+
+// DeterminismTest.FloatBitsToVerboseString.
+fn float_verbose(bits: u32) -> String {
+	let f = f32::from_bits(bits);
+	return format!("{}f : {:032b} : {}", dotnet_string(f, 9), bits, bits);
+}
+
+// DeterminismTest.DoubleBitsToVerboseString.
+fn double_verbose(bits: u64) -> String {
+	let d = f64::from_bits(bits);
+	return format!("{}d : {:064b} : {}", dotnet_string(d, 17), bits, bits);
+}
+
+fn verbose(op: u8, bits: u64) -> String {
+	return if op & TRACE_DOUBLE != 0 { double_verbose(bits) } else { float_verbose(bits as u32) };
+}
+
+fn modes_name(r: &Record) -> String {
+	return format!(
+		"{} backend, {} denormals, {} NaNs",
+		if r.backend() == 0 { "Hardware" } else { "Soft" },
+		if r.denormal_mode() == 0 { "Preserve" } else { "Flush" },
+		if r.nan_mode() == 0 { "Preserve" } else { "Canonical" }
+	);
+}
+
+fn mode_name(mode: u64) -> &'static str {
+	return match mode as u32 {
+		ROUND_TRUNCATE => "Truncate",
+		ROUND_FLOOR => "Floor",
+		_ => "HalfEven",
+	};
+}
+
+// The integer operand or result of a conversion.
+fn integer(op: u8, bits: u64) -> String {
+	return match op {
+		TRACE_TO_I32 | TRACE_FROM_I32 => (bits as u32 as i32).to_string(),
+		TRACE_TO_I64 | TRACE_FROM_I64 => (bits as i64).to_string(),
+		_ => (bits as u32).to_string(),
+	};
+}
+
+// The result of op: an integer for conversions to integers and the hash of the
+// outputs for calls.
+fn result_string(op: u8, bits: u64) -> String {
+	if is_call(op) {
+		return format!("hash {:016x}", bits);
+	}
+
+	if conversion(op) && op <= TRACE_TO_I64 {
+		return integer(op, bits);
+	}
+
+	return verbose(op & TRACE_DOUBLE, bits);
+}
+
+// As DeterminismTest.DescribeHashedResult, with the modes.
+fn describe(r: &Record, result: u64) -> String {
+	if is_call(r.op) {
+		return format!("{}: {} inputs, {} outputs, {} ({})", op_name(r.op), r.a, r.b, result_string(r.op, result), modes_name(r));
+	}
+
+	if conversion(r.op) {
+		let x = if r.op <= TRACE_TO_I64 { float_verbose(r.a as u32) } else { integer(r.op, r.a) };
+		return format!("{}({}, {}) = {} ({})", op_name(r.op), x, mode_name(r.b), result_string(r.op, result), modes_name(r));
+	}
+
+	let b = if unary(r.op) { String::new() } else { format!(", {}", verbose(r.op, r.b)) };
+	return format!("{}({}{}) = {} ({})", op_name(r.op), verbose(r.op, r.a), b, verbose(r.op, result), modes_name(r));
+}
+
+fn usage<T>(error: &str) -> T {
+	eprintln!("{}\n\n{}", error, USAGE);
+	process::exit(2);
+}
+
+fn fail<T>(error: io::Error) -> T {
+	eprintln!("{}", error);
+	process::exit(2);
+}
+
+fn parse_number(s: &str) -> Option<u64> {
+	return s.replace('_', "").parse().ok();
+}
+
+// Whether a replayed result matches the recorded one. With NaNs preserved any NaN
+// matches any NaN, as in DeterminismTest, since which NaN operand is returned
+// depends on the order the compiler puts commutative operands in, which differs
+// between the scalar and batched exports.
+fn matches(r: &Record, result: u64) -> bool {
+	if r.nan_mode() == 0 && !conversion(r.op) {
+		if r.op & TRACE_DOUBLE != 0 && f64::from_bits(r.result).is_nan() && f64::from_bits(result).is_nan() {
+			return true;
+		}
+
+		if r.op & TRACE_DOUBLE == 0 && f32::from_bits(r.result as u32).is_nan() && f32::from_bits(result as u32).is_nan() {
+			return true;
+		}
+	}
+
+	return result == r.result;
+}
+
+// The operations that replay_run takes as one batch, which for conversions also
+// share the rounding mode.
+fn run_key(r: &Record) -> (u8, u8, u64) {
+	return (r.op, r.modes, if conversion(r.op) { r.b } else { 0 });
+}
+
+// Runs a batch of operations with the same run_key through the batched export,
+// and returns the results, or None for calls, which cannot be replayed.
+unsafe fn replay_run(run: &[Record]) -> Option<Vec<u64>> {
+	let first = run[0];
+	let len = run.len();
+
+	if is_call(first.op) {
+		return None;
+	}
+
+	dfloat_set_backend(first.backend());
+	dfloat_set_denormal_mode(first.denormal_mode());
+	dfloat_set_nan_mode(first.nan_mode());
+
+	if conversion(first.op) {
+		let mode = first.b as u32;
+		let mut out = vec![0u64; len];
+
+		match first.op {
+			TRACE_TO_I32 | TRACE_TO_U32 | TRACE_FROM_I32 | TRACE_FROM_U32 => {
+				let a: Vec<u32> = run.iter().map(|r| r.a as u32).collect();
+				let mut words = vec![0u32; len];
+
+				match first.op {
+					TRACE_TO_I32 => float_to_i32_batch(a.as_ptr(), words.as_mut_ptr() as *mut i32, len, mode),
+					TRACE_TO_U32 => float_to_u32_batch(a.as_ptr(), words.as_mut_ptr(), len, mode),
+					TRACE_FROM_I32 => float_from_i32_batch(a.as_ptr() as *const i32, words.as_mut_ptr(), len, mode),
+					_ => float_from_u32_batch(a.as_ptr(), words.as_mut_ptr(), len, mode),
+				}
+
+				for i in 0..len {
+					out[i] = words[i] as u64;
+				}
+			}
+			TRACE_TO_I64 => {
+				let a: Vec<u32> = run.iter().map(|r| r.a as u32).collect();
+				float_to_i64_batch(a.as_ptr(), out.as_mut_ptr() as *mut i64, len, mode);
+			}
+			_ => {
+				let a: Vec<i64> = run.iter().map(|r| r.a as i64).collect();
+				let mut words = vec![0u32; len];
+				float_from_i64_batch(a.as_ptr(), words.as_mut_ptr(), len, mode);
+
+				for i in 0..len {
+					out[i] = words[i] as u64;
+				}
+			}
+		}
+
+		return Some(out);
+	}
+
+	if first.op & TRACE_DOUBLE != 0 {
+		let a: Vec<u64> = run.iter().map(|r| r.a).collect();
+		let b: Vec<u64> = run.iter().map(|r| r.b).collect();
+		let mut out = vec![0u64; len];
+
+		let batch = match first.op & !TRACE_DOUBLE {
+			OP_ADD => double_add_batch,
+			OP_SUB => double_sub_batch,
+			OP_MUL => double_mul_batch,
+			_ => double_div_batch,
+		};
+
+		batch(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), len);
+		return Some(out);
+	}
+
+	let a: Vec<u32> = run.iter().map(|r| r.a as u32).collect();
+	let b: Vec<u32> = run.iter().map(|r| r.b as u32).collect();
+	let mut out = vec![0u32; len];
+
+	if unary(first.op) {
+		let batch = match first.op {
+			OP_SQRT => float_sqrt_batch,
+			OP_SIN => float_sin_batch,
+			OP_COS => float_cos_batch,
+			OP_EXP => float_exp_batch,
+			_ => float_log_batch,
+		};
+
+		batch(a.as_ptr(), out.as_mut_ptr(), len);
+	} else {
+		let batch = match first.op {
+			OP_ADD => float_add_batch,
+			OP_SUB => float_sub_batch,
+			OP_MUL => float_mul_batch,
+			OP_DIV => float_div_batch,
+			_ => float_atan2_batch,
+		};
+
+		batch(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), len);
+	}
+
+	return Some(out.into_iter().map(|x| x as u64).collect());
+}
+
+fn replay(trace: &mut Trace, thread: Option<u32>, examples: usize) -> io::Result<u64> {
+	let mut differences: u64 = 0;
+
+	for s in 0..trace.sections.len() {
+		let section = &trace.sections[s];
+
+		if thread.map_or(false, |t| t != section.thread) {
+			continue;
+		}
+
+		let (id, count, dropped, bytes) = (section.thread, section.count, section.dropped, section.bytes);
+		let records = trace.read_records(s, 0, bytes)?;
+
+		if records.iter().any(|r| op_name(r.op) == "Unknown") {
+			return Err(invalid(&trace.path, "unknown opcode"));
+		}
+
+		let start = Instant::now();
+		let mut thread_differences = 0;
+		let mut calls = 0;
+		let mut i = 0;
+
+		while i < records.len() {
+			let key = run_key(&records[i]);
+			let end = (i..records.len().min(i + RUN)).find(|&j| run_key(&records[j]) != key).unwrap_or(records.len().min(i + RUN));
+
+			let results = match unsafe { replay_run(&records[i..end]) } {
+				Some(results) => results,
+				None => {
+					calls += end - i;
+					i = end;
+					continue;
+				}
+			};
+
+			for (j, &result) in results.iter().enumerate() {
+				let r = &records[i + j];
+
+				if !matches(r, result) {
+					if thread_differences < examples {
+						println!("  operation {}: {}", dropped + (i + j) as u64, describe(r, r.result));
+						println!("    replayed: {}", result_string(r.op, result));
+					}
+
+					thread_differences += 1;
+				}
+			}
+
+			i = end;
+		}
+
+		let seconds = start.elapsed().as_secs_f64();
+		let replayed = count - calls as u64;
+		println!(
+			"thread {}: replayed {} operations in {:.1} ms ({:.1} Mops/s), {} differ from the recorded results",
+			id,
+			replayed,
+			seconds * 1e3,
+			replayed as f64 / seconds.max(1e-9) / 1e6,
+			thread_differences
+		);
+
+		if calls > 0 {
+			println!("  skipped {} calls of composite exports, whose inputs are not traced", calls);
+		}
+
+		differences += thread_differences as u64;
+	}
+
+	return Ok(differences);
+}
+
+// The first block of section s where the traces differ, or the number of blocks
+// both have if they agree up to the end of the shorter.
+fn first_different_block(a: &mut Trace, b: &mut Trace, s: usize) -> io::Result<u64> {
+	let mut low = 0;
+	let mut high = a.blocks(s).min(b.blocks(s));
+
+	while low < high {
+		let mid = low + (high - low) / 2;
+
+		if a.block_hash(s, mid)? != b.block_hash(s, mid)? {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+
+	return Ok(low);
+}
+
+fn diff(a: &mut Trace, b: &mut Trace, thread: Option<u32>) -> io::Result<bool> {
+	let mut same = true;
+
+	if a.block != b.block {
+		return Err(invalid(&b.path, "has a different block size"));
+	}
+
+	if a.sections.len() != b.sections.len() {
+		println!("{} has {} threads, {} has {}", a.path, a.sections.len(), b.path, b.sections.len());
+	}
+
+	for s in 0..a.sections.len().min(b.sections.len()) {
+		if thread.map_or(false, |t| t != a.sections[s].thread) {
+			continue;
+		}
+
+		let id = a.sections[s].thread;
+		let dropped = a.sections[s].dropped;
+
+		if dropped != b.sections[s].dropped {
+			println!("thread {}: the traces start after {} and {} dropped operations, so their operation numbers differ", id, dropped, b.sections[s].dropped);
+		}
+
+		let (index_reads, block_reads) = (a.index_reads + b.index_reads, a.block_reads + b.block_reads);
+		let k = first_different_block(a, b, s)?;
+		let common = a.blocks(s).min(b.blocks(s));
+		let records_a = if k < a.blocks(s) { a.block(s, k)? } else { Vec::new() };
+		let records_b = if k < b.blocks(s) { b.block(s, k)? } else { Vec::new() };
+		let i = records_a.iter().zip(&records_b).position(|(x, y)| x != y).unwrap_or(records_a.len().min(records_b.len()));
+		let n = dropped + k * a.block + i as u64;
+
+		let reads = format!(
+			"{} index reads, {} block reads",
+			a.index_reads + b.index_reads - index_reads,
+			a.block_reads + b.block_reads - block_reads
+		);
+
+		if k == common && a.sections[s].count == b.sections[s].count {
+			println!("thread {}: the {} operations are the same ({})", id, a.sections[s].count, reads);
+			continue;
+		}
+
+		same = false;
+
+		match (records_a.get(i), records_b.get(i)) {
+			(Some(x), Some(y)) => {
+				println!("thread {}: operation {} is the first that differs ({})", id, n, reads);
+				println!("  {}: {}", a.path, describe(x, x.result));
+				println!("  {}: {}", b.path, describe(y, y.result));
+
+				if (x.op, x.a, x.b) != (y.op, y.a, y.b) {
+					println!("  Its operands differ, so the traces diverged before it, in C# or native code that is not traced.");
+				} else if x.modes != y.modes {
+					println!("  It ran in different modes.");
+				} else if is_call(x.op) {
+					println!("  Its outputs differ. Its inputs are not traced, so they may have diverged before it.");
+				}
+			}
+			(Some(x), None) | (None, Some(x)) => {
+				let (longer, shorter) = if records_a.len() > i { (&a.path, &b.path) } else { (&b.path, &a.path) };
+				println!("thread {}: {} ends before operation {}, where {} continues with ({})", id, shorter, n, longer, reads);
+				println!("  {}", describe(x, x.result));
+			}
+			(None, None) => println!("thread {}: the traces agree up to operation {}, where both end ({})", id, n, reads),
+		}
+	}
+
+	return Ok(same);
+}
+
+fn main() {
+	let mut args = env::args().skip(1);
+	let mut files = Vec::new();
+	let mut thread = None;
+	let mut examples = 8;
+	let command = args.next().unwrap_or_else(|| usage("missing command"));
+
+	if command == "--help" {
+		println!("{}", USAGE);
+		return;
+	}
+
+	while let Some(arg) = args.next() {
+		if !arg.starts_with("--") {
+			files.push(arg);
+			continue;
+		}
+
+		let value = args.next().unwrap_or_else(|| usage(&format!("missing value for {}", arg)));
+		let invalid = format!("invalid value {} for {}", value, arg);
+
+		match arg.as_str() {
+			"--thread" => thread = Some(parse_number(&value).unwrap_or_else(|| usage(&invalid)) as u32),
+			"--examples" => examples = parse_number(&value).unwrap_or_else(|| usage(&invalid)) as usize,
+			_ => usage(&format!("unknown option {}", arg)),
+		}
+	}
+
+	match (command.as_str(), files.len()) {
+		("replay", 1) => {
+			let mut trace = Trace::open(&files[0]).unwrap_or_else(fail);
+
+			if replay(&mut trace, thread, examples).unwrap_or_else(fail) > 0 {
+				process::exit(1);
+			}
+		}
+		("diff", 2) => {
+			let mut a = Trace::open(&files[0]).unwrap_or_else(fail);
+			let mut b = Trace::open(&files[1]).unwrap_or_else(fail);
+
+			if !diff(&mut a, &mut b, thread).unwrap_or_else(fail) {
+				process::exit(1);
+			}
+		}
+		("replay", _) | ("diff", _) => usage("wrong number of files"),
+		_ => usage(&format!("unknown command {}", command)),
+	}
+}
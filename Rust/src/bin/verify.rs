@@ -0,0 +1,989 @@
+// Checks the native operations against reference implementations over far more
+// inputs than the Unity test, on every core:
+//
+//   cargo run --release --bin verify -- [options] [task...]
+//
+// The unary tasks (sqrt, the float to integer conversions, from_i32, from_u32, sin,
+// cos, exp and log) run every one of the 2^32 inputs, or the --range given. The
+// binary tasks (add, sub, mul, div, atan2) and from_i64 run --pairs seeded random
+// inputs, and a structured sweep of every pair of exponents against edge case
+// mantissas and signs.
+//
+// Each input goes through the scalar export and the batched kernels, for
+// add/sub/mul/div every instruction set variant the CPU supports and the oracle in
+// oracle.rs, and all are compared with the reference:
+//
+//   add, sub, mul, div, sqrt   computed in f64 and rounded to f32, which is
+//                              correctly rounded since 53 >= 2 * 24 + 2
+//   conversions                computed in f64 and i128 with Rust's casts
+//   sin, cos, exp, log, atan2  the other backend, as the functions are not
+//                              correctly rounded, and the host's f64 functions
+//                              rounded to f32, within max_error ulps; the largest
+//                              error is reported alongside
+//
+// following the library's NaN rules (a NaN operand is returned quieted, the first
+// if both are, and invalid operations give DEFAULT_NAN) and the selected denormal
+// and NaN modes. With NaNs preserved any NaN matches any NaN, as in DeterminismTest.
+//
+// Inputs are split into chunks handed out to the threads from a shared counter, so
+// slow chunks (denormals on the hardware backend, soft-float) don't hold up the
+// others. With --checkpoint FILE the finished chunks and failure counts of each task
+// are saved every few seconds, and skipped when run again with the same options.
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Mutex;
+use std::time::{Duration, Instant};
+use std::{env, fs, process, thread};
+use unity_rust::arith::*;
+use unity_rust::convert::*;
+use unity_rust::dispatch::{VARIANTS, VARIANT_AVX2, VARIANT_AVX512, VARIANT_NEON, VARIANT_SCALAR, VARIANT_SSE2};
+use unity_rust::dmath::*;
+use unity_rust::oracle::float_oracle_batch;
+use unity_rust::soft::{DEFAULT_NAN, EXP_MASK, INFINITY, QUIET_BIT, SIGN};
+use unity_rust::{dmath, float_add, float_div, float_mul, float_sub};
+
+const USAGE: &str = "usage: verify [options] [task...]
+
+tasks: sqrt to_i32 to_u32 to_i64 from_i32 from_u32 from_i64 sin cos exp log
+       add sub mul div atan2 (default: all)
+
+  --backend hardware|soft|all        (default: all)
+  --denormals preserve|flush|all     (default: preserve)
+  --nans preserve|canonical|all      (default: preserve)
+  --threads N                        (default: every core)
+  --pairs N        random inputs per binary task (default: 2^28)
+  --seed N         seed of the random inputs (default: 1)
+  --sweep random|structured|all      (default: all)
+  --range START:END  inputs of the unary tasks, END exclusive (default: 0:0x100000000)
+  --checkpoint FILE  save progress to FILE and resume from it
+  --examples N     failures printed per task (default: 8)";
+
+// Inputs per chunk, the unit of work handed to a thread and saved in checkpoints.
+const CHUNK: u64 = 1 << 16;
+
+const CHECKPOINT_INTERVAL: Duration = Duration::from_secs(10);
+
+const MODES: [(u32, &str); 3] = [(ROUND_TRUNCATE, "truncate"), (ROUND_HALF_EVEN, "half even"), (ROUND_FLOOR, "floor")];
+
+// Mantissas of the structured sweep.
+const EDGE_MANTISSAS: [u32; 8] = [0, 1, 2, 0x3f_ffff, 0x40_0000, 0x40_0001, 0x7f_fffe, 0x7f_ffff];
+
+#[derive(Clone, Copy, PartialEq)]
+enum Op {
+	Add,
+	Sub,
+	Mul,
+	Div,
+	Sqrt,
+	ToI32,
+	ToU32,
+	ToI64,
+	FromI32,
+	FromU32,
+	FromI64,
+	Sin,
+	Cos,
+	Exp,
+	Log,
+	Atan2,
+}
+
+const OPS: [(Op, &str); 16] = [
+	(Op::Sqrt, "sqrt"),
+	(Op::ToI32, "to_i32"),
+	(Op::ToU32, "to_u32"),
+	(Op::ToI64, "to_i64"),
+	(Op::FromI32, "from_i32"),
+	(Op::FromU32, "from_u32"),
+	(Op::FromI64, "from_i64"),
+	(Op::Sin, "sin"),
+	(Op::Cos, "cos"),
+	(Op::Exp, "exp"),
+	(Op::Log, "log"),
+	(Op::Add, "add"),
+	(Op::Sub, "sub"),
+	(Op::Mul, "mul"),
+	(Op::Div, "div"),
+	(Op::Atan2, "atan2"),
+];
+
+impl Op {
+	fn exhaustive(self) -> bool {
+		return !matches!(self, Op::Add | Op::Sub | Op::Mul | Op::Div | Op::Atan2 | Op::FromI64);
+	}
+
+	fn elementary(self) -> bool {
+		return matches!(self, Op::Sin | Op::Cos | Op::Exp | Op::Log | Op::Atan2);
+	}
+}
+
+#[derive(Clone, Copy)]
+enum Inputs {
+	Range(u64, u64),
+	Random(u64, u64),
+	Structured,
+}
+
+impl Inputs {
+	fn count(&self, op: Op) -> u64 {
+		return match *self {
+			Inputs::Range(start, end) => end - start,
+			Inputs::Random(count, _) => count,
+			Inputs::Structured if op == Op::FromI64 => 2 * 64 * 512,
+			Inputs::Structured => 4 * 256 * 256 * (EDGE_MANTISSAS.len() * EDGE_MANTISSAS.len()) as u64,
+		};
+	}
+
+	fn name(&self) -> String {
+		return match *self {
+			Inputs::Range(start, end) => format!("{:#x}..{:#x}", start, end),
+			Inputs::Random(count, seed) => format!("random:{}:seed={}", count, seed),
+			Inputs::Structured => "structured".to_string(),
+		};
+	}
+
+	// The float pair for input i.
+	fn pair(&self, i: u64) -> (u32, u32) {
+		match *self {
+			Inputs::Random(_, seed) => {
+				let r = mix(seed, i);
+				let a = r as u32;
+				let mut b = (r >> 32) as u32;
+
+				// Half the pairs have nearby exponents, to exercise cancellation and
+				// rounding in add and sub rather than just the larger operand winning.
+				if mix(seed ^ 1, i) & 1 != 0 {
+					let exponent = ((a & EXP_MASK) >> 23) as i32 + ((b >> 23) & 7) as i32 - 4;
+					b = (b & !EXP_MASK) | ((exponent.max(0).min(255) as u32) << 23);
+				}
+
+				return (a, b);
+			}
+			_ => {
+				let signs = (i & 3) as u32;
+				let m = EDGE_MANTISSAS.len() as u64;
+				let mb = EDGE_MANTISSAS[(i >> 2) as usize % m as usize];
+				let ma = EDGE_MANTISSAS[((i >> 2) / m % m) as usize];
+				let eb = ((i >> 2) / (m * m) % 256) as u32;
+				let ea = ((i >> 2) / (m * m * 256)) as u32;
+				return ((signs & 1) << 31 | ea << 23 | ma, (signs >> 1) << 31 | eb << 23 | mb);
+			}
+		}
+	}
+
+	// The integer for input i of from_i64: every magnitude for random inputs, and
+	// the neighbourhood of each power of two, where rounding changes, for structured.
+	fn long(&self, i: u64) -> i64 {
+		match *self {
+			Inputs::Random(_, seed) => {
+				let r = mix(seed, i);
+				return (r as i64) >> (r >> 58);
+			}
+			_ => {
+				let power = 1u64 << ((i >> 10) % 64);
+				let value = power.wrapping_add(i & 511).wrapping_sub(256) as i64;
+				return if i & 512 != 0 { value.wrapping_neg() } else { value };
+			}
+		}
+	}
+}
+
+// splitmix64 of seed and i, so any input can be generated without its predecessors.
+fn mix(seed: u64, i: u64) -> u64 {
+	let mut z = seed.wrapping_mul(0x9e37_79b9_7f4a_7c15).wrapping_add(i.wrapping_add(1).wrapping_mul(0xbf58_476d_1ce4_e5b9));
+	z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+	z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+	return z ^ (z >> 31);
+}
+
+#[derive(Clone, Copy)]
+struct Config {
+	backend: u32,
+	denormals: u32,
+	nans: u32,
+}
+
+impl Config {
+	fn flush(&self) -> bool {
+		return self.denormals == DENORMALS_FLUSH;
+	}
+
+	fn canonical(&self) -> bool {
+		return self.nans == NANS_CANONICAL;
+	}
+
+	fn name(&self) -> String {
+		return format!(
+			"{}/{}/{}",
+			if self.backend == BACKEND_SOFT { "soft" } else { "hardware" },
+			if self.flush() { "flush" } else { "preserve" },
+			if self.canonical() { "canonical" } else { "preserve" }
+		);
+	}
+
+	fn select(&self) {
+		dfloat_set_backend(self.backend);
+		dfloat_set_denormal_mode(self.denormals);
+		dfloat_set_nan_mode(self.nans);
+	}
+
+	// A result of an operation on flushed inputs, in the selected modes.
+	fn result(&self, x: u32) -> u32 {
+		let x = if self.flush() { flush(x) } else { x };
+		return if self.canonical() && is_nan(x) { DEFAULT_NAN } else { x };
+	}
+
+	fn same(&self, actual: u32, expected: u32) -> bool {
+		return actual == expected || (!self.canonical() && is_nan(actual) && is_nan(expected));
+	}
+}
+
+// Evaluates body with the type name R bound to the backend cfg doesn't select,
+// wrapped for cfg's denormal and NaN modes.
+macro_rules! with_other_backend {
+	($cfg:expr, $R:ident => $body:expr) => {
+		match ($cfg.backend == BACKEND_SOFT, $cfg.flush(), $cfg.canonical()) {
+			(false, false, false) => {
+				type $R = Soft;
+				$body
+			}
+			(false, true, false) => {
+				type $R = FlushDenormals<Soft>;
+				$body
+			}
+			(false, false, true) => {
+				type $R = CanonicalNaNs<Soft>;
+				$body
+			}
+			(false, true, true) => {
+				type $R = CanonicalNaNs<FlushDenormals<Soft>>;
+				$body
+			}
+			(true, false, false) => {
+				type $R = Hardware;
+				$body
+			}
+			(true, true, false) => {
+				type $R = FlushDenormals<Hardware>;
+				$body
+			}
+			(true, false, true) => {
+				type $R = CanonicalNaNs<Hardware>;
+				$body
+			}
+			(true, true, true) => {
+				type $R = CanonicalNaNs<FlushDenormals<Hardware>>;
+				$body
+			}
+		}
+	};
+}
+
+fn is_nan(x: u32) -> bool {
+	return x & !SIGN > INFINITY;
+}
+
+fn flush(x: u32) -> u32 {
+	return if x & EXP_MASK == 0 { x & SIGN } else { x };
+}
+
+fn arith_reference(cfg: &Config, op: Op, a: u32, b: u32) -> u32 {
+	let (a, b) = if cfg.flush() { (flush(a), flush(b)) } else { (a, b) };
+
+	if is_nan(a) {
+		return cfg.result(a | QUIET_BIT);
+	}
+
+	if is_nan(b) && op != Op::Sqrt {
+		return cfg.result(b | QUIET_BIT);
+	}
+
+	let (x, y) = (f32::from_bits(a) as f64, f32::from_bits(b) as f64);
+
+	let r = match op {
+		Op::Add => x + y,
+		Op::Sub => x - y,
+		Op::Mul => x * y,
+		Op::Div => x / y,
+		_ => x.sqrt(),
+	} as f32;
+
+	return cfg.result(if r.is_nan() { DEFAULT_NAN } else { r.to_bits() });
+}
+
+fn round(x: f64, mode: u32) -> f64 {
+	return match mode {
+		ROUND_TRUNCATE => x.trunc(),
+		ROUND_FLOOR => x.floor(),
+		_ => x.round_ties_even(),
+	};
+}
+
+// The float to integer conversions, as the result's bits.
+fn to_int_reference(cfg: &Config, op: Op, x: u32, mode: u32) -> u64 {
+	let x = round(f32::from_bits(if cfg.flush() { flush(x) } else { x }) as f64, mode);
+
+	return match op {
+		Op::ToI32 => x as i32 as u32 as u64,
+		Op::ToU32 => x as u32 as u64,
+		_ => x as i64 as u64,
+	};
+}
+
+fn from_int_reference(v: i128, mode: u32) -> u32 {
+	let nearest = v as f32;
+	let rounded = nearest as i128;
+
+	// Casts round to nearest, so at most one step toward zero or down from there.
+	let step = match mode {
+		ROUND_TRUNCATE => rounded.abs() > v.abs(),
+		ROUND_FLOOR => rounded > v,
+		_ => false,
+	};
+
+	if !step {
+		return nearest.to_bits();
+	}
+
+	return if mode == ROUND_FLOOR && v < 0 { nearest.to_bits() + 1 } else { nearest.to_bits() - 1 };
+}
+
+fn elementary<A: Arith>(op: Op, a: u32, b: u32) -> u32 {
+	return match op {
+		Op::Sin => dmath::sin::<A>(a),
+		Op::Cos => dmath::cos::<A>(a),
+		Op::Exp => dmath::exp::<A>(a),
+		Op::Log => dmath::log::<A>(a),
+		_ => dmath::atan2::<A>(a, b),
+	};
+}
+
+fn host_elementary(op: Op, a: u32, b: u32) -> f32 {
+	let (x, y) = (f32::from_bits(a) as f64, f32::from_bits(b) as f64);
+
+	return match op {
+		Op::Sin => x.sin(),
+		Op::Cos => x.cos(),
+		Op::Exp => x.exp(),
+		Op::Log => x.ln(),
+		_ => x.atan2(y),
+	} as f32;
+}
+
+// The largest error of an elementary function against the host's f64 function
+// rounded to f32 that is not a failure. The library's functions are faithful to
+// within an ulp or so of the exact result, and the rounded reference adds half
+// an ulp.
+fn max_error(op: Op) -> u64 {
+	return if op == Op::Atan2 { 3 } else { 2 };
+}
+
+// Distance in ulps between finite floats.
+fn ulps(a: u32, b: u32) -> u64 {
+	let ordered = |x: u32| if x & SIGN != 0 { -((x & !SIGN) as i64) } else { x as i64 };
+	return (ordered(a) - ordered(b)).unsigned_abs();
+}
+
+fn variant_name(id: u32) -> &'static str {
+	return match id {
+		VARIANT_SCALAR => "scalar",
+		VARIANT_SSE2 => "sse2",
+		VARIANT_AVX2 => "avx2",
+		VARIANT_AVX512 => "avx512",
+		VARIANT_NEON => "neon",
+		_ => "unknown",
+	};
+}
+
+struct Failure {
+	path: String,
+	a: u64,
+	b: u64,
+	actual: u64,
+	expected: u64,
+}
+
+#[derive(Default)]
+struct Report {
+	failures: u64,
+	examples: Vec<Failure>,
+	// Largest error of the elementary functions against the host's, and its inputs.
+	worst: (u64, u32, u32),
+}
+
+impl Report {
+	fn fail(&mut self, limit: usize, path: &str, a: u64, b: u64, actual: u64, expected: u64) {
+		self.failures += 1;
+
+		if self.examples.len() < limit {
+			self.examples.push(Failure { path: path.to_string(), a, b, actual, expected });
+		}
+	}
+
+	fn merge(&mut self, other: Report, limit: usize) {
+		self.failures += other.failures;
+		let room = limit.saturating_sub(self.examples.len());
+		self.examples.extend(other.examples.into_iter().take(room));
+
+		if other.worst.0 > self.worst.0 {
+			self.worst = other.worst;
+		}
+	}
+}
+
+// Checks inputs [start, start + len) of op.
+fn check_chunk(cfg: &Config, op: Op, inputs: &Inputs, start: u64, len: usize, limit: usize, report: &mut Report) {
+	match op {
+		Op::Add | Op::Sub | Op::Mul | Op::Div | Op::Atan2 => {
+			let (a, b): (Vec<u32>, Vec<u32>) = (start..start + len as u64).map(|i| inputs.pair(i)).unzip();
+			let mut out = vec![0; len];
+
+			let expected: Vec<u32> = if op == Op::Atan2 {
+				with_other_backend!(cfg, R => a.iter().zip(&b).map(|(&a, &b)| elementary::<R>(op, a, b)).collect())
+			} else {
+				a.iter().zip(&b).map(|(&a, &b)| arith_reference(cfg, op, a, b)).collect()
+			};
+
+			for i in 0..len {
+				let actual = unsafe {
+					match op {
+						Op::Add => float_add(a[i], b[i]),
+						Op::Sub => float_sub(a[i], b[i]),
+						Op::Mul => float_mul(a[i], b[i]),
+						Op::Div => float_div(a[i], b[i]),
+						_ => float_atan2(a[i], b[i]),
+					}
+				};
+
+				if !cfg.same(actual, expected[i]) {
+					report.fail(limit, "scalar", a[i] as u64, b[i] as u64, actual as u64, expected[i] as u64);
+				}
+			}
+
+			if op == Op::Atan2 {
+				unsafe { float_atan2_batch(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), len) };
+				check_outputs(cfg, "batch", &a, &b, &out, &expected, limit, report);
+				measure(cfg, op, &a, &b, &out, limit, report);
+				return;
+			}
+
+			let kernel = op as usize - Op::Add as usize;
+
+			unsafe { float_oracle_batch(kernel as u32, a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), len) };
+			check_outputs(cfg, "oracle", &a, &b, &out, &expected, limit, report);
+
+			for variant in VARIANTS.iter().filter(|v| (v.detect)()) {
+				let f = variant.kernels[cfg.nans as usize][cfg.denormals as usize][cfg.backend as usize][kernel];
+				unsafe { f(a.as_ptr(), b.as_ptr(), out.as_mut_ptr(), len) };
+				check_outputs(cfg, variant_name(variant.id), &a, &b, &out, &expected, limit, report);
+			}
+		}
+		Op::Sqrt | Op::Sin | Op::Cos | Op::Exp | Op::Log => {
+			let x: Vec<u32> = (start..start + len as u64).map(|i| i as u32).collect();
+			let mut out = vec![0; len];
+
+			let expected: Vec<u32> = if op == Op::Sqrt {
+				x.iter().map(|&x| arith_reference(cfg, op, x, 0)).collect()
+			} else {
+				with_other_backend!(cfg, R => x.iter().map(|&x| elementary::<R>(op, x, 0)).collect())
+			};
+
+			for i in 0..len {
+				let actual = match op {
+					Op::Sqrt => float_sqrt(x[i]),
+					Op::Sin => float_sin(x[i]),
+					Op::Cos => float_cos(x[i]),
+					Op::Exp => float_exp(x[i]),
+					_ => float_log(x[i]),
+				};
+
+				if !cfg.same(actual, expected[i]) {
+					report.fail(limit, "scalar", x[i] as u64, 0, actual as u64, expected[i] as u64);
+				}
+			}
+
+			unsafe {
+				match op {
+					Op::Sqrt => float_sqrt_batch(x.as_ptr(), out.as_mut_ptr(), len),
+					Op::Sin => float_sin_batch(x.as_ptr(), out.as_mut_ptr(), len),
+					Op::Cos => float_cos_batch(x.as_ptr(), out.as_mut_ptr(), len),
+					Op::Exp => float_exp_batch(x.as_ptr(), out.as_mut_ptr(), len),
+					_ => float_log_batch(x.as_ptr(), out.as_mut_ptr(), len),
+				}
+			}
+
+			let zeros = vec![0; len];
+			check_outputs(cfg, "batch", &x, &zeros, &out, &expected, limit, report);
+
+			if op != Op::Sqrt {
+				measure(cfg, op, &x, &zeros, &out, limit, report);
+			}
+		}
+		Op::ToI32 | Op::ToU32 | Op::ToI64 => {
+			let x: Vec<u32> = (start..start + len as u64).map(|i| i as u32).collect();
+
+			for &(mode, mode_name) in &MODES {
+				let mut out = vec![0u64; len];
+
+				unsafe {
+					match op {
+						Op::ToI32 => {
+							let mut ints = vec![0i32; len];
+							float_to_i32_batch(x.as_ptr(), ints.as_mut_ptr(), len, mode);
+							out.iter_mut().zip(&ints).for_each(|(o, &v)| *o = v as u32 as u64);
+						}
+						Op::ToU32 => {
+							let mut ints = vec![0u32; len];
+							float_to_u32_batch(x.as_ptr(), ints.as_mut_ptr(), len, mode);
+							out.iter_mut().zip(&ints).for_each(|(o, &v)| *o = v as u64);
+						}
+						_ => {
+							let mut ints = vec![0i64; len];
+							float_to_i64_batch(x.as_ptr(), ints.as_mut_ptr(), len, mode);
+							out.iter_mut().zip(&ints).for_each(|(o, &v)| *o = v as u64);
+						}
+					}
+				}
+
+				for i in 0..len {
+					let expected = to_int_reference(cfg, op, x[i], mode);
+
+					let actual = match op {
+						Op::ToI32 => float_to_i32(x[i], mode) as u32 as u64,
+						Op::ToU32 => float_to_u32(x[i], mode) as u64,
+						_ => float_to_i64(x[i], mode) as u64,
+					};
+
+					if actual != expected {
+						report.fail(limit, &format!("{} scalar", mode_name), x[i] as u64, 0, actual, expected);
+					}
+
+					if out[i] != expected {
+						report.fail(limit, &format!("{} batch", mode_name), x[i] as u64, 0, out[i], expected);
+					}
+				}
+			}
+		}
+		Op::FromI32 | Op::FromU32 | Op::FromI64 => {
+			let x: Vec<i128> = (start..start + len as u64)
+				.map(|i| match op {
+					Op::FromI32 => i as u32 as i32 as i128,
+					Op::FromU32 => i as u32 as i128,
+					_ => inputs.long(i) as i128,
+				})
+				.collect();
+
+			for &(mode, mode_name) in &MODES {
+				let mut out = vec![0u32; len];
+
+				unsafe {
+					match op {
+						Op::FromI32 => {
+							let ints: Vec<i32> = x.iter().map(|&v| v as i32).collect();
+							float_from_i32_batch(ints.as_ptr(), out.as_mut_ptr(), len, mode);
+						}
+						Op::FromU32 => {
+							let ints: Vec<u32> = x.iter().map(|&v| v as u32).collect();
+							float_from_u32_batch(ints.as_ptr(), out.as_mut_ptr(), len, mode);
+						}
+						_ => {
+							let ints: Vec<i64> = x.iter().map(|&v| v as i64).collect();
+							float_from_i64_batch(ints.as_ptr(), out.as_mut_ptr(), len, mode);
+						}
+					}
+				}
+
+				for i in 0..len {
+					let expected = from_int_reference(x[i], mode);
+
+					let actual = match op {
+						Op::FromI32 => float_from_i32(x[i] as i32, mode),
+						Op::FromU32 => float_from_u32(x[i] as u32, mode),
+						_ => float_from_i64(x[i] as i64, mode),
+					};
+
+					if actual != expected {
+						report.fail(limit, &format!("{} scalar", mode_name), x[i] as u64, 0, actual as u64, expected as u64);
+					}
+
+					if out[i] != expected {
+						report.fail(limit, &format!("{} batch", mode_name), x[i] as u64, 0, out[i] as u64, expected as u64);
+					}
+				}
+			}
+		}
+	}
+}
+
+fn check_outputs(cfg: &Config, path: &str, a: &[u32], b: &[u32], out: &[u32], expected: &[u32], limit: usize, report: &mut Report) {
+	for i in 0..out.len() {
+		if !cfg.same(out[i], expected[i]) {
+			report.fail(limit, path, a[i] as u64, b[i] as u64, out[i] as u64, expected[i] as u64);
+		}
+	}
+}
+
+// Records the largest error of out against the host's f64 functions, over the
+// results that are normal or zero, so flushing doesn't count as error, and fails
+// those beyond max_error.
+fn measure(cfg: &Config, op: Op, a: &[u32], b: &[u32], out: &[u32], limit: usize, report: &mut Report) {
+	for i in 0..out.len() {
+		if cfg.flush() && (flush(a[i]) != a[i] || flush(b[i]) != b[i]) {
+			continue;
+		}
+
+		let host = host_elementary(op, a[i], b[i]);
+
+		if !host.is_finite() || (host != 0.0 && !host.is_normal()) || out[i] & EXP_MASK == EXP_MASK {
+			continue;
+		}
+
+		let error = ulps(out[i], host.to_bits());
+
+		if error > max_error(op) {
+			report.fail(limit, "f64", a[i] as u64, b[i] as u64, out[i] as u64, host.to_bits() as u64);
+		}
+
+		if error > report.worst.0 {
+			report.worst = (error, a[i], b[i]);
+		}
+	}
+}
+
+// The finished chunks and failure count of each task, keyed by task, config and
+// inputs, saved as one line per task.
+struct Checkpoint {
+	path: Option<String>,
+	tasks: HashMap<String, (u64, Vec<u64>)>,
+}
+
+impl Checkpoint {
+	fn load(path: Option<String>) -> Checkpoint {
+		let mut tasks = HashMap::new();
+
+		if let Some(text) = path.as_ref().and_then(|p| fs::read_to_string(p).ok()) {
+			for line in text.lines().skip(1) {
+				let fields: Vec<&str> = line.split(' ').collect();
+
+				if fields.len() < 2 {
+					continue;
+				}
+
+				let failures = fields[1].parse().unwrap_or(0);
+				let done = fields[2..].iter().map(|w| u64::from_str_radix(w, 16).unwrap_or(0)).collect();
+				tasks.insert(fields[0].to_string(), (failures, done));
+			}
+		}
+
+		return Checkpoint { path, tasks };
+	}
+
+	fn save(&self) {
+		let path = match &self.path {
+			Some(path) => path,
+			None => return,
+		};
+
+		let mut text = String::from("verify checkpoint 1\n");
+
+		for (key, (failures, done)) in &self.tasks {
+			text += &format!("{} {}", key, failures);
+
+			for word in done {
+				text += &format!(" {:x}", word);
+			}
+
+			text += "\n";
+		}
+
+		// Written aside and renamed, so an interrupted save leaves the last one intact.
+		let temp = format!("{}.tmp", path);
+
+		if fs::write(&temp, text).and_then(|_| fs::rename(&temp, path)).is_err() {
+			eprintln!("failed to write checkpoint {}", path);
+		}
+	}
+}
+
+struct Options {
+	configs: Vec<Config>,
+	ops: Vec<(Op, &'static str)>,
+	threads: usize,
+	pairs: u64,
+	seed: u64,
+	random: bool,
+	structured: bool,
+	range: (u64, u64),
+	checkpoint: Option<String>,
+	examples: usize,
+}
+
+fn parse_number(s: &str) -> Option<u64> {
+	let s = s.replace('_', "");
+
+	return match s.strip_prefix("0x") {
+		Some(hex) => u64::from_str_radix(hex, 16).ok(),
+		None => s.parse().ok(),
+	};
+}
+
+fn parse_choice(value: &str, choices: &[(&str, u32)]) -> Option<Vec<u32>> {
+	if value == "all" {
+		return Some(choices.iter().map(|c| c.1).collect());
+	}
+
+	return choices.iter().find(|c| c.0 == value).map(|c| vec![c.1]);
+}
+
+fn usage<T>(error: &str) -> T {
+	eprintln!("{}\n\n{}", error, USAGE);
+	process::exit(2);
+}
+
+fn parse_options() -> Options {
+	let mut backends = vec![BACKEND_HARDWARE, BACKEND_SOFT];
+	let mut denormals = vec![DENORMALS_PRESERVE];
+	let mut nans = vec![NANS_PRESERVE];
+	let mut options = Options {
+		configs: Vec::new(),
+		ops: Vec::new(),
+		threads: thread::available_parallelism().map(|n| n.get()).unwrap_or(1),
+		pairs: 1 << 28,
+		seed: 1,
+		random: true,
+		structured: true,
+		range: (0, 1 << 32),
+		checkpoint: None,
+		examples: 8,
+	};
+
+	let mut args = env::args().skip(1);
+
+	while let Some(arg) = args.next() {
+		if arg == "--help" {
+			println!("{}", USAGE);
+			process::exit(0);
+		}
+
+		if !arg.starts_with("--") {
+			match OPS.iter().find(|op| op.1 == arg) {
+				Some(&op) => options.ops.push(op),
+				None => usage(&format!("unknown task {}", arg)),
+			}
+			continue;
+		}
+
+		let value = args.next().unwrap_or_else(|| usage(&format!("missing value for {}", arg)));
+		let invalid = format!("invalid value {} for {}", value, arg);
+
+		match arg.as_str() {
+			"--backend" => backends = parse_choice(&value, &[("hardware", BACKEND_HARDWARE), ("soft", BACKEND_SOFT)]).unwrap_or_else(|| usage(&invalid)),
+			"--denormals" => denormals = parse_choice(&value, &[("preserve", DENORMALS_PRESERVE), ("flush", DENORMALS_FLUSH)]).unwrap_or_else(|| usage(&invalid)),
+			"--nans" => nans = parse_choice(&value, &[("preserve", NANS_PRESERVE), ("canonical", NANS_CANONICAL)]).unwrap_or_else(|| usage(&invalid)),
+			"--threads" => options.threads = parse_number(&value).filter(|&n| n > 0).unwrap_or_else(|| usage(&invalid)) as usize,
+			"--pairs" => options.pairs = parse_number(&value).unwrap_or_else(|| usage(&invalid)),
+			"--seed" => options.seed = parse_number(&value).unwrap_or_else(|| usage(&invalid)),
+			"--examples" => options.examples = parse_number(&value).unwrap_or_else(|| usage(&invalid)) as usize,
+			"--checkpoint" => options.checkpoint = Some(value.clone()),
+			"--sweep" => {
+				options.random = value == "random" || value == "all";
+				options.structured = value == "structured" || value == "all";
+
+				if !options.random && !options.structured {
+					usage::<()>(&invalid);
+				}
+			}
+			"--range" => {
+				let bounds: Vec<Option<u64>> = value.split(':').map(parse_number).collect();
+
+				options.range = match bounds[..] {
+					[Some(start), Some(end)] if start < end && end <= 1 << 32 => (start, end),
+					_ => usage(&invalid),
+				};
+			}
+			_ => usage(&format!("unknown option {}", arg)),
+		}
+	}
+
+	if options.ops.is_empty() {
+		options.ops = OPS.to_vec();
+	}
+
+	for &backend in &backends {
+		for &denormals in &denormals {
+			for &nans in &nans {
+				options.configs.push(Config { backend, denormals, nans });
+			}
+		}
+	}
+
+	return options;
+}
+
+// Runs the unfinished chunks of one task on every thread, printing progress, and
+// returns the report including failures counted by earlier runs.
+fn run_task(options: &Options, cfg: &Config, op: Op, inputs: &Inputs, checkpoint: &mut Checkpoint, key: &str) -> Report {
+	let first = match *inputs {
+		Inputs::Range(start, _) => start,
+		_ => 0,
+	};
+	let total = inputs.count(op);
+	let chunks = (total + CHUNK - 1) / CHUNK;
+	let words = ((chunks + 63) / 64) as usize;
+
+	let (failures, done) = match checkpoint.tasks.get(key) {
+		Some((failures, done)) if done.len() == words => (*failures, done.clone()),
+		_ => (0, vec![0; words]),
+	};
+
+	let chunk_len = |c: u64| std::cmp::min(CHUNK, total - c * CHUNK);
+	let finished_before: u64 = (0..chunks).filter(|&c| done[(c / 64) as usize] & (1 << (c % 64)) != 0).map(chunk_len).sum();
+
+	let done: Vec<AtomicU64> = done.into_iter().map(AtomicU64::new).collect();
+	let report = Mutex::new(Report { failures, ..Report::default() });
+	let next = AtomicU64::new(0);
+	let finished = AtomicU64::new(0);
+	let start = Instant::now();
+	// Nanoseconds from start to the last chunk finishing, for the throughput.
+	let elapsed = AtomicU64::new(0);
+	let mut saved = Instant::now();
+	let mut last_print = Instant::now();
+
+	thread::scope(|s| {
+		let workers: Vec<_> = (0..options.threads)
+			.map(|_| {
+				s.spawn(|| loop {
+					let c = next.fetch_add(1, Ordering::Relaxed);
+
+					if c >= chunks {
+						break;
+					}
+
+					let (word, bit) = ((c / 64) as usize, 1u64 << (c % 64));
+
+					if done[word].load(Ordering::Relaxed) & bit != 0 {
+						continue;
+					}
+
+					let mut chunk = Report::default();
+					check_chunk(cfg, op, inputs, first + c * CHUNK, chunk_len(c) as usize, options.examples, &mut chunk);
+
+					// Under the lock, so a checkpoint sees failures and finished chunks agree.
+					let mut report = report.lock().unwrap();
+					report.merge(chunk, options.examples);
+					done[word].fetch_or(bit, Ordering::Relaxed);
+					finished.fetch_add(chunk_len(c), Ordering::Relaxed);
+					elapsed.fetch_max(start.elapsed().as_nanos() as u64, Ordering::Relaxed);
+				})
+			})
+			.collect();
+
+		while workers.iter().any(|w| !w.is_finished()) {
+			thread::sleep(Duration::from_millis(50));
+
+			if last_print.elapsed() < Duration::from_secs(1) {
+				continue;
+			}
+
+			last_print = Instant::now();
+
+			let count = finished.load(Ordering::Relaxed);
+			let rate = count as f64 / start.elapsed().as_secs_f64();
+			let left = total - finished_before - count;
+			eprint!(
+				"\r  {}/{} ({:.1}%) {:.2} M/s, {:.0}s left, {} failures   ",
+				finished_before + count,
+				total,
+				100.0 * (finished_before + count) as f64 / total as f64,
+				rate / 1e6,
+				left as f64 / rate.max(1.0),
+				report.lock().unwrap().failures
+			);
+
+			if checkpoint.path.is_some() && saved.elapsed() > CHECKPOINT_INTERVAL {
+				let report = report.lock().unwrap();
+				let words = done.iter().map(|w| w.load(Ordering::Relaxed)).collect();
+				checkpoint.tasks.insert(key.to_string(), (report.failures, words));
+				checkpoint.save();
+				saved = Instant::now();
+			}
+		}
+	});
+
+	eprint!("\r{:80}\r", "");
+
+	let report = report.into_inner().unwrap();
+	checkpoint.tasks.insert(key.to_string(), (report.failures, done.iter().map(|w| w.load(Ordering::Relaxed)).collect()));
+	checkpoint.save();
+
+	let count = finished.load(Ordering::Relaxed);
+	let seconds = elapsed.load(Ordering::Relaxed) as f64 / 1e9;
+	println!(
+		"  {:<9} {:<34} {:>11} inputs {:>8.1}s {:>8.2} M/s {:>10} failures",
+		op_name(op),
+		inputs.name(),
+		total,
+		seconds,
+		count as f64 / seconds.max(1e-9) / 1e6,
+		report.failures
+	);
+
+	return report;
+}
+
+fn op_name(op: Op) -> &'static str {
+	return OPS.iter().find(|o| o.0 == op).unwrap().1;
+}
+
+fn main() {
+	let options = parse_options();
+	let mut checkpoint = Checkpoint::load(options.checkpoint.clone());
+	let mut failures = 0;
+
+	println!("{} threads, chunks of {} inputs", options.threads, CHUNK);
+
+	for cfg in &options.configs {
+		cfg.select();
+		println!("{}", cfg.name());
+
+		for &(op, _) in &options.ops {
+			let mut sets = Vec::new();
+
+			if op.exhaustive() {
+				sets.push(Inputs::Range(options.range.0, options.range.1));
+			} else {
+				if options.random {
+					sets.push(Inputs::Random(options.pairs, options.seed));
+				}
+				if options.structured {
+					sets.push(Inputs::Structured);
+				}
+			}
+
+			for inputs in &sets {
+				let key = format!("{}:{}:{}", op_name(op), cfg.name(), inputs.name());
+				let report = run_task(&options, cfg, op, inputs, &mut checkpoint, &key);
+				failures += report.failures;
+
+				for f in &report.examples {
+					if matches!(op, Op::Add | Op::Sub | Op::Mul | Op::Div | Op::Atan2) {
+						println!("    {:<16} {:#010x} {:#010x} gave {:#010x}, expected {:#010x}", f.path, f.a, f.b, f.actual, f.expected);
+					} else {
+						println!("    {:<16} {:#x} gave {:#x}, expected {:#x}", f.path, f.a, f.actual, f.expected);
+					}
+				}
+
+				if op.elementary() && report.worst.0 > 0 {
+					println!("    largest error against f64 {} ulp, at {:#010x} {:#010x}", report.worst.0, report.worst.1, report.worst.2);
+				}
+			}
+		}
+	}
+
+	if failures > 0 {
+		println!("{} failures", failures);
+		process::exit(1);
+	}
+
+	println!("no failures");
+}
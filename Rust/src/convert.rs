@@ -0,0 +1,240 @@
+use crate::arith::Arith;
+use crate::batch::map1;
+use crate::soft::{is_nan, EXP_MASK, FRAC_MASK, SIGN};
+use crate::trace::{self, TRACE_FROM_I32, TRACE_FROM_I64, TRACE_FROM_U32, TRACE_TO_I32, TRACE_TO_I64, TRACE_TO_U32};
+
+// Conversions between dfloat and i32, u32 and i64, with an explicit rounding mode:
+//
+//   ROUND_TRUNCATE   toward zero
+//   ROUND_HALF_EVEN  to nearest, ties to even (IEEE-754's default)
+//   ROUND_FLOOR      toward negative infinity
+//
+// Float to integer conversions saturate: values beyond the target's range give its
+// minimum or maximum, including infinities, and NaN gives 0. Integer to float
+// conversions round the integer to 24 significant bits with the same modes and
+// never overflow. Zero always converts to +0.
+//
+// The functions here use integer operations only and back the soft backend. The
+// hardware backend uses the FPU where Rust specifies the same results, see
+// arith.rs. Any mode other than the three above is taken as ROUND_HALF_EVEN.
+
+pub const ROUND_TRUNCATE: u32 = 0;
+pub const ROUND_HALF_EVEN: u32 = 1;
+pub const ROUND_FLOOR: u32 = 2;
+
+const HIDDEN_BIT: u64 = 0x80_0000;
+
+// Evaluates body with the constant M bound to the rounding mode mode, so kernels
+// are monomorphized per mode like they are per backend.
+macro_rules! with_mode {
+	($M:ident, $mode:expr => $body:expr) => {
+		match $mode {
+			ROUND_TRUNCATE => {
+				const $M: u32 = ROUND_TRUNCATE;
+				$body
+			}
+			ROUND_FLOOR => {
+				const $M: u32 = ROUND_FLOOR;
+				$body
+			}
+			_ => {
+				const $M: u32 = ROUND_HALF_EVEN;
+				$body
+			}
+		}
+	};
+}
+
+// Whether a magnitude q with the discarded bits r, out of 2 * half, rounds up.
+#[inline(always)]
+fn round_up<const MODE: u32>(negative: bool, q: u64, r: u64, half: u64) -> bool {
+	return match MODE {
+		ROUND_TRUNCATE => false,
+		ROUND_FLOOR => negative && r != 0,
+		_ => r > half || (r == half && q & 1 != 0),
+	};
+}
+
+// x rounded to an integer and clamped to [min, max], where min and max are within
+// the range of i64.
+#[inline(always)]
+pub fn to_int<const MODE: u32>(x: u32, min: i64, max: i64) -> i64 {
+	if is_nan(x) {
+		return 0;
+	}
+
+	let negative = x & SIGN != 0;
+	let exp = ((x & EXP_MASK) >> 23) as i32;
+
+	// |x| >= 2^63, beyond every target.
+	if exp >= 127 + 63 {
+		return if negative { min } else { max };
+	}
+
+	let sig = (x & FRAC_MASK) as u64 | if exp != 0 { HIDDEN_BIT } else { 0 };
+
+	// |x| = sig * 2^(max(exp, 1) - 150).
+	let shift = exp.max(1) - 150;
+
+	let q = if shift >= 0 {
+		sig << shift
+	} else {
+		// sig has 24 bits, so anything shifted by 63 or more is less than half.
+		let s = (-shift).min(63) as u32;
+		let q = sig >> s;
+		let r = sig & ((1 << s) - 1);
+		q + round_up::<MODE>(negative, q, r, 1 << (s - 1)) as u64
+	};
+
+	// q < 2^63 as |x| < 2^63, so it always fits.
+	let value = if negative { -(q as i64) } else { q as i64 };
+
+	return value.clamp(min, max);
+}
+
+// The float nearest, in mode, to the integer with the given sign and magnitude.
+#[inline(always)]
+pub fn from_int<const MODE: u32>(negative: bool, magnitude: u64) -> u32 {
+	if magnitude == 0 {
+		return 0;
+	}
+
+	let sign = if negative { SIGN } else { 0 };
+	let bits = 64 - magnitude.leading_zeros();
+	let mut exp = bits - 1;
+
+	let sig = if bits <= 24 {
+		magnitude << (24 - bits)
+	} else {
+		let s = bits - 24;
+		let q = magnitude >> s;
+		let r = magnitude & ((1 << s) - 1);
+		let mut q = q + round_up::<MODE>(negative, q, r, 1 << (s - 1)) as u64;
+
+		if q == HIDDEN_BIT << 1 {
+			q >>= 1;
+			exp += 1;
+		}
+
+		q
+	};
+
+	return sign | ((exp + 127) << 23) | (sig as u32 & FRAC_MASK);
+}
+
+#[inline(always)]
+pub fn to_i32<const MODE: u32>(x: u32) -> i32 {
+	return to_int::<MODE>(x, i32::MIN as i64, i32::MAX as i64) as i32;
+}
+
+#[inline(always)]
+pub fn to_u32<const MODE: u32>(x: u32) -> u32 {
+	return to_int::<MODE>(x, 0, u32::MAX as i64) as u32;
+}
+
+#[inline(always)]
+pub fn to_i64<const MODE: u32>(x: u32) -> i64 {
+	return to_int::<MODE>(x, i64::MIN, i64::MAX);
+}
+
+#[inline(always)]
+pub fn from_i32<const MODE: u32>(x: i32) -> u32 {
+	return from_int::<MODE>(x < 0, x.unsigned_abs() as u64);
+}
+
+#[inline(always)]
+pub fn from_u32<const MODE: u32>(x: u32) -> u32 {
+	return from_int::<MODE>(false, x as u64);
+}
+
+#[inline(always)]
+pub fn from_i64<const MODE: u32>(x: i64) -> u32 {
+	return from_int::<MODE>(x < 0, x.unsigned_abs());
+}
+
+#[no_mangle]
+pub extern "C" fn float_to_i32(x: u32, mode: u32) -> i32 {
+	let r = with_backend!(A => with_mode!(M, mode => A::to_i32::<M>(x)));
+	return trace::op(TRACE_TO_I32, x, mode, r as u32) as i32;
+}
+
+#[no_mangle]
+pub extern "C" fn float_to_u32(x: u32, mode: u32) -> u32 {
+	return trace::op(TRACE_TO_U32, x, mode, with_backend!(A => with_mode!(M, mode => A::to_u32::<M>(x))));
+}
+
+#[no_mangle]
+pub extern "C" fn float_to_i64(x: u32, mode: u32) -> i64 {
+	let r = with_backend!(A => with_mode!(M, mode => A::to_i64::<M>(x)));
+	return trace::op(TRACE_TO_I64, x as u64, mode as u64, r as u64) as i64;
+}
+
+#[no_mangle]
+pub extern "C" fn float_from_i32(x: i32, mode: u32) -> u32 {
+	return trace::op(TRACE_FROM_I32, x as u32, mode, with_backend!(A => with_mode!(M, mode => A::from_i32::<M>(x))));
+}
+
+#[no_mangle]
+pub extern "C" fn float_from_u32(x: u32, mode: u32) -> u32 {
+	return trace::op(TRACE_FROM_U32, x, mode, with_backend!(A => with_mode!(M, mode => A::from_u32::<M>(x))));
+}
+
+#[no_mangle]
+pub extern "C" fn float_from_i64(x: i64, mode: u32) -> u32 {
+	let r = with_backend!(A => with_mode!(M, mode => A::from_i64::<M>(x)));
+	return trace::op(TRACE_FROM_I64, x as u64, mode as u64, r as u64) as u32;
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_to_i32_batch(x: *const u32, out: *mut i32, len: usize, mode: u32) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_to_i32(x, mode));
+	}
+
+	with_backend!(A => with_mode!(M, mode => map1(x, out, len, A::to_i32::<M>)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_to_u32_batch(x: *const u32, out: *mut u32, len: usize, mode: u32) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_to_u32(x, mode));
+	}
+
+	with_backend!(A => with_mode!(M, mode => map1(x, out, len, A::to_u32::<M>)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_to_i64_batch(x: *const u32, out: *mut i64, len: usize, mode: u32) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_to_i64(x, mode));
+	}
+
+	with_backend!(A => with_mode!(M, mode => map1(x, out, len, A::to_i64::<M>)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_from_i32_batch(x: *const i32, out: *mut u32, len: usize, mode: u32) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_from_i32(x, mode));
+	}
+
+	with_backend!(A => with_mode!(M, mode => map1(x, out, len, A::from_i32::<M>)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_from_u32_batch(x: *const u32, out: *mut u32, len: usize, mode: u32) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_from_u32(x, mode));
+	}
+
+	with_backend!(A => with_mode!(M, mode => map1(x, out, len, A::from_u32::<M>)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_from_i64_batch(x: *const i64, out: *mut u32, len: usize, mode: u32) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_from_i64(x, mode));
+	}
+
+	with_backend!(A => with_mode!(M, mode => map1(x, out, len, A::from_i64::<M>)));
+}
@@ -0,0 +1,182 @@
+use crate::random::Random;
+use crate::soft::{EXP_MASK, FRAC_MASK, INFINITY, QUIET_BIT, SIGN};
+use crate::{slice, slice_mut};
+
+// Test inputs drawn from the classes of floats where platforms and backends tend
+// to disagree, instead of uniformly over the bit patterns, where nearly every
+// value is a normal far from any boundary and crossing them mostly repeats the
+// same easy cases.
+//
+// The corpus is stratified: each class gets exactly its share of the inputs by
+// weight, the shares being rounded by largest remainder (ties to the lower
+// class), so every class is represented in proportion to within one input,
+// rather than only on average. The classes are generated in order and then
+// shuffled (Fisher-Yates, from the end), all from the one generator, so the
+// corpus depends only on the seed, the weights and the length. With all weights
+// zero the corpus is uniformly random bits instead, as from Random::next_u32.
+//
+// A quarter of each class's values are its edge cases, the exact boundary values
+// listed below, and the rest are drawn at random within the class. Every value
+// has a random sign.
+
+pub const CLASS_ZERO: usize = 0;
+pub const CLASS_DENORMAL: usize = 1;
+// Normals in the lowest exponents, whose results cross into the denormals.
+pub const CLASS_NORMAL_MIN: usize = 2;
+// Normals with any exponent, as the uniform inputs are.
+pub const CLASS_NORMAL: usize = 3;
+// Normals within 2^12 of one, the range most game values are in.
+pub const CLASS_NEAR_ONE: usize = 4;
+// Normals in the highest exponents, whose results overflow.
+pub const CLASS_NORMAL_MAX: usize = 5;
+// Values near one with only a few significant bits, so sums of two of them whose
+// exponents differ by 24 or 25 fall exactly halfway between two floats, and
+// products are often exact or halfway.
+pub const CLASS_TIE: usize = 6;
+pub const CLASS_INFINITY: usize = 7;
+pub const CLASS_QUIET_NAN: usize = 8;
+pub const CLASS_SIGNALLING_NAN: usize = 9;
+// Integers and halves near the limits of the integer conversions and of the
+// floats' own integer range.
+pub const CLASS_INTEGER_EDGE: usize = 10;
+
+pub const CLASSES: usize = 11;
+
+pub const DEFAULT_WEIGHTS: [u32; CLASSES] = [4, 10, 8, 20, 20, 8, 16, 2, 4, 4, 4];
+
+const MIN_NORMAL: u32 = 0x0080_0000;
+const MAX_FINITE: u32 = 0x7f7f_ffff;
+const ONE: u32 = 0x3f80_0000;
+
+fn edges(class: usize) -> &'static [u32] {
+	return match class {
+		CLASS_ZERO => &[0],
+		CLASS_DENORMAL => &[1, 2, 3, FRAC_MASK, FRAC_MASK - 1, MIN_NORMAL >> 1],
+		CLASS_NORMAL_MIN => &[MIN_NORMAL, MIN_NORMAL + 1, MIN_NORMAL | FRAC_MASK, 2 * MIN_NORMAL],
+		CLASS_NORMAL => &[ONE],
+		CLASS_NEAR_ONE => &[ONE, ONE - 1, ONE + 1, 0x3f00_0000, 0x4000_0000, 0x3fc0_0000],
+		CLASS_NORMAL_MAX => &[MAX_FINITE, MAX_FINITE - 1, 0x7f00_0000, 0x7f7f_fffe, 0x7e80_0000],
+		CLASS_TIE => &[ONE, 0x3380_0000, 0x3300_0000, 0x3f80_0001, 0x4b80_0001, 0x3f7f_ffff],
+		CLASS_INFINITY => &[INFINITY],
+		CLASS_QUIET_NAN => &[EXP_MASK | QUIET_BIT, EXP_MASK | FRAC_MASK],
+		CLASS_SIGNALLING_NAN => &[EXP_MASK | 1, EXP_MASK | (QUIET_BIT - 1)],
+		// 2^23, 2^24 + 2, 2^31 - 128, 2^31, 2^32, 2^63, 0.5, 1.5, 2.5.
+		_ => &[0x4b00_0000, 0x4b80_0001, 0x4eff_ffff, 0x4f00_0000, 0x4f80_0000, 0x5f00_0000, 0x3f00_0000, 0x3fc0_0000, 0x4020_0000],
+	};
+}
+
+// A random value of the class, without its sign.
+fn sample(random: &mut Random, class: usize) -> u32 {
+	let r = random.next_u32();
+	let frac = r & FRAC_MASK;
+	let choice = r >> 23;
+
+	let edges = edges(class);
+
+	if choice % 4 == 0 {
+		return edges[(choice / 4) as usize % edges.len()];
+	}
+
+	let exponent = |low: u32, count: u32| (low + choice % count) << 23;
+
+	return match class {
+		CLASS_ZERO => 0,
+		// Shifted so the leading bit is anywhere, not nearly always in the top few.
+		CLASS_DENORMAL => (frac >> (choice % 23)).max(1),
+		CLASS_NORMAL_MIN => exponent(1, 3) | frac,
+		CLASS_NORMAL => exponent(1, 254) | frac,
+		CLASS_NEAR_ONE => exponent(127 - 12, 25) | frac,
+		CLASS_NORMAL_MAX => exponent(252, 3) | frac,
+		// Up to 3 significant bits after the leading one, at any position.
+		CLASS_TIE => exponent(127 - 26, 53) | (((frac & 7) << 20) >> (choice % 21)),
+		CLASS_INFINITY => INFINITY,
+		CLASS_QUIET_NAN => EXP_MASK | QUIET_BIT | frac,
+		CLASS_SIGNALLING_NAN => EXP_MASK | (frac & (QUIET_BIT - 1)).max(1),
+		// Exponents from 2^22 (ulp 1/2) to 2^32, and 2^62 to 2^64.
+		_ => {
+			let e = if choice % 4 == 3 { exponent(127 + 62, 2) } else { exponent(127 + 22, 11) };
+			return e | frac;
+		}
+	};
+}
+
+// How many of len inputs each class gets.
+pub fn shares(weights: &[u32; CLASSES], len: usize) -> [usize; CLASSES] {
+	let total: u64 = weights.iter().map(|&w| w as u64).sum();
+	let mut shares = [0; CLASSES];
+
+	if total == 0 {
+		return shares;
+	}
+
+	let mut remainders = [0u64; CLASSES];
+	let mut assigned = 0;
+
+	for class in 0..CLASSES {
+		let exact = len as u128 * weights[class] as u128;
+		shares[class] = (exact / total as u128) as usize;
+		remainders[class] = (exact % total as u128) as u64;
+		assigned += shares[class];
+	}
+
+	for _ in assigned..len {
+		let mut largest = 0;
+
+		for class in 1..CLASSES {
+			if remainders[class] > remainders[largest] {
+				largest = class;
+			}
+		}
+
+		shares[largest] += 1;
+		remainders[largest] = 0;
+	}
+
+	return shares;
+}
+
+// Fills out with a corpus of out.len() inputs.
+pub fn fill(random: &mut Random, weights: &[u32; CLASSES], out: &mut [u32]) {
+	if weights.iter().all(|&w| w == 0) {
+		for x in out.iter_mut() {
+			*x = random.next_u32();
+		}
+
+		return;
+	}
+
+	let shares = shares(weights, out.len());
+	let mut i = 0;
+
+	for class in 0..CLASSES {
+		for _ in 0..shares[class] {
+			let sign = random.next_u32() & SIGN;
+			out[i] = sign | sample(random, class);
+			i += 1;
+		}
+	}
+
+	for i in (1..out.len()).rev() {
+		let j = (random.next_u32() as u64 * (i as u64 + 1) >> 32) as usize;
+		out.swap(i, j);
+	}
+}
+
+// Fills out with a corpus of len inputs. weights holds the weights of the first
+// classes classes, the others being zero, or is null for DEFAULT_WEIGHTS.
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_random_fill_corpus(state: *mut Random, weights: *const u32, classes: usize, out: *mut u32, len: usize) {
+	let mut all = DEFAULT_WEIGHTS;
+
+	if !weights.is_null() {
+		all = [0; CLASSES];
+
+		for (class, &w) in slice(weights, classes.min(CLASSES)).iter().enumerate() {
+			all[class] = w;
+		}
+	}
+
+	let mut random = *state;
+	fill(&mut random, &all, slice_mut(out, len));
+	*state = random;
+}
@@ -0,0 +1,63 @@
+use crate::arith::{lanes, Arith};
+use crate::batch::map2;
+use crate::trace::{self, TRACE_DOUBLE};
+use crate::vm::{OP_ADD, OP_DIV, OP_MUL, OP_SUB};
+
+// ddouble is the 64-bit counterpart of dfloat: the same operations on binary64
+// bit patterns, using the selected backend.
+
+#[no_mangle]
+pub unsafe extern "C" fn double_add(a: u64, b: u64) -> u64 {
+	return trace::op(TRACE_DOUBLE | OP_ADD, a, b, with_backend!(A => A::add64(a, b)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn double_sub(a: u64, b: u64) -> u64 {
+	return trace::op(TRACE_DOUBLE | OP_SUB, a, b, with_backend!(A => A::sub64(a, b)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn double_mul(a: u64, b: u64) -> u64 {
+	return trace::op(TRACE_DOUBLE | OP_MUL, a, b, with_backend!(A => A::mul64(a, b)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn double_div(a: u64, b: u64) -> u64 {
+	return trace::op(TRACE_DOUBLE | OP_DIV, a, b, with_backend!(A => A::div64(a, b)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn double_add_batch(a: *const u64, b: *const u64, out: *mut u64, len: usize) {
+	if trace::tracing() {
+		return trace::each2(a, b, out, len, |a, b| double_add(a, b));
+	}
+
+	with_backend!(A => map2(a, b, out, len, |x, y| lanes(x, y, A::add64), A::add64));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn double_sub_batch(a: *const u64, b: *const u64, out: *mut u64, len: usize) {
+	if trace::tracing() {
+		return trace::each2(a, b, out, len, |a, b| double_sub(a, b));
+	}
+
+	with_backend!(A => map2(a, b, out, len, |x, y| lanes(x, y, A::sub64), A::sub64));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn double_mul_batch(a: *const u64, b: *const u64, out: *mut u64, len: usize) {
+	if trace::tracing() {
+		return trace::each2(a, b, out, len, |a, b| double_mul(a, b));
+	}
+
+	with_backend!(A => map2(a, b, out, len, |x, y| lanes(x, y, A::mul64), A::mul64));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn double_div_batch(a: *const u64, b: *const u64, out: *mut u64, len: usize) {
+	if trace::tracing() {
+		return trace::each2(a, b, out, len, |a, b| double_div(a, b));
+	}
+
+	with_backend!(A => map2(a, b, out, len, |x, y| lanes(x, y, A::div64), A::div64));
+}
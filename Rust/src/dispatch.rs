@@ -0,0 +1,323 @@
+use crate::arith::{Arith, CanonicalNaNs, FlushDenormals, Hardware, Soft};
+use crate::batch::map2_blocks;
+use crate::soft;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+// The batched kernels are compiled once per vector instruction set, and the widest
+// one the CPU supports is picked the first time a batch export is called. Every
+// variant runs the same Arith operations in the same order, only more lanes at a
+// time, so they must all give the same bits, except for the payloads of NaNs when
+// they are preserved; dfloat_dispatch_self_test checks it.
+//
+// There is no NEON variant for 32-bit ARM, since ARMv7 NEON always flushes
+// denormals to zero.
+pub const VARIANT_SCALAR: u32 = 0;
+pub const VARIANT_SSE2: u32 = 1;
+pub const VARIANT_AVX2: u32 = 2;
+pub const VARIANT_AVX512: u32 = 3;
+pub const VARIANT_NEON: u32 = 4;
+
+pub const KERNEL_ADD: usize = 0;
+pub const KERNEL_SUB: usize = 1;
+pub const KERNEL_MUL: usize = 2;
+pub const KERNEL_DIV: usize = 3;
+
+pub type Kernel = unsafe fn(*const u32, *const u32, *mut u32, usize);
+
+// Indexed by NaN mode (NANS_PRESERVE, NANS_CANONICAL), then by denormal mode
+// (DENORMALS_PRESERVE, DENORMALS_FLUSH), then by backend (BACKEND_HARDWARE,
+// BACKEND_SOFT), then by KERNEL_ op.
+pub type Kernels = [[[[Kernel; 4]; 2]; 2]; 2];
+
+pub struct Variant {
+	pub id: u32,
+	pub kernels: Kernels,
+	pub detect: fn() -> bool,
+}
+
+macro_rules! variant_kernels {
+	($module:ident, $hardware:expr, $soft:expr $(, $feature:tt)?) => {
+		mod $module {
+			use super::*;
+
+			$(#[target_feature(enable = $feature)])?
+			unsafe fn add<A: Arith, const N: usize>(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+				map2_blocks::<u32, N, _, _>(a, b, out, len, A::add_lanes, A::add);
+			}
+
+			$(#[target_feature(enable = $feature)])?
+			unsafe fn sub<A: Arith, const N: usize>(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+				map2_blocks::<u32, N, _, _>(a, b, out, len, A::sub_lanes, A::sub);
+			}
+
+			$(#[target_feature(enable = $feature)])?
+			unsafe fn mul<A: Arith, const N: usize>(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+				map2_blocks::<u32, N, _, _>(a, b, out, len, A::mul_lanes, A::mul);
+			}
+
+			$(#[target_feature(enable = $feature)])?
+			unsafe fn div<A: Arith, const N: usize>(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+				map2_blocks::<u32, N, _, _>(a, b, out, len, A::div_lanes, A::div);
+			}
+
+			macro_rules! ops {
+				($A:ty, $N:expr) => {
+					[add::<$A, $N>, sub::<$A, $N>, mul::<$A, $N>, div::<$A, $N>]
+				};
+			}
+
+			pub const KERNELS: Kernels = [
+				[
+					[ops!(Hardware, $hardware), ops!(Soft, $soft)],
+					[ops!(FlushDenormals<Hardware>, $hardware), ops!(FlushDenormals<Soft>, $soft)],
+				],
+				[
+					[ops!(CanonicalNaNs<Hardware>, $hardware), ops!(CanonicalNaNs<Soft>, $soft)],
+					[ops!(CanonicalNaNs<FlushDenormals<Hardware>>, $hardware), ops!(CanonicalNaNs<FlushDenormals<Soft>>, $soft)],
+				],
+			];
+		}
+	};
+}
+
+variant_kernels!(scalar, 1, 1);
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+variant_kernels!(sse2, 8, 8, "sse2");
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+variant_kernels!(avx2, 8, 8, "avx2");
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+variant_kernels!(avx512, 8, 16, "avx512f");
+
+#[cfg(target_arch = "aarch64")]
+variant_kernels!(neon, 8, 8, "neon");
+
+fn always() -> bool {
+	return true;
+}
+
+// In order of preference, lowest first.
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+pub static VARIANTS: [Variant; 4] = [
+	Variant { id: VARIANT_SCALAR, kernels: scalar::KERNELS, detect: always },
+	Variant { id: VARIANT_SSE2, kernels: sse2::KERNELS, detect: || is_x86_feature_detected!("sse2") },
+	Variant { id: VARIANT_AVX2, kernels: avx2::KERNELS, detect: || is_x86_feature_detected!("avx2") },
+	Variant { id: VARIANT_AVX512, kernels: avx512::KERNELS, detect: || is_x86_feature_detected!("avx512f") },
+];
+
+#[cfg(target_arch = "aarch64")]
+pub static VARIANTS: [Variant; 2] = [
+	Variant { id: VARIANT_SCALAR, kernels: scalar::KERNELS, detect: always },
+	Variant { id: VARIANT_NEON, kernels: neon::KERNELS, detect: || std::arch::is_aarch64_feature_detected!("neon") },
+];
+
+#[cfg(not(any(target_arch = "x86", target_arch = "x86_64", target_arch = "aarch64")))]
+pub static VARIANTS: [Variant; 1] = [
+	Variant { id: VARIANT_SCALAR, kernels: scalar::KERNELS, detect: always },
+];
+
+const UNSELECTED: usize = usize::MAX;
+
+// Index into VARIANTS.
+static SELECTED: AtomicUsize = AtomicUsize::new(UNSELECTED);
+
+fn detect() -> usize {
+	let mut best = 0;
+
+	for (i, variant) in VARIANTS.iter().enumerate() {
+		if (variant.detect)() {
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+#[inline(always)]
+pub fn selected() -> &'static Variant {
+	let mut index = SELECTED.load(Ordering::Relaxed);
+
+	if index == UNSELECTED {
+		// Racing threads all detect the same thing, so it doesn't matter who wins.
+		index = detect();
+		SELECTED.store(index, Ordering::Relaxed);
+	}
+
+	return &VARIANTS[index];
+}
+
+#[inline(always)]
+pub fn kernel(op: usize) -> Kernel {
+	use crate::arith::{backend, denormal_mode, nan_mode};
+	return selected().kernels[nan_mode() as usize][denormal_mode() as usize][backend() as usize][op];
+}
+
+fn find(id: u32) -> Option<usize> {
+	return VARIANTS.iter().position(|v| v.id == id && (v.detect)());
+}
+
+#[no_mangle]
+pub extern "C" fn dfloat_dispatch_variant() -> u32 {
+	return selected().id;
+}
+
+// Bit (1 << id) is set for each variant this CPU can run.
+#[no_mangle]
+pub extern "C" fn dfloat_dispatch_supported() -> u32 {
+	let mut mask = 0;
+
+	for variant in VARIANTS.iter() {
+		if (variant.detect)() {
+			mask |= 1 << variant.id;
+		}
+	}
+
+	return mask;
+}
+
+// Forces the batch exports to use the given variant, and returns the previously
+// selected one. Unknown variants and ones the CPU can't run are ignored.
+#[no_mangle]
+pub extern "C" fn dfloat_set_dispatch_variant(id: u32) -> u32 {
+	let previous = selected().id;
+
+	if let Some(index) = find(id) {
+		SELECTED.store(index, Ordering::Relaxed);
+	}
+
+	return previous;
+}
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct SelfTestFailure {
+	pub variant: u32,
+	pub backend: u32,
+	pub denormals: u32,
+	pub nans: u32,
+	pub op: u32,
+	pub index: u32,
+	pub a: u32,
+	pub b: u32,
+	pub expected: u32,
+	pub actual: u32,
+}
+
+// The values DeterminismTest.Execute tests against each other, plus the other
+// edges of each class: signed zeros, smallest and largest denormals and normals,
+// infinities, and quiet and signalling NaNs of both signs.
+const SPECIALS: [u32; 22] = [
+	0x0000_0000, 0x8000_0000,
+	0x3f00_0000, 0xbf00_0000, 0x3f80_0000, 0x3f80_0001, 0x4b00_0000, 0x3380_0000,
+	0x007f_ffff, 0x0000_1fff, 0x0000_0001, 0x8000_0001, 0x807f_ffff,
+	0x0080_0000, 0x8080_0000, 0x7f7f_ffff, 0xff7f_ffff,
+	0x7f80_0000, 0xff80_0000,
+	0x7fc0_0000, 0xffc0_0000, 0x7fa0_0001,
+];
+
+const SENTINEL: u32 = 0xdead_beef;
+
+// Runs every variant this CPU supports, for both backends, both denormal modes,
+// both NaN modes and all ops, over every pair of SPECIALS and compares against the scalar Arith
+// operations. Each kernel is run on slices of several lengths and offsets, so the
+// block loops, the tails and unaligned pointers are all covered, and a sentinel
+// past the end of out catches overruns. Writes up to capacity failures to report
+// and returns the total number found.
+//
+// Results are compared bit for bit. With NaNs preserved, a NaN result whose
+// payload differs from the scalar one is a known difference rather than a
+// failure, as which NaN operand the FPU propagates depends on the order the
+// compiler puts commutative operands in. Those are counted in *nan_payloads, if
+// not null, and not reported.
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_dispatch_self_test(report: *mut SelfTestFailure, capacity: usize, nan_payloads: *mut usize) -> usize {
+	macro_rules! ops {
+		($A:ty) => {
+			[<$A>::add as fn(u32, u32) -> u32, <$A>::sub, <$A>::mul, <$A>::div]
+		};
+	}
+
+	let scalar = [
+		[
+			[ops!(Hardware), ops!(Soft)],
+			[ops!(FlushDenormals<Hardware>), ops!(FlushDenormals<Soft>)],
+		],
+		[
+			[ops!(CanonicalNaNs<Hardware>), ops!(CanonicalNaNs<Soft>)],
+			[ops!(CanonicalNaNs<FlushDenormals<Hardware>>), ops!(CanonicalNaNs<FlushDenormals<Soft>>)],
+		],
+	];
+
+	let n = SPECIALS.len() * SPECIALS.len();
+	let mut a = Vec::with_capacity(n);
+	let mut b = Vec::with_capacity(n);
+
+	for &x in SPECIALS.iter() {
+		for &y in SPECIALS.iter() {
+			a.push(x);
+			b.push(y);
+		}
+	}
+
+	let mut out = vec![0u32; n + 1];
+	let mut failures = 0;
+	let mut payloads = 0;
+
+	let mut fail = |failure: SelfTestFailure| {
+		if failures < capacity {
+			*report.add(failures) = failure;
+		}
+		failures += 1;
+	};
+
+	for variant in VARIANTS.iter().filter(|v| (v.detect)()) {
+		for nans in 0..2 {
+			for denormals in 0..2 {
+				for backend in 0..2 {
+					for op in 0..4 {
+						let kernel = variant.kernels[nans][denormals][backend][op];
+						let failure = |index: usize, a: u32, b: u32, expected: u32, actual: u32| SelfTestFailure {
+							variant: variant.id, backend: backend as u32, denormals: denormals as u32, nans: nans as u32, op: op as u32,
+							index: index as u32, a, b, expected, actual,
+						};
+
+						// Whole matrix at each misalignment, then every length up to a few blocks
+						// of the widest variant.
+						let mut slices: Vec<(usize, usize)> = (0..4).map(|start| (start, n - start)).collect();
+						slices.extend((0..=40).map(|len| (3, len)));
+
+						for (start, len) in slices {
+							out.iter_mut().for_each(|x| *x = SENTINEL);
+							kernel(a.as_ptr().add(start), b.as_ptr().add(start), out.as_mut_ptr().add(start), len);
+
+							for i in start..start + len {
+								let expected = scalar[nans][denormals][backend][op](a[i], b[i]);
+
+								if out[i] == expected {
+									continue;
+								}
+
+								if nans == 0 && soft::is_nan(out[i]) && soft::is_nan(expected) {
+									payloads += 1;
+								} else {
+									fail(failure(i, a[i], b[i], expected, out[i]));
+								}
+							}
+
+							let end = start + len;
+							if out[end] != SENTINEL || out[..start].iter().any(|&x| x != SENTINEL) {
+								fail(failure(end, 0, 0, SENTINEL, out[end]));
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if !nan_payloads.is_null() {
+		*nan_payloads = payloads;
+	}
+
+	return failures;
+}
@@ -0,0 +1,445 @@
+use crate::arith::{lanes, Arith, Float};
+use crate::batch::{map1, map2};
+use crate::soft::{is_nan, DEFAULT_NAN, EXP_MASK, FRAC_MASK, INFINITY, QUIET_BIT, SIGN};
+use crate::trace;
+use crate::vm::{OP_ATAN2, OP_COS, OP_EXP, OP_LOG, OP_SIN, OP_SQRT};
+
+// Elementary functions built from the backend's add/sub/mul/div with fixed
+// polynomials (from Cephes) and a fixed evaluation order, so they inherit the
+// determinism of the basic operations. Range reduction and special cases work on
+// the bits directly. Results are accurate to a few ulp, but are not correctly
+// rounded; what matters is that they are the same everywhere.
+//
+// NaN inputs are returned quieted, and invalid inputs (log of a negative number,
+// sin of infinity) return DEFAULT_NAN on every platform.
+//
+// When the backend flushes denormals, denormal inputs are read as zero. Results
+// come from the backend's operations, so are flushed along with them. When it
+// canonicalizes NaNs, the functions run on its uncanonical arithmetic and only
+// their results are canonicalized, so NaN inputs are returned as DEFAULT_NAN.
+
+type F<A> = Float<A>;
+
+// 1.5 * 2^23. Adding this to |t| < 2^22 rounds t to an integer held in the low
+// bits of the sum.
+const ROUNDER: f32 = 12582912.0;
+
+// Returns t rounded to the nearest integer, both as a float and an integer, for
+// |t| < 2^22.
+#[inline(always)]
+fn round_to_int<A: Arith>(t: F<A>) -> (F<A>, i32) {
+	let sum = t + F::c(ROUNDER);
+	return (sum - F::c(ROUNDER), sum.0.wrapping_sub(ROUNDER.to_bits()) as i32);
+}
+
+// Exact for |n| < 2^22.
+#[inline(always)]
+fn int_to_float<A: Arith>(n: i32) -> F<A> {
+	return F::from_bits(ROUNDER.to_bits().wrapping_add(n as u32)) - F::c(ROUNDER);
+}
+
+// 2^n for -126 <= n <= 127.
+#[inline(always)]
+fn pow2<A: Arith>(n: i32) -> F<A> {
+	return F::from_bits(((n + 127) as u32) << 23);
+}
+
+// Correctly rounded, computed exactly with integer arithmetic, so identical to an
+// IEEE-754 hardware square root.
+#[inline(always)]
+pub fn sqrt(x: u32) -> u32 {
+	if is_nan(x) {
+		return x | QUIET_BIT;
+	}
+
+	if x & !SIGN == 0 || x == INFINITY {
+		return x;
+	}
+
+	if x & SIGN != 0 {
+		return DEFAULT_NAN;
+	}
+
+	let mut exp = (x >> 23) as i32 - 127;
+	let mut sig = (x & FRAC_MASK) as u64;
+
+	if exp == -127 {
+		let shift = sig.leading_zeros() as i32 - 40;
+		sig <<= shift;
+		exp = -126 - shift;
+	} else {
+		sig |= 0x0080_0000;
+	}
+
+	if exp & 1 != 0 {
+		sig <<= 1;
+		exp -= 1;
+	}
+
+	// sqrt(sig * 2^23) has exactly 24 integer bits. The float estimate only
+	// speeds up finding the integer square root; the loops make it exact.
+	let n = sig << 23;
+	let mut root = (n as f64).sqrt() as u64;
+
+	while root * root > n {
+		root -= 1;
+	}
+
+	while (root + 1) * (root + 1) <= n {
+		root += 1;
+	}
+
+	// A square root can never lie exactly halfway between two floats.
+	if n - root * root > root {
+		root += 1;
+	}
+
+	return (((exp / 2 + 126) as u32) << 23).wrapping_add(root as u32);
+}
+
+#[inline(always)]
+fn sin_poly<A: Arith>(r: F<A>, z: F<A>) -> F<A> {
+	return ((F::c(-1.9515295891e-4) * z + F::c(8.3321608736e-3)) * z + F::c(-1.6666654611e-1)) * z * r + r;
+}
+
+#[inline(always)]
+fn cos_poly<A: Arith>(z: F<A>) -> F<A> {
+	return ((F::c(2.443315711809948e-5) * z + F::c(-1.388731625493765e-3)) * z + F::c(4.166664568298827e-2)) * z * z - F::c(0.5) * z + F::c(1.0);
+}
+
+// Bits of 2/pi, most significant first, with a zero word either side.
+const TWO_OVER_PI: [u32; 10] = [0, 0xa2f9_836e, 0x4e44_1529, 0xfc27_57d1, 0xf534_ddc0, 0xdb62_9599, 0x3c43_9041, 0xfe51_63ab, 0, 0];
+
+// pi/2 * 2^62.
+const PI_2_Q62: i128 = 0x6487_ed51_10b4_611a;
+
+// Rounds mag * 2^exp to a float.
+#[inline(always)]
+fn fixed_to_float(mag: u64, exp: i32) -> u32 {
+	if mag == 0 {
+		return 0;
+	}
+
+	let shift = mag.leading_zeros();
+	let norm = mag << shift;
+	let mut sig = (norm >> 40) as u32;
+	let rest = norm & 0xff_ffff_ffff;
+
+	if rest > 0x80_0000_0000 || (rest == 0x80_0000_0000 && sig & 1 != 0) {
+		sig += 1;
+	}
+
+	return (((63 + exp - shift as i32 + 126) as u32) << 23).wrapping_add(sig);
+}
+
+// Payne-Hanek reduction for large |x|: x * 2/pi is computed exactly enough in
+// integer arithmetic, multiplying the significand by the 96 bits of 2/pi that
+// affect the last two bits of the integer part and the fraction.
+#[inline(always)]
+fn reduce_large(x: u32) -> (u32, i32) {
+	let magnitude = x & !SIGN;
+	let sig = ((magnitude & FRAC_MASK) | 0x0080_0000) as u128;
+	let position = ((magnitude >> 23) as i32 - 120) as usize;
+	let (word, bit) = (position / 32, position % 32);
+
+	let mut window = 0u128;
+	for i in 0..4 {
+		window = (window << 32) | TWO_OVER_PI[word + i] as u128;
+	}
+	if bit != 0 {
+		window = (window << bit) | (TWO_OVER_PI[word + 4] >> (32 - bit)) as u128;
+	}
+
+	// product / 2^94 is x * 2/pi modulo 4.
+	let product = sig * (window >> 32);
+	let mut n = ((product >> 94) & 3) as i32;
+	let fraction = (product >> 30) as u64 as i64;
+
+	// Round to the nearest quadrant, leaving the fraction in [-0.5, 0.5).
+	if fraction < 0 {
+		n += 1;
+	}
+
+	let r = (fraction as i128 * PI_2_Q62) >> 62;
+	let mut r_bits = fixed_to_float(r.unsigned_abs() as u64, -64) | if r < 0 { SIGN } else { 0 };
+
+	if x & SIGN != 0 {
+		r_bits ^= SIGN;
+		n = -n;
+	}
+
+	return (r_bits, n);
+}
+
+// Reduces x to r in [-pi/4, pi/4] with x = r + n * pi/2, then picks the
+// polynomial and sign from the quadrant n + offset. Inputs below 2 use pi/2 split
+// into three parts, the first two of 8 and 11 significant bits, so that k * part
+// is exact for |k| < 2^13. Their 43 bits of pi/2 are not enough near larger
+// multiples of pi/2, where r is much smaller than x, so from 2 up reduce_large is
+// used instead.
+#[inline(always)]
+fn sin_cos<A: Arith>(x: u32, offset: i32) -> u32 {
+	let x = A::flush(x);
+	let magnitude = x & !SIGN;
+
+	if magnitude >= INFINITY {
+		return if is_nan(x) { x | QUIET_BIT } else { DEFAULT_NAN };
+	}
+
+	// Below 2^-12, sin(x) rounds to x and cos(x) to 1.
+	if magnitude < 0x3980_0000 {
+		return if offset == 0 { x } else { 0x3f80_0000 };
+	}
+
+	let (r, n) = if magnitude < 0x4000_0000 {
+		let x = F::<A>::from_bits(x);
+		let (k, n) = round_to_int(x * F::c(0.636619772367581343));
+		((x - k * F::c(1.5703125) - k * F::c(4.837512969970703125e-4) - k * F::c(7.54978995489188216e-8)).0, n)
+	} else {
+		reduce_large(x)
+	};
+
+	let r = F::<A>::from_bits(r);
+	let z = r * r;
+	let quadrant = n.wrapping_add(offset) & 3;
+
+	let y = if quadrant & 1 == 0 { sin_poly(r, z) } else { cos_poly(z) };
+
+	return if quadrant & 2 == 0 { y.0 } else { (-y).0 };
+}
+
+#[inline(always)]
+pub fn sin<A: Arith>(x: u32) -> u32 {
+	return A::canonical(sin_cos::<A::Uncanonical>(x, 0));
+}
+
+#[inline(always)]
+pub fn cos<A: Arith>(x: u32) -> u32 {
+	return A::canonical(sin_cos::<A::Uncanonical>(x, 1));
+}
+
+#[inline(always)]
+pub fn exp<A: Arith>(x: u32) -> u32 {
+	return A::canonical(exp_uncanonical::<A::Uncanonical>(x));
+}
+
+#[inline(always)]
+fn exp_uncanonical<A: Arith>(x: u32) -> u32 {
+	let x = A::flush(x);
+
+	if is_nan(x) {
+		return x | QUIET_BIT;
+	}
+
+	let x = F::<A>::from_bits(x);
+
+	if F::c(88.72283).lt(x) {
+		return INFINITY;
+	}
+
+	if x.lt(F::c(-103.972084)) {
+		return 0;
+	}
+
+	// x = r + n * ln(2), with ln(2) split in two so n * 0.693359375 is exact.
+	let (k, n) = round_to_int(x * F::c(1.44269504088896341));
+	let r = x - k * F::c(0.693359375) - k * F::c(-2.12194440e-4);
+	let z = r * r;
+	let p = (((((F::c(1.9875691500e-4) * r + F::c(1.3981999507e-3)) * r + F::c(8.3334519073e-3)) * r + F::c(4.1665795894e-2)) * r + F::c(1.6666665459e-1)) * r + F::c(5.0000001201e-1)) * z + r + F::c(1.0);
+
+	// Scale by 2^n in two steps, so the intermediate stays normal and a subnormal
+	// result is rounded only once.
+	let half = n / 2;
+	return (p * pow2(half) * pow2(n - half)).0;
+}
+
+#[inline(always)]
+pub fn log<A: Arith>(x: u32) -> u32 {
+	return A::canonical(log_uncanonical::<A::Uncanonical>(x));
+}
+
+#[inline(always)]
+fn log_uncanonical<A: Arith>(x: u32) -> u32 {
+	let x = A::flush(x);
+
+	if is_nan(x) {
+		return x | QUIET_BIT;
+	}
+
+	if x & !SIGN == 0 {
+		return SIGN | INFINITY;
+	}
+
+	if x & SIGN != 0 {
+		return DEFAULT_NAN;
+	}
+
+	if x == INFINITY {
+		return x;
+	}
+
+	let mut x = F::<A>::from_bits(x);
+	let mut e = 0;
+
+	if x.0 & EXP_MASK == 0 {
+		x = x * F::c(8388608.0);
+		e = -23;
+	}
+
+	// x = m * 2^e with m in [sqrt(0.5), sqrt(2)), and f = m - 1.
+	e += (x.0 >> 23) as i32 - 126;
+	let mut f = F::<A>::from_bits((x.0 & FRAC_MASK) | 0x3f00_0000);
+
+	if f.lt(F::c(0.707106781186547524)) {
+		e -= 1;
+		f = f + f - F::c(1.0);
+	} else {
+		f = f - F::c(1.0);
+	}
+
+	let z = f * f;
+	let mut y = ((((((((F::c(7.0376836292e-2) * f + F::c(-1.1514610310e-1)) * f + F::c(1.1676998740e-1)) * f + F::c(-1.2420140846e-1)) * f + F::c(1.4249322787e-1)) * f + F::c(-1.6668057665e-1)) * f + F::c(2.0000714765e-1)) * f + F::c(-2.4999993993e-1)) * f + F::c(3.3333331174e-1)) * f * z;
+
+	let fe = int_to_float::<A>(e);
+	y = y + fe * F::c(-2.12194440e-4);
+	y = y - F::c(0.5) * z;
+
+	return (f + y + fe * F::c(0.693359375)).0;
+}
+
+// atan(t) for t in [0, 1].
+#[inline(always)]
+fn atan01<A: Arith>(t: F<A>) -> F<A> {
+	let (t, offset) = if F::c(0.414213562373095).lt(t) { ((t - F::c(1.0)) / (t + F::c(1.0)), F::c(0.785398163397448)) } else { (t, F::c(0.0)) };
+	let z = t * t;
+
+	return offset + ((((F::c(8.05374449538e-2) * z + F::c(-1.38776856032e-1)) * z + F::c(1.99777106478e-1)) * z + F::c(-3.33329491539e-1)) * z * t + t);
+}
+
+#[inline(always)]
+pub fn atan2<A: Arith>(y: u32, x: u32) -> u32 {
+	return A::canonical(atan2_uncanonical::<A::Uncanonical>(y, x));
+}
+
+#[inline(always)]
+fn atan2_uncanonical<A: Arith>(y: u32, x: u32) -> u32 {
+	let (y, x) = (A::flush(y), A::flush(x));
+
+	if is_nan(y) {
+		return y | QUIET_BIT;
+	}
+
+	if is_nan(x) {
+		return x | QUIET_BIT;
+	}
+
+	const PI: f32 = 3.14159265358979323846;
+	const PI_2: f32 = 1.57079632679489661923;
+	const PI_4: f32 = 0.785398163397448309616;
+	const PI_3_4: f32 = 2.35619449019234492885;
+
+	let sign = y & SIGN;
+	let x_negative = x & SIGN != 0;
+	let ay = y & !SIGN;
+	let ax = x & !SIGN;
+
+	let angle = if ay == INFINITY && ax == INFINITY {
+		F::<A>::c(if x_negative { PI_3_4 } else { PI_4 })
+	} else if ax == INFINITY || ay == 0 {
+		F::c(if x_negative { PI } else { 0.0 })
+	} else if ay == INFINITY || ax == 0 {
+		F::c(PI_2)
+	} else {
+		let swap = ay > ax;
+		let t = if swap { F::from_bits(ax) / F::from_bits(ay) } else { F::from_bits(ay) / F::from_bits(ax) };
+		let a = atan01(t);
+		let a = if swap { F::c(PI_2) - a } else { a };
+		if x_negative { F::c(PI) - a } else { a }
+	};
+
+	return angle.0 | sign;
+}
+
+#[no_mangle]
+pub extern "C" fn float_sqrt(x: u32) -> u32 {
+	return trace::op(OP_SQRT, x, 0, with_backend!(A => A::canonical(sqrt(A::flush(x)))));
+}
+
+#[no_mangle]
+pub extern "C" fn float_sin(x: u32) -> u32 {
+	return trace::op(OP_SIN, x, 0, with_backend!(A => sin::<A>(x)));
+}
+
+#[no_mangle]
+pub extern "C" fn float_cos(x: u32) -> u32 {
+	return trace::op(OP_COS, x, 0, with_backend!(A => cos::<A>(x)));
+}
+
+#[no_mangle]
+pub extern "C" fn float_atan2(y: u32, x: u32) -> u32 {
+	return trace::op(OP_ATAN2, y, x, with_backend!(A => atan2::<A>(y, x)));
+}
+
+#[no_mangle]
+pub extern "C" fn float_exp(x: u32) -> u32 {
+	return trace::op(OP_EXP, x, 0, with_backend!(A => exp::<A>(x)));
+}
+
+#[no_mangle]
+pub extern "C" fn float_log(x: u32) -> u32 {
+	return trace::op(OP_LOG, x, 0, with_backend!(A => log::<A>(x)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_sqrt_batch(x: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_sqrt(x));
+	}
+
+	with_backend!(A => map1(x, out, len, |x| A::canonical(sqrt(A::flush(x)))));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_sin_batch(x: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_sin(x));
+	}
+
+	with_backend!(A => map1(x, out, len, sin::<A>));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_cos_batch(x: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_cos(x));
+	}
+
+	with_backend!(A => map1(x, out, len, cos::<A>));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_atan2_batch(y: *const u32, x: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each2(y, x, out, len, |y, x| float_atan2(y, x));
+	}
+
+	with_backend!(A => map2(y, x, out, len, |y, x| lanes(y, x, atan2::<A>), atan2::<A>));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_exp_batch(x: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_exp(x));
+	}
+
+	with_backend!(A => map1(x, out, len, exp::<A>));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_log_batch(x: *const u32, out: *mut u32, len: usize) {
+	if trace::tracing() {
+		return trace::each1(x, out, len, |x| float_log(x));
+	}
+
+	with_backend!(A => map1(x, out, len, log::<A>));
+}
@@ -0,0 +1,210 @@
+use crate::arith::lanes;
+use crate::batch::{map1, map2};
+
+// Fixed-point numbers, the usual alternative to verified floats in lockstep games:
+// Q16.16 stored in an i32 and Q32.32 stored in an i64, where the raw integer is the
+// value times 2^16 or 2^32. Everything is integer arithmetic, so results are the
+// same on every platform by construction, and do not depend on the float backend.
+//
+// Every operation has a wrapping variant, where results that do not fit wrap
+// around like two's complement integers, and a saturating variant, where they
+// clamp to the largest or smallest representable value.
+//
+//   add, sub   exact, apart from overflow
+//   mul        rounded to nearest, ties away from zero
+//   div        rounded to nearest, ties away from zero. Dividing by zero gives
+//              the largest value for a positive dividend, the smallest for a
+//              negative one and 0 for 0, in both variants.
+//   recip      1 / x, as saturating div
+//   sqrt       rounded to nearest; 0 for zero and negative inputs. The result
+//              always fits, so there is only one variant.
+
+pub trait Fixed: Copy + Default {
+	fn add_wrapping(a: Self, b: Self) -> Self;
+	fn add_saturating(a: Self, b: Self) -> Self;
+	fn sub_wrapping(a: Self, b: Self) -> Self;
+	fn sub_saturating(a: Self, b: Self) -> Self;
+	fn mul_wrapping(a: Self, b: Self) -> Self;
+	fn mul_saturating(a: Self, b: Self) -> Self;
+	fn div_wrapping(a: Self, b: Self) -> Self;
+	fn div_saturating(a: Self, b: Self) -> Self;
+	fn recip(x: Self) -> Self;
+	fn sqrt(x: Self) -> Self;
+}
+
+// T is the storage type, W a signed type twice as wide, U the unsigned version of
+// W and FRAC the number of fractional bits.
+macro_rules! impl_fixed {
+	($T:ty, $W:ty, $U:ty, $FRAC:expr) => {
+		impl Fixed for $T {
+			#[inline(always)]
+			fn add_wrapping(a: $T, b: $T) -> $T {
+				return a.wrapping_add(b);
+			}
+
+			#[inline(always)]
+			fn add_saturating(a: $T, b: $T) -> $T {
+				return a.saturating_add(b);
+			}
+
+			#[inline(always)]
+			fn sub_wrapping(a: $T, b: $T) -> $T {
+				return a.wrapping_sub(b);
+			}
+
+			#[inline(always)]
+			fn sub_saturating(a: $T, b: $T) -> $T {
+				return a.saturating_sub(b);
+			}
+
+			#[inline(always)]
+			fn mul_wrapping(a: $T, b: $T) -> $T {
+				return mul_wide(a, b) as $T;
+			}
+
+			#[inline(always)]
+			fn mul_saturating(a: $T, b: $T) -> $T {
+				return saturate(mul_wide(a, b));
+			}
+
+			#[inline(always)]
+			fn div_wrapping(a: $T, b: $T) -> $T {
+				if b == 0 {
+					return div_by_zero(a);
+				}
+
+				return div_wide(a, b) as $T;
+			}
+
+			#[inline(always)]
+			fn div_saturating(a: $T, b: $T) -> $T {
+				if b == 0 {
+					return div_by_zero(a);
+				}
+
+				return saturate(div_wide(a, b));
+			}
+
+			#[inline(always)]
+			fn recip(x: $T) -> $T {
+				return Self::div_saturating(1 << $FRAC, x);
+			}
+
+			#[inline(always)]
+			fn sqrt(x: $T) -> $T {
+				if x <= 0 {
+					return 0;
+				}
+
+				// sqrt(x / 2^FRAC) * 2^FRAC = sqrt(x * 2^FRAC), computed a bit at a time.
+				let mut n = (x as $U) << $FRAC;
+				let mut root: $U = 0;
+				let mut bit: $U = 1 << ((<$U>::BITS - 1 - n.leading_zeros()) & !1);
+
+				// Branch-free, as whether each bit is set is unpredictable.
+				while bit != 0 {
+					let trial = root + bit;
+					let mask = ((n >= trial) as $U).wrapping_neg();
+					n -= trial & mask;
+					root = (root >> 1) + (bit & mask);
+					bit >>= 2;
+				}
+
+				// n is now x * 2^FRAC - root^2, and the exact root is nearer root + 1
+				// exactly when that exceeds root, as (root + 1/2)^2 = root^2 + root + 1/4.
+				if n > root {
+					root += 1;
+				}
+
+				return root as $T;
+			}
+		}
+
+		#[inline(always)]
+		fn mul_wide(a: $T, b: $T) -> $W {
+			let p = a as $W * b as $W;
+			let half: $W = 1 << ($FRAC - 1);
+			return if p >= 0 { (p + half) >> $FRAC } else { -((half - p) >> $FRAC) };
+		}
+
+		// Twice the quotient truncated, then halved away from zero, which rounds the
+		// quotient to nearest with ties away from zero.
+		#[inline(always)]
+		fn div_wide(a: $T, b: $T) -> $W {
+			let q2 = ((a as $W) << ($FRAC + 1)) / b as $W;
+			return if q2 >= 0 { (q2 + 1) >> 1 } else { -((1 - q2) >> 1) };
+		}
+
+		#[inline(always)]
+		fn saturate(x: $W) -> $T {
+			return x.clamp(<$T>::MIN as $W, <$T>::MAX as $W) as $T;
+		}
+
+		#[inline(always)]
+		fn div_by_zero(a: $T) -> $T {
+			return if a > 0 { <$T>::MAX } else if a < 0 { <$T>::MIN } else { 0 };
+		}
+	};
+}
+
+mod q16 {
+	use super::*;
+	impl_fixed!(i32, i64, u64, 16);
+}
+
+mod q32 {
+	use super::*;
+	impl_fixed!(i64, i128, u128, 32);
+}
+
+// Scalar and batched exports for one operation, in the shape of float_add and
+// float_add_batch.
+macro_rules! export_binary {
+	($T:ty, $op:ident, $scalar:ident, $batch:ident) => {
+		#[no_mangle]
+		pub extern "C" fn $scalar(a: $T, b: $T) -> $T {
+			return <$T>::$op(a, b);
+		}
+
+		#[no_mangle]
+		pub unsafe extern "C" fn $batch(a: *const $T, b: *const $T, out: *mut $T, len: usize) {
+			map2(a, b, out, len, |x, y| lanes(x, y, <$T>::$op), <$T>::$op);
+		}
+	};
+}
+
+macro_rules! export_unary {
+	($T:ty, $op:ident, $scalar:ident, $batch:ident) => {
+		#[no_mangle]
+		pub extern "C" fn $scalar(x: $T) -> $T {
+			return <$T>::$op(x);
+		}
+
+		#[no_mangle]
+		pub unsafe extern "C" fn $batch(x: *const $T, out: *mut $T, len: usize) {
+			map1(x, out, len, <$T>::$op);
+		}
+	};
+}
+
+export_binary!(i32, add_wrapping, fixed16_add_wrapping, fixed16_add_wrapping_batch);
+export_binary!(i32, add_saturating, fixed16_add_saturating, fixed16_add_saturating_batch);
+export_binary!(i32, sub_wrapping, fixed16_sub_wrapping, fixed16_sub_wrapping_batch);
+export_binary!(i32, sub_saturating, fixed16_sub_saturating, fixed16_sub_saturating_batch);
+export_binary!(i32, mul_wrapping, fixed16_mul_wrapping, fixed16_mul_wrapping_batch);
+export_binary!(i32, mul_saturating, fixed16_mul_saturating, fixed16_mul_saturating_batch);
+export_binary!(i32, div_wrapping, fixed16_div_wrapping, fixed16_div_wrapping_batch);
+export_binary!(i32, div_saturating, fixed16_div_saturating, fixed16_div_saturating_batch);
+export_unary!(i32, recip, fixed16_recip, fixed16_recip_batch);
+export_unary!(i32, sqrt, fixed16_sqrt, fixed16_sqrt_batch);
+
+export_binary!(i64, add_wrapping, fixed32_add_wrapping, fixed32_add_wrapping_batch);
+export_binary!(i64, add_saturating, fixed32_add_saturating, fixed32_add_saturating_batch);
+export_binary!(i64, sub_wrapping, fixed32_sub_wrapping, fixed32_sub_wrapping_batch);
+export_binary!(i64, sub_saturating, fixed32_sub_saturating, fixed32_sub_saturating_batch);
+export_binary!(i64, mul_wrapping, fixed32_mul_wrapping, fixed32_mul_wrapping_batch);
+export_binary!(i64, mul_saturating, fixed32_mul_saturating, fixed32_mul_saturating_batch);
+export_binary!(i64, div_wrapping, fixed32_div_wrapping, fixed32_div_wrapping_batch);
+export_binary!(i64, div_saturating, fixed32_div_saturating, fixed32_div_saturating_batch);
+export_unary!(i64, recip, fixed32_recip, fixed32_recip_batch);
+export_unary!(i64, sqrt, fixed32_sqrt, fixed32_sqrt_batch);
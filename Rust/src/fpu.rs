@@ -0,0 +1,144 @@
+// The FPU's control register for the calling thread: MXCSR on x86, FPCR on ARM64.
+// The hardware backend's results assume its default state, round to nearest even
+// with denormals handled exactly, but a host or another library may change it, for
+// instance to flush denormals for speed. These exports let callers save the state,
+// set a known one around batch calls, and restore it afterwards:
+//
+//   let saved = dfloat_fpu_set_default(0);
+//   ... batch calls ...
+//   dfloat_fpu_set_state(saved);
+//
+// The flush flags only change the hardware backend, and how they behave is up to
+// the platform: x86 flushes results that are tiny after rounding, ARM those tiny
+// before rounding, and ARM has a single bit for both flags. For flushing that is
+// the same everywhere, use dfloat_set_denormal_mode instead.
+//
+// On other architectures there is no register to change: states are 0 and setting
+// one does nothing.
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64", target_arch = "aarch64"))]
+use std::arch::asm;
+
+// Denormal results are replaced by zero.
+pub const FPU_FLUSH_TO_ZERO: u32 = 1;
+// Denormal inputs are read as zero.
+pub const FPU_DENORMALS_ARE_ZERO: u32 = 2;
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+mod register {
+	use super::*;
+
+	const FTZ: u64 = 1 << 15;
+	const DAZ: u64 = 1 << 6;
+
+	// Status flags, which are kept when the control bits are replaced.
+	const FLAGS: u64 = 0x3f;
+
+	// All exceptions masked, round to nearest, no flushing.
+	const DEFAULT: u64 = 0x1f80;
+
+	pub fn get() -> u64 {
+		let mut csr: u32 = 0;
+		unsafe { asm!("stmxcsr [{}]", in(reg) &mut csr, options(nostack, preserves_flags)) };
+		return csr as u64;
+	}
+
+	pub fn set(state: u64) {
+		// Setting reserved bits would fault.
+		let csr = (state & 0xffff) as u32;
+		unsafe { asm!("ldmxcsr [{}]", in(reg) &csr, options(nostack, preserves_flags, readonly)) };
+	}
+
+	pub fn default(state: u64) -> u64 {
+		return (state & FLAGS) | DEFAULT;
+	}
+
+	pub fn to_flags(state: u64) -> u32 {
+		return if state & FTZ != 0 { FPU_FLUSH_TO_ZERO } else { 0 } | if state & DAZ != 0 { FPU_DENORMALS_ARE_ZERO } else { 0 };
+	}
+
+	pub fn with_flags(state: u64, flags: u32) -> u64 {
+		let state = state & !(FTZ | DAZ);
+		return state | if flags & FPU_FLUSH_TO_ZERO != 0 { FTZ } else { 0 } | if flags & FPU_DENORMALS_ARE_ZERO != 0 { DAZ } else { 0 };
+	}
+}
+
+#[cfg(target_arch = "aarch64")]
+mod register {
+	use super::*;
+
+	const FZ: u64 = 1 << 24;
+
+	pub fn get() -> u64 {
+		let fpcr: u64;
+		unsafe { asm!("mrs {}, fpcr", out(reg) fpcr, options(nomem, nostack, preserves_flags)) };
+		return fpcr;
+	}
+
+	pub fn set(state: u64) {
+		unsafe { asm!("msr fpcr, {}", in(reg) state, options(nomem, nostack, preserves_flags)) };
+	}
+
+	// Round to nearest, no flushing, default NaN off and no traps.
+	pub fn default(_state: u64) -> u64 {
+		return 0;
+	}
+
+	pub fn to_flags(state: u64) -> u32 {
+		return if state & FZ != 0 { FPU_FLUSH_TO_ZERO | FPU_DENORMALS_ARE_ZERO } else { 0 };
+	}
+
+	pub fn with_flags(state: u64, flags: u32) -> u64 {
+		return if flags != 0 { state | FZ } else { state & !FZ };
+	}
+}
+
+#[cfg(not(any(target_arch = "x86", target_arch = "x86_64", target_arch = "aarch64")))]
+mod register {
+	pub fn get() -> u64 {
+		return 0;
+	}
+
+	pub fn set(_state: u64) {}
+
+	pub fn default(_state: u64) -> u64 {
+		return 0;
+	}
+
+	pub fn to_flags(_state: u64) -> u32 {
+		return 0;
+	}
+
+	pub fn with_flags(state: u64, _flags: u32) -> u64 {
+		return state;
+	}
+}
+
+// The whole register, to pass to dfloat_fpu_set_state later.
+#[no_mangle]
+pub extern "C" fn dfloat_fpu_get_state() -> u64 {
+	return register::get();
+}
+
+// Restores a state returned by one of the other exports, and returns the current one.
+#[no_mangle]
+pub extern "C" fn dfloat_fpu_set_state(state: u64) -> u64 {
+	let previous = register::get();
+	register::set(state);
+	return previous;
+}
+
+// Sets the default state, round to nearest with all exceptions masked, with the
+// FPU_ flags given, and returns the previous state.
+#[no_mangle]
+pub extern "C" fn dfloat_fpu_set_default(flags: u32) -> u64 {
+	let previous = register::get();
+	register::set(register::with_flags(register::default(previous), flags));
+	return previous;
+}
+
+// The FPU_ flags currently set.
+#[no_mangle]
+pub extern "C" fn dfloat_fpu_get_flags() -> u32 {
+	return register::to_flags(register::get());
+}
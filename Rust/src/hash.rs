@@ -0,0 +1,293 @@
+use crate::soft;
+use crate::soft64;
+use crate::{slice, slice_mut};
+
+// Hashes of dfloat and ddouble buffers, for lockstep games to compare their
+// simulation state between clients every tick.
+//
+// The hash is XXH64 (Yann Collet, https://github.com/Cyan4973/xxHash) of the
+// buffer's little-endian bytes, so it is the same on every platform and can be
+// checked against any other implementation. Its four accumulators are
+// independent, so a 32-byte stripe is four multiplies the CPU runs in parallel.
+//
+// With HASH_CANONICAL_NANS, every NaN is hashed as DEFAULT_NAN (0xffc00000, or
+// 0xfff8000000000000 for ddouble), as NaN payloads can differ between platforms
+// even when the results are otherwise the same (see NaNMode). The buffer is not
+// modified; NaNs are replaced as the words are read.
+//
+// The chunked hashes split a buffer into chunks of chunk_len elements, the last
+// possibly shorter, and keep the hash of each chunk, with seed 0, in a caller's
+// array. Only the chunks flagged dirty (nonzero) are rehashed, and their flags
+// cleared, so a buffer where few chunks change per tick is cheap to hash again.
+// A null dirty array rehashes every chunk. The hash of the buffer is then the
+// hash of the chunk hashes, as little-endian u64, with the buffer's length in
+// elements as the seed (see dfloat_hash_combine). It depends on chunk_len, and is
+// not the same as the hash of the whole buffer at once.
+
+pub const HASH_CANONICAL_NANS: u32 = 1;
+
+const P1: u64 = 0x9e37_79b1_85eb_ca87;
+const P2: u64 = 0xc2b2_ae3d_27d4_eb4f;
+const P3: u64 = 0x1656_67b1_9e37_79f9;
+const P4: u64 = 0x85eb_ca77_c2b2_ae63;
+const P5: u64 = 0x27d4_eb2f_1656_67c5;
+
+// Input to XXH64: its length in bytes, and its 8 and 4-byte little-endian words at
+// byte offsets that are multiples of their size. Bytes are only read for the last
+// 1 to 3 bytes of an input whose length is not a multiple of 4.
+trait Input {
+	fn len(&self) -> usize;
+	fn u64_at(&self, offset: usize) -> u64;
+	fn u32_at(&self, offset: usize) -> u32;
+	fn u8_at(&self, offset: usize) -> u8;
+
+	// The four 8-byte words of the 32-byte stripe at offset.
+	#[inline(always)]
+	fn stripe(&self, offset: usize) -> [u64; 4] {
+		return [self.u64_at(offset), self.u64_at(offset + 8), self.u64_at(offset + 16), self.u64_at(offset + 24)];
+	}
+}
+
+impl Input for [u8] {
+	fn len(&self) -> usize {
+		return <[u8]>::len(self);
+	}
+
+	#[inline(always)]
+	fn u64_at(&self, offset: usize) -> u64 {
+		let mut bytes = [0; 8];
+		bytes.copy_from_slice(&self[offset..offset + 8]);
+		return u64::from_le_bytes(bytes);
+	}
+
+	#[inline(always)]
+	fn u32_at(&self, offset: usize) -> u32 {
+		let mut bytes = [0; 4];
+		bytes.copy_from_slice(&self[offset..offset + 4]);
+		return u32::from_le_bytes(bytes);
+	}
+
+	#[inline(always)]
+	fn u8_at(&self, offset: usize) -> u8 {
+		return self[offset];
+	}
+}
+
+struct Floats<'a, const CANONICAL: bool>(&'a [u32]);
+
+impl<'a, const CANONICAL: bool> Floats<'a, CANONICAL> {
+	#[inline(always)]
+	fn get(&self, i: usize) -> u32 {
+		let x = self.0[i];
+
+		if CANONICAL && x & !soft::SIGN > soft::INFINITY {
+			return soft::DEFAULT_NAN;
+		}
+
+		return x;
+	}
+}
+
+impl<'a, const CANONICAL: bool> Input for Floats<'a, CANONICAL> {
+	fn len(&self) -> usize {
+		return self.0.len() * 4;
+	}
+
+	#[inline(always)]
+	fn u64_at(&self, offset: usize) -> u64 {
+		return self.get(offset / 4) as u64 | (self.get(offset / 4 + 1) as u64) << 32;
+	}
+
+	#[inline(always)]
+	fn u32_at(&self, offset: usize) -> u32 {
+		return self.get(offset / 4);
+	}
+
+	fn u8_at(&self, _: usize) -> u8 {
+		unreachable!();
+	}
+
+	// A whole stripe at once, so the eight words are bounds checked and canonicalized
+	// together.
+	#[inline(always)]
+	fn stripe(&self, offset: usize) -> [u64; 4] {
+		let x = &self.0[offset / 4..offset / 4 + 8];
+		let mut w = [0u32; 8];
+
+		for i in 0..8 {
+			w[i] = if CANONICAL && x[i] & !soft::SIGN > soft::INFINITY { soft::DEFAULT_NAN } else { x[i] };
+		}
+
+		return [0, 1, 2, 3].map(|i| w[2 * i] as u64 | (w[2 * i + 1] as u64) << 32);
+	}
+}
+
+struct Doubles<'a, const CANONICAL: bool>(&'a [u64]);
+
+impl<'a, const CANONICAL: bool> Input for Doubles<'a, CANONICAL> {
+	fn len(&self) -> usize {
+		return self.0.len() * 8;
+	}
+
+	#[inline(always)]
+	fn u64_at(&self, offset: usize) -> u64 {
+		let x = self.0[offset / 8];
+
+		if CANONICAL && x & !soft64::SIGN > soft64::INFINITY {
+			return soft64::DEFAULT_NAN;
+		}
+
+		return x;
+	}
+
+	fn u32_at(&self, _: usize) -> u32 {
+		unreachable!();
+	}
+
+	fn u8_at(&self, _: usize) -> u8 {
+		unreachable!();
+	}
+}
+
+#[inline(always)]
+fn round(acc: u64, input: u64) -> u64 {
+	return acc.wrapping_add(input.wrapping_mul(P2)).rotate_left(31).wrapping_mul(P1);
+}
+
+#[inline(always)]
+fn merge(acc: u64, v: u64) -> u64 {
+	return (acc ^ round(0, v)).wrapping_mul(P1).wrapping_add(P4);
+}
+
+#[inline(always)]
+fn xxh64<I: Input + ?Sized>(input: &I, seed: u64) -> u64 {
+	let len = input.len();
+	let mut offset = 0;
+	let mut h;
+
+	if len >= 32 {
+		let mut v = [seed.wrapping_add(P1).wrapping_add(P2), seed.wrapping_add(P2), seed, seed.wrapping_sub(P1)];
+
+		while offset + 32 <= len {
+			let stripe = input.stripe(offset);
+
+			for lane in 0..4 {
+				v[lane] = round(v[lane], stripe[lane]);
+			}
+
+			offset += 32;
+		}
+
+		h = v[0].rotate_left(1).wrapping_add(v[1].rotate_left(7)).wrapping_add(v[2].rotate_left(12)).wrapping_add(v[3].rotate_left(18));
+
+		for lane in 0..4 {
+			h = merge(h, v[lane]);
+		}
+	} else {
+		h = seed.wrapping_add(P5);
+	}
+
+	h = h.wrapping_add(len as u64);
+
+	while offset + 8 <= len {
+		h = (h ^ round(0, input.u64_at(offset))).rotate_left(27).wrapping_mul(P1).wrapping_add(P4);
+		offset += 8;
+	}
+
+	if offset + 4 <= len {
+		h = (h ^ (input.u32_at(offset) as u64).wrapping_mul(P1)).rotate_left(23).wrapping_mul(P2).wrapping_add(P3);
+		offset += 4;
+	}
+
+	while offset < len {
+		h = (h ^ (input.u8_at(offset) as u64).wrapping_mul(P5)).rotate_left(11).wrapping_mul(P1);
+		offset += 1;
+	}
+
+	h ^= h >> 33;
+	h = h.wrapping_mul(P2);
+	h ^= h >> 29;
+	h = h.wrapping_mul(P3);
+	h ^= h >> 32;
+
+	return h;
+}
+
+pub fn hash_bytes(bytes: &[u8], seed: u64) -> u64 {
+	return xxh64(bytes, seed);
+}
+
+pub fn hash_floats(x: &[u32], flags: u32, seed: u64) -> u64 {
+	if flags & HASH_CANONICAL_NANS != 0 {
+		return xxh64(&Floats::<true>(x), seed);
+	}
+
+	return xxh64(&Floats::<false>(x), seed);
+}
+
+pub fn hash_doubles(x: &[u64], flags: u32, seed: u64) -> u64 {
+	if flags & HASH_CANONICAL_NANS != 0 {
+		return xxh64(&Doubles::<true>(x), seed);
+	}
+
+	return xxh64(&Doubles::<false>(x), seed);
+}
+
+pub fn combine(hashes: &[u64], len: usize) -> u64 {
+	return xxh64(&Doubles::<false>(hashes), len as u64);
+}
+
+unsafe fn hash_chunks<T>(x: *const T, len: usize, chunk_len: usize, dirty: *mut u8, hashes: *mut u64, hash: impl Fn(&[T]) -> u64) -> u64 {
+	let x = slice(x, len);
+	let chunks = (len + chunk_len - 1) / chunk_len.max(1);
+	let hashes = slice_mut(hashes, chunks);
+
+	for (i, chunk) in x.chunks(chunk_len).enumerate() {
+		if dirty.is_null() || *dirty.add(i) != 0 {
+			hashes[i] = hash(chunk);
+
+			if !dirty.is_null() {
+				*dirty.add(i) = 0;
+			}
+		}
+	}
+
+	return combine(hashes, len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_hash(x: *const u32, len: usize, flags: u32, seed: u64) -> u64 {
+	return hash_floats(slice(x, len), flags, seed);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn ddouble_hash(x: *const u64, len: usize, flags: u32, seed: u64) -> u64 {
+	return hash_doubles(slice(x, len), flags, seed);
+}
+
+// hashes and dirty, if not null, hold one element per chunk. Returns 0 if
+// chunk_len is 0.
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_hash_chunks(x: *const u32, len: usize, chunk_len: usize, flags: u32, dirty: *mut u8, hashes: *mut u64) -> u64 {
+	if chunk_len == 0 {
+		return 0;
+	}
+
+	return hash_chunks(x, len, chunk_len, dirty, hashes, |chunk| hash_floats(chunk, flags, 0));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn ddouble_hash_chunks(x: *const u64, len: usize, chunk_len: usize, flags: u32, dirty: *mut u8, hashes: *mut u64) -> u64 {
+	if chunk_len == 0 {
+		return 0;
+	}
+
+	return hash_chunks(x, len, chunk_len, dirty, hashes, |chunk| hash_doubles(chunk, flags, 0));
+}
+
+// The hash of a chunked buffer of len elements from the hashes of its chunks, for
+// callers that hash the chunks themselves, e.g. as a stream of results arrives.
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_hash_combine(hashes: *const u64, count: usize, len: usize) -> u64 {
+	return combine(slice(hashes, count), len);
+}
@@ -1,25 +1,61 @@
+#[macro_use]
+pub mod arith;
+pub mod batch;
+pub mod convert;
+pub mod corpus;
+pub mod ddouble;
+pub mod dispatch;
+pub mod dmath;
+pub mod fixed;
+pub mod fpu;
+pub mod hash;
+pub mod matrix;
+pub mod oracle;
+pub mod random;
+pub mod reduce;
+pub mod soft;
+pub mod soft64;
+pub mod trace;
+pub mod vector;
+pub mod vm;
+
+use arith::Arith;
+use vm::{OP_ADD, OP_DIV, OP_MUL, OP_SUB};
+
+// Number of elements processed per iteration of the batched kernels' inner loops.
+// Each iteration is a plain elementwise loop over fixed-size arrays, which LLVM
+// lowers to packed SSE/NEON instructions. Packed and scalar IEEE add/sub/mul/div
+// round identically, so batched results are bit-identical to float_add etc.
+pub const LANES: usize = 8;
+
 #[no_mangle]
-pub unsafe extern fn float_add(a: u32, b: u32) -> u32 {	
-    let result : f32 = from_bits(a) + from_bits(b);	
-	return to_bits(result);
+pub unsafe extern "C" fn float_add(a: u32, b: u32) -> u32 {
+	return trace::op(OP_ADD, a, b, with_backend!(A => A::add(a, b)));
 }
 
 #[no_mangle]
-pub unsafe extern fn float_sub(a: u32, b: u32) -> u32 {	
-    let result : f32 = from_bits(a) - from_bits(b);
-	return to_bits(result);
+pub unsafe extern "C" fn float_sub(a: u32, b: u32) -> u32 {
+	return trace::op(OP_SUB, a, b, with_backend!(A => A::sub(a, b)));
 }
 
 #[no_mangle]
-pub unsafe extern fn float_mul(a: u32, b: u32) -> u32 {	
-    let result : f32 = from_bits(a) * from_bits(b);
-	return to_bits(result);	
+pub unsafe extern "C" fn float_mul(a: u32, b: u32) -> u32 {
+	return trace::op(OP_MUL, a, b, with_backend!(A => A::mul(a, b)));
 }
 
 #[no_mangle]
-pub unsafe extern fn float_div(a: u32, b: u32) -> u32 {	
-    let result : f32 = from_bits(a) / from_bits(b);
-	return to_bits(result);
+pub unsafe extern "C" fn float_div(a: u32, b: u32) -> u32 {
+	return trace::op(OP_DIV, a, b, with_backend!(A => A::div(a, b)));
+}
+
+// Slices from buffers passed across the FFI, which may be null when empty (C# pins
+// an empty array as null).
+pub unsafe fn slice<'a, T>(p: *const T, len: usize) -> &'a [T] {
+	return if len == 0 { &[] } else { std::slice::from_raw_parts(p, len) };
+}
+
+pub unsafe fn slice_mut<'a, T>(p: *mut T, len: usize) -> &'a mut [T] {
+	return if len == 0 { &mut [] } else { std::slice::from_raw_parts_mut(p, len) };
 }
 
 #[no_mangle]
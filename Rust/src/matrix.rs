@@ -0,0 +1,190 @@
+use crate::arith::Arith;
+use crate::trace;
+
+// 4x4 matrices of dfloats, stored column-major like Unity's Matrix4x4: element
+// (row, column) is at index column * 4 + row.
+//
+// Every product is accumulated left to right over k, with no fused multiply-add:
+//
+//   (a * b)[r][c]     ((a[r][0] * b[0][c] + a[r][1] * b[1][c]) + a[r][2] * b[2][c]) + a[r][3] * b[3][c]
+//   point p, row r    ((m[r][0] * x + m[r][1] * y) + m[r][2] * z) + m[r][3]
+//   vector v, row r   (m[r][0] * x + m[r][1] * y) + m[r][2] * z
+//
+// Points and vectors are transformed by the upper 3x4 of the matrix, like
+// Matrix4x4.MultiplyPoint3x4 and MultiplyVector. Sums are accumulated on the
+// backend's uncanonical arithmetic and only the results canonicalized, see
+// Arith::Uncanonical.
+//
+// The batched kernels work on BLOCK elements at a time. Each block is loaded into
+// one array per component, whether the buffer is an array of structures or a
+// structure of arrays, so the arithmetic is always the backend's lane operations
+// on contiguous arrays and the block stays in cache while it is used. Elements
+// left over at the end are done one at a time by the same code with one lane.
+
+const BLOCK: usize = 16;
+
+pub type Planes<const C: usize, const N: usize> = [[u32; N]; C];
+
+#[inline(always)]
+fn splat<const N: usize>(x: u32) -> [u32; N] {
+	return [x; N];
+}
+
+#[inline(always)]
+pub fn mul<A: Arith, const N: usize>(a: &Planes<16, N>, b: &Planes<16, N>) -> Planes<16, N> {
+	let mut m = [[0; N]; 16];
+
+	for c in 0..4 {
+		for r in 0..4 {
+			let mut sum = A::Uncanonical::mul_lanes(a[r], b[c * 4]);
+
+			for k in 1..4 {
+				sum = A::Uncanonical::add_lanes(sum, A::Uncanonical::mul_lanes(a[k * 4 + r], b[c * 4 + k]));
+			}
+
+			m[c * 4 + r] = A::canonical_lanes(sum);
+		}
+	}
+
+	return m;
+}
+
+#[inline(always)]
+pub fn transform<A: Arith, const N: usize>(m: &[u32; 16], v: &Planes<3, N>, point: bool) -> Planes<3, N> {
+	let mut out = [[0; N]; 3];
+
+	for r in 0..3 {
+		let mut sum = A::Uncanonical::mul_lanes(splat(m[r]), v[0]);
+		sum = A::Uncanonical::add_lanes(sum, A::Uncanonical::mul_lanes(splat(m[4 + r]), v[1]));
+		sum = A::Uncanonical::add_lanes(sum, A::Uncanonical::mul_lanes(splat(m[8 + r]), v[2]));
+
+		if point {
+			sum = A::Uncanonical::add_lanes(sum, splat(m[12 + r]));
+		}
+
+		out[r] = A::canonical_lanes(sum);
+	}
+
+	return out;
+}
+
+// Reads n <= N elements of C components starting at element base. In an array of
+// structures element i is at p[i * C..], in a structure of arrays component c of
+// element i is at p[c * count + i].
+#[inline(always)]
+unsafe fn gather<const C: usize, const N: usize>(p: *const u32, soa: bool, count: usize, base: usize, n: usize) -> Planes<C, N> {
+	let mut planes = [[0; N]; C];
+
+	for c in 0..C {
+		for l in 0..n {
+			let i = base + l;
+			planes[c][l] = if soa { *p.add(c * count + i) } else { *p.add(i * C + c) };
+		}
+	}
+
+	return planes;
+}
+
+#[inline(always)]
+unsafe fn scatter<const C: usize, const N: usize>(p: *mut u32, soa: bool, count: usize, base: usize, n: usize, planes: &Planes<C, N>) {
+	for c in 0..C {
+		for l in 0..n {
+			let i = base + l;
+			*(if soa { p.add(c * count + i) } else { p.add(i * C + c) }) = planes[c][l];
+		}
+	}
+}
+
+pub unsafe fn mul_batch<A: Arith>(a: *const u32, b: *const u32, out: *mut u32, count: usize, soa: bool) {
+	let mut base = 0;
+
+	while base + BLOCK <= count {
+		let x = gather::<16, BLOCK>(a, soa, count, base, BLOCK);
+		let y = gather::<16, BLOCK>(b, soa, count, base, BLOCK);
+		scatter(out, soa, count, base, BLOCK, &mul::<A, BLOCK>(&x, &y));
+		base += BLOCK;
+	}
+
+	while base < count {
+		let x = gather::<16, 1>(a, soa, count, base, 1);
+		let y = gather::<16, 1>(b, soa, count, base, 1);
+		scatter(out, soa, count, base, 1, &mul::<A, 1>(&x, &y));
+		base += 1;
+	}
+}
+
+pub unsafe fn transform_batch<A: Arith>(m: *const [u32; 16], v: *const u32, out: *mut u32, count: usize, soa: bool, point: bool) {
+	let m = &*m;
+	let mut base = 0;
+
+	while base + BLOCK <= count {
+		let x = gather::<3, BLOCK>(v, soa, count, base, BLOCK);
+		scatter(out, soa, count, base, BLOCK, &transform::<A, BLOCK>(m, &x, point));
+		base += BLOCK;
+	}
+
+	while base < count {
+		let x = gather::<3, 1>(v, soa, count, base, 1);
+		scatter(out, soa, count, base, 1, &transform::<A, 1>(m, &x, point));
+		base += 1;
+	}
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_mul(a: *const [u32; 16], b: *const [u32; 16], out: *mut [u32; 16]) {
+	with_backend!(A => mul_batch::<A>(a as *const u32, b as *const u32, out as *mut u32, 1, false));
+	trace::call(trace::CALL_DMAT4_MUL, 32, out as *const u32, 16);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_transform_point(m: *const [u32; 16], p: *const [u32; 3], out: *mut [u32; 3]) {
+	with_backend!(A => transform_batch::<A>(m, p as *const u32, out as *mut u32, 1, false, true));
+	trace::call(trace::CALL_DMAT4_TRANSFORM_POINT, 19, out as *const u32, 3);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_transform_vector(m: *const [u32; 16], v: *const [u32; 3], out: *mut [u32; 3]) {
+	with_backend!(A => transform_batch::<A>(m, v as *const u32, out as *mut u32, 1, false, false));
+	trace::call(trace::CALL_DMAT4_TRANSFORM_VECTOR, 19, out as *const u32, 3);
+}
+
+// out[i] = a[i] * b[i] for count matrices stored one after another. out may be
+// the same buffer as a or b.
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_mul_batch(a: *const u32, b: *const u32, out: *mut u32, count: usize) {
+	with_backend!(A => mul_batch::<A>(a, b, out, count, false));
+	trace::call(trace::CALL_DMAT4_MUL_BATCH, 32 * count, out, 16 * count);
+}
+
+// As dmat4_mul_batch, with the matrices stored as 16 planes of count elements.
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_mul_batch_soa(a: *const u32, b: *const u32, out: *mut u32, count: usize) {
+	with_backend!(A => mul_batch::<A>(a, b, out, count, true));
+	trace::call(trace::CALL_DMAT4_MUL_BATCH_SOA, 32 * count, out, 16 * count);
+}
+
+// Transforms count points stored as consecutive (x, y, z) by m.
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_transform_points(m: *const [u32; 16], p: *const u32, out: *mut u32, count: usize) {
+	with_backend!(A => transform_batch::<A>(m, p, out, count, false, true));
+	trace::call(trace::CALL_DMAT4_TRANSFORM_POINTS, 16 + 3 * count, out, 3 * count);
+}
+
+// Transforms count points stored as x, y and z planes of count elements by m.
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_transform_points_soa(m: *const [u32; 16], p: *const u32, out: *mut u32, count: usize) {
+	with_backend!(A => transform_batch::<A>(m, p, out, count, true, true));
+	trace::call(trace::CALL_DMAT4_TRANSFORM_POINTS_SOA, 16 + 3 * count, out, 3 * count);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_transform_vectors(m: *const [u32; 16], v: *const u32, out: *mut u32, count: usize) {
+	with_backend!(A => transform_batch::<A>(m, v, out, count, false, false));
+	trace::call(trace::CALL_DMAT4_TRANSFORM_VECTORS, 16 + 3 * count, out, 3 * count);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dmat4_transform_vectors_soa(m: *const [u32; 16], v: *const u32, out: *mut u32, count: usize) {
+	with_backend!(A => transform_batch::<A>(m, v, out, count, true, false));
+	trace::call(trace::CALL_DMAT4_TRANSFORM_VECTORS_SOA, 16 + 3 * count, out, 3 * count);
+}
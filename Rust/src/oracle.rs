@@ -0,0 +1,265 @@
+use crate::arith::{denormal_mode, nan_mode, Arith, DENORMALS_FLUSH, NANS_CANONICAL};
+use crate::dispatch::{self, KERNEL_ADD, KERNEL_DIV, KERNEL_MUL, KERNEL_SUB};
+use crate::soft::{flush, is_nan, DEFAULT_NAN, EXP_MASK, FRAC_MASK, INFINITY, QUIET_BIT, SIGN};
+
+// A reference for add, sub, mul and div that gives the correctly rounded IEEE-754
+// result (round to nearest, ties to even) from integer arithmetic, so a device can
+// check its own results without ground truth files.
+//
+// It is written independently of the soft backend, for clarity rather than speed:
+// each operand is decoded to an integer significand and a power of two, the exact
+// result is formed in wide integers (a remainder standing in for the rest of a
+// quotient), and one function rounds it. It follows the library's NaN rules, and
+// the selected denormal and NaN modes, like the exports do.
+
+// Value = sig * 2^exp, for finite x.
+#[inline(always)]
+fn decode(x: u32) -> (u64, i32) {
+	let biased = ((x & EXP_MASK) >> 23) as i32;
+
+	if biased == 0 {
+		return ((x & FRAC_MASK) as u64, -149);
+	}
+
+	return (((x & FRAC_MASK) | 0x80_0000) as u64, biased - 150);
+}
+
+// Rounds (mag + inexact) * 2^exp to a float with the given sign, where inexact
+// means a nonzero amount less than 1 is missing from mag.
+fn round(sign: u32, mag: u128, exp: i32, inexact: bool) -> u32 {
+	if mag == 0 {
+		return sign;
+	}
+
+	// The result is m * 2^q with 2^23 <= m < 2^24, or a denormal with q = -149.
+	let bits = 128 - mag.leading_zeros() as i32;
+	let mut q = std::cmp::max(exp + bits - 24, -149);
+	let shift = q - exp;
+
+	let mut m = if shift <= 0 {
+		(mag << -shift) as u64
+	} else if shift >= 128 {
+		// Less than half the smallest denormal.
+		0
+	} else {
+		let kept = (mag >> shift) as u64;
+		let rest = mag & ((1u128 << shift) - 1);
+		let half = 1u128 << (shift - 1);
+		let up = rest > half || (rest == half && (inexact || kept & 1 != 0));
+		kept + up as u64
+	};
+
+	if m == 1 << 24 {
+		m >>= 1;
+		q += 1;
+	}
+
+	if q > 104 {
+		return sign | INFINITY;
+	}
+
+	if m < 1 << 23 {
+		return sign | m as u32;
+	}
+
+	return sign | ((q + 150) as u32) << 23 | (m as u32 & FRAC_MASK);
+}
+
+fn add_finite(a: u32, b: u32) -> u32 {
+	let (mut sig_a, mut exp_a) = decode(a);
+	let (mut sig_b, mut exp_b) = decode(b);
+	let (mut sign_a, mut sign_b) = (a & SIGN, b & SIGN);
+
+	if exp_a < exp_b {
+		std::mem::swap(&mut sig_a, &mut sig_b);
+		std::mem::swap(&mut exp_a, &mut exp_b);
+		std::mem::swap(&mut sign_a, &mut sign_b);
+	}
+
+	// A b this far below a is under a quarter of a's ulp, so any such value of the
+	// same sign rounds the same way; use the smallest, keeping the sum small.
+	if exp_a - exp_b > 30 {
+		sig_b = (sig_b != 0) as u64;
+		exp_b = exp_a - 30;
+	}
+
+	let term = |sig: u64, exp: i32, sign: u32| {
+		let v = (sig << (exp - exp_b)) as i64;
+		if sign != 0 { -v } else { v }
+	};
+
+	let sum = term(sig_a, exp_a, sign_a) + term(sig_b, exp_b, sign_b);
+
+	if sum == 0 {
+		// Exact zeros are +0, unless both operands are negative.
+		return sign_a & sign_b;
+	}
+
+	return round(if sum < 0 { SIGN } else { 0 }, sum.unsigned_abs() as u128, exp_b, false);
+}
+
+fn mul_finite(a: u32, b: u32) -> u32 {
+	let (sig_a, exp_a) = decode(a);
+	let (sig_b, exp_b) = decode(b);
+	return round((a ^ b) & SIGN, (sig_a * sig_b) as u128, exp_a + exp_b, false);
+}
+
+// b is nonzero.
+fn div_finite(a: u32, b: u32) -> u32 {
+	let (sig_a, exp_a) = decode(a);
+	let (sig_b, exp_b) = decode(b);
+
+	// At least 40 bits of quotient, well beyond the 24 kept and the rounding bit.
+	let n = (sig_a as u128) << 64;
+	let quotient = n / sig_b as u128;
+	let inexact = n % sig_b as u128 != 0;
+
+	return round((a ^ b) & SIGN, quotient, exp_a - exp_b - 64, inexact);
+}
+
+fn is_inf(x: u32) -> bool {
+	return x & !SIGN == INFINITY;
+}
+
+fn is_zero(x: u32) -> bool {
+	return x & !SIGN == 0;
+}
+
+// op is one of dispatch's KERNEL_ ops. Denormals are handled exactly and NaNs
+// preserved; see reference for the selected modes.
+pub fn exact(op: usize, a: u32, b: u32) -> u32 {
+	if is_nan(a) {
+		return a | QUIET_BIT;
+	}
+
+	if is_nan(b) {
+		return b | QUIET_BIT;
+	}
+
+	let b = if op == KERNEL_SUB { b ^ SIGN } else { b };
+	let sign = (a ^ b) & SIGN;
+
+	match op {
+		KERNEL_ADD | KERNEL_SUB => {
+			if is_inf(a) && is_inf(b) && sign != 0 {
+				return DEFAULT_NAN;
+			}
+
+			if is_inf(a) {
+				return a;
+			}
+
+			if is_inf(b) {
+				return b;
+			}
+
+			return add_finite(a, b);
+		}
+		KERNEL_MUL => {
+			if (is_inf(a) && is_zero(b)) || (is_zero(a) && is_inf(b)) {
+				return DEFAULT_NAN;
+			}
+
+			if is_inf(a) || is_inf(b) {
+				return sign | INFINITY;
+			}
+
+			return mul_finite(a, b);
+		}
+		_ => {
+			if (is_inf(a) && is_inf(b)) || (is_zero(a) && is_zero(b)) {
+				return DEFAULT_NAN;
+			}
+
+			if is_inf(a) || is_zero(b) {
+				return sign | INFINITY;
+			}
+
+			if is_inf(b) {
+				return sign;
+			}
+
+			return div_finite(a, b);
+		}
+	}
+}
+
+// The result of the op in the selected denormal and NaN modes.
+#[inline(always)]
+pub fn reference(op: usize, a: u32, b: u32, flush_denormals: bool, canonical_nans: bool) -> u32 {
+	let r = if flush_denormals { flush(exact(op, flush(a), flush(b))) } else { exact(op, a, b) };
+	return if canonical_nans && is_nan(r) { DEFAULT_NAN } else { r };
+}
+
+fn modes() -> (bool, bool) {
+	return (denormal_mode() == DENORMALS_FLUSH, nan_mode() == NANS_CANONICAL);
+}
+
+fn same(actual: u32, expected: u32, canonical_nans: bool) -> bool {
+	return actual == expected || (!canonical_nans && is_nan(actual) && is_nan(expected));
+}
+
+// op is 0 to 3 for add, sub, mul and div; other values give 0.
+#[no_mangle]
+pub extern "C" fn float_oracle(op: u32, a: u32, b: u32) -> u32 {
+	if op > KERNEL_DIV as u32 {
+		return 0;
+	}
+
+	let (flush_denormals, canonical_nans) = modes();
+	return reference(op as usize, a, b, flush_denormals, canonical_nans);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_oracle_batch(op: u32, a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	if op > KERNEL_DIV as u32 {
+		return;
+	}
+
+	let (flush_denormals, canonical_nans) = modes();
+
+	for i in 0..len {
+		*out.add(i) = reference(op as usize, *a.add(i), *b.add(i), flush_denormals, canonical_nans);
+	}
+}
+
+// Checks the selected backend's scalar and batched op on each pair of a and b
+// against the oracle, with any two NaNs equal unless NaNs are canonical. Returns
+// the number of pairs where either differs, and writes the indices of the first
+// capacity of them to mismatches.
+#[no_mangle]
+pub unsafe extern "C" fn float_oracle_check(op: u32, a: *const u32, b: *const u32, len: usize, mismatches: *mut u32, capacity: usize) -> usize {
+	if op > KERNEL_DIV as u32 || len == 0 {
+		return 0;
+	}
+
+	let op = op as usize;
+	let (flush_denormals, canonical_nans) = modes();
+	let (a, b) = (std::slice::from_raw_parts(a, len), std::slice::from_raw_parts(b, len));
+
+	let mut batched = vec![0; len];
+	(dispatch::kernel(op))(a.as_ptr(), b.as_ptr(), batched.as_mut_ptr(), len);
+
+	let scalar: fn(u32, u32) -> u32 = with_backend!(A => match op {
+		KERNEL_ADD => A::add,
+		KERNEL_SUB => A::sub,
+		KERNEL_MUL => A::mul,
+		_ => A::div,
+	});
+
+	let mut count = 0;
+
+	for i in 0..len {
+		let expected = reference(op, a[i], b[i], flush_denormals, canonical_nans);
+
+		if !same(scalar(a[i], b[i]), expected, canonical_nans) || !same(batched[i], expected, canonical_nans) {
+			if count < capacity {
+				*mismatches.add(count) = i as u32;
+			}
+
+			count += 1;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,166 @@
+use crate::arith::Arith;
+use crate::{slice_mut, LANES};
+
+// A seeded random number generator whose sequence is specified here, so every
+// platform, runtime and build gives the same numbers from the same seed, unlike
+// System.Random, whose algorithm .NET and Mono do not guarantee.
+//
+// The generator is xoshiro128** 1.1 (Blackman and Vigna), with a 128-bit state of
+// four u32 and 32-bit outputs. A u64 seed fills the state with the first two
+// outputs of SplitMix64 started from the seed, low word first. An all-zero state
+// never leaves zero, so it is replaced by (1, 0, 0, 0), but SplitMix64 does not
+// produce it from any seed in practice.
+//
+// Unit dfloats take the top 24 bits x of an output and are x * 2^-24, built from
+// the bits rather than computed, so they are exact, in [0, 1), and the same on
+// every backend and in every mode. Ranges map them with the backend's arithmetic,
+// min + u * (max - min), so follow its denormal and NaN modes like any other
+// operation; rounding can give max itself.
+//
+// The batched fills produce the same numbers as the same number of single calls,
+// in order, and leave the state where those calls would.
+
+#[repr(C)]
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+pub struct Random {
+	pub s: [u32; 4],
+}
+
+impl Random {
+	pub fn new(seed: u64) -> Random {
+		let mut x = seed;
+		let a = splitmix64(&mut x);
+		let b = splitmix64(&mut x);
+		let s = [a as u32, (a >> 32) as u32, b as u32, (b >> 32) as u32];
+
+		if s == [0; 4] {
+			return Random { s: [1, 0, 0, 0] };
+		}
+
+		return Random { s };
+	}
+
+	#[inline(always)]
+	pub fn next_u32(&mut self) -> u32 {
+		let s = &mut self.s;
+		let result = s[1].wrapping_mul(5).rotate_left(7).wrapping_mul(9);
+		let t = s[1] << 9;
+
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = s[3].rotate_left(11);
+
+		return result;
+	}
+
+	#[inline(always)]
+	pub fn next_unit(&mut self) -> u32 {
+		return unit(self.next_u32());
+	}
+}
+
+#[inline(always)]
+fn splitmix64(x: &mut u64) -> u64 {
+	*x = x.wrapping_add(0x9e3779b97f4a7c15);
+	let mut z = *x;
+	z = (z ^ (z >> 30)).wrapping_mul(0xbf58476d1ce4e5b9);
+	z = (z ^ (z >> 27)).wrapping_mul(0x94d049bb133111eb);
+	return z ^ (z >> 31);
+}
+
+// The top 24 bits of x times 2^-24, as dfloat bits.
+#[inline(always)]
+pub fn unit(x: u32) -> u32 {
+	let m = x >> 8;
+
+	if m == 0 {
+		return 0;
+	}
+
+	// m has its leading one at bit 23 - shift, so is in [2^-1-shift, 2^-shift) once scaled.
+	let shift = m.leading_zeros() - 8;
+	return (126 - shift) << 23 | (m << shift) & 0x7fffff;
+}
+
+#[inline(always)]
+fn range<A: Arith>(u: u32, min: u32, max: u32) -> u32 {
+	return A::add(min, A::mul(u, A::sub(max, min)));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_random_seed(state: *mut Random, seed: u64) {
+	*state = Random::new(seed);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_random_next(state: *mut Random) -> u32 {
+	return (*state).next_u32();
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_random_next_unit(state: *mut Random) -> u32 {
+	return (*state).next_unit();
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_random_next_range(state: *mut Random, min: u32, max: u32) -> u32 {
+	let u = (*state).next_unit();
+	return with_backend!(A => range::<A>(u, min, max));
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_random_fill(state: *mut Random, out: *mut u32, len: usize) {
+	// A local copy keeps the state in registers rather than reloading it through the
+	// pointer after every store to out.
+	let mut random = *state;
+	let out = slice_mut(out, len);
+
+	for x in out.iter_mut() {
+		*x = random.next_u32();
+	}
+
+	*state = random;
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_random_fill_unit(state: *mut Random, out: *mut u32, len: usize) {
+	let mut random = *state;
+	let out = slice_mut(out, len);
+
+	for x in out.iter_mut() {
+		*x = random.next_unit();
+	}
+
+	*state = random;
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_random_fill_range(state: *mut Random, out: *mut u32, len: usize, min: u32, max: u32) {
+	let mut random = *state;
+	let out = slice_mut(out, len);
+
+	with_backend!(A => {
+		let width = A::sub(max, min);
+		let mut chunks = out.chunks_exact_mut(LANES);
+
+		for chunk in &mut chunks {
+			let mut u = [0; LANES];
+
+			for lane in u.iter_mut() {
+				*lane = random.next_unit();
+			}
+
+			let scaled = A::add_lanes([min; LANES], A::mul_lanes(u, [width; LANES]));
+			chunk.copy_from_slice(&scaled);
+		}
+
+		for x in chunks.into_remainder() {
+			*x = A::add(min, A::mul(random.next_unit(), width));
+		}
+	});
+
+	*state = random;
+}
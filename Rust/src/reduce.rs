@@ -0,0 +1,252 @@
+use crate::arith::{nan_mode, Arith, NANS_CANONICAL};
+use crate::soft::{self, INFINITY, SIGN};
+use crate::trace;
+use crate::LANES;
+use std::thread;
+
+// Reductions of dfloat buffers that give the same bits for any number of threads.
+//
+// The order of operations is a fixed tree that only depends on the length:
+//
+//   1. The buffer is split into chunks of CHUNK elements, the last one possibly
+//      shorter.
+//   2. Each chunk is reduced into LANES accumulators, starting from the identity,
+//      where lane l takes elements l, l + LANES, l + 2 * LANES, ... of the chunk in
+//      order. Lanes past the end of a short chunk take the identity.
+//   3. The accumulators are combined pairwise, ((0, 1), (2, 3)), ((4, 5), (6, 7)).
+//   4. The chunk results are combined pairwise, level by level: results 2i and
+//      2i + 1 of one level give result i of the next, and an odd one out at the end
+//      of a level is carried up unchanged, until one result is left.
+//
+// Threads only decide who computes which chunk, never how it is computed, so the
+// thread count can be anything. Chunks are also what gets parallelized, so a
+// buffer of a single chunk is always reduced on the calling thread.
+//
+// The identity is -0 for sum and dot (-0 + x is x for every x other than a
+// signalling NaN, which is quieted), +infinity for min and -infinity for max. Dot
+// multiplies elementwise first and then sums the products with the same tree.
+// Both run on the backend's uncanonical arithmetic and canonicalize the result,
+// see Arith::Uncanonical.
+//
+// min and max order -0 below +0 so the result does not depend on which of the two
+// is seen first, and return a NaN if there is one; which NaN, if there are
+// several, is fixed by the tree, and it is DEFAULT_NAN if NaNs are canonicalized.
+// Otherwise they return one of the elements as it is, so never flush denormals.
+
+const CHUNK: usize = 4096;
+
+const NEGATIVE_ZERO: u32 = SIGN;
+const NEGATIVE_INFINITY: u32 = SIGN | INFINITY;
+
+// Total order on the bits with NaNs removed: -infinity < ... < -0 < +0 < ... < +infinity.
+#[inline(always)]
+fn key(x: u32) -> i32 {
+	return if x & SIGN != 0 { !(x & !SIGN) as i32 } else { x as i32 };
+}
+
+#[inline(always)]
+fn is_nan(x: u32) -> bool {
+	return x & !SIGN > INFINITY;
+}
+
+#[inline(always)]
+pub fn min(a: u32, b: u32) -> u32 {
+	if is_nan(a) {
+		return a;
+	}
+
+	if is_nan(b) {
+		return b;
+	}
+
+	return if key(b) < key(a) { b } else { a };
+}
+
+#[inline(always)]
+pub fn max(a: u32, b: u32) -> u32 {
+	if is_nan(a) {
+		return a;
+	}
+
+	if is_nan(b) {
+		return b;
+	}
+
+	return if key(b) > key(a) { b } else { a };
+}
+
+#[inline(always)]
+unsafe fn load(p: *const u32, i: usize, n: usize, identity: u32) -> [u32; LANES] {
+	if n == LANES {
+		return (p.add(i) as *const [u32; LANES]).read_unaligned();
+	}
+
+	let mut v = [identity; LANES];
+
+	for l in 0..n {
+		v[l] = *p.add(i + l);
+	}
+
+	return v;
+}
+
+#[inline(always)]
+fn reduce_chunk<B, L, F>(block: &B, start: usize, end: usize, identity: u32, lanes_op: &L, op: &F) -> u32
+where
+	B: Fn(usize, usize) -> [u32; LANES],
+	L: Fn([u32; LANES], [u32; LANES]) -> [u32; LANES],
+	F: Fn(u32, u32) -> u32,
+{
+	let mut acc = [identity; LANES];
+	let mut i = start;
+
+	while i < end {
+		let n = LANES.min(end - i);
+		acc = lanes_op(acc, block(i, n));
+		i += n;
+	}
+
+	let mut width = LANES;
+
+	while width > 1 {
+		width /= 2;
+
+		for l in 0..width {
+			acc[l] = op(acc[2 * l], acc[2 * l + 1]);
+		}
+	}
+
+	return acc[0];
+}
+
+fn combine<F: Fn(u32, u32) -> u32>(mut results: Vec<u32>, op: &F) -> u32 {
+	while results.len() > 1 {
+		let next = results.chunks(2).map(|pair| if pair.len() == 2 { op(pair[0], pair[1]) } else { pair[0] }).collect();
+		results = next;
+	}
+
+	return results[0];
+}
+
+pub fn thread_count(threads: usize) -> usize {
+	if threads != 0 {
+		return threads;
+	}
+
+	return thread::available_parallelism().map_or(1, |n| n.get());
+}
+
+// block(i, n) returns elements i..i + n, n <= LANES, padded with identity.
+// threads is the number of threads to use, including the calling one, or 0 for
+// one per core.
+pub fn reduce<B, L, F>(block: &B, len: usize, identity: u32, threads: usize, lanes_op: L, op: F) -> u32
+where
+	B: Fn(usize, usize) -> [u32; LANES] + Sync,
+	L: Fn([u32; LANES], [u32; LANES]) -> [u32; LANES] + Sync,
+	F: Fn(u32, u32) -> u32 + Sync,
+{
+	if len == 0 {
+		return identity;
+	}
+
+	let chunks = (len + CHUNK - 1) / CHUNK;
+	let mut results = vec![identity; chunks];
+	let threads = thread_count(threads).min(chunks);
+	let per_thread = (chunks + threads - 1) / threads;
+
+	let run = |first: usize, out: &mut [u32]| {
+		for (c, r) in out.iter_mut().enumerate() {
+			let start = (first + c) * CHUNK;
+			*r = reduce_chunk(block, start, len.min(start + CHUNK), identity, &lanes_op, &op);
+		}
+	};
+
+	if threads == 1 {
+		run(0, &mut results);
+	} else {
+		thread::scope(|s| {
+			let mut parts = results.chunks_mut(per_thread).enumerate();
+			let (_, own) = parts.next().unwrap();
+
+			for (t, part) in parts {
+				let run = &run;
+				s.spawn(move || run(t * per_thread, part));
+			}
+
+			run(0, own);
+		});
+	}
+
+	return combine(results, &op);
+}
+
+pub unsafe fn sum<A: Arith>(x: *const u32, len: usize, threads: usize) -> u32 {
+	let x = x as usize;
+	let block = move |i, n| load(x as *const u32, i, n, NEGATIVE_ZERO);
+	return A::canonical(reduce(&block, len, NEGATIVE_ZERO, threads, A::Uncanonical::add_lanes::<LANES>, A::Uncanonical::add));
+}
+
+pub unsafe fn dot<A: Arith>(a: *const u32, b: *const u32, len: usize, threads: usize) -> u32 {
+	let (a, b) = (a as usize, b as usize);
+	let block = move |i, n| {
+		let mut products = A::Uncanonical::mul_lanes(load(a as *const u32, i, n, 0), load(b as *const u32, i, n, 0));
+
+		for l in n..LANES {
+			products[l] = NEGATIVE_ZERO;
+		}
+
+		products
+	};
+
+	return A::canonical(reduce(&block, len, NEGATIVE_ZERO, threads, A::Uncanonical::add_lanes::<LANES>, A::Uncanonical::add));
+}
+
+#[inline(always)]
+fn canonical(x: u32) -> u32 {
+	return if nan_mode() == NANS_CANONICAL { soft::canonical(x) } else { x };
+}
+
+pub unsafe fn min_all(x: *const u32, len: usize, threads: usize) -> u32 {
+	let x = x as usize;
+	let block = move |i, n| load(x as *const u32, i, n, INFINITY);
+	return reduce(&block, len, INFINITY, threads, |a, b| crate::arith::lanes(a, b, min), min);
+}
+
+pub unsafe fn max_all(x: *const u32, len: usize, threads: usize) -> u32 {
+	let x = x as usize;
+	let block = move |i, n| load(x as *const u32, i, n, NEGATIVE_INFINITY);
+	return reduce(&block, len, NEGATIVE_INFINITY, threads, |a, b| crate::arith::lanes(a, b, max), max);
+}
+
+// Sum of x[0..len]. threads is the number of threads to use, or 0 for one per
+// core; the result is the same for any value.
+#[no_mangle]
+pub unsafe extern "C" fn float_sum(x: *const u32, len: usize, threads: usize) -> u32 {
+	let r = with_backend!(A => sum::<A>(x, len, threads));
+	trace::call(trace::CALL_FLOAT_SUM, len, &r, 1);
+	return r;
+}
+
+// Sum of a[i] * b[i].
+#[no_mangle]
+pub unsafe extern "C" fn float_dot(a: *const u32, b: *const u32, len: usize, threads: usize) -> u32 {
+	let r = with_backend!(A => dot::<A>(a, b, len, threads));
+	trace::call(trace::CALL_FLOAT_DOT, 2 * len, &r, 1);
+	return r;
+}
+
+// These compare bits, so they do not depend on the backend, only on whether a NaN
+// found is canonicalized.
+#[no_mangle]
+pub unsafe extern "C" fn float_min(x: *const u32, len: usize, threads: usize) -> u32 {
+	let r = canonical(min_all(x, len, threads));
+	trace::call(trace::CALL_FLOAT_MIN, len, &r, 1);
+	return r;
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn float_max(x: *const u32, len: usize, threads: usize) -> u32 {
+	let r = canonical(max_all(x, len, threads));
+	trace::call(trace::CALL_FLOAT_MAX, len, &r, 1);
+	return r;
+}
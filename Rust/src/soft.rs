@@ -0,0 +1,377 @@
+// IEEE-754 binary32 add/sub/mul/div using only integer operations on the bit
+// patterns, so the results do not depend on the FPU, its denormal handling or its
+// control register. Rounding is always round-to-nearest-even and denormals are
+// fully supported. The algorithms follow Berkeley SoftFloat 3.
+//
+// NaN results follow x86 SSE, which produced the ground truth: a NaN operand is
+// returned quieted (the first one if both are NaN), and invalid operations return
+// DEFAULT_NAN. This makes the soft path bit-identical to hardware on x86.
+
+pub const SIGN: u32 = 0x8000_0000;
+pub const EXP_MASK: u32 = 0x7f80_0000;
+pub const FRAC_MASK: u32 = 0x007f_ffff;
+pub const QUIET_BIT: u32 = 0x0040_0000;
+pub const INFINITY: u32 = 0x7f80_0000;
+pub const DEFAULT_NAN: u32 = 0xffc0_0000;
+
+#[inline(always)]
+pub fn is_nan(x: u32) -> bool {
+	return x & !SIGN > INFINITY;
+}
+
+// x with a denormal replaced by zero of the same sign, see arith::FlushDenormals.
+#[inline(always)]
+pub fn flush(x: u32) -> u32 {
+	return if x & EXP_MASK == 0 { x & SIGN } else { x };
+}
+
+// DEFAULT_NAN if x is a NaN, otherwise x, see arith::CanonicalNaNs.
+#[inline(always)]
+pub fn canonical(x: u32) -> u32 {
+	let nan = ((INFINITY as i32).wrapping_sub((x & !SIGN) as i32) >> 31) as u32;
+	return (x & !nan) | (DEFAULT_NAN & nan);
+}
+
+#[inline(always)]
+fn propagate_nan(a: u32, b: u32) -> u32 {
+	return if is_nan(a) { a | QUIET_BIT } else { b | QUIET_BIT };
+}
+
+#[inline(always)]
+fn shift_right_jam(a: u32, dist: u32) -> u32 {
+	if dist == 0 {
+		return a;
+	}
+
+	return if dist < 32 { (a >> dist) | ((a << (32 - dist) != 0) as u32) } else { (a != 0) as u32 };
+}
+
+// Returns (biased exponent, significand without hidden bit) of a normalized
+// subnormal significand, with an exponent of 0 or below.
+#[inline(always)]
+fn normalize_subnormal(frac: u32) -> (i32, u32) {
+	let shift = frac.leading_zeros() as i32 - 8;
+	return (1 - shift, (frac << shift) & FRAC_MASK);
+}
+
+// exp is the biased exponent minus one, and sig holds the significand with its
+// leading bit at bit 30 and 7 bits of rounding information below the result's
+// last bit. Adding the exponent and rounded significand lets a carry out of the
+// significand increment the exponent.
+#[inline(always)]
+fn round_pack(sign: u32, mut exp: i32, mut sig: u32) -> u32 {
+	let mut round_bits = sig & 0x7f;
+
+	if exp as u32 >= 0xfd {
+		if exp < 0 {
+			sig = shift_right_jam(sig, (-exp) as u32);
+			exp = 0;
+			round_bits = sig & 0x7f;
+		} else if exp > 0xfd || sig + 0x40 >= 0x8000_0000 {
+			return sign | INFINITY;
+		}
+	}
+
+	sig = (sig + 0x40) >> 7;
+
+	if round_bits == 0x40 {
+		sig &= !1;
+	}
+
+	if sig == 0 {
+		exp = 0;
+	}
+
+	return sign | ((exp as u32) << 23).wrapping_add(sig);
+}
+
+// Magnitude of a is at least that of b, and both are finite.
+#[inline(always)]
+fn add_mags(a: u32, b: u32, sign: u32) -> u32 {
+	let exp_a = ((a & EXP_MASK) >> 23) as i32;
+	let exp_b = ((b & EXP_MASK) >> 23) as i32;
+
+	if exp_a == 0 {
+		// Both subnormal; the sum is exact and a carry becomes the hidden bit.
+		return sign | ((a & FRAC_MASK) + (b & FRAC_MASK));
+	}
+
+	let sig_a = (a & FRAC_MASK) << 6;
+	let mut sig_b = (b & FRAC_MASK) << 6;
+	// Subnormals have an effective exponent of 1 but no hidden bit.
+	sig_b += if exp_b != 0 { 0x2000_0000 } else { sig_b };
+	sig_b = shift_right_jam(sig_b, (exp_a - exp_b) as u32);
+
+	let mut exp = exp_a;
+	let mut sig = 0x2000_0000 + sig_a + sig_b;
+
+	if sig < 0x4000_0000 {
+		exp -= 1;
+		sig <<= 1;
+	}
+
+	return round_pack(sign, exp, sig);
+}
+
+// Magnitude of a is at least that of b, and both are finite.
+#[inline(always)]
+fn sub_mags(a: u32, b: u32, sign: u32) -> u32 {
+	if a & !SIGN == b & !SIGN {
+		return 0;
+	}
+
+	let exp_a = ((a & EXP_MASK) >> 23) as i32;
+	let exp_b = ((b & EXP_MASK) >> 23) as i32;
+
+	if exp_a == 0 {
+		return sign | ((a & FRAC_MASK) - (b & FRAC_MASK));
+	}
+
+	let sig_a = ((a & FRAC_MASK) << 7) | 0x4000_0000;
+	let mut sig_b = (b & FRAC_MASK) << 7;
+	sig_b += if exp_b != 0 { 0x4000_0000 } else { sig_b };
+	sig_b = shift_right_jam(sig_b, (exp_a - exp_b) as u32);
+
+	let sig = sig_a - sig_b;
+	let shift = sig.leading_zeros() as i32 - 1;
+
+	return round_pack(sign, exp_a - 1 - shift, sig << shift);
+}
+
+#[inline(always)]
+pub fn add(a: u32, b: u32) -> u32 {
+	if is_nan(a) || is_nan(b) {
+		return propagate_nan(a, b);
+	}
+
+	if a & EXP_MASK == EXP_MASK || b & EXP_MASK == EXP_MASK {
+		if a & EXP_MASK != EXP_MASK {
+			return b;
+		}
+		if b & EXP_MASK == EXP_MASK && (a ^ b) & SIGN != 0 {
+			return DEFAULT_NAN;
+		}
+		return a;
+	}
+
+	let (x, y) = if a & !SIGN >= b & !SIGN { (a, b) } else { (b, a) };
+
+	return if (a ^ b) & SIGN == 0 { add_mags(x, y, x & SIGN) } else { sub_mags(x, y, x & SIGN) };
+}
+
+#[inline(always)]
+pub fn sub(a: u32, b: u32) -> u32 {
+	// The NaN check comes first as a NaN b is returned with its own sign.
+	if is_nan(a) || is_nan(b) {
+		return propagate_nan(a, b);
+	}
+
+	return add(a, b ^ SIGN);
+}
+
+#[inline(always)]
+pub fn mul(a: u32, b: u32) -> u32 {
+	if is_nan(a) || is_nan(b) {
+		return propagate_nan(a, b);
+	}
+
+	let sign = (a ^ b) & SIGN;
+	let mut exp_a = ((a & EXP_MASK) >> 23) as i32;
+	let mut exp_b = ((b & EXP_MASK) >> 23) as i32;
+	let mut frac_a = a & FRAC_MASK;
+	let mut frac_b = b & FRAC_MASK;
+
+	if exp_a == 0xff || exp_b == 0xff {
+		if a & !SIGN == 0 || b & !SIGN == 0 {
+			return DEFAULT_NAN;
+		}
+		return sign | INFINITY;
+	}
+
+	if a & !SIGN == 0 || b & !SIGN == 0 {
+		return sign;
+	}
+
+	if exp_a == 0 {
+		let n = normalize_subnormal(frac_a);
+		exp_a = n.0;
+		frac_a = n.1;
+	}
+
+	if exp_b == 0 {
+		let n = normalize_subnormal(frac_b);
+		exp_b = n.0;
+		frac_b = n.1;
+	}
+
+	let sig_a = (frac_a | 0x0080_0000) << 7;
+	let sig_b = (frac_b | 0x0080_0000) << 8;
+	let product = sig_a as u64 * sig_b as u64;
+
+	let mut exp = exp_a + exp_b - 0x7f;
+	let mut sig = (product >> 32) as u32 | ((product as u32 != 0) as u32);
+
+	if sig < 0x4000_0000 {
+		exp -= 1;
+		sig <<= 1;
+	}
+
+	return round_pack(sign, exp, sig);
+}
+
+#[inline(always)]
+pub fn div(a: u32, b: u32) -> u32 {
+	if is_nan(a) || is_nan(b) {
+		return propagate_nan(a, b);
+	}
+
+	let sign = (a ^ b) & SIGN;
+	let mut exp_a = ((a & EXP_MASK) >> 23) as i32;
+	let mut exp_b = ((b & EXP_MASK) >> 23) as i32;
+	let mut frac_a = a & FRAC_MASK;
+	let mut frac_b = b & FRAC_MASK;
+
+	if exp_a == 0xff {
+		return if exp_b == 0xff { DEFAULT_NAN } else { sign | INFINITY };
+	}
+
+	if exp_b == 0xff {
+		return sign;
+	}
+
+	if b & !SIGN == 0 {
+		return if a & !SIGN == 0 { DEFAULT_NAN } else { sign | INFINITY };
+	}
+
+	if a & !SIGN == 0 {
+		return sign;
+	}
+
+	if exp_a == 0 {
+		let n = normalize_subnormal(frac_a);
+		exp_a = n.0;
+		frac_a = n.1;
+	}
+
+	if exp_b == 0 {
+		let n = normalize_subnormal(frac_b);
+		exp_b = n.0;
+		frac_b = n.1;
+	}
+
+	let sig_a = frac_a | 0x0080_0000;
+	let sig_b = frac_b | 0x0080_0000;
+
+	let mut exp = exp_a - exp_b + 0x7e;
+	let dividend = if sig_a < sig_b {
+		exp -= 1;
+		(sig_a as u64) << 31
+	} else {
+		(sig_a as u64) << 30
+	};
+
+	let mut sig = (dividend / sig_b as u64) as u32;
+
+	if sig & 0x3f == 0 {
+		sig |= (sig_b as u64 * sig as u64 != dividend) as u32;
+	}
+
+	return round_pack(sign, exp, sig);
+}
+
+// Lane-parallel versions of add and mul. Every lane is computed with the same
+// branch-free integer sequence, which LLVM vectorizes, assuming both inputs and
+// the result are normal numbers. Lanes where that does not hold are recomputed
+// with the scalar functions, so the results are always identical to them.
+
+#[inline(always)]
+fn round_fast(sign: u32, exp: i32, sig: u32) -> u32 {
+	let mut rounded = (sig + 0x40) >> 7;
+	rounded &= !((sig & 0x7f == 0x40) as u32);
+	return sign | ((exp as u32) << 23).wrapping_add(rounded);
+}
+
+#[inline(always)]
+fn is_normal(x: u32) -> bool {
+	return (x & EXP_MASK).wrapping_sub(0x0080_0000) < 0x7f00_0000;
+}
+
+#[inline(always)]
+pub fn add_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+	let mut r = [0u32; N];
+	let mut slow = [false; N];
+
+	for l in 0..N {
+		let (a, b) = (a[l], b[l]);
+		let swap = b & !SIGN > a & !SIGN;
+		let x = if swap { b } else { a };
+		let y = if swap { a } else { b };
+
+		let exp_x = ((x >> 23) & 0xff) as i32;
+		let dist = exp_x as u32 - ((y >> 23) & 0xff);
+		let sig_x = ((x & FRAC_MASK) | 0x0080_0000) << 7;
+		let sig_y = ((y & FRAC_MASK) | 0x0080_0000) << 7;
+		let shifted = sig_y.checked_shr(dist).unwrap_or(0);
+		let sticky = (shifted.checked_shl(dist).unwrap_or(0) != sig_y) as u32;
+
+		let sig = if (a ^ b) & SIGN != 0 { sig_x - (shifted | sticky) } else { sig_x + (shifted | sticky) };
+		let zeros = sig.leading_zeros() as i32;
+		let carry = zeros == 0;
+		let shift = if carry { 0 } else { zeros - 1 } as u32;
+		let norm = if carry { (sig >> 1) | (sig & 1) } else { sig << shift };
+		let exp = if carry { exp_x } else { exp_x - 1 - shift as i32 };
+
+		r[l] = round_fast(x & SIGN, exp, norm);
+		slow[l] = !is_normal(a) || !is_normal(b) || sig == 0 || exp < 0 || exp >= 0xfd;
+	}
+
+	for l in 0..N {
+		if slow[l] {
+			r[l] = add(a[l], b[l]);
+		}
+	}
+
+	return r;
+}
+
+#[inline(always)]
+pub fn sub_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+	let mut r = add_lanes(a, b.map(|x| x ^ SIGN));
+
+	// Only NaN inputs differ from a + -b, and those already took the slow path.
+	for l in 0..N {
+		if is_nan(a[l]) || is_nan(b[l]) {
+			r[l] = sub(a[l], b[l]);
+		}
+	}
+
+	return r;
+}
+
+#[inline(always)]
+pub fn mul_lanes<const N: usize>(a: [u32; N], b: [u32; N]) -> [u32; N] {
+	let mut r = [0u32; N];
+	let mut slow = [false; N];
+
+	for l in 0..N {
+		let (a, b) = (a[l], b[l]);
+		let sig_a = ((a & FRAC_MASK) | 0x0080_0000) << 7;
+		let sig_b = ((b & FRAC_MASK) | 0x0080_0000) << 8;
+		let product = sig_a as u64 * sig_b as u64;
+		let sig = (product >> 32) as u32 | ((product as u32 != 0) as u32);
+
+		let low = sig < 0x4000_0000;
+		let exp = ((a >> 23) & 0xff) as i32 + ((b >> 23) & 0xff) as i32 - 0x7f - low as i32;
+
+		r[l] = round_fast((a ^ b) & SIGN, exp, sig << low as u32);
+		slow[l] = !is_normal(a) || !is_normal(b) || exp < 0 || exp >= 0xfd;
+	}
+
+	for l in 0..N {
+		if slow[l] {
+			r[l] = mul(a[l], b[l]);
+		}
+	}
+
+	return r;
+}
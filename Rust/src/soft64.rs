@@ -0,0 +1,269 @@
+// IEEE-754 binary64 add/sub/mul/div using only integer operations, the double
+// precision counterpart of soft.rs. The structure is the same; significands have
+// 10 bits of rounding information instead of 7, and products and quotients use
+// u128 intermediates.
+//
+// NaN results follow x86 SSE2 as in soft.rs.
+
+pub const SIGN: u64 = 0x8000_0000_0000_0000;
+pub const EXP_MASK: u64 = 0x7ff0_0000_0000_0000;
+pub const FRAC_MASK: u64 = 0x000f_ffff_ffff_ffff;
+pub const QUIET_BIT: u64 = 0x0008_0000_0000_0000;
+pub const INFINITY: u64 = 0x7ff0_0000_0000_0000;
+pub const DEFAULT_NAN: u64 = 0xfff8_0000_0000_0000;
+
+const HIDDEN_BIT: u64 = 0x0010_0000_0000_0000;
+
+#[inline(always)]
+pub fn is_nan(x: u64) -> bool {
+	return x & !SIGN > INFINITY;
+}
+
+// x with a denormal replaced by zero of the same sign, see arith::FlushDenormals.
+#[inline(always)]
+pub fn flush(x: u64) -> u64 {
+	return if x & EXP_MASK == 0 { x & SIGN } else { x };
+}
+
+// DEFAULT_NAN if x is a NaN, otherwise x, see arith::CanonicalNaNs.
+#[inline(always)]
+pub fn canonical(x: u64) -> u64 {
+	return if is_nan(x) { DEFAULT_NAN } else { x };
+}
+
+#[inline(always)]
+fn propagate_nan(a: u64, b: u64) -> u64 {
+	return if is_nan(a) { a | QUIET_BIT } else { b | QUIET_BIT };
+}
+
+#[inline(always)]
+fn shift_right_jam(a: u64, dist: u32) -> u64 {
+	if dist == 0 {
+		return a;
+	}
+
+	return if dist < 64 { (a >> dist) | ((a << (64 - dist) != 0) as u64) } else { (a != 0) as u64 };
+}
+
+#[inline(always)]
+fn normalize_subnormal(frac: u64) -> (i32, u64) {
+	let shift = frac.leading_zeros() as i32 - 11;
+	return (1 - shift, (frac << shift) & FRAC_MASK);
+}
+
+// exp is the biased exponent minus one, and sig holds the significand with its
+// leading bit at bit 62 and 10 bits of rounding information.
+#[inline(always)]
+fn round_pack(sign: u64, mut exp: i32, mut sig: u64) -> u64 {
+	let mut round_bits = sig & 0x3ff;
+
+	if exp as u32 >= 0x7fd {
+		if exp < 0 {
+			sig = shift_right_jam(sig, (-exp) as u32);
+			exp = 0;
+			round_bits = sig & 0x3ff;
+		} else if exp > 0x7fd || sig + 0x200 >= 0x8000_0000_0000_0000 {
+			return sign | INFINITY;
+		}
+	}
+
+	sig = (sig + 0x200) >> 10;
+
+	if round_bits == 0x200 {
+		sig &= !1;
+	}
+
+	if sig == 0 {
+		exp = 0;
+	}
+
+	return sign | ((exp as u64) << 52).wrapping_add(sig);
+}
+
+// Magnitude of a is at least that of b, and both are finite.
+#[inline(always)]
+fn add_mags(a: u64, b: u64, sign: u64) -> u64 {
+	let exp_a = ((a & EXP_MASK) >> 52) as i32;
+	let exp_b = ((b & EXP_MASK) >> 52) as i32;
+
+	if exp_a == 0 {
+		return sign | ((a & FRAC_MASK) + (b & FRAC_MASK));
+	}
+
+	let sig_a = (a & FRAC_MASK) << 9;
+	let mut sig_b = (b & FRAC_MASK) << 9;
+	sig_b += if exp_b != 0 { 0x2000_0000_0000_0000 } else { sig_b };
+	sig_b = shift_right_jam(sig_b, (exp_a - exp_b) as u32);
+
+	let mut exp = exp_a;
+	let mut sig = 0x2000_0000_0000_0000 + sig_a + sig_b;
+
+	if sig < 0x4000_0000_0000_0000 {
+		exp -= 1;
+		sig <<= 1;
+	}
+
+	return round_pack(sign, exp, sig);
+}
+
+// Magnitude of a is at least that of b, and both are finite.
+#[inline(always)]
+fn sub_mags(a: u64, b: u64, sign: u64) -> u64 {
+	if a & !SIGN == b & !SIGN {
+		return 0;
+	}
+
+	let exp_a = ((a & EXP_MASK) >> 52) as i32;
+	let exp_b = ((b & EXP_MASK) >> 52) as i32;
+
+	if exp_a == 0 {
+		return sign | ((a & FRAC_MASK) - (b & FRAC_MASK));
+	}
+
+	let sig_a = ((a & FRAC_MASK) << 10) | 0x4000_0000_0000_0000;
+	let mut sig_b = (b & FRAC_MASK) << 10;
+	sig_b += if exp_b != 0 { 0x4000_0000_0000_0000 } else { sig_b };
+	sig_b = shift_right_jam(sig_b, (exp_a - exp_b) as u32);
+
+	let sig = sig_a - sig_b;
+	let shift = sig.leading_zeros() as i32 - 1;
+
+	return round_pack(sign, exp_a - 1 - shift, sig << shift);
+}
+
+#[inline(always)]
+pub fn add(a: u64, b: u64) -> u64 {
+	if is_nan(a) || is_nan(b) {
+		return propagate_nan(a, b);
+	}
+
+	if a & EXP_MASK == EXP_MASK || b & EXP_MASK == EXP_MASK {
+		if a & EXP_MASK != EXP_MASK {
+			return b;
+		}
+		if b & EXP_MASK == EXP_MASK && (a ^ b) & SIGN != 0 {
+			return DEFAULT_NAN;
+		}
+		return a;
+	}
+
+	let (x, y) = if a & !SIGN >= b & !SIGN { (a, b) } else { (b, a) };
+
+	return if (a ^ b) & SIGN == 0 { add_mags(x, y, x & SIGN) } else { sub_mags(x, y, x & SIGN) };
+}
+
+#[inline(always)]
+pub fn sub(a: u64, b: u64) -> u64 {
+	if is_nan(a) || is_nan(b) {
+		return propagate_nan(a, b);
+	}
+
+	return add(a, b ^ SIGN);
+}
+
+#[inline(always)]
+pub fn mul(a: u64, b: u64) -> u64 {
+	if is_nan(a) || is_nan(b) {
+		return propagate_nan(a, b);
+	}
+
+	let sign = (a ^ b) & SIGN;
+	let mut exp_a = ((a & EXP_MASK) >> 52) as i32;
+	let mut exp_b = ((b & EXP_MASK) >> 52) as i32;
+	let mut frac_a = a & FRAC_MASK;
+	let mut frac_b = b & FRAC_MASK;
+
+	if exp_a == 0x7ff || exp_b == 0x7ff {
+		if a & !SIGN == 0 || b & !SIGN == 0 {
+			return DEFAULT_NAN;
+		}
+		return sign | INFINITY;
+	}
+
+	if a & !SIGN == 0 || b & !SIGN == 0 {
+		return sign;
+	}
+
+	if exp_a == 0 {
+		let n = normalize_subnormal(frac_a);
+		exp_a = n.0;
+		frac_a = n.1;
+	}
+
+	if exp_b == 0 {
+		let n = normalize_subnormal(frac_b);
+		exp_b = n.0;
+		frac_b = n.1;
+	}
+
+	let sig_a = (frac_a | HIDDEN_BIT) << 10;
+	let sig_b = (frac_b | HIDDEN_BIT) << 11;
+	let product = sig_a as u128 * sig_b as u128;
+
+	let mut exp = exp_a + exp_b - 0x3ff;
+	let mut sig = (product >> 64) as u64 | ((product as u64 != 0) as u64);
+
+	if sig < 0x4000_0000_0000_0000 {
+		exp -= 1;
+		sig <<= 1;
+	}
+
+	return round_pack(sign, exp, sig);
+}
+
+#[inline(always)]
+pub fn div(a: u64, b: u64) -> u64 {
+	if is_nan(a) || is_nan(b) {
+		return propagate_nan(a, b);
+	}
+
+	let sign = (a ^ b) & SIGN;
+	let mut exp_a = ((a & EXP_MASK) >> 52) as i32;
+	let mut exp_b = ((b & EXP_MASK) >> 52) as i32;
+	let mut frac_a = a & FRAC_MASK;
+	let mut frac_b = b & FRAC_MASK;
+
+	if exp_a == 0x7ff {
+		return if exp_b == 0x7ff { DEFAULT_NAN } else { sign | INFINITY };
+	}
+
+	if exp_b == 0x7ff {
+		return sign;
+	}
+
+	if b & !SIGN == 0 {
+		return if a & !SIGN == 0 { DEFAULT_NAN } else { sign | INFINITY };
+	}
+
+	if a & !SIGN == 0 {
+		return sign;
+	}
+
+	if exp_a == 0 {
+		let n = normalize_subnormal(frac_a);
+		exp_a = n.0;
+		frac_a = n.1;
+	}
+
+	if exp_b == 0 {
+		let n = normalize_subnormal(frac_b);
+		exp_b = n.0;
+		frac_b = n.1;
+	}
+
+	let sig_a = frac_a | HIDDEN_BIT;
+	let sig_b = (frac_b | HIDDEN_BIT) as u128;
+
+	let mut exp = exp_a - exp_b + 0x3fe;
+	let dividend = if sig_a < sig_b as u64 {
+		exp -= 1;
+		(sig_a as u128) << 63
+	} else {
+		(sig_a as u128) << 62
+	};
+
+	// Any remainder is jammed into the last bit so rounding sees it.
+	let sig = (dividend / sig_b) as u64 | ((dividend % sig_b != 0) as u64);
+
+	return round_pack(sign, exp, sig);
+}
@@ -0,0 +1,426 @@
+use crate::arith;
+use crate::hash;
+use std::cell::RefCell;
+use std::fs::File;
+use std::io::{self, BufWriter, Write};
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+
+// A trace of the operations the library executes, for finding which one first
+// differs between two devices that desynced.
+//
+// While tracing, every elementary operation export (float_ and double_ add, sub,
+// mul and div, float_ sqrt, sin, cos, atan2, exp and log, and the conversions,
+// scalar or batched) records its opcode, operands and result in a ring buffer of
+// the calling thread, keeping the last capacity records. Each thread writes only
+// its own ring, so recording takes no lock; the registry of rings is only locked
+// when a thread records for the first time since tracing started.
+//
+// The composite exports (vectors, quaternions, matrices, programs, reductions)
+// record one record per call instead, with the number of elements they read and
+// wrote and the XXH64 of those they wrote, so a trace shows which call first
+// returned different results, though not which of its operations.
+//
+// While not tracing, an export costs one relaxed load and a branch more, per call
+// rather than per element. A traced batch runs the scalar operation on each
+// element instead of the batched kernel, which gives the same bits.
+//
+// A dump is a little-endian file of:
+//
+//   u32 MAGIC, u32 VERSION, u32 thread count, u32 BLOCK
+//   for each thread, in the order they first recorded:
+//     u32 thread index, u64 record count, u64 records dropped before the first,
+//     u64 length of the records in bytes
+//     for each block of BLOCK records: u64 offset of its first record from the
+//       first record, u64 hash of the records up to the block's end
+//     the records, oldest first
+//
+// A record is its u8 opcode, a u8 of the modes it ran in (backend, then
+// denormal mode << 1, then NaN mode << 2), then the operands a and b and the
+// result, each 4 bytes, or 8 for the TRACE_DOUBLE opcodes, the conversions to and
+// from i64 and the calls. Unary operations have b = 0, and conversions have the
+// rounding mode as b. So a dfloat operation takes 14 bytes and a ddouble one 26.
+// A call has the input and output element counts as a and b and the hash of the
+// outputs as the result, seeded with dfloat_program_run's return code.
+//
+// A block's hash is the XXH64 of its bytes seeded with the previous block's hash,
+// or 0 for the first, so two traces hold the same records up to the end of a
+// block if that block's hashes match. The first block where they differ is found
+// by a binary search over the hashes, without reading the records before it.
+//
+// Dumping while other threads trace can lose the records they overwrite during
+// the dump, which are counted as dropped; stop tracing first for a complete dump.
+
+pub const MAGIC: u32 = 0x5254_4644; // "DFTR"
+pub const VERSION: u32 = 3;
+
+pub const BLOCK: usize = 4096;
+
+// The dfloat opcodes are those of vm.rs; the ddouble ones have this bit set.
+pub const TRACE_DOUBLE: u8 = 0x80;
+
+// Conversions, named after their exports.
+pub const TRACE_TO_I32: u8 = 0x20;
+pub const TRACE_TO_U32: u8 = 0x21;
+pub const TRACE_TO_I64: u8 = 0x22;
+pub const TRACE_FROM_I32: u8 = 0x23;
+pub const TRACE_FROM_U32: u8 = 0x24;
+pub const TRACE_FROM_I64: u8 = 0x25;
+
+// Calls of composite exports, TRACE_CALL plus the export's index below.
+pub const TRACE_CALL: u8 = 0x40;
+
+macro_rules! calls {
+	($($name:ident = $index:expr => $export:ident,)*) => {
+		$(pub const $name: u8 = TRACE_CALL + $index;)*
+
+		// The name of the export a call record's opcode stands for.
+		pub fn call_name(op: u8) -> Option<&'static str> {
+			return match op {
+				$($name => Some(stringify!($export)),)*
+				_ => None,
+			};
+		}
+	};
+}
+
+calls! {
+	CALL_DVEC2_DOT = 0 => dvec2_dot,
+	CALL_DVEC3_DOT = 1 => dvec3_dot,
+	CALL_DVEC4_DOT = 2 => dvec4_dot,
+	CALL_DVEC3_CROSS = 3 => dvec3_cross,
+	CALL_DVEC2_NORMALIZE = 4 => dvec2_normalize,
+	CALL_DVEC3_NORMALIZE = 5 => dvec3_normalize,
+	CALL_DVEC4_NORMALIZE = 6 => dvec4_normalize,
+	CALL_DQUAT_MUL = 7 => dquat_mul,
+	CALL_DQUAT_ROTATE = 8 => dquat_rotate,
+	CALL_DVEC2_DOT_BATCH = 9 => dvec2_dot_batch,
+	CALL_DVEC3_DOT_BATCH = 10 => dvec3_dot_batch,
+	CALL_DVEC4_DOT_BATCH = 11 => dvec4_dot_batch,
+	CALL_DVEC3_CROSS_BATCH = 12 => dvec3_cross_batch,
+	CALL_DVEC2_NORMALIZE_BATCH = 13 => dvec2_normalize_batch,
+	CALL_DVEC3_NORMALIZE_BATCH = 14 => dvec3_normalize_batch,
+	CALL_DVEC4_NORMALIZE_BATCH = 15 => dvec4_normalize_batch,
+	CALL_DQUAT_MUL_BATCH = 16 => dquat_mul_batch,
+	CALL_DQUAT_ROTATE_BATCH = 17 => dquat_rotate_batch,
+	CALL_DMAT4_MUL = 18 => dmat4_mul,
+	CALL_DMAT4_TRANSFORM_POINT = 19 => dmat4_transform_point,
+	CALL_DMAT4_TRANSFORM_VECTOR = 20 => dmat4_transform_vector,
+	CALL_DMAT4_MUL_BATCH = 21 => dmat4_mul_batch,
+	CALL_DMAT4_MUL_BATCH_SOA = 22 => dmat4_mul_batch_soa,
+	CALL_DMAT4_TRANSFORM_POINTS = 23 => dmat4_transform_points,
+	CALL_DMAT4_TRANSFORM_POINTS_SOA = 24 => dmat4_transform_points_soa,
+	CALL_DMAT4_TRANSFORM_VECTORS = 25 => dmat4_transform_vectors,
+	CALL_DMAT4_TRANSFORM_VECTORS_SOA = 26 => dmat4_transform_vectors_soa,
+	CALL_PROGRAM_RUN = 27 => dfloat_program_run,
+	CALL_FLOAT_SUM = 28 => float_sum,
+	CALL_FLOAT_DOT = 29 => float_dot,
+	CALL_FLOAT_MIN = 30 => float_min,
+	CALL_FLOAT_MAX = 31 => float_max,
+}
+
+pub const DEFAULT_CAPACITY: usize = 1 << 16;
+
+static TRACING: AtomicBool = AtomicBool::new(false);
+static CAPACITY: AtomicUsize = AtomicUsize::new(DEFAULT_CAPACITY);
+// Incremented by every start, so threads replace rings from an earlier trace.
+static GENERATION: AtomicU64 = AtomicU64::new(0);
+static RINGS: Mutex<Vec<Arc<Ring>>> = Mutex::new(Vec::new());
+
+struct Ring {
+	thread: u32,
+	generation: u64,
+	// The opcode and modes, a, b and the result of each record, a power of two of
+	// them. Atomics so that a dump on another thread can read them; relaxed stores
+	// are plain stores.
+	records: Box<[[AtomicU64; 4]]>,
+	// How many records the owning thread has pushed.
+	written: AtomicU64,
+}
+
+impl Ring {
+	#[inline(always)]
+	fn push(&self, words: [u64; 4]) {
+		let n = self.written.load(Ordering::Relaxed);
+		let slot = &self.records[n as usize & (self.records.len() - 1)];
+
+		for i in 0..4 {
+			slot[i].store(words[i], Ordering::Relaxed);
+		}
+
+		self.written.store(n + 1, Ordering::Release);
+	}
+}
+
+thread_local! {
+	static RING: RefCell<Option<Arc<Ring>>> = RefCell::new(None);
+}
+
+#[inline(always)]
+pub fn tracing() -> bool {
+	return TRACING.load(Ordering::Relaxed);
+}
+
+#[inline(always)]
+fn modes() -> u64 {
+	return (arith::backend() | arith::denormal_mode() << 1 | arith::nan_mode() << 2) as u64;
+}
+
+#[cold]
+#[inline(never)]
+fn record(op: u8, a: u64, b: u64, result: u64) {
+	let words = [op as u64 | modes() << 8, a, b, result];
+	let generation = GENERATION.load(Ordering::Acquire);
+
+	// try_with fails while the thread is exiting, when the record is lost.
+	let _ = RING.try_with(|ring| {
+		let mut ring = ring.borrow_mut();
+
+		match &*ring {
+			Some(r) if r.generation == generation => r.push(words),
+			_ => {
+				let r = register(generation);
+				r.push(words);
+				*ring = Some(r);
+			}
+		}
+	});
+}
+
+fn register(generation: u64) -> Arc<Ring> {
+	let mut rings = RINGS.lock().unwrap_or_else(|e| e.into_inner());
+	let capacity = CAPACITY.load(Ordering::Relaxed);
+
+	let ring = Arc::new(Ring {
+		thread: rings.len() as u32,
+		generation,
+		records: (0..capacity).map(|_| Default::default()).collect(),
+		written: AtomicU64::new(0),
+	});
+
+	// Registered after a newer start, the ring is discarded by the next record.
+	if generation == GENERATION.load(Ordering::Acquire) {
+		rings.push(ring.clone());
+	}
+
+	return ring;
+}
+
+// Records the operation if tracing, and returns its result.
+#[inline(always)]
+pub fn op<T: Copy + Into<u64>>(op: u8, a: T, b: T, result: T) -> T {
+	if tracing() {
+		record(op, a.into(), b.into(), result.into());
+	}
+
+	return result;
+}
+
+// The batched forms of traced scalar operations, which record each element.
+// out may be the same buffer as a or b.
+pub unsafe fn each2<T: Copy, F: Fn(T, T) -> T>(a: *const T, b: *const T, out: *mut T, len: usize, op: F) {
+	for i in 0..len {
+		*out.add(i) = op(*a.add(i), *b.add(i));
+	}
+}
+
+pub unsafe fn each1<T: Copy, U, F: Fn(T) -> U>(x: *const T, out: *mut U, len: usize, op: F) {
+	for i in 0..len {
+		*out.add(i) = op(*x.add(i));
+	}
+}
+
+// Records a call of a composite export that read inputs elements and wrote the
+// len at outputs, if tracing.
+#[inline(always)]
+pub unsafe fn call(op: u8, inputs: usize, outputs: *const u32, len: usize) {
+	if tracing() {
+		record_call(op, inputs, outputs, len, 0);
+	}
+}
+
+// As call, with the hash seeded with seed.
+#[inline(always)]
+pub unsafe fn call_seeded(op: u8, inputs: usize, outputs: *const u32, len: usize, seed: u64) {
+	if tracing() {
+		record_call(op, inputs, outputs, len, seed);
+	}
+}
+
+#[cold]
+#[inline(never)]
+unsafe fn record_call(op: u8, inputs: usize, outputs: *const u32, len: usize, seed: u64) {
+	record(op, inputs as u64, len as u64, hash::hash_floats(crate::slice(outputs, len), 0, seed));
+}
+
+pub fn start(capacity: usize) {
+	let mut rings = RINGS.lock().unwrap_or_else(|e| e.into_inner());
+
+	CAPACITY.store(capacity.next_power_of_two(), Ordering::Relaxed);
+	GENERATION.fetch_add(1, Ordering::AcqRel);
+	rings.clear();
+	TRACING.store(true, Ordering::Relaxed);
+}
+
+pub fn stop() {
+	TRACING.store(false, Ordering::Relaxed);
+}
+
+// The size of an operand of op in bytes.
+pub fn width(op: u8) -> usize {
+	return if op & TRACE_DOUBLE != 0 || op == TRACE_TO_I64 || op == TRACE_FROM_I64 || is_call(op) { 8 } else { 4 };
+}
+
+pub fn is_call(op: u8) -> bool {
+	return op & TRACE_DOUBLE == 0 && op >= TRACE_CALL;
+}
+
+pub fn record_size(op: u8) -> usize {
+	return 2 + 3 * width(op);
+}
+
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+pub struct Record {
+	pub op: u8,
+	pub modes: u8,
+	pub a: u64,
+	pub b: u64,
+	pub result: u64,
+}
+
+impl Record {
+	pub fn encode(&self, out: &mut Vec<u8>) {
+		let width = width(self.op);
+		out.push(self.op);
+		out.push(self.modes);
+
+		for word in &[self.a, self.b, self.result] {
+			out.extend_from_slice(&word.to_le_bytes()[..width]);
+		}
+	}
+
+	// The record at the start of bytes, and its size, or None if bytes ends first.
+	pub fn decode(bytes: &[u8]) -> Option<(Record, usize)> {
+		let op = *bytes.first()?;
+		let width = width(op);
+		let size = record_size(op);
+
+		if bytes.len() < size {
+			return None;
+		}
+
+		let word = |i: usize| {
+			let mut w = [0; 8];
+			w[..width].copy_from_slice(&bytes[2 + i * width..2 + (i + 1) * width]);
+			return u64::from_le_bytes(w);
+		};
+
+		return Some((Record { op, modes: bytes[1], a: word(0), b: word(1), result: word(2) }, size));
+	}
+
+	pub fn backend(&self) -> u32 {
+		return (self.modes & 1) as u32;
+	}
+
+	pub fn denormal_mode(&self) -> u32 {
+		return (self.modes >> 1 & 1) as u32;
+	}
+
+	pub fn nan_mode(&self) -> u32 {
+		return (self.modes >> 2 & 1) as u32;
+	}
+}
+
+// Writes every thread's records to w, and returns the number written.
+pub fn dump<W: Write>(w: &mut W) -> io::Result<u64> {
+	let rings: Vec<Arc<Ring>> = RINGS.lock().unwrap_or_else(|e| e.into_inner()).clone();
+	let mut total = 0;
+
+	w.write_all(&MAGIC.to_le_bytes())?;
+	w.write_all(&VERSION.to_le_bytes())?;
+	w.write_all(&(rings.len() as u32).to_le_bytes())?;
+	w.write_all(&(BLOCK as u32).to_le_bytes())?;
+
+	for ring in &rings {
+		let capacity = ring.records.len() as u64;
+		let end = ring.written.load(Ordering::Acquire);
+		let first = end.saturating_sub(capacity);
+		let mut records = Vec::with_capacity((end - first) as usize);
+
+		for n in first..end {
+			let slot = &ring.records[n as usize & (capacity as usize - 1)];
+			records.push([0, 1, 2, 3].map(|i| slot[i].load(Ordering::Relaxed)));
+		}
+
+		// Records the owner overwrote while they were copied, and while tracing, the
+		// one it may be overwriting now.
+		let writing = tracing() as u64;
+		let overwritten = (ring.written.load(Ordering::Acquire) + writing).saturating_sub(capacity).max(first);
+		let kept = &records[(overwritten - first) as usize..];
+
+		let mut bytes = Vec::new();
+		let mut index = Vec::new();
+		let mut hash = 0;
+
+		for block in kept.chunks(BLOCK) {
+			let start = bytes.len();
+
+			for r in block {
+				Record { op: r[0] as u8, modes: (r[0] >> 8) as u8, a: r[1], b: r[2], result: r[3] }.encode(&mut bytes);
+			}
+
+			hash = hash::hash_bytes(&bytes[start..], hash);
+			index.push((start as u64, hash));
+		}
+
+		w.write_all(&ring.thread.to_le_bytes())?;
+		w.write_all(&(kept.len() as u64).to_le_bytes())?;
+		w.write_all(&overwritten.to_le_bytes())?;
+		w.write_all(&(bytes.len() as u64).to_le_bytes())?;
+
+		for (offset, hash) in index {
+			w.write_all(&offset.to_le_bytes())?;
+			w.write_all(&hash.to_le_bytes())?;
+		}
+
+		w.write_all(&bytes)?;
+
+		total += kept.len() as u64;
+	}
+
+	w.flush()?;
+	return Ok(total);
+}
+
+// Starts tracing, discarding any records from before, with rings of capacity
+// records per thread, rounded up to a power of two, or DEFAULT_CAPACITY if 0.
+// Each record takes 32 bytes, so the default rings take 2 MB each.
+#[no_mangle]
+pub extern "C" fn dfloat_trace_start(capacity: usize) {
+	start(if capacity == 0 { DEFAULT_CAPACITY } else { capacity });
+}
+
+// Stops tracing, keeping the records to dump.
+#[no_mangle]
+pub extern "C" fn dfloat_trace_stop() {
+	stop();
+}
+
+#[no_mangle]
+pub extern "C" fn dfloat_trace_active() -> u32 {
+	return tracing() as u32;
+}
+
+// Dumps the records to the file at the UTF-8 path of path_len bytes, replacing
+// it. Returns the number of records written, or -1 if the file could not be
+// written.
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_trace_dump(path: *const u8, path_len: usize) -> i64 {
+	let path = match std::str::from_utf8(crate::slice(path, path_len)) {
+		Ok(path) => path,
+		Err(_) => return -1,
+	};
+
+	let result = File::create(path).and_then(|file| dump(&mut BufWriter::new(file)));
+	return result.map_or(-1, |total| total as i64);
+}
@@ -0,0 +1,280 @@
+use crate::arith::{Arith, Float};
+use crate::dmath;
+use crate::soft::SIGN;
+use crate::trace;
+
+// Vector and quaternion operations on dfloat components. Every formula below is
+// evaluated exactly in the order written, one separately rounded operation at a
+// time, so the results only depend on the backend's basic operations:
+//
+//   dot        ((x * x' + y * y') + z * z') + w * w', with as many terms as
+//              components
+//   cross      (y * z' - z * y', z * x' - x * z', x * y' - y * x')
+//   normalize  each component divided by sqrt(dot(v, v)), using the correctly
+//              rounded dmath::sqrt. If dot(v, v) is zero (including when it
+//              underflows) the result is the zero vector.
+//   quat mul   the Hamilton product a * b, as in Unity, with each component
+//              summed left to right:
+//              x = ((w * x' + x * w') + y * z') - z * y'
+//              y = ((w * y' - x * z') + y * w') + z * x'
+//              z = ((w * z' + x * y') - y * x') + z * w'
+//              w = ((w * w' - x * x') - y * y') - z * z'
+//   rotate     v + (w * t + cross(q, t)), where q is the vector part and
+//              t = cross(q, v) * 2, the standard expansion of q * v * q^-1
+//              for a unit quaternion.
+//
+// Each formula runs on the backend's uncanonical arithmetic and only its results
+// are canonicalized, see Arith::Uncanonical.
+//
+// Quaternions are stored (x, y, z, w). Batched exports take structure-of-arrays
+// buffers: a buffer of len vectors with N components holds N consecutive planes
+// of len values, all of x, then all of y, and so on.
+
+type F<A> = Float<A>;
+
+#[inline(always)]
+fn f<A: Arith>(bits: u32) -> F<A> {
+	return F::from_bits(bits);
+}
+
+#[inline(always)]
+pub fn dot<A: Arith, const N: usize>(a: [u32; N], b: [u32; N]) -> u32 {
+	return A::canonical(dot_uncanonical::<A::Uncanonical, N>(a, b));
+}
+
+#[inline(always)]
+pub fn cross<A: Arith>(a: [u32; 3], b: [u32; 3]) -> [u32; 3] {
+	return cross_uncanonical::<A::Uncanonical>(a, b).map(A::canonical);
+}
+
+#[inline(always)]
+pub fn normalize<A: Arith, const N: usize>(v: [u32; N]) -> [u32; N] {
+	return normalize_uncanonical::<A::Uncanonical, N>(v).map(A::canonical);
+}
+
+#[inline(always)]
+pub fn quat_mul<A: Arith>(a: [u32; 4], b: [u32; 4]) -> [u32; 4] {
+	return quat_mul_uncanonical::<A::Uncanonical>(a, b).map(A::canonical);
+}
+
+#[inline(always)]
+pub fn quat_rotate<A: Arith>(q: [u32; 4], v: [u32; 3]) -> [u32; 3] {
+	return quat_rotate_uncanonical::<A::Uncanonical>(q, v).map(A::canonical);
+}
+
+#[inline(always)]
+fn dot_uncanonical<A: Arith, const N: usize>(a: [u32; N], b: [u32; N]) -> u32 {
+	let mut sum = f::<A>(a[0]) * f(b[0]);
+
+	for i in 1..N {
+		sum = sum + f(a[i]) * f(b[i]);
+	}
+
+	return sum.0;
+}
+
+#[inline(always)]
+fn cross_uncanonical<A: Arith>(a: [u32; 3], b: [u32; 3]) -> [u32; 3] {
+	let (ax, ay, az) = (f::<A>(a[0]), f::<A>(a[1]), f::<A>(a[2]));
+	let (bx, by, bz) = (f::<A>(b[0]), f::<A>(b[1]), f::<A>(b[2]));
+
+	return [(ay * bz - az * by).0, (az * bx - ax * bz).0, (ax * by - ay * bx).0];
+}
+
+#[inline(always)]
+fn normalize_uncanonical<A: Arith, const N: usize>(v: [u32; N]) -> [u32; N] {
+	let length_squared = dot_uncanonical::<A, N>(v, v);
+
+	if length_squared & !SIGN == 0 {
+		return [0; N];
+	}
+
+	let length = f::<A>(dmath::sqrt(length_squared));
+	let mut r = [0; N];
+
+	for i in 0..N {
+		r[i] = (f::<A>(v[i]) / length).0;
+	}
+
+	return r;
+}
+
+#[inline(always)]
+fn quat_mul_uncanonical<A: Arith>(a: [u32; 4], b: [u32; 4]) -> [u32; 4] {
+	let (x, y, z, w) = (f::<A>(a[0]), f::<A>(a[1]), f::<A>(a[2]), f::<A>(a[3]));
+	let (x2, y2, z2, w2) = (f::<A>(b[0]), f::<A>(b[1]), f::<A>(b[2]), f::<A>(b[3]));
+
+	return [
+		(w * x2 + x * w2 + y * z2 - z * y2).0,
+		(w * y2 - x * z2 + y * w2 + z * x2).0,
+		(w * z2 + x * y2 - y * x2 + z * w2).0,
+		(w * w2 - x * x2 - y * y2 - z * z2).0,
+	];
+}
+
+#[inline(always)]
+fn quat_rotate_uncanonical<A: Arith>(q: [u32; 4], v: [u32; 3]) -> [u32; 3] {
+	let u = [q[0], q[1], q[2]];
+	let w = f::<A>(q[3]);
+	let two = F::<A>::c(2.0);
+
+	let c = cross_uncanonical::<A>(u, v);
+	let t = [(f::<A>(c[0]) * two).0, (f::<A>(c[1]) * two).0, (f::<A>(c[2]) * two).0];
+	let ut = cross_uncanonical::<A>(u, t);
+
+	let mut r = [0; 3];
+
+	for i in 0..3 {
+		r[i] = (f::<A>(v[i]) + (w * f(t[i]) + f(ut[i]))).0;
+	}
+
+	return r;
+}
+
+// Element i of an SoA buffer of len vectors.
+#[inline(always)]
+unsafe fn load<const N: usize>(p: *const u32, len: usize, i: usize) -> [u32; N] {
+	let mut v = [0; N];
+
+	for c in 0..N {
+		v[c] = *p.add(c * len + i);
+	}
+
+	return v;
+}
+
+#[inline(always)]
+unsafe fn store<const N: usize>(p: *mut u32, len: usize, i: usize, v: [u32; N]) {
+	for c in 0..N {
+		*p.add(c * len + i) = v[c];
+	}
+}
+
+// out may be the same buffer as an input with the same number of components.
+#[inline(always)]
+unsafe fn map_soa2<const N: usize, const M: usize, const R: usize, F: Fn([u32; N], [u32; M]) -> [u32; R]>(a: *const u32, b: *const u32, out: *mut u32, len: usize, op: F) {
+	for i in 0..len {
+		let r = op(load(a, len, i), load(b, len, i));
+		store(out, len, i, r);
+	}
+}
+
+#[inline(always)]
+unsafe fn map_soa1<const N: usize, F: Fn([u32; N]) -> [u32; N]>(v: *const u32, out: *mut u32, len: usize, op: F) {
+	for i in 0..len {
+		let r = op(load(v, len, i));
+		store(out, len, i, r);
+	}
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec2_dot(a: *const [u32; 2], b: *const [u32; 2]) -> u32 {
+	let r = with_backend!(A => dot::<A, 2>(*a, *b));
+	trace::call(trace::CALL_DVEC2_DOT, 4, &r, 1);
+	return r;
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec3_dot(a: *const [u32; 3], b: *const [u32; 3]) -> u32 {
+	let r = with_backend!(A => dot::<A, 3>(*a, *b));
+	trace::call(trace::CALL_DVEC3_DOT, 6, &r, 1);
+	return r;
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec4_dot(a: *const [u32; 4], b: *const [u32; 4]) -> u32 {
+	let r = with_backend!(A => dot::<A, 4>(*a, *b));
+	trace::call(trace::CALL_DVEC4_DOT, 8, &r, 1);
+	return r;
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec3_cross(a: *const [u32; 3], b: *const [u32; 3], out: *mut [u32; 3]) {
+	*out = with_backend!(A => cross::<A>(*a, *b));
+	trace::call(trace::CALL_DVEC3_CROSS, 6, out as *const u32, 3);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec2_normalize(v: *const [u32; 2], out: *mut [u32; 2]) {
+	*out = with_backend!(A => normalize::<A, 2>(*v));
+	trace::call(trace::CALL_DVEC2_NORMALIZE, 2, out as *const u32, 2);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec3_normalize(v: *const [u32; 3], out: *mut [u32; 3]) {
+	*out = with_backend!(A => normalize::<A, 3>(*v));
+	trace::call(trace::CALL_DVEC3_NORMALIZE, 3, out as *const u32, 3);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec4_normalize(v: *const [u32; 4], out: *mut [u32; 4]) {
+	*out = with_backend!(A => normalize::<A, 4>(*v));
+	trace::call(trace::CALL_DVEC4_NORMALIZE, 4, out as *const u32, 4);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dquat_mul(a: *const [u32; 4], b: *const [u32; 4], out: *mut [u32; 4]) {
+	*out = with_backend!(A => quat_mul::<A>(*a, *b));
+	trace::call(trace::CALL_DQUAT_MUL, 8, out as *const u32, 4);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dquat_rotate(q: *const [u32; 4], v: *const [u32; 3], out: *mut [u32; 3]) {
+	*out = with_backend!(A => quat_rotate::<A>(*q, *v));
+	trace::call(trace::CALL_DQUAT_ROTATE, 7, out as *const u32, 3);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec2_dot_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa2(a, b, out, len, |x, y| [dot::<A, 2>(x, y)]));
+	trace::call(trace::CALL_DVEC2_DOT_BATCH, 4 * len, out, len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec3_dot_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa2(a, b, out, len, |x, y| [dot::<A, 3>(x, y)]));
+	trace::call(trace::CALL_DVEC3_DOT_BATCH, 6 * len, out, len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec4_dot_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa2(a, b, out, len, |x, y| [dot::<A, 4>(x, y)]));
+	trace::call(trace::CALL_DVEC4_DOT_BATCH, 8 * len, out, len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec3_cross_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa2(a, b, out, len, cross::<A>));
+	trace::call(trace::CALL_DVEC3_CROSS_BATCH, 6 * len, out, 3 * len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec2_normalize_batch(v: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa1(v, out, len, normalize::<A, 2>));
+	trace::call(trace::CALL_DVEC2_NORMALIZE_BATCH, 2 * len, out, 2 * len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec3_normalize_batch(v: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa1(v, out, len, normalize::<A, 3>));
+	trace::call(trace::CALL_DVEC3_NORMALIZE_BATCH, 3 * len, out, 3 * len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dvec4_normalize_batch(v: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa1(v, out, len, normalize::<A, 4>));
+	trace::call(trace::CALL_DVEC4_NORMALIZE_BATCH, 4 * len, out, 4 * len);
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn dquat_mul_batch(a: *const u32, b: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa2(a, b, out, len, quat_mul::<A>));
+	trace::call(trace::CALL_DQUAT_MUL_BATCH, 8 * len, out, 4 * len);
+}
+
+// q holds len quaternions and v and out len vectors.
+#[no_mangle]
+pub unsafe extern "C" fn dquat_rotate_batch(q: *const u32, v: *const u32, out: *mut u32, len: usize) {
+	with_backend!(A => map_soa2(q, v, out, len, quat_rotate::<A>));
+	trace::call(trace::CALL_DQUAT_ROTATE_BATCH, 7 * len, out, 3 * len);
+}
@@ -0,0 +1,174 @@
+use crate::arith::Arith;
+use crate::dmath;
+use crate::trace;
+
+// A program is a sequence of u32 instruction words, each packed as
+// opcode | dst << 8 | a << 16 | b << 24. OP_CONST is followed by one extra word
+// holding the bits of the constant.
+//
+// Instructions execute strictly in program order and every arithmetic op is a
+// separately rounded IEEE operation; Rust never contracts a * b + c into a fused
+// multiply-add, so a program gives the same bits as the equivalent sequence of
+// float_add/float_mul/... calls.
+pub const OP_LOAD: u8 = 0; // dst = inputs[a]
+pub const OP_STORE: u8 = 1; // outputs[dst] = a
+pub const OP_CONST: u8 = 2; // dst = next word
+pub const OP_ADD: u8 = 3; // dst = a + b
+pub const OP_SUB: u8 = 4; // dst = a - b
+pub const OP_MUL: u8 = 5; // dst = a * b
+pub const OP_DIV: u8 = 6; // dst = a / b
+pub const OP_SQRT: u8 = 7; // dst = sqrt(a)
+pub const OP_SIN: u8 = 8; // dst = sin(a)
+pub const OP_COS: u8 = 9; // dst = cos(a)
+pub const OP_ATAN2: u8 = 10; // dst = atan2(a, b)
+pub const OP_EXP: u8 = 11; // dst = exp(a)
+pub const OP_LOG: u8 = 12; // dst = log(a)
+
+pub const VM_OK: i32 = 0;
+pub const VM_INVALID_OPCODE: i32 = -1;
+pub const VM_INVALID_REGISTER: i32 = -2;
+pub const VM_INVALID_INPUT: i32 = -3;
+pub const VM_INVALID_OUTPUT: i32 = -4;
+pub const VM_TRUNCATED: i32 = -5;
+
+pub const MAX_REGISTERS: usize = 64;
+
+// Lanes are executed in blocks, so decoding each instruction is paid once per
+// block rather than once per lane, and each op is a vectorizable array loop.
+const BLOCK: usize = 32;
+
+#[derive(Clone, Copy)]
+pub struct Instr {
+	pub op: u8,
+	pub dst: u8,
+	pub a: u8,
+	pub b: u8,
+	pub imm: u32,
+}
+
+type Registers = [[u32; BLOCK]; MAX_REGISTERS];
+
+pub fn decode(code: &[u32], input_count: usize, output_count: usize) -> Result<Vec<Instr>, i32> {
+	let mut program = Vec::with_capacity(code.len());
+	let mut i = 0;
+
+	while i < code.len() {
+		let word = code[i];
+		let mut ins = Instr { op: word as u8, dst: (word >> 8) as u8, a: (word >> 16) as u8, b: (word >> 24) as u8, imm: 0 };
+		i += 1;
+
+		let (dst, a, b) = match ins.op {
+			OP_LOAD => {
+				if ins.a as usize >= input_count {
+					return Err(VM_INVALID_INPUT);
+				}
+				(ins.dst, 0, 0)
+			}
+			OP_STORE => {
+				if ins.dst as usize >= output_count {
+					return Err(VM_INVALID_OUTPUT);
+				}
+				(0, ins.a, 0)
+			}
+			OP_CONST => {
+				if i >= code.len() {
+					return Err(VM_TRUNCATED);
+				}
+				ins.imm = code[i];
+				i += 1;
+				(ins.dst, 0, 0)
+			}
+			OP_ADD | OP_SUB | OP_MUL | OP_DIV | OP_ATAN2 => (ins.dst, ins.a, ins.b),
+			OP_SQRT | OP_SIN | OP_COS | OP_EXP | OP_LOG => (ins.dst, ins.a, 0),
+			_ => return Err(VM_INVALID_OPCODE),
+		};
+
+		if dst as usize >= MAX_REGISTERS || a as usize >= MAX_REGISTERS || b as usize >= MAX_REGISTERS {
+			return Err(VM_INVALID_REGISTER);
+		}
+
+		program.push(ins);
+	}
+
+	return Ok(program);
+}
+
+#[inline(always)]
+fn unary<F: Fn(u32) -> u32>(regs: &mut Registers, ins: &Instr, op: F) {
+	let a = regs[ins.a as usize];
+	regs[ins.dst as usize] = a.map(op);
+}
+
+#[inline(always)]
+fn binary<F: Fn(u32, u32) -> u32>(regs: &mut Registers, ins: &Instr, op: F) {
+	let a = regs[ins.a as usize];
+	let b = regs[ins.b as usize];
+	let dst = &mut regs[ins.dst as usize];
+
+	for l in 0..BLOCK {
+		dst[l] = op(a[l], b[l]);
+	}
+}
+
+// inputs holds input_count rows of lanes values, and outputs output_count rows.
+pub unsafe fn run<A: Arith>(program: &[Instr], inputs: *const u32, outputs: *mut u32, lanes: usize) {
+	let mut regs: Registers = [[0; BLOCK]; MAX_REGISTERS];
+	let mut base = 0;
+
+	while base < lanes {
+		let n = std::cmp::min(BLOCK, lanes - base);
+
+		for ins in program {
+			match ins.op {
+				OP_LOAD => {
+					let row = inputs.add(ins.a as usize * lanes + base);
+					let dst = &mut regs[ins.dst as usize];
+					for l in 0..BLOCK {
+						dst[l] = if l < n { *row.add(l) } else { 0 };
+					}
+				}
+				OP_STORE => {
+					let row = outputs.add(ins.dst as usize * lanes + base);
+					let src = &regs[ins.a as usize];
+					for l in 0..n {
+						*row.add(l) = src[l];
+					}
+				}
+				OP_CONST => regs[ins.dst as usize] = [ins.imm; BLOCK],
+				OP_ADD => binary(&mut regs, ins, A::add),
+				OP_SUB => binary(&mut regs, ins, A::sub),
+				OP_MUL => binary(&mut regs, ins, A::mul),
+				OP_DIV => binary(&mut regs, ins, A::div),
+				OP_SQRT => unary(&mut regs, ins, |x| A::canonical(dmath::sqrt(A::flush(x)))),
+				OP_SIN => unary(&mut regs, ins, dmath::sin::<A>),
+				OP_COS => unary(&mut regs, ins, dmath::cos::<A>),
+				OP_ATAN2 => binary(&mut regs, ins, dmath::atan2::<A>),
+				OP_EXP => unary(&mut regs, ins, dmath::exp::<A>),
+				OP_LOG => unary(&mut regs, ins, dmath::log::<A>),
+				_ => unreachable!(),
+			}
+		}
+
+		base += BLOCK;
+	}
+}
+
+// Runs the program once for each of lanes independent sets of inputs. Returns
+// VM_OK, or one of the negative VM_ error codes if the program is malformed, in
+// which case outputs is left untouched.
+#[no_mangle]
+pub unsafe extern "C" fn dfloat_program_run(code: *const u32, code_len: usize, inputs: *const u32, input_count: usize, outputs: *mut u32, output_count: usize, lanes: usize) -> i32 {
+	let code = if code_len == 0 { &[][..] } else { std::slice::from_raw_parts(code, code_len) };
+
+	let result = match decode(code, input_count, output_count) {
+		Ok(program) => {
+			with_backend!(A => run::<A>(&program, inputs, outputs, lanes));
+			VM_OK
+		}
+		Err(error) => error,
+	};
+
+	let written = if result == VM_OK { output_count * lanes } else { 0 };
+	trace::call_seeded(trace::CALL_PROGRAM_RUN, code_len + input_count * lanes, outputs, written, result as u64);
+	return result;
+}
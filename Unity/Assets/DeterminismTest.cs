@@ -12,36 +12,200 @@ public class DeterminismTest : MonoBehaviour
     [SerializeField]
     int count = 100;
 
+    /// <summary>
+    /// Seed of the <see cref="count"/> random inputs, which every device generates the same
+    /// with <see cref="DfloatRandom"/>. Ground truth must be generated with the same seed; the
+    /// binary ground truth records it, and is rejected if it differs.
+    /// </summary>
+    [SerializeField]
+    long inputSeed = 1;
+
+    /// <summary>
+    /// Whether the inputs are uniformly random bits, or a corpus stratified over the classes
+    /// of floats where results tend to differ, weighted by <see cref="inputClassWeights"/>
+    /// (see <see cref="DfloatRandom.FillCorpus"/>). The corpus hits rounding ties, underflow,
+    /// overflow and NaNs many times more often, so fewer inputs test as much.
+    /// </summary>
+    [SerializeField]
+    InputDistribution inputDistribution = InputDistribution.Stratified;
+
+    /// <summary>
+    /// Weights of the classes of a stratified input corpus, indexed by
+    /// <see cref="DfloatRandom.FloatClass"/>.
+    /// </summary>
+    [SerializeField]
+    int[] inputClassWeights = (int[])DfloatRandom.DefaultCorpusWeights.Clone();
+
+    public enum InputDistribution { Uniform, Stratified }
+
     [SerializeField]
     bool treatAllNaNAlike;
 
+    [SerializeField]
+    Mathd.Backend nativeBackend = Mathd.Backend.Hardware;
+
+    /// <summary>
+    /// With <see cref="Mathd.NaNMode.Canonical"/> every native NaN result is the same NaN, so
+    /// native results are compared bit for bit and <see cref="treatAllNaNAlike"/> only applies
+    /// to the C# results. Ground truth must be generated with the same setting.
+    /// </summary>
+    [SerializeField]
+    Mathd.NaNMode nativeNaNMode = Mathd.NaNMode.Canonical;
+
     [SerializeField]
     Text output;
 
     [SerializeField]
     long logOutputLimit = 100;
 
-    private enum Operator { Add = 0, Sub = 1, Mul = 2, Div = 3 }
+    /// <summary>
+    /// Results per block of the ground truth hash tree. Smaller blocks narrow a mismatch down
+    /// to fewer operations, at the cost of a larger tree file.
+    /// </summary>
+    [SerializeField]
+    int hashTreeBlockSize = 64;
+
+    /// <summary>
+    /// The format ground truth is generated in. The binary formats are one file read in place
+    /// (see <see cref="GroundTruthFile"/>), which is preferred over the text files when both
+    /// are found; compressed files are smaller but are decoded into memory when loaded.
+    /// </summary>
+    [SerializeField]
+    GroundTruthFormat groundTruthFormat = GroundTruthFormat.Binary;
+
+    public enum GroundTruthFormat { Text, Binary, CompressedBinary }
+
+    /// <summary>
+    /// Records every native operation of the tests (see <see cref="Mathd.StartTrace"/>) and
+    /// dumps them to <see cref="traceFilename"/> in the persistent data path, to diff with
+    /// another device's trace when their results differ.
+    /// </summary>
+    [SerializeField]
+    bool traceNativeOperations;
+
+    private enum Operator { Add = 0, Sub = 1, Mul = 2, Div = 3, Atan2 = 4, Sqrt = 5, Sin = 6, Cos = 7, Exp = 8, Log = 9 }
+
+    private static readonly Operator[] binaryOperators = { Operator.Add, Operator.Sub, Operator.Mul, Operator.Div, Operator.Atan2 };
+
+    /// <summary>
+    /// Operators that only use their first operand. These are tested once per input rather
+    /// than once per pair of inputs.
+    /// </summary>
+    private static readonly Operator[] unaryOperators = { Operator.Sqrt, Operator.Sin, Operator.Cos, Operator.Exp, Operator.Log };
+
+    /// <summary>
+    /// Conversions between floats and integers, each tested in every rounding mode. The C#
+    /// results use plain casts, which have no rounding modes and leave out of range results
+    /// unspecified, so they show what casts do on each platform.
+    /// </summary>
+    private enum Conversion { ToInt = 0, ToUInt = 1, ToLong = 2, FromInt = 3, FromUInt = 4, FromLong = 5 }
+
+    private static readonly Conversion[] conversions = { Conversion.ToInt, Conversion.ToUInt, Conversion.ToLong, Conversion.FromInt, Conversion.FromUInt, Conversion.FromLong };
+
+    private static readonly Mathd.RoundingMode[] roundingModes = { Mathd.RoundingMode.Truncate, Mathd.RoundingMode.HalfEven, Mathd.RoundingMode.Floor };
+
+    /// <summary>
+    /// The operators ddouble supports, tested against C# doubles.
+    /// </summary>
+    private static readonly Operator[] doubleOperators = { Operator.Add, Operator.Sub, Operator.Mul, Operator.Div };
 
-    private const string floatInputsFilename = "floatInputs.txt";
 
     private const string floatResultsFilename = "floatResults.txt";
     private const string dfloatResultsFilename = "dfloatResults.txt";
+    private const string doubleResultsFilename = "doubleResults.txt";
+    private const string ddoubleResultsFilename = "ddoubleResults.txt";
 
-    private const string errorTextColor = "#FF7575";
+    private const string groundTruthFilename = "groundTruth.bin";
+
+    /// <summary>
+    /// Bytes of each input and ground truth file read ahead of the test; two chunks per file
+    /// are held at a time.
+    /// </summary>
+    private const int streamChunkSize = 1 << 16;
 
     /// <summary>
-    /// Randomly generated floats stored as uints separated by newlines. Contains 
-    /// all possible kinds of floats, including NaNs.
+    /// Hash trees of the four result files (see <see cref="ResultHashTree"/>), which can be
+    /// shipped instead of them. The file starts with "DFHT", a version, the block size and
+    /// <see cref="HashTreeFlags"/>, as little-endian ints, followed by the trees in the order of
+    /// <see cref="resultNames"/>.
     /// </summary>
-    private StreamReader floatBitsInputReader;
+    private const string hashTreeFilename = "groundTruth.tree";
 
-    private StreamWriter floatResultsWriter, dfloatResultsWriter;
-    private StreamReader floatResultsReader, dfloatResultsReader;
+    private const string traceFilename = "dfloatTrace.bin";
+    private const int hashTreeVersion = 1;
+
+    [Flags]
+    private enum HashTreeFlags { None = 0, FloatNaNsAlike = 1, DfloatNaNsAlike = 2 }
+
+    private static readonly string[] resultNames = { "float", "dfloat", "double", "ddouble" };
+
+    private const string errorTextColor = "#FF7575";
+
+    private IResultWriter floatResultsWriter, dfloatResultsWriter, doubleResultsWriter, ddoubleResultsWriter;
+    private IResultReader floatResultsReader, dfloatResultsReader, doubleResultsReader, ddoubleResultsReader;
+
+    /// <summary>
+    /// The binary ground truth, if it was found, which the result readers read from.
+    /// </summary>
+    private GroundTruthFile groundTruthFile;
 
     private StringBuilder log;
 
-    private long tests, floatErrors, dfloatErrors;
+    private long tests, floatErrors, dfloatErrors, doubleTests, doubleErrors, ddoubleErrors, batchErrors, oracleTests, oracleErrors;
+
+    /// <summary>
+    /// Whether <see cref="LoadReaders"/> found the ground truth files. Without them the test
+    /// only checks the native operations against the reference oracle.
+    /// </summary>
+    private bool groundTruthLoaded;
+
+    /// <summary>
+    /// Hash trees of this run's results, in the order of <see cref="resultNames"/>, and those
+    /// read from <see cref="hashTreeFilename"/>, if it was found.
+    /// </summary>
+    private ResultHashTree[] resultTrees, truthTrees;
+
+    /// <summary>
+    /// Whether NaN results are hashed as the same NaN, making the trees' comparison like
+    /// <see cref="treatAllNaNAlike"/>. Taken from the tree file when comparing with it.
+    /// </summary>
+    private HashTreeFlags hashTreeFlags;
+
+    private enum ResultKind { Operator, Conversion, Double }
+
+    /// <summary>
+    /// An operation in the current block of a hash tree, kept to log if the block turns out
+    /// to differ from the ground truth.
+    /// </summary>
+    private struct HashedResult
+    {
+        public ResultKind Kind;
+        public Operator Op;
+        public Conversion Conversion;
+        public Mathd.RoundingMode Mode;
+        public ulong A, B, Result, NativeResult;
+    }
+
+    /// <summary>
+    /// The current blocks of the float and dfloat trees, and of the double and ddouble trees,
+    /// which always hold the same operations.
+    /// </summary>
+    private HashedResult[] floatBlock, doubleBlock;
+
+    private long hashTreeErrors, hashTreeLoggedBlocks;
+
+    /// <summary>
+    /// Native hashes of the four result streams (see <see cref="HashingResultWriter"/>), hashed
+    /// as they are for the hash trees, which combined are a fingerprint of the whole run that
+    /// devices can compare at a glance.
+    /// </summary>
+    private HashingResultWriter[] fingerprints;
+
+    /// <summary>
+    /// Whether this run is compared with <see cref="truthTrees"/>, there being no ground truth
+    /// result files.
+    /// </summary>
+    private bool comparingTrees;
 
     private void Log(string message)
     {
@@ -78,23 +242,10 @@ public class DeterminismTest : MonoBehaviour
     {
         log = new StringBuilder();
 
-        string floatInputsPath = Path.Combine(Application.streamingAssetsPath, floatInputsFilename);
-        var floatInputs = new StreamWriter(floatInputsPath);
-
-        var rand = new System.Random();
-
-        for (int i = 0; i < count; i++)
-        {
-            uint value = (uint)rand.Next(-int.MaxValue, int.MaxValue);
-
-            floatInputs.WriteLine(value);
-        }
-
-        floatInputs.Dispose();
+        groundTruthFile?.Dispose();
+        groundTruthFile = null;
 
-        Log($"Generated {count} random floats to file { floatInputsPath } ");
-
-        floatBitsInputReader = new StreamReader(floatInputsPath);
+        Log($"Generating ground truth for {count} {inputDistribution} random floats from seed {inputSeed}.");
 
         Execute(true);
     }
@@ -122,22 +273,223 @@ public class DeterminismTest : MonoBehaviour
         Log($"Loading inputs/truths duration: {stopwatch.Elapsed.Milliseconds}ms");
         output.text = log.ToString();
 
-        Execute(false);
+        if (groundTruthLoaded)
+        {
+            Execute(false);
+        }
+        else if (truthTrees != null)
+        {
+            Log("No ground truth results found, comparing with the ground truth hash tree.");
+            Execute(false);
+        }
+        else
+        {
+            Log("No ground truth found, checking the native operations against the reference oracle only.");
+            SelfVerify();
+        }
     }
 
+    /// <summary>
+    /// Finds the inputs and ground truth, and opens them to be read a chunk at a time as the
+    /// test runs, so memory use doesn't grow with the number of operations tested. The binary
+    /// ground truth is preferred, then the text files, then the hash tree.
+    /// </summary>
     private IEnumerator LoadReaders()
     {
-        UnityWebRequest inputsReq = UnityWebRequest.Get(Path.Combine(Application.streamingAssetsPath, floatInputsFilename));
-        UnityWebRequest floatReq = UnityWebRequest.Get(Path.Combine(Application.streamingAssetsPath, floatResultsFilename));
-        UnityWebRequest dfloatReq = UnityWebRequest.Get(Path.Combine(Application.streamingAssetsPath, dfloatResultsFilename));
+        truthTrees = null;
+        groundTruthFile?.Dispose();
+        groundTruthFile = null;
+        groundTruthLoaded = false;
+
+        string binaryPath = null, floatPath = null, dfloatPath = null, doublePath = null, ddoublePath = null, treePath = null;
+
+        yield return StartCoroutine(LocateStreamingAsset(groundTruthFilename, path => binaryPath = path));
+
+        if (binaryPath != null)
+        {
+            try
+            {
+                UseGroundTruthFile(GroundTruthFile.Open(binaryPath));
+            }
+            catch (Exception e) when (e is InvalidDataException || e is IOException)
+            {
+                LogError($"Could not read {groundTruthFilename}: {e.Message}");
+            }
+        }
+
+        if (groundTruthLoaded)
+            yield break;
+
+        yield return StartCoroutine(LocateStreamingAsset(floatResultsFilename, path => floatPath = path));
+        yield return StartCoroutine(LocateStreamingAsset(dfloatResultsFilename, path => dfloatPath = path));
+        yield return StartCoroutine(LocateStreamingAsset(doubleResultsFilename, path => doublePath = path));
+        yield return StartCoroutine(LocateStreamingAsset(ddoubleResultsFilename, path => ddoublePath = path));
+        yield return StartCoroutine(LocateStreamingAsset(hashTreeFilename, path => treePath = path));
+
+        groundTruthLoaded = floatPath != null && dfloatPath != null && doublePath != null && ddoublePath != null;
+
+        if (treePath != null)
+        {
+            try
+            {
+                ReadHashTrees(File.ReadAllBytes(treePath));
+            }
+            catch (Exception e) when (e is InvalidDataException || e is EndOfStreamException)
+            {
+                LogError($"Could not read {hashTreeFilename}: {e.Message}");
+            }
+        }
+
+        if (!groundTruthLoaded)
+            yield break;
+
+        floatResultsReader = new TextResultReader(OpenText(floatPath));
+        dfloatResultsReader = new TextResultReader(OpenText(dfloatPath));
+        doubleResultsReader = new TextResultReader(OpenText(doublePath));
+        ddoubleResultsReader = new TextResultReader(OpenText(ddoublePath));
+    }
+
+    /// <summary>
+    /// Passes <paramref name="found"/> a local path of the StreamingAssets file
+    /// <paramref name="filename"/>, or null if there is none. Where StreamingAssets is not a
+    /// folder (on Android, where it is inside the APK) the file is first downloaded to the
+    /// cache, written to disk as it arrives rather than held in memory.
+    /// </summary>
+    private IEnumerator LocateStreamingAsset(string filename, Action<string> found)
+    {
+        string path = Path.Combine(Application.streamingAssetsPath, filename);
+
+        if (!path.Contains("://"))
+        {
+            found(File.Exists(path) ? path : null);
+            yield break;
+        }
+
+        string cached = Path.Combine(Application.temporaryCachePath, filename);
+        var request = new UnityWebRequest(path, UnityWebRequest.kHttpVerbGET, new DownloadHandlerFile(cached) { removeFileOnAbort = true }, null);
+
+        yield return request.SendWebRequest();
+
+        found(request.result == UnityWebRequest.Result.Success ? cached : null);
+    }
+
+    private static StreamReader OpenText(string path)
+    {
+        return new StreamReader(new ReadAheadStream(File.OpenRead(path), streamChunkSize));
+    }
+
+    private void UseGroundTruthFile(GroundTruthFile file)
+    {
+        var ids = new[]
+        {
+            GroundTruthFile.SectionId.Layout, GroundTruthFile.SectionId.FloatResults,
+            GroundTruthFile.SectionId.DfloatResults, GroundTruthFile.SectionId.DoubleResults, GroundTruthFile.SectionId.DdoubleResults
+        };
+
+        uint[] expected = LayoutWords();
+        bool sameLayout = Array.TrueForAll(ids, file.HasSection) && file.SectionLength(GroundTruthFile.SectionId.Layout) == expected.Length;
+
+        if (sameLayout)
+        {
+            using (IResultReader layout = file.OpenReader(GroundTruthFile.SectionId.Layout))
+            {
+                try
+                {
+                    for (int i = 0; sameLayout && i < expected.Length; i++)
+                    {
+                        sameLayout = layout.ReadUInt32() == expected[i];
+                    }
+                }
+                catch (EndOfStreamException)
+                {
+                    sameLayout = false;
+                }
+            }
+        }
+
+        if (!sameLayout)
+        {
+            file.Dispose();
+            LogError($"{groundTruthFilename} is incomplete or was generated with other inputs or by a version of the test with other operations.");
+            return;
+        }
+
+        groundTruthFile = file;
+        floatResultsReader = file.OpenReader(GroundTruthFile.SectionId.FloatResults, streamChunkSize);
+        dfloatResultsReader = file.OpenReader(GroundTruthFile.SectionId.DfloatResults, streamChunkSize);
+        doubleResultsReader = file.OpenReader(GroundTruthFile.SectionId.DoubleResults, streamChunkSize);
+        ddoubleResultsReader = file.OpenReader(GroundTruthFile.SectionId.DdoubleResults, streamChunkSize);
+        groundTruthLoaded = true;
+    }
+
+    /// <summary>
+    /// The inputs and operations tested, in order, which the results of the binary ground truth
+    /// depend on: the input count, seed (low word first) and distribution, the count and the
+    /// values of the class weights if stratified, and then of each of the operator, conversion
+    /// and rounding mode lists.
+    /// </summary>
+    private uint[] LayoutWords()
+    {
+        var words = new List<uint> { (uint)count, (uint)inputSeed, (uint)((ulong)inputSeed >> 32), (uint)inputDistribution };
+
+        void Add<T>(T[] values)
+        {
+            words.Add((uint)values.Length);
+
+            foreach (T value in values)
+            {
+                words.Add(Convert.ToUInt32(value));
+            }
+        }
+
+        if (inputDistribution == InputDistribution.Stratified)
+            Add(inputClassWeights);
+
+        Add(binaryOperators);
+        Add(unaryOperators);
+        Add(conversions);
+        Add(roundingModes);
+        Add(doubleOperators);
+
+        return words.ToArray();
+    }
+
+    private void WriteGroundTruthFile(List<uint> floatInputs)
+    {
+        string path = Path.Combine(Application.streamingAssetsPath, groundTruthFilename);
+
+        var deflate = groundTruthFormat == GroundTruthFormat.CompressedBinary ? GroundTruthFile.SectionEncoding.Deflate : GroundTruthFile.SectionEncoding.Raw;
+        var native = groundTruthFormat == GroundTruthFormat.CompressedBinary ? GroundTruthFile.SectionEncoding.XorReference | deflate : deflate;
+
+        Func<Stream> Words(uint[] words) => () =>
+        {
+            var bytes = new byte[words.Length * 4];
+            Buffer.BlockCopy(words, 0, bytes, 0, bytes.Length);
+            return new MemoryStream(bytes);
+        };
 
-        yield return inputsReq.SendWebRequest();
-        yield return floatReq.SendWebRequest();
-        yield return dfloatReq.SendWebRequest();
+        Func<Stream> Results(IResultWriter writer) => () => File.OpenRead(((BinaryResultWriter)writer).Path);
 
-        floatBitsInputReader = new StreamReader(new MemoryStream(inputsReq.downloadHandler.data));
-        floatResultsReader = new StreamReader(new MemoryStream(floatReq.downloadHandler.data));
-        dfloatResultsReader = new StreamReader(new MemoryStream(dfloatReq.downloadHandler.data));
+        var sources = new[]
+        {
+            new GroundTruthFile.Source { Id = GroundTruthFile.SectionId.Layout, Open = Words(LayoutWords()) },
+            // Not read by the test, which generates the inputs from the seed, but kept for tools
+            // that read the file without the generator.
+            new GroundTruthFile.Source { Id = GroundTruthFile.SectionId.Inputs, Open = Words(floatInputs.ToArray()) },
+            new GroundTruthFile.Source { Id = GroundTruthFile.SectionId.FloatResults, Encoding = deflate, Open = Results(floatResultsWriter) },
+            new GroundTruthFile.Source { Id = GroundTruthFile.SectionId.DfloatResults, Encoding = native, Reference = GroundTruthFile.SectionId.FloatResults, Open = Results(dfloatResultsWriter) },
+            new GroundTruthFile.Source { Id = GroundTruthFile.SectionId.DoubleResults, Encoding = deflate, Open = Results(doubleResultsWriter) },
+            new GroundTruthFile.Source { Id = GroundTruthFile.SectionId.DdoubleResults, Encoding = native, Reference = GroundTruthFile.SectionId.DoubleResults, Open = Results(ddoubleResultsWriter) },
+        };
+
+        long length = GroundTruthFile.Write(path, tests, doubleTests, sources);
+
+        foreach (IResultWriter writer in new[] { floatResultsWriter, dfloatResultsWriter, doubleResultsWriter, ddoubleResultsWriter })
+        {
+            File.Delete(((BinaryResultWriter)writer).Path);
+        }
+
+        Log($"Wrote {tests} C# and native results and {doubleTests} double results ({length} bytes) to {path}");
     }
 
     private void Execute(bool write)
@@ -147,16 +499,72 @@ public class DeterminismTest : MonoBehaviour
         tests = 0;
         floatErrors = 0;
         dfloatErrors = 0;
+        doubleTests = 0;
+        doubleErrors = 0;
+        ddoubleErrors = 0;
+        batchErrors = 0;
 
         floatResultsWriter = null;
         dfloatResultsWriter = null;
+        doubleResultsWriter = null;
+        ddoubleResultsWriter = null;
 
-        if (write)
+        comparingTrees = !write && !groundTruthLoaded;
+        int blockSize = comparingTrees ? truthTrees[0].BlockSize : hashTreeBlockSize;
+
+        if (!comparingTrees)
+        {
+            hashTreeFlags = treatAllNaNAlike ? HashTreeFlags.FloatNaNsAlike : HashTreeFlags.None;
+
+            if (treatAllNaNAlike && nativeNaNMode == Mathd.NaNMode.Preserve)
+                hashTreeFlags |= HashTreeFlags.DfloatNaNsAlike;
+        }
+
+        resultTrees = new ResultHashTree[resultNames.Length];
+
+        for (int i = 0; i < resultTrees.Length; i++)
+        {
+            resultTrees[i] = new ResultHashTree(blockSize);
+        }
+
+        floatBlock = new HashedResult[blockSize];
+        doubleBlock = new HashedResult[blockSize];
+        hashTreeErrors = 0;
+        hashTreeLoggedBlocks = 0;
+        fingerprints = new HashingResultWriter[resultNames.Length];
+
+        for (int i = 0; i < fingerprints.Length; i++)
+        {
+            fingerprints[i] = new HashingResultWriter();
+        }
+
+        if (write && groundTruthFormat == GroundTruthFormat.Text)
+        {
+            floatResultsWriter = new TextResultWriter(Path.Combine(Application.streamingAssetsPath, floatResultsFilename));
+            dfloatResultsWriter = new TextResultWriter(Path.Combine(Application.streamingAssetsPath, dfloatResultsFilename));
+            doubleResultsWriter = new TextResultWriter(Path.Combine(Application.streamingAssetsPath, doubleResultsFilename));
+            ddoubleResultsWriter = new TextResultWriter(Path.Combine(Application.streamingAssetsPath, ddoubleResultsFilename));
+
+            // The binary file is preferred when loading, so would shadow these.
+            File.Delete(Path.Combine(Application.streamingAssetsPath, groundTruthFilename));
+        }
+        else if (write)
         {
-            floatResultsWriter = new StreamWriter(Path.Combine(Application.streamingAssetsPath, floatResultsFilename));
-            dfloatResultsWriter = new StreamWriter(Path.Combine(Application.streamingAssetsPath, dfloatResultsFilename));
+            // Written to temporary files, then copied into sections of the ground truth file.
+            floatResultsWriter = new BinaryResultWriter(Path.GetTempFileName());
+            dfloatResultsWriter = new BinaryResultWriter(Path.GetTempFileName());
+            doubleResultsWriter = new BinaryResultWriter(Path.GetTempFileName());
+            ddoubleResultsWriter = new BinaryResultWriter(Path.GetTempFileName());
         }
 
+        Mathd.SetBackend(nativeBackend);
+        Mathd.SetDenormalMode(Mathd.DenormalMode.Preserve);
+        Mathd.SetNaNMode(nativeNaNMode);
+        Log($"Using {nativeBackend} native backend, with {Mathd.GetKernelVariant()} batched kernels, {nativeNaNMode} NaNs and FPU flush flags {Mathd.GetFpuFlags()}.");
+
+        if (traceNativeOperations)
+            Mathd.StartTrace();
+
         stopwatch.Start();
 
         // 1.17549421069e-38
@@ -194,14 +602,32 @@ public class DeterminismTest : MonoBehaviour
         OpTestAll(0, posInfinity, write, "zero posInfinity");
         OpTestAll(0, negInfinity, write, "zero negInfinity");
 
-        List<uint> floatInputs = new List<uint>();
-
-        while (!floatBitsInputReader.EndOfStream)
+        UnaryOpTestAll(0, write, "zero");
+        UnaryOpTestAll(0x80000000, write, "negzero");
+        UnaryOpTestAll(pointfive, write, "norm");
+        UnaryOpTestAll(largestDenormal, write, "denorm");
+        UnaryOpTestAll(middleDenormal, write, "denorm");
+        UnaryOpTestAll(posInfinity, write, "posinf");
+        UnaryOpTestAll(negInfinity, write, "neginf");
+
+        // Floats at the rounding and range boundaries of each integer type, then integers
+        // at the boundaries of float precision. The low 32 bits are used as a float or
+        // 32-bit integer, and all 64 as a long.
+        ulong[] conversionSpecials =
         {
-            floatInputs.Add(Convert.ToUInt32(floatBitsInputReader.ReadLine()));
+            0, 0x80000000, pointfive, 0xbf000000, 0x3fc00000, 0x40200000, 0xc0200000, largestDenormal, 0x807fffff,
+            0x4effffff, 0x4f000000, 0xcf000000, 0xcf000001, 0x4f7fffff, 0x4f800000, 0x5effffff, 0x5f000000, 0xdf000000,
+            posInfinity, negInfinity, 0x7fc00000,
+            1, 0xffffffff, 0x01000001, 0xfeffffff, 0x7fffffff, 0x0000000001000003, 0x0020000000000001,
+            0x7fffffffffffffff, 0x8000000000000000, 0xffffff7fffffffff
+        };
+
+        foreach (ulong x in conversionSpecials)
+        {
+            ConversionTestAll(x, write, "Special");
         }
 
-        floatBitsInputReader.Close();
+        List<uint> floatInputs = GenerateInputs();
 
         for (int i = 0; i < floatInputs.Count; i++)
         {
@@ -211,24 +637,74 @@ public class DeterminismTest : MonoBehaviour
             }
         }
 
+        for (int i = 0; i < floatInputs.Count; i++)
+        {
+            UnaryOpTestAll(floatInputs[i], write, "Any");
+            ConversionTestAll(((ulong)floatInputs[(i + 1) % floatInputs.Count] << 32) | floatInputs[i], write, "Any");
+        }
+
+        DoubleTestAll(floatInputs, write);
+
+        BatchTestAll(floatInputs);
+        VectorTestAll(floatInputs);
+        MatrixTestAll(floatInputs);
+        ReductionTestAll(floatInputs);
+        DenormalTestAll(floatInputs);
+        NaNTestAll(floatInputs);
+        OracleTestAll(floatInputs);
+        DumpTrace();
+        DispatchSelfTest();
+        LogFingerprint();
+
         if (write)
         {
-            floatResultsWriter.Close();
-            dfloatResultsWriter.Close();
+            floatResultsWriter.Dispose();
+            dfloatResultsWriter.Dispose();
+            doubleResultsWriter.Dispose();
+            ddoubleResultsWriter.Dispose();
 
-            Log($"Wrote {tests} C# results to {Path.Combine(Application.streamingAssetsPath, floatResultsFilename)}");
-            Log($"Wrote {tests} native Rust results to {Path.Combine(Application.streamingAssetsPath, dfloatResultsFilename)}");
+            if (groundTruthFormat == GroundTruthFormat.Text)
+            {
+                Log($"Wrote {tests} C# results to {Path.Combine(Application.streamingAssetsPath, floatResultsFilename)}");
+                Log($"Wrote {tests} native Rust results to {Path.Combine(Application.streamingAssetsPath, dfloatResultsFilename)}");
+                Log($"Wrote {doubleTests} C# double results to {Path.Combine(Application.streamingAssetsPath, doubleResultsFilename)}");
+                Log($"Wrote {doubleTests} native Rust double results to {Path.Combine(Application.streamingAssetsPath, ddoubleResultsFilename)}");
+            }
+            else
+            {
+                WriteGroundTruthFile(floatInputs);
+            }
         }
-        else
+        else if (groundTruthLoaded)
         {
             floatResultsReader.Dispose();
             dfloatResultsReader.Dispose();
+            doubleResultsReader.Dispose();
+            ddoubleResultsReader.Dispose();
+
+            if (groundTruthFile != null && (groundTruthFile.Tests != tests || groundTruthFile.DoubleTests != doubleTests))
+                LogError($"The ground truth has {groundTruthFile.Tests} results and {groundTruthFile.DoubleTests} double results, but {tests} and {doubleTests} were tested.");
+
+            // Encoded sections are only checked once they have been read.
+            foreach (IResultReader reader in new[] { floatResultsReader, dfloatResultsReader, doubleResultsReader, ddoubleResultsReader })
+            {
+                if (reader is GroundTruthFile.SectionReader section && !section.ChecksumMatches)
+                    LogError($"The {section.Id} section of {groundTruthFilename} is corrupt or was not read to its end.");
+            }
+
+            groundTruthFile?.Dispose();
+            groundTruthFile = null;
         }
 
-        if (floatErrors + dfloatErrors > logOutputLimit)
+        if (write)
+            WriteHashTrees();
+        else if (comparingTrees)
+            CompareHashTrees();
+
+        if (floatErrors + dfloatErrors + doubleErrors + ddoubleErrors + hashTreeLoggedBlocks > logOutputLimit)
             LogError("(Reached maximum amount of displayable errors.)");        
 
-        if (!write)
+        if (!write && groundTruthLoaded)
         {
             Log($"Tested {tests} operations.");
 
@@ -245,8 +721,26 @@ public class DeterminismTest : MonoBehaviour
                 LogError(dfloatMessage);
             else
                 Log(dfloatMessage);
+
+            Log($"Tested {doubleTests} double operations.");
+
+            string doubleMessage = $"{doubleErrors} errors with C# double operations.";
+
+            if (doubleErrors > 0)
+                LogError(doubleMessage);
+            else
+                Log(doubleMessage);
+
+            string ddoubleMessage = $"{ddoubleErrors} errors with native (Rust) double operations.";
+
+            if (ddoubleErrors > 0)
+                LogError(ddoubleMessage);
+            else
+                Log(ddoubleMessage);
         }
 
+        LogSelfCheckResults();
+
         stopwatch.Stop();
 
         Log($"Arithmetic duration: {stopwatch.Elapsed.Milliseconds}ms");
@@ -255,53 +749,1613 @@ public class DeterminismTest : MonoBehaviour
             output.text = log.ToString();
     }
 
-    private void OpTestAll(uint a, uint b, bool write, string messagePrefix = "")
+    /// <summary>
+    /// Checks the native basic operations against the reference oracle, and the batched
+    /// kernels against the scalar operations, which needs no ground truth files.
+    /// </summary>
+    private void SelfVerify()
     {
-        for (int i = 0; i < 4; i++)
-        {
-            Operator op = (Operator)i;
+        var stopwatch = new System.Diagnostics.Stopwatch();
 
-            OpTest(a, b, op, write, messagePrefix);
-        }
-    }
+        batchErrors = 0;
 
-    private void OpTest(uint a, uint b, Operator op, bool write, string messagePrefix = "")
-    {
-        Operate(a, b, op, out float floatResult, out dfloat dfloatResult);
+        Mathd.SetBackend(nativeBackend);
+        Mathd.SetDenormalMode(Mathd.DenormalMode.Preserve);
+        Mathd.SetNaNMode(nativeNaNMode);
+        Log($"Using {Mathd.GetKernelVariant()} batched kernels, {nativeNaNMode} NaNs and FPU flush flags {Mathd.GetFpuFlags()}.");
 
-        if (write)
-        {
-            floatResultsWriter.WriteLine(FloatToBits(floatResult));
-            dfloatResultsWriter.WriteLine(dfloatResult.Bits);
-        }
-        else
-        {
-            uint floatTruth = Convert.ToUInt32(floatResultsReader.ReadLine());
-            uint dfloatTruth = Convert.ToUInt32(dfloatResultsReader.ReadLine());
+        stopwatch.Start();
 
-            bool floatPass = FloatToBits(floatResult) == floatTruth || (treatAllNaNAlike && float.IsNaN(floatResult) && float.IsNaN(BitsToFloat(floatTruth)));
-            bool dfloatPass = dfloatResult.Bits == dfloatTruth || (treatAllNaNAlike && float.IsNaN(dfloat.AsNonDetermFloat(dfloatResult)) && float.IsNaN(BitsToFloat(dfloatTruth)));
+        List<uint> floatInputs = GenerateInputs();
 
-            if (!floatPass)
-            {
-                floatErrors++;
+        OracleTestAll(floatInputs);
+        DispatchSelfTest();
+        LogSelfCheckResults();
 
-                if (floatErrors + dfloatErrors < logOutputLimit)
-                    LogError($"{messagePrefix} {op} for float: {GetResultString(a, b, FloatToBits(floatResult), floatTruth)}");
-            }
+        stopwatch.Stop();
 
-            if (!dfloatPass)
-            {
-                dfloatErrors++;
+        Log($"Arithmetic duration: {stopwatch.Elapsed.Milliseconds}ms");
 
-                if (floatErrors + dfloatErrors < logOutputLimit)
-                    LogError($"{messagePrefix} {op} for dfloat: {GetResultString(a, b, dfloatResult.Bits, dfloatTruth)}");
-            }
-        }
+        if (Application.isPlaying)
+            output.text = log.ToString();
+    }
+
+    /// <summary>
+    /// The <see cref="count"/> random floats the tests are run on, drawn as set by
+    /// <see cref="inputDistribution"/>. Every device generates the same ones from
+    /// <see cref="inputSeed"/>, so they need not be shipped.
+    /// </summary>
+    private List<uint> GenerateInputs()
+    {
+        var inputs = new uint[count];
+        var random = new DfloatRandom((ulong)inputSeed);
+
+        if (inputDistribution == InputDistribution.Stratified)
+            random.FillCorpus(inputs, inputClassWeights);
+        else
+            random.Fill(inputs);
+
+        return new List<uint>(inputs);
+    }
+
+    private void LogSelfCheckResults()
+    {
+        string oracleMessage = $"{oracleErrors} of {oracleTests} native operations differed from the reference oracle.";
+
+        if (oracleErrors > 0)
+            LogError(oracleMessage);
+        else
+            Log(oracleMessage);
+
+        string batchMessage = $"{batchErrors} batched native operations differed from their scalar equivalent.";
+
+        if (batchErrors > 0)
+            LogError(batchMessage);
+        else
+            Log(batchMessage);
+    }
+
+    private void OpTestAll(uint a, uint b, bool write, string messagePrefix = "")
+    {
+        foreach (Operator op in binaryOperators)
+        {
+            OpTest(a, b, op, write, messagePrefix);
+        }
+    }
+
+    private void UnaryOpTestAll(uint a, bool write, string messagePrefix = "")
+    {
+        foreach (Operator op in unaryOperators)
+        {
+            OpTest(a, 0, op, write, messagePrefix);
+        }
+    }
+
+    private void OpTest(uint a, uint b, Operator op, bool write, string messagePrefix = "")
+    {
+        Operate(a, b, op, out float floatResult, out dfloat dfloatResult);
+
+        if (write)
+        {
+            floatResultsWriter.Write(FloatToBits(floatResult));
+            dfloatResultsWriter.Write(dfloatResult.Bits);
+        }
+        else if (groundTruthLoaded)
+        {
+            uint floatTruth = floatResultsReader.ReadUInt32();
+            uint dfloatTruth = dfloatResultsReader.ReadUInt32();
+
+            bool floatPass = FloatToBits(floatResult) == floatTruth || (treatAllNaNAlike && float.IsNaN(floatResult) && float.IsNaN(BitsToFloat(floatTruth)));
+            bool dfloatPass = dfloatResult.Bits == dfloatTruth || (treatAllNaNAlike && nativeNaNMode == Mathd.NaNMode.Preserve && float.IsNaN(dfloat.AsNonDetermFloat(dfloatResult)) && float.IsNaN(BitsToFloat(dfloatTruth)));
+
+            if (!floatPass)
+            {
+                floatErrors++;
+
+                if (floatErrors + dfloatErrors < logOutputLimit)
+                    LogError($"{messagePrefix} {op} for float: {GetResultString(a, b, FloatToBits(floatResult), floatTruth)}");
+            }
+
+            if (!dfloatPass)
+            {
+                dfloatErrors++;
+
+                if (floatErrors + dfloatErrors < logOutputLimit)
+                    LogError($"{messagePrefix} {op} for dfloat: {GetResultString(a, b, dfloatResult.Bits, dfloatTruth)}");
+            }
+        }
+
+        HashFloatResults(new HashedResult { Kind = ResultKind.Operator, Op = op, A = a, B = b, Result = FloatToBits(floatResult), NativeResult = dfloatResult.Bits });
+
+        tests++;
+    }
+
+    private void ConversionTestAll(ulong x, bool write, string messagePrefix = "")
+    {
+        foreach (Conversion conversion in conversions)
+        {
+            foreach (Mathd.RoundingMode mode in roundingModes)
+            {
+                ConversionTest(x, conversion, mode, write, messagePrefix);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Conversion results are written to the float and dfloat result files like the other
+    /// operations, as integers or float bits. They are compared exactly, as neither kind
+    /// can be a NaN with a varying payload.
+    /// </summary>
+    private void ConversionTest(ulong x, Conversion conversion, Mathd.RoundingMode mode, bool write, string messagePrefix = "")
+    {
+        ConversionOperate(x, conversion, mode, out ulong floatResult, out ulong dfloatResult);
+
+        if (write)
+        {
+            floatResultsWriter.Write(floatResult);
+            dfloatResultsWriter.Write(dfloatResult);
+        }
+        else if (groundTruthLoaded)
+        {
+            ulong floatTruth = floatResultsReader.ReadUInt64();
+            ulong dfloatTruth = dfloatResultsReader.ReadUInt64();
+
+            if (floatResult != floatTruth)
+            {
+                floatErrors++;
+
+                if (floatErrors + dfloatErrors < logOutputLimit)
+                    LogError($"{messagePrefix} {conversion} {mode} for float: {GetConversionResultString(x, conversion, floatResult, floatTruth)}");
+            }
+
+            if (dfloatResult != dfloatTruth)
+            {
+                dfloatErrors++;
+
+                if (floatErrors + dfloatErrors < logOutputLimit)
+                    LogError($"{messagePrefix} {conversion} {mode} for dfloat: {GetConversionResultString(x, conversion, dfloatResult, dfloatTruth)}");
+            }
+        }
+
+        HashFloatResults(new HashedResult { Kind = ResultKind.Conversion, Conversion = conversion, Mode = mode, A = x, Result = floatResult, NativeResult = dfloatResult });
 
         tests++;
     }
 
+    /// <summary>
+    /// Results are integers (as their two's complement bits) for conversions to integers,
+    /// and float bits for conversions from them. 32-bit inputs are the low bits of x.
+    /// </summary>
+    private void ConversionOperate(ulong x, Conversion conversion, Mathd.RoundingMode mode, out ulong floatResult, out ulong dfloatResult)
+    {
+        float f = BitsToFloat((uint)x);
+        double rounded = mode == Mathd.RoundingMode.Truncate ? f : mode == Mathd.RoundingMode.Floor ? Math.Floor(f) : Math.Round(f);
+
+        unchecked
+        {
+            switch (conversion)
+            {
+                case Conversion.ToInt:
+                    floatResult = (uint)(int)rounded;
+                    dfloatResult = (uint)Mathd.ToInt(new dfloat((uint)x), mode);
+                    break;
+                case Conversion.ToUInt:
+                    floatResult = (uint)rounded;
+                    dfloatResult = Mathd.ToUInt(new dfloat((uint)x), mode);
+                    break;
+                case Conversion.ToLong:
+                    floatResult = (ulong)(long)rounded;
+                    dfloatResult = (ulong)Mathd.ToLong(new dfloat((uint)x), mode);
+                    break;
+                case Conversion.FromInt:
+                    floatResult = FloatToBits((int)x);
+                    dfloatResult = Mathd.FromInt((int)x, mode).Bits;
+                    break;
+                case Conversion.FromUInt:
+                    floatResult = FloatToBits((uint)x);
+                    dfloatResult = Mathd.FromUInt((uint)x, mode).Bits;
+                    break;
+                case Conversion.FromLong:
+                    floatResult = FloatToBits((long)x);
+                    dfloatResult = Mathd.FromLong((long)x, mode).Bits;
+                    break;
+                default:
+                    throw new Exception("Unknown conversion.");
+            }
+        }
+    }
+
+    private string GetConversionResultString(ulong x, Conversion conversion, ulong result, ulong truth)
+    {
+        switch (conversion)
+        {
+            case Conversion.ToInt:
+            case Conversion.ToUInt:
+            case Conversion.ToLong:
+                return $"result {(long)result} != truth {(long)truth}\nInput: {FloatBitsToVerboseString((uint)x)}";
+            case Conversion.FromLong:
+                return $"result {FloatBitsToVerboseString((uint)result)} != truth {FloatBitsToVerboseString((uint)truth)}\nInput: {(long)x}";
+            default:
+                return $"result {FloatBitsToVerboseString((uint)result)} != truth {FloatBitsToVerboseString((uint)truth)}\nInput: {(uint)x} ({(int)x})";
+        }
+    }
+
+    /// <summary>
+    /// Tests the double operations on the special values, then on every pair of doubles made
+    /// from consecutive float inputs, and checks the batched ddouble operations against the
+    /// scalar ones.
+    /// </summary>
+    private void DoubleTestAll(List<uint> floatInputs, bool write)
+    {
+        ulong largestDenormal = 0x000fffffffffffff;
+        ulong middleDenormal = 0x00000000ffffffff;
+        ulong pointfive = 0x3fe0000000000000;
+        ulong posInfinity = DoubleToBits(double.PositiveInfinity);
+        ulong negInfinity = DoubleToBits(double.NegativeInfinity);
+
+        ulong[] specials = { 0, 0x8000000000000000, largestDenormal, middleDenormal, pointfive, posInfinity, negInfinity };
+
+        foreach (ulong x in specials)
+        {
+            foreach (ulong y in specials)
+            {
+                DoubleOpTestAll(x, y, write, "Special");
+            }
+        }
+
+        int length = floatInputs.Count;
+        var inputs = new ddouble[length];
+
+        for (int i = 0; i < length; i++)
+        {
+            inputs[i] = new ddouble(((ulong)floatInputs[i] << 32) | floatInputs[(i + 1) % length]);
+        }
+
+        for (int i = 0; i < length; i++)
+        {
+            for (int j = i; j < length; j++)
+            {
+                DoubleOpTestAll(inputs[i].Bits, inputs[j].Bits, write, "Any");
+            }
+        }
+
+        var b = new ddouble[length];
+        var result = new ddouble[length];
+
+        for (int i = 0; i < length; i++)
+        {
+            b[i] = inputs[(i + 1) % length];
+        }
+
+        foreach (Operator op in doubleOperators)
+        {
+            switch (op)
+            {
+                case Operator.Add:
+                    Mathd.Add(inputs, b, result);
+                    break;
+                case Operator.Sub:
+                    Mathd.Sub(inputs, b, result);
+                    break;
+                case Operator.Mul:
+                    Mathd.Mul(inputs, b, result);
+                    break;
+                case Operator.Div:
+                    Mathd.Div(inputs, b, result);
+                    break;
+            }
+
+            for (int j = 0; j < length; j++)
+            {
+                DoubleOperate(inputs[j].Bits, b[j].Bits, op, out _, out ddouble scalar);
+
+                if (result[j].Bits != scalar.Bits)
+                {
+                    batchErrors++;
+
+                    if (batchErrors < logOutputLimit)
+                        LogError($"Batched double {op} at {j}: {GetDoubleResultString(inputs[j].Bits, b[j].Bits, result[j].Bits, scalar.Bits)}");
+                }
+            }
+        }
+    }
+
+    private void DoubleOpTestAll(ulong a, ulong b, bool write, string messagePrefix = "")
+    {
+        foreach (Operator op in doubleOperators)
+        {
+            DoubleOpTest(a, b, op, write, messagePrefix);
+        }
+    }
+
+    private void DoubleOpTest(ulong a, ulong b, Operator op, bool write, string messagePrefix = "")
+    {
+        DoubleOperate(a, b, op, out double doubleResult, out ddouble ddoubleResult);
+
+        if (write)
+        {
+            doubleResultsWriter.Write(DoubleToBits(doubleResult));
+            ddoubleResultsWriter.Write(ddoubleResult.Bits);
+        }
+        else if (groundTruthLoaded)
+        {
+            ulong doubleTruth = doubleResultsReader.ReadUInt64();
+            ulong ddoubleTruth = ddoubleResultsReader.ReadUInt64();
+
+            bool doublePass = DoubleToBits(doubleResult) == doubleTruth || (treatAllNaNAlike && double.IsNaN(doubleResult) && double.IsNaN(BitsToDouble(doubleTruth)));
+            bool ddoublePass = ddoubleResult.Bits == ddoubleTruth || (treatAllNaNAlike && nativeNaNMode == Mathd.NaNMode.Preserve && double.IsNaN(ddouble.AsNonDetermDouble(ddoubleResult)) && double.IsNaN(BitsToDouble(ddoubleTruth)));
+
+            if (!doublePass)
+            {
+                doubleErrors++;
+
+                if (floatErrors + dfloatErrors + doubleErrors + ddoubleErrors < logOutputLimit)
+                    LogError($"{messagePrefix} {op} for double: {GetDoubleResultString(a, b, DoubleToBits(doubleResult), doubleTruth)}");
+            }
+
+            if (!ddoublePass)
+            {
+                ddoubleErrors++;
+
+                if (floatErrors + dfloatErrors + doubleErrors + ddoubleErrors < logOutputLimit)
+                    LogError($"{messagePrefix} {op} for ddouble: {GetDoubleResultString(a, b, ddoubleResult.Bits, ddoubleTruth)}");
+            }
+        }
+
+        HashDoubleResults(new HashedResult { Kind = ResultKind.Double, Op = op, A = a, B = b, Result = DoubleToBits(doubleResult), NativeResult = ddoubleResult.Bits });
+
+        doubleTests++;
+    }
+
+    /// <summary>
+    /// Adds the results of a float operation or conversion to the float and dfloat hash trees,
+    /// checking each block against the ground truth tree as it is completed.
+    /// </summary>
+    private void HashFloatResults(HashedResult result)
+    {
+        AddToFingerprints(0, result);
+        floatBlock[resultTrees[0].Count % floatBlock.Length] = result;
+        resultTrees[0].Add(HashedValue(result, false));
+
+        if (resultTrees[1].Add(HashedValue(result, true)))
+            CheckHashedBlock(0, floatBlock);
+    }
+
+    private void HashDoubleResults(HashedResult result)
+    {
+        AddToFingerprints(2, result);
+        doubleBlock[resultTrees[2].Count % doubleBlock.Length] = result;
+        resultTrees[2].Add(HashedValue(result, false));
+
+        if (resultTrees[3].Add(HashedValue(result, true)))
+            CheckHashedBlock(2, doubleBlock);
+    }
+
+    /// <summary>
+    /// Adds the C# and native results to the fingerprints <paramref name="first"/> and the one
+    /// after it, with the same words as the result files hold.
+    /// </summary>
+    private void AddToFingerprints(int first, HashedResult result)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            ulong value = HashedValue(result, i == 1);
+
+            if (result.Kind == ResultKind.Operator)
+                fingerprints[first + i].Write((uint)value);
+            else
+                fingerprints[first + i].Write(value);
+        }
+    }
+
+    /// <summary>
+    /// Logs the run's fingerprint, and compares each stream's hash with that of the binary
+    /// ground truth's section when it can be hashed in place, being uncompressed, and NaNs are
+    /// not hashed alike.
+    /// </summary>
+    private void LogFingerprint()
+    {
+        var hashes = new ulong[fingerprints.Length];
+
+        for (int i = 0; i < hashes.Length; i++)
+        {
+            hashes[i] = fingerprints[i].Hash;
+        }
+
+        Log($"Run fingerprint: {Mathd.CombineHashes(hashes, hashes.Length, tests + doubleTests):x16}.");
+
+        if (groundTruthFile == null || hashTreeFlags != HashTreeFlags.None)
+            return;
+
+        var sections = new[] { GroundTruthFile.SectionId.FloatResults, GroundTruthFile.SectionId.DfloatResults, GroundTruthFile.SectionId.DoubleResults, GroundTruthFile.SectionId.DdoubleResults };
+
+        for (int i = 0; i < sections.Length; i++)
+        {
+            if (groundTruthFile.TryGetSection(sections[i], out GroundTruthFile.Words words) && HashingResultWriter.HashOf(words) != hashes[i])
+                LogError($"The {resultNames[i]} results' fingerprint differs from the ground truth's.");
+        }
+    }
+
+    /// <summary>
+    /// The result as it is hashed, which is the same NaN for every NaN result if
+    /// <see cref="hashTreeFlags"/> says NaNs are alike.
+    /// </summary>
+    private ulong HashedValue(HashedResult result, bool native)
+    {
+        ulong value = native ? result.NativeResult : result.Result;
+
+        if ((hashTreeFlags & (native ? HashTreeFlags.DfloatNaNsAlike : HashTreeFlags.FloatNaNsAlike)) == 0)
+            return value;
+
+        if (result.Kind == ResultKind.Operator && float.IsNaN(BitsToFloat((uint)value)))
+            return 0xffc00000;
+
+        if (result.Kind == ResultKind.Double && double.IsNaN(BitsToDouble(value)))
+            return 0xfff8000000000000;
+
+        return value;
+    }
+
+    /// <summary>
+    /// Logs the operations of the block just completed in the trees <paramref name="first"/>
+    /// and the one after it, for each tree where it differs from the ground truth. The trees
+    /// are still compared as a whole at the end; this only keeps the operations to log
+    /// without storing them all.
+    /// </summary>
+    private void CheckHashedBlock(int first, HashedResult[] block)
+    {
+        if (!comparingTrees)
+            return;
+
+        long index = resultTrees[first].Count / block.Length - 1;
+
+        for (int tree = first; tree < first + 2; tree++)
+        {
+            // Trees of different lengths are reported by CompareHashTrees.
+            if (index >= truthTrees[tree].BlockCount || resultTrees[tree].LastBlock == truthTrees[tree].Block(index))
+                continue;
+
+            LogHashedBlock(tree, index, block, block.Length);
+        }
+    }
+
+    private void LogHashedBlock(int tree, long index, HashedResult[] block, int count)
+    {
+        if (hashTreeLoggedBlocks++ >= logOutputLimit)
+            return;
+
+        bool native = tree % 2 == 1;
+        long start = index * block.Length;
+        var message = new StringBuilder($"Block {index} of the {resultNames[tree]} results (operations {start} to {start + count - 1}) differs from the ground truth. It computed:");
+
+        for (int i = 0; i < count; i++)
+        {
+            message.Append($"\n{start + i} {DescribeHashedResult(block[i], native)}");
+        }
+
+        LogError(message.ToString());
+    }
+
+    private string DescribeHashedResult(HashedResult result, bool native)
+    {
+        ulong value = native ? result.NativeResult : result.Result;
+
+        switch (result.Kind)
+        {
+            case ResultKind.Operator:
+                string b = Array.IndexOf(unaryOperators, result.Op) < 0 ? $", {FloatBitsToVerboseString((uint)result.B)}" : "";
+                return $"{result.Op}({FloatBitsToVerboseString((uint)result.A)}{b}) = {FloatBitsToVerboseString((uint)value)}";
+            case ResultKind.Conversion:
+                switch (result.Conversion)
+                {
+                    case Conversion.ToInt:
+                    case Conversion.ToUInt:
+                    case Conversion.ToLong:
+                        return $"{result.Conversion} {result.Mode}({FloatBitsToVerboseString((uint)result.A)}) = {(long)value}";
+                    case Conversion.FromLong:
+                        return $"{result.Conversion} {result.Mode}({(long)result.A}) = {FloatBitsToVerboseString((uint)value)}";
+                    default:
+                        return $"{result.Conversion} {result.Mode}({(uint)result.A} ({(int)result.A})) = {FloatBitsToVerboseString((uint)value)}";
+                }
+            default:
+                return $"{result.Op}({DoubleBitsToVerboseString(result.A)}, {DoubleBitsToVerboseString(result.B)}) = {DoubleBitsToVerboseString(value)}";
+        }
+    }
+
+    private void WriteHashTrees()
+    {
+        string path = Path.Combine(Application.streamingAssetsPath, hashTreeFilename);
+
+        using (var writer = new BinaryWriter(File.Create(path)))
+        {
+            writer.Write(Encoding.ASCII.GetBytes("DFHT"));
+            writer.Write(hashTreeVersion);
+            writer.Write(resultTrees[0].BlockSize);
+            writer.Write((int)hashTreeFlags);
+
+            foreach (ResultHashTree tree in resultTrees)
+            {
+                tree.Write(writer);
+            }
+
+            Log($"Wrote hash trees of the results ({writer.BaseStream.Length} bytes) to {path}");
+        }
+    }
+
+    private void ReadHashTrees(byte[] data)
+    {
+        using (var reader = new BinaryReader(new MemoryStream(data)))
+        {
+            if (Encoding.ASCII.GetString(reader.ReadBytes(4)) != "DFHT")
+                throw new InvalidDataException("Not a hash tree file.");
+
+            int version = reader.ReadInt32();
+
+            if (version != hashTreeVersion)
+                throw new InvalidDataException($"Unsupported version {version}.");
+
+            int blockSize = reader.ReadInt32();
+
+            if (blockSize <= 0)
+                throw new InvalidDataException($"Invalid block size {blockSize}.");
+
+            hashTreeFlags = (HashTreeFlags)reader.ReadInt32();
+
+            var trees = new ResultHashTree[resultNames.Length];
+
+            for (int i = 0; i < trees.Length; i++)
+            {
+                trees[i] = ResultHashTree.Read(reader, blockSize);
+            }
+
+            truthTrees = trees;
+        }
+    }
+
+    /// <summary>
+    /// Compares the roots of this run's hash trees with the ground truth's, descending into
+    /// the differing subtrees to count the differing blocks. Completed blocks were logged as
+    /// they were hashed; a last partial block is logged here.
+    /// </summary>
+    private void CompareHashTrees()
+    {
+        Log($"Tested {tests} operations and {doubleTests} double operations against the ground truth hash tree, in blocks of {resultTrees[0].BlockSize}.");
+
+        for (int tree = 0; tree < resultTrees.Length; tree++)
+        {
+            ResultHashTree ours = resultTrees[tree], truth = truthTrees[tree];
+
+            if (ours.Count != truth.Count)
+                LogError($"The ground truth has {truth.Count} {resultNames[tree]} results but {ours.Count} were tested, so it was generated from other inputs or by another version.");
+
+            List<long> differences = ours.Differences(truth);
+            hashTreeErrors += differences.Count;
+
+            int partial = (int)(ours.Count % ours.BlockSize);
+
+            if (partial != 0 && ours.Count == truth.Count && differences.Count > 0 && differences[differences.Count - 1] == ours.BlockCount - 1)
+                LogHashedBlock(tree, ours.BlockCount - 1, tree < 2 ? floatBlock : doubleBlock, partial);
+
+            string message = $"{differences.Count} of {ours.BlockCount} blocks of {resultNames[tree]} results differ from the ground truth.";
+
+            if (differences.Count > 0)
+                LogError(message);
+            else
+                Log(message);
+        }
+    }
+
+    /// <summary>
+    /// Batched native operations and programs have no ground truth of their own; they must
+    /// match the scalar native operations bit for bit. The inputs are paired with a rotation of
+    /// themselves so an odd count also exercises the non-vectorized tail.
+    /// </summary>
+    private void BatchTestAll(List<uint> inputs)
+    {
+        int length = inputs.Count;
+
+        var a = new dfloat[length];
+        var b = new dfloat[length];
+        var result = new dfloat[length];
+
+        for (int i = 0; i < length; i++)
+        {
+            a[i] = new dfloat(inputs[i]);
+            b[i] = new dfloat(inputs[(i + 1) % length]);
+        }
+
+        foreach (Operator op in binaryOperators)
+        {
+            switch (op)
+            {
+                case Operator.Add:
+                    Mathd.Add(a, b, result);
+                    break;
+                case Operator.Sub:
+                    Mathd.Sub(a, b, result);
+                    break;
+                case Operator.Mul:
+                    Mathd.Mul(a, b, result);
+                    break;
+                case Operator.Div:
+                    Mathd.Div(a, b, result);
+                    break;
+                case Operator.Atan2:
+                    Mathd.Atan2(a, b, result);
+                    break;
+            }
+
+            for (int j = 0; j < length; j++)
+            {
+                Operate(a[j].Bits, b[j].Bits, op, out _, out dfloat scalar);
+
+                if (result[j].Bits != scalar.Bits)
+                {
+                    batchErrors++;
+
+                    if (batchErrors < logOutputLimit)
+                        LogError($"Batched {op} at {j}: {GetResultString(a[j].Bits, b[j].Bits, result[j].Bits, scalar.Bits)}");
+                }
+            }
+        }
+
+        foreach (Operator op in unaryOperators)
+        {
+            switch (op)
+            {
+                case Operator.Sqrt:
+                    Mathd.Sqrt(a, result);
+                    break;
+                case Operator.Sin:
+                    Mathd.Sin(a, result);
+                    break;
+                case Operator.Cos:
+                    Mathd.Cos(a, result);
+                    break;
+                case Operator.Exp:
+                    Mathd.Exp(a, result);
+                    break;
+                case Operator.Log:
+                    Mathd.Log(a, result);
+                    break;
+            }
+
+            for (int j = 0; j < length; j++)
+            {
+                Operate(a[j].Bits, 0, op, out _, out dfloat scalar);
+
+                if (result[j].Bits != scalar.Bits)
+                {
+                    batchErrors++;
+
+                    if (batchErrors < logOutputLimit)
+                        LogError($"Batched {op} at {j}: {GetResultString(a[j].Bits, 0, result[j].Bits, scalar.Bits)}");
+                }
+            }
+        }
+
+        // Integer inputs as in ConversionTestAll: the float inputs' bits, and longs made
+        // from pairs of them.
+        var intInputs = new int[length];
+        var uintInputs = inputs.ToArray();
+        var longInputs = new long[length];
+
+        for (int j = 0; j < length; j++)
+        {
+            intInputs[j] = (int)inputs[j];
+            longInputs[j] = (long)(((ulong)inputs[(j + 1) % length] << 32) | inputs[j]);
+        }
+
+        var ints = new int[length];
+        var uints = new uint[length];
+        var longs = new long[length];
+
+        foreach (Mathd.RoundingMode mode in roundingModes)
+        {
+            foreach (Conversion conversion in conversions)
+            {
+                switch (conversion)
+                {
+                    case Conversion.ToInt:
+                        Mathd.ToInt(a, ints, mode);
+                        break;
+                    case Conversion.ToUInt:
+                        Mathd.ToUInt(a, uints, mode);
+                        break;
+                    case Conversion.ToLong:
+                        Mathd.ToLong(a, longs, mode);
+                        break;
+                    case Conversion.FromInt:
+                        Mathd.FromInt(intInputs, result, mode);
+                        break;
+                    case Conversion.FromUInt:
+                        Mathd.FromUInt(uintInputs, result, mode);
+                        break;
+                    case Conversion.FromLong:
+                        Mathd.FromLong(longInputs, result, mode);
+                        break;
+                }
+
+                for (int j = 0; j < length; j++)
+                {
+                    ulong x = (ulong)longInputs[j];
+                    ConversionOperate(x, conversion, mode, out _, out ulong scalar);
+
+                    ulong batched;
+
+                    switch (conversion)
+                    {
+                        case Conversion.ToInt:
+                            batched = (uint)ints[j];
+                            break;
+                        case Conversion.ToUInt:
+                            batched = uints[j];
+                            break;
+                        case Conversion.ToLong:
+                            batched = (ulong)longs[j];
+                            break;
+                        default:
+                            batched = result[j].Bits;
+                            break;
+                    }
+
+                    if (batched != scalar)
+                    {
+                        batchErrors++;
+
+                        if (batchErrors < logOutputLimit)
+                            LogError($"Batched {conversion} {mode} at {j}: {GetConversionResultString(x, conversion, batched, scalar)}");
+                    }
+                }
+            }
+        }
+
+        // (a * b + a) / b, evaluated by the native interpreter in one call.
+        var program = new DfloatProgram();
+        int ra = program.Load(0);
+        int rb = program.Load(1);
+        program.Store(0, program.Div(program.Add(program.Mul(ra, rb), ra), rb));
+
+        var programInputs = new dfloat[length * 2];
+        a.CopyTo(programInputs, 0);
+        b.CopyTo(programInputs, length);
+
+        program.Run(programInputs, result, length);
+
+        for (int j = 0; j < length; j++)
+        {
+            dfloat scalar = Mathd.Div(Mathd.Add(Mathd.Mul(a[j], b[j]), a[j]), b[j]);
+
+            if (result[j].Bits != scalar.Bits)
+            {
+                batchErrors++;
+
+                if (batchErrors < logOutputLimit)
+                    LogError($"Program (a * b + a) / b at {j}: {GetResultString(a[j].Bits, b[j].Bits, result[j].Bits, scalar.Bits)}");
+            }
+        }
+
+        // Indices the instruction encoding cannot hold must be rejected rather than truncated.
+        var outOfRange = new (string name, Action<DfloatProgram> emit)[]
+        {
+            ("Load(256)", p => p.Load(256)),
+            ("Load(-1)", p => p.Load(-1)),
+            ("Store(256, r)", p => p.Store(256, p.Load(0))),
+            ("Store(0, 64)", p => p.Store(0, 64)),
+            ("Add(r, 64)", p => p.Add(p.Load(0), 64)),
+            ("Sqrt(-1)", p => p.Sqrt(-1)),
+        };
+
+        foreach (var check in outOfRange)
+        {
+            try
+            {
+                check.emit(new DfloatProgram());
+                batchErrors++;
+                LogError($"Program {check.name} was accepted.");
+            }
+            catch (ArgumentOutOfRangeException)
+            {
+            }
+        }
+    }
+
+    /// <summary>
+    /// The native vector and quaternion operations, both scalar and batched, must match their
+    /// formulas written out with the scalar native operations in the documented order. Unless
+    /// NaNs are canonical, any two NaNs are considered equal, as the NaN the FPU propagates can
+    /// depend on operand order the compiler chooses.
+    /// </summary>
+    private void VectorTestAll(List<uint> inputs)
+    {
+        int count = inputs.Count / 4;
+
+        var qa = new dquat[count];
+        var qb = new dquat[count];
+        var soaA = new dfloat[count * 4];
+        var soaB = new dfloat[count * 4];
+
+        for (int i = 0; i < count; i++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                soaA[c * count + i] = new dfloat(inputs[i * 4 + c]);
+                soaB[c * count + i] = new dfloat(inputs[(i * 4 + c + 1) % inputs.Count]);
+            }
+
+            qa[i] = new dquat(soaA[i], soaA[count + i], soaA[2 * count + i], soaA[3 * count + i]);
+            qb[i] = new dquat(soaB[i], soaB[count + i], soaB[2 * count + i], soaB[3 * count + i]);
+        }
+
+        // The first three planes of a quaternion buffer are a vector buffer.
+        var vecA = new dfloat[count * 3];
+        var vecB = new dfloat[count * 3];
+        Array.Copy(soaA, vecA, count * 3);
+        Array.Copy(soaB, vecB, count * 3);
+
+        var dots = new dfloat[count];
+        var crosses = new dfloat[count * 3];
+        var normals = new dfloat[count * 3];
+        var products = new dfloat[count * 4];
+        var rotated = new dfloat[count * 3];
+
+        Mathd.Dot3(vecA, vecB, dots);
+        Mathd.Cross(vecA, vecB, crosses);
+        Mathd.Normalize3(vecA, normals);
+        Mathd.QuatMul(soaA, soaB, products);
+        Mathd.QuatRotate(soaA, vecB, rotated);
+
+        dfloat two = new dfloat(0x40000000);
+
+        for (int i = 0; i < count; i++)
+        {
+            dquat a = qa[i], b = qb[i];
+            var u = new dvec3(a.x, a.y, a.z);
+            var v = new dvec3(b.x, b.y, b.z);
+
+            dfloat dot = Mathd.Add(Mathd.Add(Mathd.Mul(u.x, v.x), Mathd.Mul(u.y, v.y)), Mathd.Mul(u.z, v.z));
+            VectorCheck("Dot", i, new[] { dot }, new[] { Mathd.Dot(u, v) }, new[] { dots[i] });
+
+            var cross = WrittenOutCross(u, v);
+            dvec3 nativeCross = Mathd.Cross(u, v);
+            VectorCheck("Cross", i, Components(cross), Components(nativeCross), Plane(crosses, 3, count, i));
+
+            dfloat lengthSquared = Mathd.Add(Mathd.Add(Mathd.Mul(u.x, u.x), Mathd.Mul(u.y, u.y)), Mathd.Mul(u.z, u.z));
+            var normal = new dvec3(new dfloat(0), new dfloat(0), new dfloat(0));
+
+            if ((lengthSquared.Bits & 0x7fffffff) != 0)
+            {
+                dfloat length = Mathd.Sqrt(lengthSquared);
+                normal = new dvec3(Mathd.Div(u.x, length), Mathd.Div(u.y, length), Mathd.Div(u.z, length));
+            }
+
+            VectorCheck("Normalize", i, Components(normal), Components(Mathd.Normalize(u)), Plane(normals, 3, count, i));
+
+            var product = new dfloat[]
+            {
+                Mathd.Sub(Mathd.Add(Mathd.Add(Mathd.Mul(a.w, b.x), Mathd.Mul(a.x, b.w)), Mathd.Mul(a.y, b.z)), Mathd.Mul(a.z, b.y)),
+                Mathd.Add(Mathd.Add(Mathd.Sub(Mathd.Mul(a.w, b.y), Mathd.Mul(a.x, b.z)), Mathd.Mul(a.y, b.w)), Mathd.Mul(a.z, b.x)),
+                Mathd.Add(Mathd.Sub(Mathd.Add(Mathd.Mul(a.w, b.z), Mathd.Mul(a.x, b.y)), Mathd.Mul(a.y, b.x)), Mathd.Mul(a.z, b.w)),
+                Mathd.Sub(Mathd.Sub(Mathd.Sub(Mathd.Mul(a.w, b.w), Mathd.Mul(a.x, b.x)), Mathd.Mul(a.y, b.y)), Mathd.Mul(a.z, b.z)),
+            };
+            dquat nativeProduct = Mathd.Mul(a, b);
+            VectorCheck("QuatMul", i, product, new[] { nativeProduct.x, nativeProduct.y, nativeProduct.z, nativeProduct.w }, Plane(products, 4, count, i));
+
+            dvec3 c2 = WrittenOutCross(u, v);
+            var t = new dvec3(Mathd.Mul(c2.x, two), Mathd.Mul(c2.y, two), Mathd.Mul(c2.z, two));
+            dvec3 ut = WrittenOutCross(u, t);
+            var rotation = new dvec3(
+                Mathd.Add(v.x, Mathd.Add(Mathd.Mul(a.w, t.x), ut.x)),
+                Mathd.Add(v.y, Mathd.Add(Mathd.Mul(a.w, t.y), ut.y)),
+                Mathd.Add(v.z, Mathd.Add(Mathd.Mul(a.w, t.z), ut.z)));
+            VectorCheck("QuatRotate", i, Components(rotation), Components(Mathd.Rotate(a, v)), Plane(rotated, 3, count, i));
+        }
+    }
+
+    /// <summary>
+    /// The native matrix operations, scalar and batched in both layouts, must match their
+    /// formulas written out with the scalar native operations.
+    /// </summary>
+    private void MatrixTestAll(List<uint> inputs)
+    {
+        int count = inputs.Count / 4;
+
+        var a = new dmat4[count];
+        var b = new dmat4[count];
+        var points = new dvec3[count];
+
+        for (int i = 0; i < count; i++)
+        {
+            for (int e = 0; e < 16; e++)
+            {
+                a[i][e] = new dfloat(inputs[(i * 4 + e) % inputs.Count]);
+                b[i][e] = new dfloat(inputs[(i * 4 + e + 7) % inputs.Count]);
+            }
+
+            points[i] = new dvec3(new dfloat(inputs[i]), new dfloat(inputs[(i + 1) % inputs.Count]), new dfloat(inputs[(i + 2) % inputs.Count]));
+        }
+
+        var products = new dmat4[count];
+        Mathd.Mul(a, b, products);
+
+        var soaA = new dfloat[count * 16];
+        var soaB = new dfloat[count * 16];
+        var soaProducts = new dfloat[count * 16];
+
+        for (int i = 0; i < count; i++)
+        {
+            for (int e = 0; e < 16; e++)
+            {
+                soaA[e * count + i] = a[i][e];
+                soaB[e * count + i] = b[i][e];
+            }
+        }
+
+        Mathd.MulSoa(soaA, soaB, soaProducts);
+
+        dmat4 m = a[0];
+        var transformed = new dvec3[count];
+        var soaPoints = new dfloat[count * 3];
+        var soaTransformed = new dfloat[count * 3];
+
+        for (int i = 0; i < count; i++)
+        {
+            soaPoints[i] = points[i].x;
+            soaPoints[count + i] = points[i].y;
+            soaPoints[2 * count + i] = points[i].z;
+        }
+
+        for (int point = 0; point < 2; point++)
+        {
+            if (point == 1)
+            {
+                Mathd.MultiplyPoint3x4(m, points, transformed);
+                Mathd.MultiplyPoint3x4(m, soaPoints, soaTransformed);
+            }
+            else
+            {
+                Mathd.MultiplyVector(m, points, transformed);
+                Mathd.MultiplyVector(m, soaPoints, soaTransformed);
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                dvec3 p = points[i];
+                var truth = new dfloat[3];
+
+                for (int r = 0; r < 3; r++)
+                {
+                    truth[r] = Mathd.Add(Mathd.Add(Mathd.Mul(m[r, 0], p.x), Mathd.Mul(m[r, 1], p.y)), Mathd.Mul(m[r, 2], p.z));
+
+                    if (point == 1)
+                        truth[r] = Mathd.Add(truth[r], m[r, 3]);
+                }
+
+                dvec3 scalar = point == 1 ? Mathd.MultiplyPoint3x4(m, p) : Mathd.MultiplyVector(m, p);
+                string name = point == 1 ? "MultiplyPoint3x4" : "MultiplyVector";
+
+                VectorCheck(name, i, truth, Components(scalar), Components(transformed[i]));
+                VectorCheck(name + " SoA", i, truth, Components(scalar), Plane(soaTransformed, 3, count, i));
+            }
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            var truth = new dfloat[16];
+
+            for (int c = 0; c < 4; c++)
+            {
+                for (int r = 0; r < 4; r++)
+                {
+                    dfloat sum = Mathd.Mul(a[i][r, 0], b[i][0, c]);
+
+                    for (int k = 1; k < 4; k++)
+                    {
+                        sum = Mathd.Add(sum, Mathd.Mul(a[i][r, k], b[i][k, c]));
+                    }
+
+                    truth[c * 4 + r] = sum;
+                }
+            }
+
+            dmat4 scalar = Mathd.Mul(a[i], b[i]);
+            var scalarElements = new dfloat[16];
+            var batchedElements = new dfloat[16];
+
+            for (int e = 0; e < 16; e++)
+            {
+                scalarElements[e] = scalar[e];
+                batchedElements[e] = products[i][e];
+            }
+
+            VectorCheck("Matrix Mul", i, truth, scalarElements, batchedElements);
+            VectorCheck("Matrix Mul SoA", i, truth, scalarElements, Plane(soaProducts, 16, count, i));
+        }
+    }
+
+    /// <summary>
+    /// The parallel reductions must give the same bits for every thread count, and match
+    /// their tree (see reduce.rs) written out with the scalar native operations. The buffers
+    /// span several chunks, with a partial one at the end.
+    /// </summary>
+    private void ReductionTestAll(List<uint> inputs)
+    {
+        const int chunk = 4096;
+        int[] threadCounts = { 1, 2, 3, 4, 7, 16, 0 };
+
+        // The inputs with exponents limited to about 2^-32 to 2^32, so sums neither
+        // overflow nor are dominated by one element, then the same with special values
+        // mixed in, then the inputs as they are.
+        var moderate = inputs.ConvertAll(x => (x & 0x807fffff) | ((0x5f + (x >> 23) % 0x40) << 23));
+        var specials = new List<uint>(moderate);
+        uint[] specialValues = { 0, 0x80000000, 0x00000001, 0x807fffff, 0x7f800000, 0xff800000, 0x7fc00000 };
+
+        for (int i = 0; i < specials.Count; i += 97)
+        {
+            specials[i] = specialValues[i % specialValues.Length];
+        }
+
+        foreach (var source in new[] { moderate, specials, inputs })
+        {
+            var x = new dfloat[chunk * 9 + 123];
+            var y = new dfloat[x.Length];
+
+            for (int i = 0; i < x.Length; i++)
+            {
+                x[i] = new dfloat(source[i % source.Count]);
+                y[i] = new dfloat(source[(i * 7 + 3) % source.Count]);
+            }
+
+            var products = new dfloat[x.Length];
+
+            for (int i = 0; i < x.Length; i++)
+            {
+                products[i] = Mathd.Mul(x[i], y[i]);
+            }
+
+            var checks = new (string name, dfloat truth, Func<int, dfloat> native)[]
+            {
+                ("Sum", WrittenOutReduction(x, chunk, new dfloat(0x80000000), Mathd.Add), t => Mathd.Sum(x, t)),
+                ("Dot", WrittenOutReduction(products, chunk, new dfloat(0x80000000), Mathd.Add), t => Mathd.Dot(x, y, t)),
+                ("Min", CanonicalNaN(WrittenOutReduction(x, chunk, new dfloat(0x7f800000), WrittenOutMin)), t => Mathd.Min(x, t)),
+                ("Max", CanonicalNaN(WrittenOutReduction(x, chunk, new dfloat(0xff800000), WrittenOutMax)), t => Mathd.Max(x, t)),
+            };
+
+            foreach (var check in checks)
+            {
+                dfloat first = check.native(1);
+
+                foreach (int threads in threadCounts)
+                {
+                    dfloat result = check.native(threads);
+
+                    if (result.Bits != first.Bits || !SameNativeResult(result.Bits, check.truth.Bits))
+                    {
+                        batchErrors++;
+
+                        if (batchErrors < logOutputLimit)
+                            LogError($"{check.name} with {threads} threads: {result.Bits}, with 1 thread {first.Bits}, written out {check.truth.Bits}");
+                    }
+                }
+            }
+        }
+    }
+
+    private static dfloat WrittenOutReduction(dfloat[] x, int chunk, dfloat identity, Func<dfloat, dfloat, dfloat> op)
+    {
+        var results = new List<dfloat>();
+
+        for (int start = 0; start < x.Length; start += chunk)
+        {
+            var lanes = new dfloat[8];
+
+            for (int l = 0; l < 8; l++)
+            {
+                lanes[l] = identity;
+            }
+
+            for (int i = start; i < Math.Min(x.Length, start + chunk); i++)
+            {
+                lanes[(i - start) % 8] = op(lanes[(i - start) % 8], x[i]);
+            }
+
+            results.Add(op(op(op(lanes[0], lanes[1]), op(lanes[2], lanes[3])), op(op(lanes[4], lanes[5]), op(lanes[6], lanes[7]))));
+        }
+
+        while (results.Count > 1)
+        {
+            var next = new List<dfloat>();
+
+            for (int i = 0; i < results.Count; i += 2)
+            {
+                next.Add(i + 1 < results.Count ? op(results[i], results[i + 1]) : results[i]);
+            }
+
+            results = next;
+        }
+
+        return results[0];
+    }
+
+    private static bool IsNaN(dfloat x)
+    {
+        return (x.Bits & 0x7fffffff) > 0x7f800000;
+    }
+
+    private const uint canonicalNaN = 0xffc00000;
+
+    /// <summary>
+    /// x as the native library returns it in the selected NaN mode.
+    /// </summary>
+    private dfloat CanonicalNaN(dfloat x)
+    {
+        return nativeNaNMode == Mathd.NaNMode.Canonical && IsNaN(x) ? new dfloat(canonicalNaN) : x;
+    }
+
+    // Total order with -0 below +0, on finite values and infinities.
+    private static int OrderKey(dfloat x)
+    {
+        return (x.Bits & 0x80000000) != 0 ? ~(int)(x.Bits & 0x7fffffff) : (int)x.Bits;
+    }
+
+    private static dfloat WrittenOutMin(dfloat a, dfloat b)
+    {
+        if (IsNaN(a))
+            return a;
+
+        if (IsNaN(b))
+            return b;
+
+        return OrderKey(b) < OrderKey(a) ? b : a;
+    }
+
+    private static dfloat WrittenOutMax(dfloat a, dfloat b)
+    {
+        if (IsNaN(a))
+            return a;
+
+        if (IsNaN(b))
+            return b;
+
+        return OrderKey(b) > OrderKey(a) ? b : a;
+    }
+
+    /// <summary>
+    /// With <see cref="Mathd.DenormalMode.Flush"/>, each basic operation must give the exact
+    /// result for its inputs with denormals replaced by zero, with a denormal result replaced
+    /// by zero in turn, on both backends and in batches. The soft backend must also give the
+    /// same bits whatever the FPU's flush flags are.
+    /// </summary>
+    private void DenormalTestAll(List<uint> inputs)
+    {
+        // Values either side of the smallest normal, and ones whose sums, products and
+        // quotients with them land either side of it.
+        var values = new List<uint>
+        {
+            0, 0x80000000, 0x00000001, 0x80000001, 0x007fffff, 0x807fffff, 0x00800000, 0x80800000,
+            0x00800001, 0x00ffffff, 0x3f000000, 0xbf000000, 0x3f7fffff, 0x3f800000, 0x4b000000,
+            0x7f800000, 0x7fc00000
+        };
+
+        for (int i = 0; i < Math.Min(32, inputs.Count); i++)
+        {
+            values.Add((inputs[i] & 0x807fffff) | ((inputs[i] >> 23) % 3 << 23));
+            values.Add((inputs[i] & 0x807fffff) | ((0x7e + (inputs[i] >> 23) % 3) << 23));
+        }
+
+        int n = values.Count;
+        var a = new dfloat[n * n];
+        var b = new dfloat[n * n];
+
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                a[i * n + j] = new dfloat(values[i]);
+                b[i * n + j] = new dfloat(values[j]);
+            }
+        }
+
+        var ops = new (string name, Func<dfloat, dfloat, dfloat> scalar, Action<dfloat[], dfloat[], dfloat[]> batched)[]
+        {
+            ("Add", Mathd.Add, Mathd.Add),
+            ("Sub", Mathd.Sub, Mathd.Sub),
+            ("Mul", Mathd.Mul, Mathd.Mul),
+            ("Div", Mathd.Div, Mathd.Div),
+        };
+
+        var backend = Mathd.GetBackend();
+        var expected = new dfloat[a.Length];
+        var batched = new dfloat[a.Length];
+
+        foreach (var testBackend in new[] { Mathd.Backend.Hardware, Mathd.Backend.Soft })
+        {
+            Mathd.SetBackend(testBackend);
+
+            foreach (var op in ops)
+            {
+                Mathd.SetDenormalMode(Mathd.DenormalMode.Preserve);
+
+                for (int i = 0; i < a.Length; i++)
+                {
+                    expected[i] = FlushDenormal(op.scalar(FlushDenormal(a[i]), FlushDenormal(b[i])));
+                }
+
+                Mathd.SetDenormalMode(Mathd.DenormalMode.Flush);
+                op.batched(a, b, batched);
+
+                for (int i = 0; i < a.Length; i++)
+                {
+                    DenormalCheck($"{testBackend} flushed {op.name}", a[i], b[i], expected[i], op.scalar(a[i], b[i]), batched[i]);
+                }
+            }
+
+            foreach (uint x in values)
+            {
+                Mathd.SetDenormalMode(Mathd.DenormalMode.Preserve);
+                int floor = Mathd.ToInt(FlushDenormal(new dfloat(x)), Mathd.RoundingMode.Floor);
+
+                Mathd.SetDenormalMode(Mathd.DenormalMode.Flush);
+                int flushedFloor = Mathd.ToInt(new dfloat(x), Mathd.RoundingMode.Floor);
+
+                if (flushedFloor != floor)
+                {
+                    batchErrors++;
+
+                    if (batchErrors < logOutputLimit)
+                        LogError($"{testBackend} flushed ToInt Floor of {x}: {flushedFloor}, expected {floor}");
+                }
+            }
+        }
+
+        Mathd.SetBackend(Mathd.Backend.Soft);
+        Mathd.SetDenormalMode(Mathd.DenormalMode.Preserve);
+
+        var soft = new dfloat[ops.Length][];
+
+        for (int o = 0; o < ops.Length; o++)
+        {
+            soft[o] = new dfloat[a.Length];
+            ops[o].batched(a, b, soft[o]);
+        }
+
+        ulong state = Mathd.GetFpuState();
+        Mathd.FpuFlags flags;
+
+        using (new Mathd.FpuScope(Mathd.FpuFlags.FlushToZero | Mathd.FpuFlags.DenormalsAreZero))
+        {
+            flags = Mathd.GetFpuFlags();
+
+            for (int o = 0; o < ops.Length; o++)
+            {
+                ops[o].batched(a, b, batched);
+
+                for (int i = 0; i < a.Length; i++)
+                {
+                    DenormalCheck($"Soft {ops[o].name} with FPU flags {flags}", a[i], b[i], soft[o][i], ops[o].scalar(a[i], b[i]), batched[i]);
+                }
+            }
+        }
+
+        if (Mathd.GetFpuState() != state)
+        {
+            batchErrors++;
+            LogError($"The FPU state was {Mathd.GetFpuState()} after restoring it to {state}.");
+        }
+
+        Log($"Tested denormal flushing, and the soft backend with FPU flush flags {flags}.");
+
+        Mathd.SetBackend(backend);
+    }
+
+    /// <summary>
+    /// With <see cref="Mathd.NaNMode.Canonical"/>, every native operation must give the same
+    /// result as with NaNs preserved, except that every NaN is 0xffc00000 (0xfff8000000000000
+    /// for ddouble), on both backends, scalar and batched.
+    /// </summary>
+    private void NaNTestAll(List<uint> inputs)
+    {
+        // NaNs of both signs, quiet and signalling, with several payloads, values whose
+        // combinations are invalid operations, and the inputs with and without their
+        // exponents set to make them NaNs.
+        var values = new List<uint>
+        {
+            0, 0x80000000, 0x3f800000, 0xbf800000, 0x7f800000, 0xff800000,
+            0x7fc00000, 0xffc00000, 0x7f800001, 0xff800001, 0x7fa00001, 0x7fffffff, 0xffc12345
+        };
+
+        for (int i = 0; i < Math.Min(16, inputs.Count); i++)
+        {
+            values.Add(inputs[i]);
+            values.Add(inputs[i] | 0x7f800001);
+        }
+
+        int n = values.Count;
+        var a = new dfloat[n * n];
+        var b = new dfloat[n * n];
+
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                a[i * n + j] = new dfloat(values[i]);
+                b[i * n + j] = new dfloat(values[j]);
+            }
+        }
+
+        var ops = new (string name, Func<dfloat, dfloat, dfloat> scalar, Action<dfloat[], dfloat[], dfloat[]> batched)[]
+        {
+            ("Add", Mathd.Add, Mathd.Add),
+            ("Sub", Mathd.Sub, Mathd.Sub),
+            ("Mul", Mathd.Mul, Mathd.Mul),
+            ("Div", Mathd.Div, Mathd.Div),
+            ("Atan2", Mathd.Atan2, Mathd.Atan2),
+            ("Sqrt", (x, y) => Mathd.Sqrt(x), (x, y, o) => Mathd.Sqrt(x, o)),
+            ("Sin", (x, y) => Mathd.Sin(x), (x, y, o) => Mathd.Sin(x, o)),
+            ("Cos", (x, y) => Mathd.Cos(x), (x, y, o) => Mathd.Cos(x, o)),
+            ("Exp", (x, y) => Mathd.Exp(x), (x, y, o) => Mathd.Exp(x, o)),
+            ("Log", (x, y) => Mathd.Log(x), (x, y, o) => Mathd.Log(x, o)),
+            ("Sum", (x, y) => Mathd.Sum(new[] { x, y }), null),
+            ("Min", (x, y) => Mathd.Min(new[] { x, y }), null),
+            ("Max", (x, y) => Mathd.Max(new[] { x, y }), null),
+        };
+
+        var backend = Mathd.GetBackend();
+        var preserved = new dfloat[a.Length];
+        var batched = new dfloat[a.Length];
+
+        foreach (var testBackend in new[] { Mathd.Backend.Hardware, Mathd.Backend.Soft })
+        {
+            Mathd.SetBackend(testBackend);
+
+            foreach (var op in ops)
+            {
+                Mathd.SetNaNMode(Mathd.NaNMode.Preserve);
+
+                for (int i = 0; i < a.Length; i++)
+                {
+                    preserved[i] = op.scalar(a[i], b[i]);
+                }
+
+                Mathd.SetNaNMode(Mathd.NaNMode.Canonical);
+                op.batched?.Invoke(a, b, batched);
+
+                for (int i = 0; i < a.Length; i++)
+                {
+                    uint expected = IsNaN(preserved[i]) ? canonicalNaN : preserved[i].Bits;
+                    uint scalar = op.scalar(a[i], b[i]).Bits;
+                    uint batchedBits = op.batched != null ? batched[i].Bits : scalar;
+
+                    if (scalar != expected || batchedBits != expected)
+                    {
+                        batchErrors++;
+
+                        if (batchErrors < logOutputLimit)
+                            LogError($"{testBackend} canonical {op.name} of {a[i].Bits} and {b[i].Bits}: scalar {scalar}, batched {batchedBits}, expected {expected}");
+                    }
+                }
+            }
+
+            for (int i = 0; i < n; i++)
+            {
+                for (int j = 0; j < n; j++)
+                {
+                    var x = new ddouble(((ulong)values[i] << 32) | values[j]);
+                    var y = new ddouble(((ulong)values[j] << 32) | values[i]);
+
+                    Mathd.SetNaNMode(Mathd.NaNMode.Preserve);
+                    ulong product = Mathd.Mul(x, y).Bits;
+
+                    Mathd.SetNaNMode(Mathd.NaNMode.Canonical);
+                    ulong canonical = Mathd.Mul(x, y).Bits;
+
+                    ulong expected = (product & 0x7fffffffffffffff) > 0x7ff0000000000000 ? 0xfff8000000000000 : product;
+
+                    if (canonical != expected)
+                    {
+                        batchErrors++;
+
+                        if (batchErrors < logOutputLimit)
+                            LogError($"{testBackend} canonical ddouble Mul of {x.Bits} and {y.Bits}: {canonical}, expected {expected}");
+                    }
+                }
+            }
+        }
+
+        Log("Tested NaN canonicalization.");
+
+        Mathd.SetBackend(backend);
+        Mathd.SetNaNMode(nativeNaNMode);
+    }
+
+    /// <summary>
+    /// Checks add, sub, mul and div against <see cref="Mathd.Oracle(Mathd.BasicOp, dfloat, dfloat)"/>,
+    /// which computes the correctly rounded results natively with integer arithmetic, over
+    /// every ordered pair of the special values and the inputs, on both backends and with
+    /// denormals preserved and flushed. Unlike the ground truth files this needs no I/O, and
+    /// checks the results are correct as well as the same as on the machine that wrote them.
+    /// </summary>
+    private void OracleTestAll(List<uint> inputs)
+    {
+        // Zeros, denormals, the smallest and largest normals, values whose sums and products
+        // are halfway between two floats, infinities and NaNs.
+        var values = new List<uint>
+        {
+            0, 0x80000000, 0x00000001, 0x807fffff, 0x00800000, 0x7f7fffff, 0xff7fffff, 0x3f800000,
+            0x3f800001, 0xbf800001, 0x33800000, 0x34000000, 0x3fc00000, 0x4b800001, 0x7f800000,
+            0xff800000, 0x7fc00000, 0xff800001
+        };
+
+        values.AddRange(inputs);
+
+        int n = values.Count;
+        var a = new dfloat[n * n];
+        var b = new dfloat[n * n];
+
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                a[i * n + j] = new dfloat(values[i]);
+                b[i * n + j] = new dfloat(values[j]);
+            }
+        }
+
+        var mismatches = new int[logOutputLimit];
+        var backend = Mathd.GetBackend();
+        var denormalMode = Mathd.GetDenormalMode();
+
+        oracleTests = 0;
+        oracleErrors = 0;
+
+        foreach (var testBackend in new[] { Mathd.Backend.Hardware, Mathd.Backend.Soft })
+        {
+            foreach (var testMode in new[] { Mathd.DenormalMode.Preserve, Mathd.DenormalMode.Flush })
+            {
+                Mathd.SetBackend(testBackend);
+                Mathd.SetDenormalMode(testMode);
+
+                foreach (var op in new[] { Mathd.BasicOp.Add, Mathd.BasicOp.Sub, Mathd.BasicOp.Mul, Mathd.BasicOp.Div })
+                {
+                    long differences = Mathd.CheckAgainstOracle(op, a, b, mismatches);
+
+                    for (int i = 0; i < Math.Min(differences, mismatches.Length) && oracleErrors + i < logOutputLimit; i++)
+                    {
+                        int k = mismatches[i];
+                        dfloat truth = Mathd.Oracle(op, a[k], b[k]);
+                        LogError($"{testBackend} {testMode} {op} against the oracle: {GetResultString(a[k].Bits, b[k].Bits, OracleOperate(op, a[k], b[k]).Bits, truth.Bits)}");
+                    }
+
+                    oracleTests += a.Length;
+                    oracleErrors += differences;
+                }
+            }
+        }
+
+        Mathd.SetBackend(backend);
+        Mathd.SetDenormalMode(denormalMode);
+    }
+
+    private static dfloat OracleOperate(Mathd.BasicOp op, dfloat a, dfloat b)
+    {
+        switch (op)
+        {
+            case Mathd.BasicOp.Add: return Mathd.Add(a, b);
+            case Mathd.BasicOp.Sub: return Mathd.Sub(a, b);
+            case Mathd.BasicOp.Mul: return Mathd.Mul(a, b);
+            default: return Mathd.Div(a, b);
+        }
+    }
+
+    private static dfloat FlushDenormal(dfloat x)
+    {
+        return (x.Bits & 0x7f800000) == 0 ? new dfloat(x.Bits & 0x80000000) : x;
+    }
+
+    private void DenormalCheck(string name, dfloat a, dfloat b, dfloat expected, dfloat scalar, dfloat batched)
+    {
+        if (!SameNativeResult(scalar.Bits, expected.Bits) || !SameNativeResult(batched.Bits, expected.Bits))
+        {
+            batchErrors++;
+
+            if (batchErrors < logOutputLimit)
+                LogError($"{name} of {a.Bits} and {b.Bits}: scalar {scalar.Bits}, batched {batched.Bits}, expected {expected.Bits}");
+        }
+    }
+
+    private static dvec3 WrittenOutCross(dvec3 a, dvec3 b)
+    {
+        return new dvec3(
+            Mathd.Sub(Mathd.Mul(a.y, b.z), Mathd.Mul(a.z, b.y)),
+            Mathd.Sub(Mathd.Mul(a.z, b.x), Mathd.Mul(a.x, b.z)),
+            Mathd.Sub(Mathd.Mul(a.x, b.y), Mathd.Mul(a.y, b.x)));
+    }
+
+    private static dfloat[] Components(dvec3 v)
+    {
+        return new[] { v.x, v.y, v.z };
+    }
+
+    private static dfloat[] Plane(dfloat[] soa, int components, int count, int i)
+    {
+        var v = new dfloat[components];
+
+        for (int c = 0; c < components; c++)
+        {
+            v[c] = soa[c * count + i];
+        }
+
+        return v;
+    }
+
+    private void VectorCheck(string name, int index, dfloat[] truth, dfloat[] scalar, dfloat[] batched)
+    {
+        for (int c = 0; c < truth.Length; c++)
+        {
+            bool pass = SameNativeResult(scalar[c].Bits, truth[c].Bits) && SameNativeResult(batched[c].Bits, truth[c].Bits);
+
+            if (!pass)
+            {
+                batchErrors++;
+
+                if (batchErrors < logOutputLimit)
+                    LogError($"{name} component {c} at {index}: scalar {scalar[c].Bits}, batched {batched[c].Bits}, written out {truth[c].Bits}");
+            }
+        }
+    }
+
+    /// <summary>
+    /// Bit for bit, unless native NaNs are preserved, when any two NaNs are equal.
+    /// </summary>
+    private bool SameNativeResult(uint a, uint b)
+    {
+        return a == b || (nativeNaNMode == Mathd.NaNMode.Preserve && float.IsNaN(BitsToFloat(a)) && float.IsNaN(BitsToFloat(b)));
+    }
+
+    /// <summary>
+    /// Stops tracing, if <see cref="traceNativeOperations"/> started it, and dumps the trace.
+    /// The self test is not traced, as it runs every kernel variant in every mode.
+    /// </summary>
+    private void DumpTrace()
+    {
+        if (!traceNativeOperations)
+            return;
+
+        Mathd.StopTrace();
+
+        string path = Path.Combine(Application.persistentDataPath, traceFilename);
+
+        try
+        {
+            Log($"Wrote {Mathd.DumpTrace(path)} traced native operations to {path}");
+        }
+        catch (IOException e)
+        {
+            LogError(e.Message);
+        }
+    }
+
+    /// <summary>
+    /// Runs the native self-test, which checks every batched kernel variant the CPU supports
+    /// against the scalar operations over the special values tested above.
+    /// </summary>
+    private void DispatchSelfTest()
+    {
+        var failures = new Mathd.SelfTestFailure[logOutputLimit];
+        long count = Mathd.RunDispatchSelfTest(failures, out long nanPayloads);
+
+        batchErrors += count;
+
+        for (int i = 0; i < Math.Min(count, failures.Length); i++)
+        {
+            var f = failures[i];
+            LogError($"{f.Variant} {f.Backend} {f.Denormals} kernel op {f.Op} at {f.Index}: {GetResultString(f.A, f.B, f.Actual, f.Expected)}");
+        }
+
+        if (nanPayloads > 0)
+            Log($"{nanPayloads} batched NaN results with NaNs preserved had a different payload than the scalar operation's, as the NaN propagated depends on operand order.");
+    }
+
     private void Operate(uint a, uint b, Operator op, out float floatResult, out dfloat dfloatResult)
     {
         float floatA = BitsToFloat(a);
@@ -325,11 +2379,63 @@ public class DeterminismTest : MonoBehaviour
                 floatResult = floatA / floatB;
                 dfloatResult = Mathd.Div(new dfloat(a), new dfloat(b));
                 break;
+            case Operator.Atan2:
+                floatResult = Mathf.Atan2(floatA, floatB);
+                dfloatResult = Mathd.Atan2(new dfloat(a), new dfloat(b));
+                break;
+            case Operator.Sqrt:
+                floatResult = Mathf.Sqrt(floatA);
+                dfloatResult = Mathd.Sqrt(new dfloat(a));
+                break;
+            case Operator.Sin:
+                floatResult = Mathf.Sin(floatA);
+                dfloatResult = Mathd.Sin(new dfloat(a));
+                break;
+            case Operator.Cos:
+                floatResult = Mathf.Cos(floatA);
+                dfloatResult = Mathd.Cos(new dfloat(a));
+                break;
+            case Operator.Exp:
+                floatResult = Mathf.Exp(floatA);
+                dfloatResult = Mathd.Exp(new dfloat(a));
+                break;
+            case Operator.Log:
+                floatResult = Mathf.Log(floatA);
+                dfloatResult = Mathd.Log(new dfloat(a));
+                break;
             default:
                 throw new Exception("Unknown operator.");
         }
     }
 
+    private void DoubleOperate(ulong a, ulong b, Operator op, out double doubleResult, out ddouble ddoubleResult)
+    {
+        double doubleA = BitsToDouble(a);
+        double doubleB = BitsToDouble(b);
+
+        switch (op)
+        {
+            case Operator.Add:
+                doubleResult = doubleA + doubleB;
+                ddoubleResult = Mathd.Add(new ddouble(a), new ddouble(b));
+                break;
+            case Operator.Sub:
+                doubleResult = doubleA - doubleB;
+                ddoubleResult = Mathd.Sub(new ddouble(a), new ddouble(b));
+                break;
+            case Operator.Mul:
+                doubleResult = doubleA * doubleB;
+                ddoubleResult = Mathd.Mul(new ddouble(a), new ddouble(b));
+                break;
+            case Operator.Div:
+                doubleResult = doubleA / doubleB;
+                ddoubleResult = Mathd.Div(new ddouble(a), new ddouble(b));
+                break;
+            default:
+                throw new Exception("Unknown double operator.");
+        }
+    }
+
     private string GetResultString(uint a, uint b, uint result, uint truth)
     {
         return $"result {FloatBitsToVerboseString(result) } != truth {FloatBitsToVerboseString(truth) }\n" +
@@ -341,6 +2447,17 @@ public class DeterminismTest : MonoBehaviour
         return $"{ BitsToFloat(bits)}f : { Convert.ToString(bits, 2).PadLeft(32, '0')} : {bits}";
     }
 
+    private string GetDoubleResultString(ulong a, ulong b, ulong result, ulong truth)
+    {
+        return $"result {DoubleBitsToVerboseString(result) } != truth {DoubleBitsToVerboseString(truth) }\n" +
+               $"Inputs: {DoubleBitsToVerboseString(a) } * {DoubleBitsToVerboseString(b) }";
+    }
+
+    private string DoubleBitsToVerboseString(ulong bits)
+    {
+        return $"{ BitsToDouble(bits):R}d : { Convert.ToString((long)bits, 2).PadLeft(64, '0')} : {bits}";
+    }
+
     private unsafe float BitsToFloat(uint bits)
     {
         return *(float*)&bits;
@@ -350,4 +2467,14 @@ public class DeterminismTest : MonoBehaviour
     {
         return *(uint*)&f;
     }
+
+    private unsafe double BitsToDouble(ulong bits)
+    {
+        return *(double*)&bits;
+    }
+
+    private unsafe ulong DoubleToBits(double d)
+    {
+        return *(ulong*)&d;
+    }
 }
@@ -0,0 +1,168 @@
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+
+/// <summary>
+/// A sequence of dfloat operations that the native library evaluates over many lanes
+/// with a single call, e.g. for <c>(a * b + c) / d</c>:
+/// <code>
+/// var program = new DfloatProgram();
+/// int r = program.Div(program.Add(program.Mul(program.Load(0), program.Load(1)), program.Load(2)), program.Load(3));
+/// program.Store(0, r);
+/// </code>
+/// Operations run in the order they were added, each rounded separately, so the result
+/// is bit-identical to making the same sequence of <see cref="Mathd"/> calls.
+/// </summary>
+public class DfloatProgram
+{
+    private enum OpCode : byte { Load = 0, Store = 1, Const = 2, Add = 3, Sub = 4, Mul = 5, Div = 6, Sqrt = 7, Sin = 8, Cos = 9, Atan2 = 10, Exp = 11, Log = 12 }
+
+    // Must match MAX_REGISTERS in vm.rs.
+    private const int maxRegisters = 64;
+
+    // Inputs and outputs are indexed by a byte of the instruction.
+    private const int maxSlots = 256;
+
+    [DllImport("unity_rust")]
+    private static extern unsafe int dfloat_program_run(uint* code, UIntPtr codeLength, uint* inputs, UIntPtr inputCount, uint* outputs, UIntPtr outputCount, UIntPtr lanes);
+
+    private readonly List<uint> code = new List<uint>();
+
+    // Cached copy of code to pass to the native library, rebuilt after any change.
+    private uint[] words;
+
+    private int registers;
+
+    public int InputCount { get; private set; }
+
+    public int OutputCount { get; private set; }
+
+    public int Load(int input)
+    {
+        CheckIndex(input, maxSlots, nameof(input));
+        InputCount = Math.Max(InputCount, input + 1);
+        return Operation(OpCode.Load, input, 0);
+    }
+
+    public int Const(dfloat value)
+    {
+        int register = Operation(OpCode.Const, 0, 0);
+        code.Add(value.Bits);
+        words = null;
+        return register;
+    }
+
+    public int Add(int a, int b)
+    {
+        return Operation(OpCode.Add, Register(a, nameof(a)), Register(b, nameof(b)));
+    }
+
+    public int Sub(int a, int b)
+    {
+        return Operation(OpCode.Sub, Register(a, nameof(a)), Register(b, nameof(b)));
+    }
+
+    public int Mul(int a, int b)
+    {
+        return Operation(OpCode.Mul, Register(a, nameof(a)), Register(b, nameof(b)));
+    }
+
+    public int Div(int a, int b)
+    {
+        return Operation(OpCode.Div, Register(a, nameof(a)), Register(b, nameof(b)));
+    }
+
+    public int Sqrt(int x)
+    {
+        return Operation(OpCode.Sqrt, Register(x, nameof(x)), 0);
+    }
+
+    public int Sin(int x)
+    {
+        return Operation(OpCode.Sin, Register(x, nameof(x)), 0);
+    }
+
+    public int Cos(int x)
+    {
+        return Operation(OpCode.Cos, Register(x, nameof(x)), 0);
+    }
+
+    public int Atan2(int y, int x)
+    {
+        return Operation(OpCode.Atan2, Register(y, nameof(y)), Register(x, nameof(x)));
+    }
+
+    public int Exp(int x)
+    {
+        return Operation(OpCode.Exp, Register(x, nameof(x)), 0);
+    }
+
+    public int Log(int x)
+    {
+        return Operation(OpCode.Log, Register(x, nameof(x)), 0);
+    }
+
+    public void Store(int output, int register)
+    {
+        CheckIndex(output, maxSlots, nameof(output));
+        CheckIndex(register, maxRegisters, nameof(register));
+        OutputCount = Math.Max(OutputCount, output + 1);
+        Emit(OpCode.Store, output, register, 0);
+    }
+
+    /// <summary>
+    /// <paramref name="inputs"/> holds <see cref="InputCount"/> consecutive rows of
+    /// <paramref name="lanes"/> values, one row per input, and <paramref name="outputs"/>
+    /// likewise holds <see cref="OutputCount"/> rows.
+    /// </summary>
+    public unsafe void Run(dfloat[] inputs, dfloat[] outputs, int lanes)
+    {
+        if (inputs.Length < InputCount * lanes || outputs.Length < OutputCount * lanes)
+            throw new ArgumentException("Input or output buffer is too small for the program.");
+
+        if (words == null)
+            words = code.ToArray();
+
+        fixed (uint* pCode = words)
+        fixed (dfloat* pInputs = inputs, pOutputs = outputs)
+        {
+            int error = dfloat_program_run(pCode, (UIntPtr)words.Length, (uint*)pInputs, (UIntPtr)InputCount, (uint*)pOutputs, (UIntPtr)OutputCount, (UIntPtr)lanes);
+
+            if (error != 0)
+                throw new InvalidOperationException($"Native library rejected dfloat program with error {error}.");
+        }
+    }
+
+    private int NewRegister()
+    {
+        if (registers == maxRegisters)
+            throw new InvalidOperationException($"Programs are limited to {maxRegisters} registers.");
+
+        return registers++;
+    }
+
+    private static void CheckIndex(int index, int count, string name)
+    {
+        if (index < 0 || index >= count)
+            throw new ArgumentOutOfRangeException(name, index, $"Must be from 0 to {count - 1}.");
+    }
+
+    private static int Register(int register, string name)
+    {
+        CheckIndex(register, maxRegisters, name);
+        return register;
+    }
+
+    // Emits op reading a and b, which have been checked, into a new register.
+    private int Operation(OpCode op, int a, int b)
+    {
+        return Emit(op, NewRegister(), a, b);
+    }
+
+    private int Emit(OpCode op, int dst, int a, int b)
+    {
+        code.Add((uint)op | (uint)(byte)dst << 8 | (uint)(byte)a << 16 | (uint)(byte)b << 24);
+        words = null;
+        return dst;
+    }
+}
@@ -0,0 +1,200 @@
+using System;
+using System.Runtime.InteropServices;
+
+/// <summary>
+/// A seeded random number generator that gives the same sequence on every device, runtime
+/// and build, for gameplay code and for generating test inputs. The generator is
+/// xoshiro128**, seeded with SplitMix64, as specified in random.rs:
+/// <code>
+/// var random = new DfloatRandom(seed);
+/// dfloat spread = random.Range(Mathd.FromInt(-1, Mathd.RoundingMode.Truncate), Mathd.FromInt(1, Mathd.RoundingMode.Truncate));
+/// </code>
+/// The fills give the same numbers as the same number of single calls, in order, and
+/// are much cheaper per number.
+/// </summary>
+public class DfloatRandom
+{
+    /// <summary>
+    /// The classes of floats in the corpus of <see cref="FillCorpus"/>, as described in
+    /// corpus.rs. The values match the native class indices.
+    /// </summary>
+    public enum FloatClass
+    {
+        Zero = 0, Denormal = 1, NormalMin = 2, Normal = 3, NearOne = 4, NormalMax = 5, Tie = 6,
+        Infinity = 7, QuietNaN = 8, SignallingNaN = 9, IntegerEdge = 10
+    }
+
+    /// <summary>
+    /// The corpus weights used when none are given, indexed by <see cref="FloatClass"/>.
+    /// </summary>
+    public static readonly int[] DefaultCorpusWeights = { 4, 10, 8, 20, 20, 8, 16, 2, 4, 4, 4 };
+
+    [StructLayout(LayoutKind.Sequential)]
+    private struct State
+    {
+        public uint S0, S1, S2, S3;
+    }
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dfloat_random_seed(State* state, ulong seed);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint dfloat_random_next(State* state);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint dfloat_random_next_unit(State* state);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint dfloat_random_next_range(State* state, uint min, uint max);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dfloat_random_fill(State* state, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dfloat_random_fill_unit(State* state, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dfloat_random_fill_range(State* state, uint* output, UIntPtr length, uint min, uint max);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dfloat_random_fill_corpus(State* state, uint* weights, UIntPtr classes, uint* output, UIntPtr length);
+
+    private State state;
+
+    public unsafe DfloatRandom(ulong seed)
+    {
+        fixed (State* pState = &state)
+        {
+            dfloat_random_seed(pState, seed);
+        }
+    }
+
+    /// <summary>
+    /// The generator's whole state, to save with a game and restore with
+    /// <see cref="SetState"/>, e.g. for rollback.
+    /// </summary>
+    public void GetState(out uint s0, out uint s1, out uint s2, out uint s3)
+    {
+        s0 = state.S0;
+        s1 = state.S1;
+        s2 = state.S2;
+        s3 = state.S3;
+    }
+
+    public void SetState(uint s0, uint s1, uint s2, uint s3)
+    {
+        if ((s0 | s1 | s2 | s3) == 0)
+            throw new ArgumentException("The state cannot be all zero.");
+
+        state = new State { S0 = s0, S1 = s1, S2 = s2, S3 = s3 };
+    }
+
+    /// <summary>
+    /// 32 random bits.
+    /// </summary>
+    public unsafe uint NextUInt()
+    {
+        fixed (State* pState = &state)
+        {
+            return dfloat_random_next(pState);
+        }
+    }
+
+    /// <summary>
+    /// An integer from 0 up to but excluding max, taken from the high bits of
+    /// <see cref="NextUInt"/> times max.
+    /// </summary>
+    public int NextInt(int max)
+    {
+        if (max <= 0)
+            throw new ArgumentOutOfRangeException(nameof(max));
+
+        return (int)((ulong)NextUInt() * (uint)max >> 32);
+    }
+
+    /// <summary>
+    /// A dfloat in [0, 1), a multiple of 2^-24, which is the same whatever the backend and
+    /// modes, as it is built from the bits.
+    /// </summary>
+    public unsafe dfloat NextUnit()
+    {
+        fixed (State* pState = &state)
+        {
+            return new dfloat(dfloat_random_next_unit(pState));
+        }
+    }
+
+    /// <summary>
+    /// <c>min + u * (max - min)</c> for a <see cref="NextUnit"/> u, computed with the native
+    /// operations in the current backend and modes. Rounding can give max.
+    /// </summary>
+    public unsafe dfloat Range(dfloat min, dfloat max)
+    {
+        fixed (State* pState = &state)
+        {
+            return new dfloat(dfloat_random_next_range(pState, min.Bits, max.Bits));
+        }
+    }
+
+    public unsafe void Fill(uint[] output)
+    {
+        fixed (State* pState = &state)
+        fixed (uint* pOutput = output)
+        {
+            dfloat_random_fill(pState, pOutput, (UIntPtr)output.Length);
+        }
+    }
+
+    /// <summary>
+    /// Fills output with <see cref="NextUnit"/> values.
+    /// </summary>
+    public unsafe void FillUnit(dfloat[] output)
+    {
+        fixed (State* pState = &state)
+        fixed (dfloat* pOutput = output)
+        {
+            dfloat_random_fill_unit(pState, (uint*)pOutput, (UIntPtr)output.Length);
+        }
+    }
+
+    /// <summary>
+    /// Fills output with <see cref="Range"/> values.
+    /// </summary>
+    public unsafe void FillRange(dfloat[] output, dfloat min, dfloat max)
+    {
+        fixed (State* pState = &state)
+        fixed (dfloat* pOutput = output)
+        {
+            dfloat_random_fill_range(pState, (uint*)pOutput, (UIntPtr)output.Length, min.Bits, max.Bits);
+        }
+    }
+
+    /// <summary>
+    /// Fills output with test inputs stratified over the <see cref="FloatClass"/> classes,
+    /// each getting its share of output by weight, with a quarter of each class being its
+    /// exact edge cases, in a shuffled order. weights is indexed by <see cref="FloatClass"/>,
+    /// missing classes having weight 0, and is <see cref="DefaultCorpusWeights"/> if null. If
+    /// every weight is 0, output is filled as by <see cref="Fill"/>.
+    /// </summary>
+    public unsafe void FillCorpus(uint[] output, int[] weights = null)
+    {
+        weights = weights ?? DefaultCorpusWeights;
+
+        // An empty array would be passed as null, which means the default weights.
+        if (weights.Length == 0)
+        {
+            Fill(output);
+            return;
+        }
+
+        if (Array.Exists(weights, w => w < 0))
+            throw new ArgumentException("Weights cannot be negative.", nameof(weights));
+
+        fixed (State* pState = &state)
+        fixed (int* pWeights = weights)
+        fixed (uint* pOutput = output)
+        {
+            dfloat_random_fill_corpus(pState, (uint*)pWeights, (UIntPtr)weights.Length, pOutput, (UIntPtr)output.Length);
+        }
+    }
+}
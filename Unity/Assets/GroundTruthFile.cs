@@ -0,0 +1,494 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
+using System.IO.MemoryMappedFiles;
+
+/// <summary>
+/// A versioned binary file of test inputs and results, which is memory mapped and read in place
+/// rather than parsed. On Android, where StreamingAssets are inside the APK, it is first
+/// downloaded to the cache.
+/// <para>
+/// Everything is little-endian. The header is "DFGT", the u32 <see cref="Version"/>, the u64
+/// counts of float and double tests, the u32 number of sections and a reserved u32, followed by
+/// an entry for each section: u32 <see cref="SectionId"/>, u32 <see cref="SectionEncoding"/>,
+/// u32 id of its reference section, u32 CRC-32, u64 number of words, u64 offset and u64 stored
+/// length. Each section's data starts at an offset that is a multiple of 8.
+/// </para>
+/// <para>
+/// A section is an array of u32 words, 64-bit results being two words, low first. The CRC-32
+/// is of those words' bytes before encoding. <see cref="SectionEncoding.XorReference"/> stores
+/// each word XORed with the same word of an earlier section, which turns the native results,
+/// nearly all equal to the C# ones, into mostly zeros, and <see cref="SectionEncoding.Deflate"/>
+/// compresses the section. Raw sections are read in place, and their checksums checked
+/// when the file is opened. Encoded ones are decoded as they are read, a chunk at a time
+/// (see <see cref="SectionReader"/>), so the memory used doesn't grow with their size.
+/// </para>
+/// </summary>
+public sealed unsafe class GroundTruthFile : IDisposable
+{
+    public const uint Version = 1;
+
+    public enum SectionId : uint { Layout = 1, Inputs = 2, FloatResults = 3, DfloatResults = 4, DoubleResults = 5, DdoubleResults = 6 }
+
+    [Flags]
+    public enum SectionEncoding : uint { Raw = 0, XorReference = 1, Deflate = 2 }
+
+    private const uint noReference = 0xffffffff;
+    private const int headerSize = 32;
+    private const int entrySize = 40;
+
+    /// <summary>
+    /// A raw section's words, in place, valid until the file is disposed.
+    /// </summary>
+    public readonly struct Words
+    {
+        private readonly uint* words;
+
+        public readonly long Count;
+
+        public Words(uint* words, long count)
+        {
+            this.words = words;
+            Count = count;
+        }
+
+        public uint this[long index] => (ulong)index < (ulong)Count ? words[index] : throw new IndexOutOfRangeException();
+
+        public uint* Pointer => words;
+    }
+
+    /// <summary>
+    /// A section to write, read from a stream of its little-endian words.
+    /// </summary>
+    public struct Source
+    {
+        public SectionId Id;
+        public SectionEncoding Encoding;
+        public SectionId Reference;
+        public Func<Stream> Open;
+    }
+
+    private struct Entry
+    {
+        public SectionEncoding Encoding;
+        public SectionId Reference;
+        public uint Crc;
+        public long Count, Offset, Stored;
+    }
+
+    public long Tests { get; }
+
+    public long DoubleTests { get; }
+
+    private readonly byte* data;
+
+    private readonly Dictionary<SectionId, Entry> sections = new Dictionary<SectionId, Entry>();
+
+    private MemoryMappedFile mappedFile;
+    private MemoryMappedViewAccessor view;
+
+    /// <summary>
+    /// Maps the file at <paramref name="path"/> into memory.
+    /// </summary>
+    public static GroundTruthFile Open(string path)
+    {
+        long length = new FileInfo(path).Length;
+
+        if (length < headerSize)
+            throw new InvalidDataException("File too short.");
+
+        MemoryMappedFile file = MemoryMappedFile.CreateFromFile(path, FileMode.Open, null, 0, MemoryMappedFileAccess.Read);
+        MemoryMappedViewAccessor view = null;
+        byte* pointer = null;
+
+        try
+        {
+            view = file.CreateViewAccessor(0, 0, MemoryMappedFileAccess.Read);
+            view.SafeMemoryMappedViewHandle.AcquirePointer(ref pointer);
+        }
+        catch
+        {
+            if (pointer != null)
+                view.SafeMemoryMappedViewHandle.ReleasePointer();
+
+            view?.Dispose();
+            file.Dispose();
+            throw;
+        }
+
+        // Disposes the mapping itself if the file is invalid.
+        return new GroundTruthFile(pointer + view.PointerOffset, length, file, view);
+    }
+
+    private GroundTruthFile(byte* data, long length, MemoryMappedFile mappedFile, MemoryMappedViewAccessor view)
+    {
+        this.data = data;
+        this.mappedFile = mappedFile;
+        this.view = view;
+
+        try
+        {
+            if (length < headerSize || data[0] != 'D' || data[1] != 'F' || data[2] != 'G' || data[3] != 'T')
+                throw new InvalidDataException("Not a ground truth file.");
+
+            uint version = ReadUInt32(data + 4);
+
+            if (version != Version)
+                throw new InvalidDataException($"Unsupported version {version}.");
+
+            Tests = (long)ReadUInt64(data + 8);
+            DoubleTests = (long)ReadUInt64(data + 16);
+            uint count = ReadUInt32(data + 24);
+
+            if (headerSize + (long)count * entrySize > length)
+                throw new InvalidDataException("Truncated section table.");
+
+            for (uint i = 0; i < count; i++)
+            {
+                ReadSection(data, length, data + headerSize + i * entrySize);
+            }
+        }
+        catch
+        {
+            Dispose();
+            throw;
+        }
+    }
+
+    private void ReadSection(byte* data, long length, byte* table)
+    {
+        var id = (SectionId)ReadUInt32(table);
+        var encoding = (SectionEncoding)ReadUInt32(table + 4);
+        var reference = (SectionId)ReadUInt32(table + 8);
+        uint crc = ReadUInt32(table + 12);
+        ulong count = ReadUInt64(table + 16);
+        ulong offset = ReadUInt64(table + 24);
+        ulong stored = ReadUInt64(table + 32);
+
+        if (offset > (ulong)length || stored > (ulong)length - offset || (encoding & ~(SectionEncoding.XorReference | SectionEncoding.Deflate)) != 0)
+            throw new InvalidDataException($"Invalid section {id}.");
+
+        if (sections.ContainsKey(id))
+            throw new InvalidDataException($"Duplicate section {id}.");
+
+        if ((encoding & SectionEncoding.XorReference) != 0 && (!sections.TryGetValue(reference, out Entry referenced) || referenced.Count != (long)count))
+            throw new InvalidDataException($"Section {id} needs a section {reference} of the same length before it.");
+
+        var entry = new Entry { Encoding = encoding, Reference = reference, Crc = crc, Count = (long)count, Offset = (long)offset, Stored = (long)stored };
+
+        if (encoding == SectionEncoding.Raw)
+        {
+            if (stored % 4 != 0 || stored / 4 != count || offset % 4 != 0)
+                throw new InvalidDataException($"Invalid section {id}.");
+
+            if (BitConverter.IsLittleEndian && Crc32(new Words((uint*)(data + offset), (long)count)) != crc)
+                throw new InvalidDataException($"Checksum mismatch in section {id}.");
+        }
+
+        sections.Add(id, entry);
+    }
+
+    public bool HasSection(SectionId id)
+    {
+        return sections.ContainsKey(id);
+    }
+
+    /// <summary>
+    /// Number of words in a section.
+    /// </summary>
+    public long SectionLength(SectionId id)
+    {
+        return sections[id].Count;
+    }
+
+    /// <summary>
+    /// The words of a raw section, in place. Returns false if there is no such section or it
+    /// is encoded, in which case it can only be read with <see cref="OpenReader"/>.
+    /// </summary>
+    public bool TryGetSection(SectionId id, out Words words)
+    {
+        words = default(Words);
+
+        if (!sections.TryGetValue(id, out Entry entry) || entry.Encoding != SectionEncoding.Raw || !BitConverter.IsLittleEndian)
+            return false;
+
+        words = new Words((uint*)(data + entry.Offset), entry.Count);
+        return true;
+    }
+
+    /// <summary>
+    /// Reads a section's words in order, in place if it is raw, otherwise decoding it in
+    /// chunks of <paramref name="chunkSize"/> bytes on a worker thread, one chunk ahead of the
+    /// reader (see <see cref="ReadAheadStream"/>).
+    /// </summary>
+    public IResultReader OpenReader(SectionId id, int chunkSize = 1 << 16)
+    {
+        if (TryGetSection(id, out Words words))
+            return new BinaryResultReader(words);
+
+        if (!sections.TryGetValue(id, out Entry entry))
+            throw new KeyNotFoundException($"No section {id}.");
+
+        Stream stream = new UnmanagedMemoryStream(data + entry.Offset, entry.Stored);
+
+        if ((entry.Encoding & SectionEncoding.Deflate) != 0)
+            stream = new DeflateStream(stream, CompressionMode.Decompress);
+
+        IResultReader reference = (entry.Encoding & SectionEncoding.XorReference) != 0 ? OpenReader(entry.Reference, chunkSize) : null;
+
+        return new SectionReader(id, new ReadAheadStream(stream, chunkSize), reference, entry.Count, entry.Crc);
+    }
+
+    /// <summary>
+    /// Reads an encoded section, checking its checksum once all of it has been read.
+    /// </summary>
+    public sealed class SectionReader : IResultReader
+    {
+        public SectionId Id { get; }
+
+        private readonly BinaryReader words;
+        private readonly IResultReader reference;
+        private readonly long count;
+        private readonly uint expectedCrc;
+
+        private long position;
+        private uint crc = 0xffffffff;
+
+        internal SectionReader(SectionId id, Stream stream, IResultReader reference, long count, uint expectedCrc)
+        {
+            Id = id;
+            words = new BinaryReader(stream);
+            this.reference = reference;
+            this.count = count;
+            this.expectedCrc = expectedCrc;
+        }
+
+        /// <summary>
+        /// False until the whole section has been read, and then whether its checksum matched.
+        /// </summary>
+        public bool ChecksumMatches => position == count && ~crc == expectedCrc;
+
+        public uint ReadUInt32()
+        {
+            if (position >= count)
+                throw new EndOfStreamException("More results read than the ground truth has.");
+
+            uint word;
+
+            try
+            {
+                word = words.ReadUInt32();
+            }
+            catch (EndOfStreamException)
+            {
+                // The header gave the decoded length, so the data must be damaged.
+                throw new InvalidDataException($"Section {Id} ends early.");
+            }
+            catch (InvalidDataException e)
+            {
+                // From the decompressor.
+                throw new InvalidDataException($"Section {Id} is corrupt: {e.Message}", e);
+            }
+
+            if (reference != null)
+                word ^= reference.ReadUInt32();
+
+            crc = Crc32(crc, word);
+            position++;
+
+            return word;
+        }
+
+        public ulong ReadUInt64()
+        {
+            return ReadUInt32() | (ulong)ReadUInt32() << 32;
+        }
+
+        public void Dispose()
+        {
+            words.Dispose();
+            reference?.Dispose();
+        }
+    }
+
+    public void Dispose()
+    {
+        if (view != null)
+        {
+            view.SafeMemoryMappedViewHandle.ReleasePointer();
+            view.Dispose();
+            view = null;
+        }
+
+        mappedFile?.Dispose();
+        mappedFile = null;
+    }
+
+    /// <summary>
+    /// Writes a file with the given sections, in order; a section can only reference one
+    /// before it. Returns the file's length.
+    /// </summary>
+    public static long Write(string path, long tests, long doubleTests, IList<Source> sources)
+    {
+        using (var file = new FileStream(path, FileMode.Create, FileAccess.Write))
+        using (var output = new BinaryWriter(file))
+        {
+            file.Position = Align(headerSize + sources.Count * entrySize);
+
+            var entries = new List<(uint crc, long count, long offset, long stored)>();
+
+            for (int i = 0; i < sources.Count; i++)
+            {
+                Source source = sources[i];
+                int referenceIndex = -1;
+
+                if ((source.Encoding & SectionEncoding.XorReference) != 0)
+                {
+                    for (int j = 0; j < i; j++)
+                    {
+                        if (sources[j].Id == source.Reference)
+                            referenceIndex = j;
+                    }
+
+                    if (referenceIndex < 0)
+                        throw new ArgumentException($"Section {source.Id} references {source.Reference}, which is not before it.");
+                }
+
+                long offset = file.Position;
+                uint crc = 0xffffffff;
+                long count;
+
+                Stream target = (source.Encoding & SectionEncoding.Deflate) != 0 ? new DeflateStream(file, CompressionLevel.Optimal, true) : (Stream)new NonClosingStream(file);
+
+                using (var words = new BinaryReader(source.Open()))
+                using (var referenceWords = referenceIndex >= 0 ? new BinaryReader(sources[referenceIndex].Open()) : null)
+                using (var writer = new BinaryWriter(target))
+                {
+                    count = words.BaseStream.Length / 4;
+
+                    if (referenceWords != null && referenceWords.BaseStream.Length / 4 != count)
+                        throw new ArgumentException($"Section {source.Id} is not the same length as {source.Reference}.");
+
+                    for (long j = 0; j < count; j++)
+                    {
+                        uint word = words.ReadUInt32();
+                        crc = Crc32(crc, word);
+                        writer.Write(referenceWords != null ? word ^ referenceWords.ReadUInt32() : word);
+                    }
+                }
+
+                entries.Add((~crc, count, offset, file.Position - offset));
+                file.Position = Align(file.Position);
+            }
+
+            long length = file.Position;
+            file.SetLength(length);
+            file.Position = 0;
+
+            output.Write(new[] { (byte)'D', (byte)'F', (byte)'G', (byte)'T' });
+            output.Write(Version);
+            output.Write((ulong)tests);
+            output.Write((ulong)doubleTests);
+            output.Write((uint)sources.Count);
+            output.Write(0u);
+
+            for (int i = 0; i < sources.Count; i++)
+            {
+                output.Write((uint)sources[i].Id);
+                output.Write((uint)sources[i].Encoding);
+                output.Write((sources[i].Encoding & SectionEncoding.XorReference) != 0 ? (uint)sources[i].Reference : noReference);
+                output.Write(entries[i].crc);
+                output.Write((ulong)entries[i].count);
+                output.Write((ulong)entries[i].offset);
+                output.Write((ulong)entries[i].stored);
+            }
+
+            return length;
+        }
+    }
+
+    /// <summary>
+    /// Lets a section be written to the file through a BinaryWriter without it closing the file.
+    /// </summary>
+    private sealed class NonClosingStream : Stream
+    {
+        private readonly Stream inner;
+
+        public NonClosingStream(Stream inner)
+        {
+            this.inner = inner;
+        }
+
+        public override bool CanRead => false;
+        public override bool CanSeek => false;
+        public override bool CanWrite => true;
+        public override long Length => throw new NotSupportedException();
+        public override long Position { get => throw new NotSupportedException(); set => throw new NotSupportedException(); }
+
+        public override void Flush() => inner.Flush();
+        public override int Read(byte[] buffer, int offset, int count) => throw new NotSupportedException();
+        public override long Seek(long offset, SeekOrigin origin) => throw new NotSupportedException();
+        public override void SetLength(long value) => throw new NotSupportedException();
+        public override void Write(byte[] buffer, int offset, int count) => inner.Write(buffer, offset, count);
+    }
+
+    private static long Align(long offset)
+    {
+        return (offset + 7) & ~7L;
+    }
+
+    private static uint ReadUInt32(byte* p)
+    {
+        return p[0] | (uint)p[1] << 8 | (uint)p[2] << 16 | (uint)p[3] << 24;
+    }
+
+    private static ulong ReadUInt64(byte* p)
+    {
+        return ReadUInt32(p) | (ulong)ReadUInt32(p + 4) << 32;
+    }
+
+    private static readonly uint[] crcTable = CrcTable();
+
+    private static uint[] CrcTable()
+    {
+        var table = new uint[256];
+
+        for (uint i = 0; i < 256; i++)
+        {
+            uint c = i;
+
+            for (int k = 0; k < 8; k++)
+            {
+                c = (c & 1) != 0 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            }
+
+            table[i] = c;
+        }
+
+        return table;
+    }
+
+    private static uint Crc32(uint crc, uint word)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            crc = crcTable[(crc ^ word) & 0xff] ^ (crc >> 8);
+            word >>= 8;
+        }
+
+        return crc;
+    }
+
+    private static uint Crc32(Words words)
+    {
+        uint crc = 0xffffffff;
+
+        for (long i = 0; i < words.Count; i++)
+        {
+            crc = Crc32(crc, words[i]);
+        }
+
+        return ~crc;
+    }
+}
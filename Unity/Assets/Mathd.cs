@@ -1,7 +1,159 @@
+using System;
 using System.Runtime.InteropServices;
 
 public static class Mathd
 {
+    /// <summary>
+    /// The arithmetic used by the native library. <see cref="Soft"/> computes results
+    /// using only integer operations, so does not depend on the device's FPU (for example,
+    /// its denormal handling). On x86 both give identical results.
+    /// </summary>
+    public enum Backend : uint { Hardware = 0, Soft = 1 }
+
+    /// <summary>
+    /// Whether the native library handles denormals exactly, or flushes them to zero: denormal
+    /// inputs are read as zero of the same sign, and denormal results are replaced by zero of
+    /// the same sign. Flushing is defined in software, so it gives the same results on every
+    /// platform, and avoids the slow path x86 CPUs take for denormals.
+    /// </summary>
+    public enum DenormalMode : uint { Preserve = 0, Flush = 1 }
+
+    /// <summary>
+    /// Whether the native library returns NaN results as the arithmetic produces them, or
+    /// replaces every one with the same NaN (0xffc00000, or 0xfff8000000000000 for ddouble).
+    /// Which NaN operand an operation passes on depends on the platform and on the order the
+    /// compiler puts commutative operands in, so only canonical NaNs can be compared or hashed
+    /// bit for bit.
+    /// </summary>
+    public enum NaNMode : uint { Preserve = 0, Canonical = 1 }
+
+    /// <summary>
+    /// The flush flags of the FPU's control register (MXCSR on x86, FPCR on ARM64, which has a
+    /// single bit for both). These only change the <see cref="Backend.Hardware"/> backend, and
+    /// C# arithmetic on the same thread, and what they do differs between platforms; use
+    /// <see cref="DenormalMode.Flush"/> for flushing that is the same everywhere.
+    /// </summary>
+    [Flags]
+    public enum FpuFlags : uint { None = 0, FlushToZero = 1, DenormalsAreZero = 2 }
+
+    /// <summary>
+    /// Sets the FPU's default state (round to nearest, exceptions masked) with the given flush
+    /// flags on the current thread, and restores the previous state when disposed:
+    /// <code>using (new Mathd.FpuScope(Mathd.FpuFlags.None)) { Mathd.Add(a, b, output); }</code>
+    /// </summary>
+    public struct FpuScope : IDisposable
+    {
+        private readonly ulong saved;
+
+        public FpuScope(FpuFlags flags)
+        {
+            saved = dfloat_fpu_set_default((uint)flags);
+        }
+
+        public void Dispose()
+        {
+            dfloat_fpu_set_state(saved);
+        }
+    }
+
+    /// <summary>
+    /// The instruction set the batched operations are compiled for. The widest one the
+    /// CPU supports is selected automatically; all of them must give the same bits, apart from
+    /// NaN payloads with <see cref="NaNMode.Preserve"/>, which <see cref="RunDispatchSelfTest"/> checks.
+    /// </summary>
+    public enum KernelVariant : uint { Scalar = 0, Sse2 = 1, Avx2 = 2, Avx512 = 3, Neon = 4 }
+
+    /// <summary>
+    /// How conversions between dfloat and integers round: toward zero, to nearest with
+    /// ties to even, or toward negative infinity.
+    /// </summary>
+    public enum RoundingMode : uint { Truncate = 0, HalfEven = 1, Floor = 2 }
+
+    /// <summary>
+    /// The basic operations, for <see cref="Oracle(BasicOp, dfloat, dfloat)"/>. The values
+    /// match <see cref="SelfTestFailure.Op"/>.
+    /// </summary>
+    public enum BasicOp : uint { Add = 0, Sub = 1, Mul = 2, Div = 3 }
+
+    /// <summary>
+    /// Options of <see cref="Hash(dfloat[], HashFlags, ulong)"/>. With
+    /// <see cref="CanonicalNaNs"/> every NaN is hashed as the canonical NaN of
+    /// <see cref="NaNMode.Canonical"/>, so states that differ only in NaN payloads hash the same.
+    /// </summary>
+    [Flags]
+    public enum HashFlags : uint { None = 0, CanonicalNaNs = 1 }
+
+    /// <summary>
+    /// A batched result from <see cref="RunDispatchSelfTest"/> that differed from the scalar
+    /// operation. <see cref="Op"/> is 0 to 3 for add, sub, mul and div. If
+    /// <see cref="Expected"/> is 0xdeadbeef the kernel wrote outside its output.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SelfTestFailure
+    {
+        public KernelVariant Variant;
+        public Backend Backend;
+        public DenormalMode Denormals;
+        public NaNMode NaNs;
+        public uint Op;
+        public uint Index;
+        public uint A;
+        public uint B;
+        public uint Expected;
+        public uint Actual;
+    }
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_set_backend(uint backend);
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_get_backend();
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_set_denormal_mode(uint mode);
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_get_denormal_mode();
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_set_nan_mode(uint mode);
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_get_nan_mode();
+
+    [DllImport("unity_rust")]
+    private static extern ulong dfloat_fpu_get_state();
+
+    [DllImport("unity_rust")]
+    private static extern ulong dfloat_fpu_set_state(ulong state);
+
+    [DllImport("unity_rust")]
+    private static extern ulong dfloat_fpu_set_default(uint flags);
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_fpu_get_flags();
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_dispatch_variant();
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_dispatch_supported();
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_set_dispatch_variant(uint variant);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe UIntPtr dfloat_dispatch_self_test(SelfTestFailure* report, UIntPtr capacity, UIntPtr* nanPayloads);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_oracle(uint op, uint a, uint b);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_oracle_batch(uint op, uint* a, uint* b, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe UIntPtr float_oracle_check(uint op, uint* a, uint* b, UIntPtr length, uint* mismatches, UIntPtr capacity);
+
     [DllImport("unity_rust")]
     private static extern uint float_add(uint a, uint b);
 
@@ -14,6 +166,379 @@ public static class Mathd
     [DllImport("unity_rust")]
     private static extern uint float_div(uint a, uint b);
 
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_add_batch(uint* a, uint* b, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_sub_batch(uint* a, uint* b, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_mul_batch(uint* a, uint* b, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_div_batch(uint* a, uint* b, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern ulong double_add(ulong a, ulong b);
+
+    [DllImport("unity_rust")]
+    private static extern ulong double_sub(ulong a, ulong b);
+
+    [DllImport("unity_rust")]
+    private static extern ulong double_mul(ulong a, ulong b);
+
+    [DllImport("unity_rust")]
+    private static extern ulong double_div(ulong a, ulong b);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void double_add_batch(ulong* a, ulong* b, ulong* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void double_sub_batch(ulong* a, ulong* b, ulong* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void double_mul_batch(ulong* a, ulong* b, ulong* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void double_div_batch(ulong* a, ulong* b, ulong* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint dvec2_dot(dvec2* a, dvec2* b);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint dvec3_dot(dvec3* a, dvec3* b);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint dvec4_dot(dvec4* a, dvec4* b);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec3_cross(dvec3* a, dvec3* b, dvec3* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec2_normalize(dvec2* v, dvec2* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec3_normalize(dvec3* v, dvec3* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec4_normalize(dvec4* v, dvec4* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dquat_mul(dquat* a, dquat* b, dquat* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dquat_rotate(dquat* q, dvec3* v, dvec3* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec2_dot_batch(uint* a, uint* b, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec3_dot_batch(uint* a, uint* b, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec4_dot_batch(uint* a, uint* b, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec3_cross_batch(uint* a, uint* b, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec2_normalize_batch(uint* v, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec3_normalize_batch(uint* v, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dvec4_normalize_batch(uint* v, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dquat_mul_batch(uint* a, uint* b, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dquat_rotate_batch(uint* q, uint* v, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_mul(dmat4* a, dmat4* b, dmat4* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_transform_point(dmat4* m, dvec3* p, dvec3* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_transform_vector(dmat4* m, dvec3* v, dvec3* output);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_mul_batch(dmat4* a, dmat4* b, dmat4* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_mul_batch_soa(uint* a, uint* b, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_transform_points(dmat4* m, dvec3* p, dvec3* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_transform_points_soa(dmat4* m, uint* p, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_transform_vectors(dmat4* m, dvec3* v, dvec3* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void dmat4_transform_vectors_soa(dmat4* m, uint* v, uint* output, UIntPtr count);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint float_sum(uint* x, UIntPtr length, UIntPtr threads);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint float_dot(uint* a, uint* b, UIntPtr length, UIntPtr threads);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint float_min(uint* x, UIntPtr length, UIntPtr threads);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe uint float_max(uint* x, UIntPtr length, UIntPtr threads);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe ulong dfloat_hash(uint* x, UIntPtr length, HashFlags flags, ulong seed);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe ulong ddouble_hash(ulong* x, UIntPtr length, HashFlags flags, ulong seed);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe ulong dfloat_hash_combine(ulong* hashes, UIntPtr count, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern void dfloat_trace_start(UIntPtr capacity);
+
+    [DllImport("unity_rust")]
+    private static extern void dfloat_trace_stop();
+
+    [DllImport("unity_rust")]
+    private static extern uint dfloat_trace_active();
+
+    [DllImport("unity_rust")]
+    private static extern unsafe long dfloat_trace_dump(byte* path, UIntPtr pathLength);
+
+    [DllImport("unity_rust")]
+    private static extern int float_to_i32(uint x, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_to_u32(uint x, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern long float_to_i64(uint x, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_from_i32(int x, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_from_u32(uint x, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_from_i64(long x, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_to_i32_batch(uint* x, int* output, UIntPtr length, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_to_u32_batch(uint* x, uint* output, UIntPtr length, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_to_i64_batch(uint* x, long* output, UIntPtr length, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_from_i32_batch(int* x, uint* output, UIntPtr length, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_from_u32_batch(uint* x, uint* output, UIntPtr length, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_from_i64_batch(long* x, uint* output, UIntPtr length, RoundingMode mode);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_sqrt(uint x);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_sin(uint x);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_cos(uint x);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_atan2(uint y, uint x);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_exp(uint x);
+
+    [DllImport("unity_rust")]
+    private static extern uint float_log(uint x);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_sqrt_batch(uint* x, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_sin_batch(uint* x, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_cos_batch(uint* x, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_atan2_batch(uint* y, uint* x, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_exp_batch(uint* x, uint* output, UIntPtr length);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe void float_log_batch(uint* x, uint* output, UIntPtr length);
+
+    /// <summary>
+    /// Selects the backend for all subsequent native operations, and returns the previous one.
+    /// </summary>
+    public static Backend SetBackend(Backend backend)
+    {
+        return (Backend)dfloat_set_backend((uint)backend);
+    }
+
+    public static Backend GetBackend()
+    {
+        return (Backend)dfloat_get_backend();
+    }
+
+    /// <summary>
+    /// Selects whether all subsequent native operations flush denormals, and returns the
+    /// previous mode.
+    /// </summary>
+    public static DenormalMode SetDenormalMode(DenormalMode mode)
+    {
+        return (DenormalMode)dfloat_set_denormal_mode((uint)mode);
+    }
+
+    public static DenormalMode GetDenormalMode()
+    {
+        return (DenormalMode)dfloat_get_denormal_mode();
+    }
+
+    /// <summary>
+    /// Selects whether all subsequent native operations canonicalize NaN results, and returns
+    /// the previous mode.
+    /// </summary>
+    public static NaNMode SetNaNMode(NaNMode mode)
+    {
+        return (NaNMode)dfloat_set_nan_mode((uint)mode);
+    }
+
+    public static NaNMode GetNaNMode()
+    {
+        return (NaNMode)dfloat_get_nan_mode();
+    }
+
+    /// <summary>
+    /// The whole FPU control register of the current thread, to restore later with
+    /// <see cref="SetFpuState"/>. Always 0 on platforms without one the library knows.
+    /// </summary>
+    public static ulong GetFpuState()
+    {
+        return dfloat_fpu_get_state();
+    }
+
+    /// <summary>
+    /// Restores a state returned by <see cref="GetFpuState"/> or <see cref="SetFpuDefault"/>,
+    /// and returns the current one.
+    /// </summary>
+    public static ulong SetFpuState(ulong state)
+    {
+        return dfloat_fpu_set_state(state);
+    }
+
+    /// <summary>
+    /// Sets the FPU's default state with the given flush flags, and returns the previous state.
+    /// </summary>
+    public static ulong SetFpuDefault(FpuFlags flags)
+    {
+        return dfloat_fpu_set_default((uint)flags);
+    }
+
+    public static FpuFlags GetFpuFlags()
+    {
+        return (FpuFlags)dfloat_fpu_get_flags();
+    }
+
+    public static KernelVariant GetKernelVariant()
+    {
+        return (KernelVariant)dfloat_dispatch_variant();
+    }
+
+    public static bool IsKernelVariantSupported(KernelVariant variant)
+    {
+        return (dfloat_dispatch_supported() & (1u << (int)variant)) != 0;
+    }
+
+    /// <summary>
+    /// Forces the batched operations to use the given variant, and returns the previous one.
+    /// Variants the CPU does not support are ignored.
+    /// </summary>
+    public static KernelVariant SetKernelVariant(KernelVariant variant)
+    {
+        return (KernelVariant)dfloat_set_dispatch_variant((uint)variant);
+    }
+
+    /// <summary>
+    /// Runs every supported kernel variant, for both backends, denormal modes and NaN modes,
+    /// over all pairs of a matrix of special values (zeros, denormals, normals, infinities and
+    /// NaNs) at several lengths and alignments, comparing against the scalar operations.
+    /// Results are compared bit for bit. Returns the total number of differences, and fills
+    /// failures with up to its length of them. With <see cref="NaNMode.Preserve"/>, a NaN result
+    /// whose payload differs from the scalar operation's is not counted as a difference, as
+    /// which NaN operand the FPU propagates depends on operand order; those are counted in
+    /// <paramref name="nanPayloadDifferences"/> instead.
+    /// </summary>
+    public static unsafe long RunDispatchSelfTest(SelfTestFailure[] failures, out long nanPayloadDifferences)
+    {
+        UIntPtr payloads;
+
+        fixed (SelfTestFailure* report = failures)
+        {
+            long count = (long)dfloat_dispatch_self_test(report, (UIntPtr)failures.Length, &payloads);
+            nanPayloadDifferences = (long)payloads;
+            return count;
+        }
+    }
+
+    /// <summary>
+    /// The correctly rounded result of op, computed with integer arithmetic independently of
+    /// either backend, in the current denormal and NaN modes (see oracle.rs). Devices can
+    /// check their results against it instead of against ground truth files.
+    /// </summary>
+    public static dfloat Oracle(BasicOp op, dfloat a, dfloat b)
+    {
+        return new dfloat(float_oracle((uint)op, a.Bits, b.Bits));
+    }
+
+    public static unsafe void Oracle(BasicOp op, dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            float_oracle_batch((uint)op, (uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    /// <summary>
+    /// Checks the current backend's scalar and batched op on each pair of a and b against
+    /// <see cref="Oracle(BasicOp, dfloat, dfloat)"/> in a single native call. Returns the
+    /// number of pairs where either differs, and fills mismatches with up to its length of
+    /// their indices. Unless NaNs are canonical, any two NaNs are considered equal.
+    /// </summary>
+    public static unsafe long CheckAgainstOracle(BasicOp op, dfloat[] a, dfloat[] b, int[] mismatches)
+    {
+        if (a.Length != b.Length)
+            throw new ArgumentException("Operands must have the same length.");
+
+        fixed (dfloat* pa = a, pb = b)
+        fixed (int* pMismatches = mismatches)
+        {
+            return (long)float_oracle_check((uint)op, (uint*)pa, (uint*)pb, (UIntPtr)a.Length, (uint*)pMismatches, (UIntPtr)mismatches.Length);
+        }
+    }
+
     public static dfloat Add(dfloat a, dfloat b)
     {
         uint bits = float_add(a.Bits, b.Bits);
@@ -37,4 +562,834 @@ public static class Mathd
         uint bits = float_div(a.Bits, b.Bits);
         return new dfloat(bits);
     }
+
+    /// <summary>
+    /// Conversions to integers saturate: values beyond the integer's range, including
+    /// infinities, give its minimum or maximum, and NaN gives 0. Unlike C# casts, the
+    /// results are the same on every platform.
+    /// </summary>
+    public static int ToInt(dfloat x, RoundingMode mode)
+    {
+        return float_to_i32(x.Bits, mode);
+    }
+
+    public static uint ToUInt(dfloat x, RoundingMode mode)
+    {
+        return float_to_u32(x.Bits, mode);
+    }
+
+    public static long ToLong(dfloat x, RoundingMode mode)
+    {
+        return float_to_i64(x.Bits, mode);
+    }
+
+    /// <summary>
+    /// Integers with more than 24 significant bits are rounded with mode.
+    /// </summary>
+    public static dfloat FromInt(int x, RoundingMode mode)
+    {
+        return new dfloat(float_from_i32(x, mode));
+    }
+
+    public static dfloat FromUInt(uint x, RoundingMode mode)
+    {
+        return new dfloat(float_from_u32(x, mode));
+    }
+
+    public static dfloat FromLong(long x, RoundingMode mode)
+    {
+        return new dfloat(float_from_i64(x, mode));
+    }
+
+    /// <summary>
+    /// Elementary functions are evaluated in software from the basic operations with a
+    /// fixed order, so they are as deterministic as <see cref="Add"/> etc. <see cref="Sqrt"/>
+    /// is correctly rounded; the others are accurate to a few ulp.
+    /// </summary>
+    public static dfloat Sqrt(dfloat x)
+    {
+        uint bits = float_sqrt(x.Bits);
+        return new dfloat(bits);
+    }
+
+    public static dfloat Sin(dfloat x)
+    {
+        uint bits = float_sin(x.Bits);
+        return new dfloat(bits);
+    }
+
+    public static dfloat Cos(dfloat x)
+    {
+        uint bits = float_cos(x.Bits);
+        return new dfloat(bits);
+    }
+
+    public static dfloat Atan2(dfloat y, dfloat x)
+    {
+        uint bits = float_atan2(y.Bits, x.Bits);
+        return new dfloat(bits);
+    }
+
+    public static dfloat Exp(dfloat x)
+    {
+        uint bits = float_exp(x.Bits);
+        return new dfloat(bits);
+    }
+
+    public static dfloat Log(dfloat x)
+    {
+        uint bits = float_log(x.Bits);
+        return new dfloat(bits);
+    }
+
+    /// <summary>
+    /// Batched operations perform a single native call for the whole array, and give
+    /// bit-identical results to calling the scalar operation on each element.
+    /// <paramref name="output"/> may be the same array as <paramref name="a"/> or <paramref name="b"/>.
+    /// </summary>
+    public static unsafe void Add(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            float_add_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    public static unsafe void Sub(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            float_sub_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    public static unsafe void Mul(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            float_mul_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    public static unsafe void Div(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            float_div_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    public static unsafe void Add(dfloat* a, dfloat* b, dfloat* output, int length)
+    {
+        float_add_batch((uint*)a, (uint*)b, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Sub(dfloat* a, dfloat* b, dfloat* output, int length)
+    {
+        float_sub_batch((uint*)a, (uint*)b, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Mul(dfloat* a, dfloat* b, dfloat* output, int length)
+    {
+        float_mul_batch((uint*)a, (uint*)b, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Div(dfloat* a, dfloat* b, dfloat* output, int length)
+    {
+        float_div_batch((uint*)a, (uint*)b, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Sqrt(dfloat[] x, dfloat[] output)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (dfloat* px = x, pOutput = output)
+        {
+            float_sqrt_batch((uint*)px, (uint*)pOutput, (UIntPtr)x.Length);
+        }
+    }
+
+    public static unsafe void Sin(dfloat[] x, dfloat[] output)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (dfloat* px = x, pOutput = output)
+        {
+            float_sin_batch((uint*)px, (uint*)pOutput, (UIntPtr)x.Length);
+        }
+    }
+
+    public static unsafe void Cos(dfloat[] x, dfloat[] output)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (dfloat* px = x, pOutput = output)
+        {
+            float_cos_batch((uint*)px, (uint*)pOutput, (UIntPtr)x.Length);
+        }
+    }
+
+    public static unsafe void Atan2(dfloat[] y, dfloat[] x, dfloat[] output)
+    {
+        CheckBatchLengths(y, x, output);
+
+        fixed (dfloat* py = y, px = x, pOutput = output)
+        {
+            float_atan2_batch((uint*)py, (uint*)px, (uint*)pOutput, (UIntPtr)y.Length);
+        }
+    }
+
+    public static unsafe void Exp(dfloat[] x, dfloat[] output)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (dfloat* px = x, pOutput = output)
+        {
+            float_exp_batch((uint*)px, (uint*)pOutput, (UIntPtr)x.Length);
+        }
+    }
+
+    public static unsafe void Log(dfloat[] x, dfloat[] output)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (dfloat* px = x, pOutput = output)
+        {
+            float_log_batch((uint*)px, (uint*)pOutput, (UIntPtr)x.Length);
+        }
+    }
+
+    public static unsafe void ToInt(dfloat[] x, int[] output, RoundingMode mode)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (dfloat* px = x)
+        fixed (int* pOutput = output)
+        {
+            float_to_i32_batch((uint*)px, pOutput, (UIntPtr)x.Length, mode);
+        }
+    }
+
+    public static unsafe void ToUInt(dfloat[] x, uint[] output, RoundingMode mode)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (dfloat* px = x)
+        fixed (uint* pOutput = output)
+        {
+            float_to_u32_batch((uint*)px, pOutput, (UIntPtr)x.Length, mode);
+        }
+    }
+
+    public static unsafe void ToLong(dfloat[] x, long[] output, RoundingMode mode)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (dfloat* px = x)
+        fixed (long* pOutput = output)
+        {
+            float_to_i64_batch((uint*)px, pOutput, (UIntPtr)x.Length, mode);
+        }
+    }
+
+    public static unsafe void FromInt(int[] x, dfloat[] output, RoundingMode mode)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (int* px = x)
+        fixed (dfloat* pOutput = output)
+        {
+            float_from_i32_batch(px, (uint*)pOutput, (UIntPtr)x.Length, mode);
+        }
+    }
+
+    public static unsafe void FromUInt(uint[] x, dfloat[] output, RoundingMode mode)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (uint* px = x)
+        fixed (dfloat* pOutput = output)
+        {
+            float_from_u32_batch(px, (uint*)pOutput, (UIntPtr)x.Length, mode);
+        }
+    }
+
+    public static unsafe void FromLong(long[] x, dfloat[] output, RoundingMode mode)
+    {
+        CheckBatchLengths(x, output);
+
+        fixed (long* px = x)
+        fixed (dfloat* pOutput = output)
+        {
+            float_from_i64_batch(px, (uint*)pOutput, (UIntPtr)x.Length, mode);
+        }
+    }
+
+    public static unsafe void Sqrt(dfloat* x, dfloat* output, int length)
+    {
+        float_sqrt_batch((uint*)x, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Sin(dfloat* x, dfloat* output, int length)
+    {
+        float_sin_batch((uint*)x, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Cos(dfloat* x, dfloat* output, int length)
+    {
+        float_cos_batch((uint*)x, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Atan2(dfloat* y, dfloat* x, dfloat* output, int length)
+    {
+        float_atan2_batch((uint*)y, (uint*)x, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Exp(dfloat* x, dfloat* output, int length)
+    {
+        float_exp_batch((uint*)x, (uint*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Log(dfloat* x, dfloat* output, int length)
+    {
+        float_log_batch((uint*)x, (uint*)output, (UIntPtr)length);
+    }
+
+    /// <summary>
+    /// The basic operations on <see cref="ddouble"/>, using the same backend as the
+    /// <see cref="dfloat"/> ones.
+    /// </summary>
+    public static ddouble Add(ddouble a, ddouble b)
+    {
+        ulong bits = double_add(a.Bits, b.Bits);
+        return new ddouble(bits);
+    }
+
+    public static ddouble Sub(ddouble a, ddouble b)
+    {
+        ulong bits = double_sub(a.Bits, b.Bits);
+        return new ddouble(bits);
+    }
+
+    public static ddouble Mul(ddouble a, ddouble b)
+    {
+        ulong bits = double_mul(a.Bits, b.Bits);
+        return new ddouble(bits);
+    }
+
+    public static ddouble Div(ddouble a, ddouble b)
+    {
+        ulong bits = double_div(a.Bits, b.Bits);
+        return new ddouble(bits);
+    }
+
+    public static unsafe void Add(ddouble[] a, ddouble[] b, ddouble[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (ddouble* pa = a, pb = b, pOutput = output)
+        {
+            double_add_batch((ulong*)pa, (ulong*)pb, (ulong*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    public static unsafe void Sub(ddouble[] a, ddouble[] b, ddouble[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (ddouble* pa = a, pb = b, pOutput = output)
+        {
+            double_sub_batch((ulong*)pa, (ulong*)pb, (ulong*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    public static unsafe void Mul(ddouble[] a, ddouble[] b, ddouble[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (ddouble* pa = a, pb = b, pOutput = output)
+        {
+            double_mul_batch((ulong*)pa, (ulong*)pb, (ulong*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    public static unsafe void Div(ddouble[] a, ddouble[] b, ddouble[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (ddouble* pa = a, pb = b, pOutput = output)
+        {
+            double_div_batch((ulong*)pa, (ulong*)pb, (ulong*)pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    public static unsafe void Add(ddouble* a, ddouble* b, ddouble* output, int length)
+    {
+        double_add_batch((ulong*)a, (ulong*)b, (ulong*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Sub(ddouble* a, ddouble* b, ddouble* output, int length)
+    {
+        double_sub_batch((ulong*)a, (ulong*)b, (ulong*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Mul(ddouble* a, ddouble* b, ddouble* output, int length)
+    {
+        double_mul_batch((ulong*)a, (ulong*)b, (ulong*)output, (UIntPtr)length);
+    }
+
+    public static unsafe void Div(ddouble* a, ddouble* b, ddouble* output, int length)
+    {
+        double_div_batch((ulong*)a, (ulong*)b, (ulong*)output, (UIntPtr)length);
+    }
+
+    /// <summary>
+    /// Vector and quaternion operations, each a single native call. Every one has a fixed
+    /// order of operations (documented in vector.rs), so results are reproducible wherever
+    /// the basic operations are. For example a dot product is always
+    /// ((x * x' + y * y') + z * z') + w * w'.
+    /// </summary>
+    public static unsafe dfloat Dot(dvec2 a, dvec2 b)
+    {
+        return new dfloat(dvec2_dot(&a, &b));
+    }
+
+    public static unsafe dfloat Dot(dvec3 a, dvec3 b)
+    {
+        return new dfloat(dvec3_dot(&a, &b));
+    }
+
+    public static unsafe dfloat Dot(dvec4 a, dvec4 b)
+    {
+        return new dfloat(dvec4_dot(&a, &b));
+    }
+
+    public static unsafe dvec3 Cross(dvec3 a, dvec3 b)
+    {
+        dvec3 result;
+        dvec3_cross(&a, &b, &result);
+        return result;
+    }
+
+    /// <summary>
+    /// Divides each component by the length, computed with <see cref="Sqrt"/>. A vector
+    /// whose squared length is zero (or underflows to zero) gives the zero vector.
+    /// </summary>
+    public static unsafe dvec2 Normalize(dvec2 v)
+    {
+        dvec2 result;
+        dvec2_normalize(&v, &result);
+        return result;
+    }
+
+    public static unsafe dvec3 Normalize(dvec3 v)
+    {
+        dvec3 result;
+        dvec3_normalize(&v, &result);
+        return result;
+    }
+
+    public static unsafe dvec4 Normalize(dvec4 v)
+    {
+        dvec4 result;
+        dvec4_normalize(&v, &result);
+        return result;
+    }
+
+    /// <summary>
+    /// The Hamilton product, applying b then a, like Unity's a * b.
+    /// </summary>
+    public static unsafe dquat Mul(dquat a, dquat b)
+    {
+        dquat result;
+        dquat_mul(&a, &b, &result);
+        return result;
+    }
+
+    /// <summary>
+    /// Rotates v by the unit quaternion q, like Unity's q * v.
+    /// </summary>
+    public static unsafe dvec3 Rotate(dquat q, dvec3 v)
+    {
+        dvec3 result;
+        dquat_rotate(&q, &v, &result);
+        return result;
+    }
+
+    /// <summary>
+    /// The batched vector operations take structure-of-arrays buffers: count vectors with N
+    /// components are stored as N consecutive runs of count values, all the x components,
+    /// then all the y, and so on. Buffer lengths must be N times count, where count is the
+    /// length of the output divided by its number of components.
+    /// </summary>
+    public static unsafe void Dot2(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        int count = CheckSoaLengths(a, 2, b, 2, output, 1);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            dvec2_dot_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void Dot3(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        int count = CheckSoaLengths(a, 3, b, 3, output, 1);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            dvec3_dot_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void Dot4(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        int count = CheckSoaLengths(a, 4, b, 4, output, 1);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            dvec4_dot_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void Cross(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        int count = CheckSoaLengths(a, 3, b, 3, output, 3);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            dvec3_cross_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void Normalize2(dfloat[] v, dfloat[] output)
+    {
+        int count = CheckSoaLengths(v, 2, output, 2);
+
+        fixed (dfloat* pv = v, pOutput = output)
+        {
+            dvec2_normalize_batch((uint*)pv, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void Normalize3(dfloat[] v, dfloat[] output)
+    {
+        int count = CheckSoaLengths(v, 3, output, 3);
+
+        fixed (dfloat* pv = v, pOutput = output)
+        {
+            dvec3_normalize_batch((uint*)pv, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void Normalize4(dfloat[] v, dfloat[] output)
+    {
+        int count = CheckSoaLengths(v, 4, output, 4);
+
+        fixed (dfloat* pv = v, pOutput = output)
+        {
+            dvec4_normalize_batch((uint*)pv, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void QuatMul(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        int count = CheckSoaLengths(a, 4, b, 4, output, 4);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            dquat_mul_batch((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void QuatRotate(dfloat[] q, dfloat[] v, dfloat[] output)
+    {
+        int count = CheckSoaLengths(q, 4, v, 3, output, 3);
+
+        fixed (dfloat* pq = q, pv = v, pOutput = output)
+        {
+            dquat_rotate_batch((uint*)pq, (uint*)pv, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    /// <summary>
+    /// Matrix product a * b. Each element is accumulated left to right,
+    /// ((a[r,0] * b[0,c] + a[r,1] * b[1,c]) + a[r,2] * b[2,c]) + a[r,3] * b[3,c], with no
+    /// fused multiply-add, see matrix.rs.
+    /// </summary>
+    public static unsafe dmat4 Mul(dmat4 a, dmat4 b)
+    {
+        dmat4 result;
+        dmat4_mul(&a, &b, &result);
+        return result;
+    }
+
+    /// <summary>
+    /// Transforms a point by the upper 3x4 of m, like Matrix4x4.MultiplyPoint3x4.
+    /// </summary>
+    public static unsafe dvec3 MultiplyPoint3x4(dmat4 m, dvec3 p)
+    {
+        dvec3 result;
+        dmat4_transform_point(&m, &p, &result);
+        return result;
+    }
+
+    /// <summary>
+    /// Transforms a direction by the upper 3x3 of m, like Matrix4x4.MultiplyVector.
+    /// </summary>
+    public static unsafe dvec3 MultiplyVector(dmat4 m, dvec3 v)
+    {
+        dvec3 result;
+        dmat4_transform_vector(&m, &v, &result);
+        return result;
+    }
+
+    public static unsafe void Mul(dmat4[] a, dmat4[] b, dmat4[] output)
+    {
+        CheckBatchLengths(a, b, output);
+
+        fixed (dmat4* pa = a, pb = b, pOutput = output)
+        {
+            dmat4_mul_batch(pa, pb, pOutput, (UIntPtr)a.Length);
+        }
+    }
+
+    /// <summary>
+    /// As <see cref="Mul(dmat4[], dmat4[], dmat4[])"/>, with the matrices in
+    /// structure-of-arrays buffers of 16 planes, in column-major element order.
+    /// </summary>
+    public static unsafe void MulSoa(dfloat[] a, dfloat[] b, dfloat[] output)
+    {
+        int count = CheckSoaLengths(a, 16, b, 16, output, 16);
+
+        fixed (dfloat* pa = a, pb = b, pOutput = output)
+        {
+            dmat4_mul_batch_soa((uint*)pa, (uint*)pb, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void MultiplyPoint3x4(dmat4 m, dvec3[] points, dvec3[] output)
+    {
+        CheckBatchLengths(points, output);
+
+        fixed (dvec3* pPoints = points, pOutput = output)
+        {
+            dmat4_transform_points(&m, pPoints, pOutput, (UIntPtr)points.Length);
+        }
+    }
+
+    public static unsafe void MultiplyPoint3x4(dmat4 m, dfloat[] points, dfloat[] output)
+    {
+        int count = CheckSoaLengths(points, 3, output, 3);
+
+        fixed (dfloat* pPoints = points, pOutput = output)
+        {
+            dmat4_transform_points_soa(&m, (uint*)pPoints, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    public static unsafe void MultiplyVector(dmat4 m, dvec3[] vectors, dvec3[] output)
+    {
+        CheckBatchLengths(vectors, output);
+
+        fixed (dvec3* pVectors = vectors, pOutput = output)
+        {
+            dmat4_transform_vectors(&m, pVectors, pOutput, (UIntPtr)vectors.Length);
+        }
+    }
+
+    public static unsafe void MultiplyVector(dmat4 m, dfloat[] vectors, dfloat[] output)
+    {
+        int count = CheckSoaLengths(vectors, 3, output, 3);
+
+        fixed (dfloat* pVectors = vectors, pOutput = output)
+        {
+            dmat4_transform_vectors_soa(&m, (uint*)pVectors, (uint*)pOutput, (UIntPtr)count);
+        }
+    }
+
+    /// <summary>
+    /// Sum of all elements, computed in parallel on up to threads threads (0 for one per
+    /// core). The order of the additions is a fixed tree that depends only on the length,
+    /// see reduce.rs, so the result has the same bits whatever the thread count. It is
+    /// not in general the same as adding the elements one by one.
+    /// </summary>
+    public static unsafe dfloat Sum(dfloat[] x, int threads = 0)
+    {
+        fixed (dfloat* pX = x)
+        {
+            return new dfloat(float_sum((uint*)pX, (UIntPtr)x.Length, (UIntPtr)threads));
+        }
+    }
+
+    /// <summary>
+    /// Sum of a[i] * b[i], with the products added in the same order as <see cref="Sum"/>.
+    /// </summary>
+    public static unsafe dfloat Dot(dfloat[] a, dfloat[] b, int threads = 0)
+    {
+        if (a.Length != b.Length)
+            throw new ArgumentException("Operands must have the same length.");
+
+        fixed (dfloat* pa = a, pb = b)
+        {
+            return new dfloat(float_dot((uint*)pa, (uint*)pb, (UIntPtr)a.Length, (UIntPtr)threads));
+        }
+    }
+
+    /// <summary>
+    /// Smallest element, +infinity if x is empty. -0 is smaller than +0, and any NaN is
+    /// returned.
+    /// </summary>
+    public static unsafe dfloat Min(dfloat[] x, int threads = 0)
+    {
+        fixed (dfloat* pX = x)
+        {
+            return new dfloat(float_min((uint*)pX, (UIntPtr)x.Length, (UIntPtr)threads));
+        }
+    }
+
+    /// <summary>
+    /// Largest element, -infinity if x is empty. +0 is larger than -0, and any NaN is
+    /// returned.
+    /// </summary>
+    public static unsafe dfloat Max(dfloat[] x, int threads = 0)
+    {
+        fixed (dfloat* pX = x)
+        {
+            return new dfloat(float_max((uint*)pX, (UIntPtr)x.Length, (UIntPtr)threads));
+        }
+    }
+
+    /// <summary>
+    /// The XXH64 hash of the elements' little-endian bytes (see hash.rs), the same on every
+    /// platform, for checking that clients have the same simulation state. Use
+    /// <see cref="StateHash"/> to rehash only the parts of a large buffer that changed.
+    /// </summary>
+    public static unsafe ulong Hash(dfloat[] x, HashFlags flags = HashFlags.None, ulong seed = 0)
+    {
+        fixed (dfloat* pX = x)
+        {
+            return dfloat_hash((uint*)pX, (UIntPtr)x.Length, flags, seed);
+        }
+    }
+
+    public static unsafe ulong Hash(ddouble[] x, HashFlags flags = HashFlags.None, ulong seed = 0)
+    {
+        fixed (ddouble* pX = x)
+        {
+            return ddouble_hash((ulong*)pX, (UIntPtr)x.Length, flags, seed);
+        }
+    }
+
+    /// <summary>
+    /// The hash of length dfloats, or other 32-bit words, in unmanaged memory.
+    /// </summary>
+    public static unsafe ulong Hash(uint* x, long length, HashFlags flags = HashFlags.None, ulong seed = 0)
+    {
+        return dfloat_hash(x, (UIntPtr)length, flags, seed);
+    }
+
+    /// <summary>
+    /// The hash of a buffer of length elements from the hashes of its chunks, as
+    /// <see cref="StateHash"/> computes it, for hashing chunks as they are produced.
+    /// </summary>
+    public static unsafe ulong CombineHashes(ulong[] hashes, int count, long length)
+    {
+        if ((uint)count > (uint)hashes.Length)
+            throw new ArgumentOutOfRangeException(nameof(count));
+
+        fixed (ulong* pHashes = hashes)
+        {
+            return dfloat_hash_combine(pHashes, (UIntPtr)count, (UIntPtr)length);
+        }
+    }
+
+    /// <summary>
+    /// Starts recording every native add, sub, mul, div, sqrt, sin, cos, atan2, exp, log and
+    /// conversion, scalar or batched, with its operands, result and modes, and every call of
+    /// the vector, matrix, program and reduction functions with a hash of its outputs,
+    /// discarding any earlier records. Each thread keeps its last capacity records (rounded up
+    /// to a power of two, 32 bytes each), or 65536 if 0. Batched operations run one element at
+    /// a time while tracing; otherwise tracing costs nothing measurable. See trace.rs.
+    /// </summary>
+    public static void StartTrace(int capacity = 0)
+    {
+        if (capacity < 0)
+            throw new ArgumentOutOfRangeException(nameof(capacity));
+
+        dfloat_trace_start((UIntPtr)capacity);
+    }
+
+    /// <summary>
+    /// Stops recording, keeping the records for <see cref="DumpTrace"/>.
+    /// </summary>
+    public static void StopTrace()
+    {
+        dfloat_trace_stop();
+    }
+
+    public static bool IsTracing()
+    {
+        return dfloat_trace_active() != 0;
+    }
+
+    /// <summary>
+    /// Writes the recorded operations of every thread to a compact binary file at path, to diff
+    /// with the trace of another device, and returns the number of records written.
+    /// </summary>
+    public static unsafe long DumpTrace(string path)
+    {
+        byte[] bytes = System.Text.Encoding.UTF8.GetBytes(path);
+        long count;
+
+        fixed (byte* pBytes = bytes)
+        {
+            count = dfloat_trace_dump(pBytes, (UIntPtr)bytes.Length);
+        }
+
+        if (count < 0)
+            throw new System.IO.IOException($"Could not write the trace to {path}.");
+
+        return count;
+    }
+
+    private static void CheckBatchLengths(Array a, Array b, Array output)
+    {
+        if (a.Length != b.Length || a.Length != output.Length)
+            throw new ArgumentException("Batched operands and output must have the same length.");
+    }
+
+    private static void CheckBatchLengths(Array x, Array output)
+    {
+        if (x.Length != output.Length)
+            throw new ArgumentException("Batched operand and output must have the same length.");
+    }
+
+    private static int CheckSoaLengths(Array a, int aComponents, Array b, int bComponents, Array output, int outputComponents)
+    {
+        int count = output.Length / outputComponents;
+
+        if (output.Length != count * outputComponents || a.Length != count * aComponents || b.Length != count * bComponents)
+            throw new ArgumentException("Structure-of-arrays buffers must hold the same number of vectors.");
+
+        return count;
+    }
+
+    private static int CheckSoaLengths(Array v, int vComponents, Array output, int outputComponents)
+    {
+        int count = output.Length / outputComponents;
+
+        if (output.Length != count * outputComponents || v.Length != count * vComponents)
+            throw new ArgumentException("Structure-of-arrays buffers must hold the same number of vectors.");
+
+        return count;
+    }
 }
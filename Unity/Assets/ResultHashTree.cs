@@ -0,0 +1,259 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+
+/// <summary>
+/// A hash tree (Merkle tree) over a sequence of 64-bit results, so two devices can check
+/// they produced the same results by comparing a single root hash, and on a mismatch find
+/// which blocks differ by descending only into the subtrees whose hashes differ.
+/// <para>
+/// Results are hashed in blocks of <see cref="BlockSize"/>, each block's hash being the
+/// 64-bit FNV-1a hash of its results' little-endian bytes. Each level above hashes pairs of
+/// nodes from the level below the same way, with a last unpaired node carried up as it is,
+/// until one node, the root, is left.
+/// </para>
+/// </summary>
+public class ResultHashTree
+{
+    private const ulong fnvOffset = 0xcbf29ce484222325;
+    private const ulong fnvPrime = 0x100000001b3;
+
+    public int BlockSize { get; }
+
+    /// <summary>
+    /// Number of results added.
+    /// </summary>
+    public long Count { get; private set; }
+
+    private readonly List<ulong> leaves = new List<ulong>();
+
+    private ulong block = fnvOffset;
+
+    /// <summary>
+    /// Every level of the tree, root first. Built from the leaves when first needed, and for
+    /// a tree read from a file, read with it.
+    /// </summary>
+    private ulong[][] levels;
+
+    private bool read;
+
+    public ResultHashTree(int blockSize)
+    {
+        if (blockSize <= 0)
+            throw new ArgumentOutOfRangeException(nameof(blockSize));
+
+        BlockSize = blockSize;
+    }
+
+    /// <summary>
+    /// Number of blocks, including a last partial block.
+    /// </summary>
+    public long BlockCount => Count / BlockSize + (Count % BlockSize != 0 ? 1 : 0);
+
+    public ulong Root => Levels[0][0];
+
+    private ulong[][] Levels
+    {
+        get
+        {
+            if (levels == null)
+                levels = Build();
+
+            return levels;
+        }
+    }
+
+    /// <summary>
+    /// Adds the next result, and returns true if it completed a block, whose hash is then
+    /// <see cref="LastBlock"/>.
+    /// </summary>
+    public bool Add(ulong value)
+    {
+        if (read)
+            throw new InvalidOperationException("Cannot add to a tree read from a file.");
+
+        levels = null;
+        block = Hash(block, value);
+        Count++;
+
+        if (Count % BlockSize != 0)
+            return false;
+
+        leaves.Add(block);
+        block = fnvOffset;
+
+        return true;
+    }
+
+    public ulong LastBlock => leaves[leaves.Count - 1];
+
+    public ulong Block(long index)
+    {
+        return Levels[Levels.Length - 1][index];
+    }
+
+    /// <summary>
+    /// Indices of the blocks that differ between this tree and <paramref name="other"/>, in
+    /// order, found by comparing their roots and then the children of each differing node.
+    /// The trees must have the same block size; if they hold different numbers of results,
+    /// every block from the first that either tree is missing or has only part of is returned,
+    /// as the trees' shapes no longer match.
+    /// </summary>
+    public List<long> Differences(ResultHashTree other)
+    {
+        if (other.BlockSize != BlockSize)
+            throw new ArgumentException("Trees have different block sizes.");
+
+        var differences = new List<long>();
+
+        if (other.Count != Count)
+        {
+            long common = Math.Min(Count, other.Count) / BlockSize;
+            ulong[] ours = Levels[Levels.Length - 1], theirs = other.Levels[other.Levels.Length - 1];
+
+            for (long i = 0; i < Math.Max(ours.Length, theirs.Length); i++)
+            {
+                if (i >= common || ours[i] != theirs[i])
+                    differences.Add(i);
+            }
+
+            return differences;
+        }
+
+        Descend(other, 0, 0, differences);
+
+        return differences;
+    }
+
+    private void Descend(ResultHashTree other, int level, long index, List<long> differences)
+    {
+        if (Levels[level][index] == other.Levels[level][index])
+            return;
+
+        if (level == Levels.Length - 1)
+        {
+            differences.Add(index);
+            return;
+        }
+
+        ulong[] below = Levels[level + 1];
+
+        Descend(other, level + 1, 2 * index, differences);
+
+        if (2 * index + 1 < below.Length)
+            Descend(other, level + 1, 2 * index + 1, differences);
+    }
+
+    /// <summary>
+    /// Writes the result count and every level of the tree, root first, each as its node
+    /// count and then its hashes, in little-endian order. The block size is left to the
+    /// caller, as files usually hold several trees with the same block size.
+    /// </summary>
+    public void Write(BinaryWriter writer)
+    {
+        writer.Write(Count);
+        writer.Write(Levels.Length);
+
+        foreach (ulong[] level in Levels)
+        {
+            writer.Write(level.Length);
+
+            foreach (ulong hash in level)
+            {
+                writer.Write(hash);
+            }
+        }
+    }
+
+    public static ResultHashTree Read(BinaryReader reader, int blockSize)
+    {
+        var tree = new ResultHashTree(blockSize);
+
+        tree.read = true;
+        tree.Count = reader.ReadInt64();
+
+        if (tree.Count < 0)
+            throw new InvalidDataException("Malformed hash tree.");
+
+        // The tree's shape follows from the count, so each length is checked against it, and
+        // against the bytes left, before anything is allocated.
+        long[] widths = Widths(Math.Max(tree.BlockCount, 1));
+
+        if (reader.ReadInt32() != widths.Length)
+            throw new InvalidDataException("Malformed hash tree.");
+
+        long left = reader.BaseStream.CanSeek ? reader.BaseStream.Length - reader.BaseStream.Position : long.MaxValue;
+        tree.levels = new ulong[widths.Length][];
+
+        for (int i = 0; i < widths.Length; i++)
+        {
+            int length = reader.ReadInt32();
+            left -= 4;
+
+            if (length != widths[i] || length > left / 8)
+                throw new InvalidDataException("Malformed hash tree.");
+
+            tree.levels[i] = new ulong[length];
+            left -= 8L * length;
+
+            for (int j = 0; j < length; j++)
+            {
+                tree.levels[i][j] = reader.ReadUInt64();
+            }
+        }
+
+        return tree;
+    }
+
+    /// <summary>
+    /// Node counts of the levels of a tree over the given number of blocks, root first.
+    /// </summary>
+    private static long[] Widths(long blocks)
+    {
+        var widths = new List<long> { blocks };
+
+        while (widths[0] > 1)
+        {
+            widths.Insert(0, (widths[0] + 1) / 2);
+        }
+
+        return widths.ToArray();
+    }
+
+    private ulong[][] Build()
+    {
+        var blocks = new List<ulong>(leaves);
+
+        // An empty tree has a single empty block.
+        if (Count % BlockSize != 0 || Count == 0)
+            blocks.Add(block);
+
+        var built = new List<ulong[]> { blocks.ToArray() };
+
+        while (built[0].Length > 1)
+        {
+            ulong[] below = built[0];
+            var level = new ulong[(below.Length + 1) / 2];
+
+            for (int i = 0; i < level.Length; i++)
+            {
+                level[i] = 2 * i + 1 < below.Length ? Hash(Hash(fnvOffset, below[2 * i]), below[2 * i + 1]) : below[2 * i];
+            }
+
+            built.Insert(0, level);
+        }
+
+        return built.ToArray();
+    }
+
+    private static ulong Hash(ulong hash, ulong value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            hash = (hash ^ (value & 0xff)) * fnvPrime;
+            value >>= 8;
+        }
+
+        return hash;
+    }
+}
@@ -0,0 +1,310 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading.Tasks;
+
+/// <summary>
+/// A sequence of test results in the order the test produces them, written when generating
+/// ground truth. Each result is a 32-bit or 64-bit integer, float and double results being
+/// their bits, and must be read back with the same width.
+/// </summary>
+public interface IResultWriter : IDisposable
+{
+    void Write(uint value);
+
+    void Write(ulong value);
+}
+
+public interface IResultReader : IDisposable
+{
+    uint ReadUInt32();
+
+    ulong ReadUInt64();
+}
+
+/// <summary>
+/// Results as decimal numbers, one per line, the original ground truth format.
+/// </summary>
+public sealed class TextResultWriter : IResultWriter
+{
+    private readonly StreamWriter writer;
+
+    public TextResultWriter(string path)
+    {
+        writer = new StreamWriter(path);
+    }
+
+    public void Write(uint value)
+    {
+        writer.WriteLine(value);
+    }
+
+    public void Write(ulong value)
+    {
+        writer.WriteLine(value);
+    }
+
+    public void Dispose()
+    {
+        writer.Dispose();
+    }
+}
+
+public sealed class TextResultReader : IResultReader
+{
+    private readonly StreamReader reader;
+
+    public TextResultReader(StreamReader reader)
+    {
+        this.reader = reader;
+    }
+
+    public uint ReadUInt32()
+    {
+        return Convert.ToUInt32(reader.ReadLine());
+    }
+
+    public ulong ReadUInt64()
+    {
+        return Convert.ToUInt64(reader.ReadLine());
+    }
+
+    public void Dispose()
+    {
+        reader.Dispose();
+    }
+}
+
+/// <summary>
+/// Results as little-endian words, 64-bit results as two, low first, to a file that
+/// <see cref="GroundTruthFile.Write"/> then copies into a section.
+/// </summary>
+public sealed class BinaryResultWriter : IResultWriter
+{
+    private readonly BinaryWriter writer;
+
+    public string Path { get; }
+
+    public BinaryResultWriter(string path)
+    {
+        Path = path;
+        writer = new BinaryWriter(new BufferedStream(File.Create(path)));
+    }
+
+    public void Write(uint value)
+    {
+        writer.Write(value);
+    }
+
+    public void Write(ulong value)
+    {
+        writer.Write(value);
+    }
+
+    public void Dispose()
+    {
+        writer.Dispose();
+    }
+}
+
+/// <summary>
+/// Reads the results from a section of a <see cref="GroundTruthFile"/>, in place.
+/// </summary>
+public sealed class BinaryResultReader : IResultReader
+{
+    private readonly GroundTruthFile.Words words;
+
+    private long position;
+
+    public BinaryResultReader(GroundTruthFile.Words words)
+    {
+        this.words = words;
+    }
+
+    public uint ReadUInt32()
+    {
+        if (position >= words.Count)
+            throw new EndOfStreamException("More results read than the ground truth has.");
+
+        return words[position++];
+    }
+
+    public ulong ReadUInt64()
+    {
+        return ReadUInt32() | (ulong)ReadUInt32() << 32;
+    }
+
+    public void Dispose()
+    {
+    }
+}
+
+/// <summary>
+/// Hashes the results written to it, as the words <see cref="BinaryResultWriter"/> would
+/// write, a chunk at a time with the native hash, without keeping them. <see cref="Hash"/> is
+/// the same as that of a <see cref="StateHash"/> with chunks of <see cref="ChunkLength"/> over
+/// all the words, so it can be compared with <see cref="HashOf"/> a ground truth section.
+/// </summary>
+public sealed class HashingResultWriter : IResultWriter
+{
+    public const int ChunkLength = 1 << 12;
+
+    private readonly uint[] chunk = new uint[ChunkLength];
+    private readonly List<ulong> hashes = new List<ulong>();
+
+    private int filled;
+    private long count;
+
+    public void Write(uint value)
+    {
+        chunk[filled++] = value;
+        count++;
+
+        if (filled == ChunkLength)
+        {
+            hashes.Add(HashChunk());
+            filled = 0;
+        }
+    }
+
+    public void Write(ulong value)
+    {
+        Write((uint)value);
+        Write((uint)(value >> 32));
+    }
+
+    public ulong Hash
+    {
+        get
+        {
+            var all = new ulong[hashes.Count + 1];
+            hashes.CopyTo(all);
+
+            if (filled == 0)
+                return Mathd.CombineHashes(all, hashes.Count, count);
+
+            all[hashes.Count] = HashChunk();
+            return Mathd.CombineHashes(all, all.Length, count);
+        }
+    }
+
+    private unsafe ulong HashChunk()
+    {
+        fixed (uint* pChunk = chunk)
+        {
+            return Mathd.Hash(pChunk, filled);
+        }
+    }
+
+    public static unsafe ulong HashOf(GroundTruthFile.Words words)
+    {
+        var all = new ulong[(words.Count + ChunkLength - 1) / ChunkLength];
+
+        for (long i = 0; i < all.Length; i++)
+        {
+            all[i] = Mathd.Hash(words.Pointer + i * ChunkLength, Math.Min(ChunkLength, words.Count - i * ChunkLength));
+        }
+
+        return Mathd.CombineHashes(all, all.Length, words.Count);
+    }
+
+    public void Dispose()
+    {
+    }
+}
+
+/// <summary>
+/// Reads a stream in chunks of a fixed size on a worker thread, one chunk ahead of the reader:
+/// while one buffer is read from, the next is filled. Reading, decompressing or downloading the
+/// stream then overlaps with the work done on what was read, and only two chunks are ever held.
+/// </summary>
+public sealed class ReadAheadStream : Stream
+{
+    private readonly Stream inner;
+
+    private byte[] current, next;
+    private int length, position;
+    private Task<int> pending;
+
+    public ReadAheadStream(Stream inner, int chunkSize)
+    {
+        this.inner = inner;
+        current = new byte[chunkSize];
+        next = new byte[chunkSize];
+        pending = Fill(next);
+    }
+
+    private Task<int> Fill(byte[] buffer)
+    {
+        return Task.Run(() =>
+        {
+            // Read a whole chunk where the stream allows, as some return a little at a time.
+            int filled = 0, read;
+
+            while (filled < buffer.Length && (read = inner.Read(buffer, filled, buffer.Length - filled)) > 0)
+            {
+                filled += read;
+            }
+
+            return filled;
+        });
+    }
+
+    public override int Read(byte[] buffer, int offset, int count)
+    {
+        if (position == length)
+        {
+            // GetResult rethrows the worker's exception itself, e.g. an InvalidDataException from
+            // a damaged deflate stream, where Result would wrap it in an AggregateException.
+            length = pending.GetAwaiter().GetResult();
+            position = 0;
+
+            if (length == 0)
+                return 0;
+
+            byte[] filled = next;
+            next = current;
+            current = filled;
+            pending = Fill(next);
+        }
+
+        int copied = Math.Min(count, length - position);
+        Buffer.BlockCopy(current, position, buffer, offset, copied);
+        position += copied;
+
+        return copied;
+    }
+
+    protected override void Dispose(bool disposing)
+    {
+        if (disposing)
+        {
+            // The worker may still be reading.
+            try
+            {
+                pending.Wait();
+            }
+            catch (AggregateException)
+            {
+            }
+
+            inner.Dispose();
+        }
+
+        base.Dispose(disposing);
+    }
+
+    public override bool CanRead => true;
+    public override bool CanSeek => false;
+    public override bool CanWrite => false;
+    public override long Length => throw new NotSupportedException();
+    public override long Position { get => throw new NotSupportedException(); set => throw new NotSupportedException(); }
+
+    public override void Flush()
+    {
+    }
+
+    public override long Seek(long offset, SeekOrigin origin) => throw new NotSupportedException();
+    public override void SetLength(long value) => throw new NotSupportedException();
+    public override void Write(byte[] buffer, int offset, int count) => throw new NotSupportedException();
+}
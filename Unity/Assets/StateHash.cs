@@ -0,0 +1,109 @@
+using System;
+using System.Runtime.InteropServices;
+
+/// <summary>
+/// Hashes a dfloat or ddouble buffer of a fixed length in chunks, keeping each chunk's hash,
+/// so that hashing it again, e.g. every tick, only rehashes the chunks marked dirty since:
+/// <code>
+/// var stateHash = new StateHash(positions.Length, 1024);
+/// positions[i] = p;
+/// stateHash.MarkDirty(i);
+/// ulong hash = stateHash.Hash(positions);
+/// </code>
+/// The hash is the hash of the chunk hashes (see hash.rs), so it depends on the chunk length,
+/// and is not the same as <see cref="Mathd.Hash(dfloat[], Mathd.HashFlags, ulong)"/> of the
+/// whole buffer. Every chunk starts dirty, and must be marked dirty again after changing the
+/// buffer's type or the flags.
+/// </summary>
+public class StateHash
+{
+    [DllImport("unity_rust")]
+    private static extern unsafe ulong dfloat_hash_chunks(uint* x, UIntPtr length, UIntPtr chunkLength, Mathd.HashFlags flags, byte* dirty, ulong* hashes);
+
+    [DllImport("unity_rust")]
+    private static extern unsafe ulong ddouble_hash_chunks(ulong* x, UIntPtr length, UIntPtr chunkLength, Mathd.HashFlags flags, byte* dirty, ulong* hashes);
+
+    private readonly ulong[] hashes;
+    private readonly byte[] dirty;
+
+    public int Length { get; }
+
+    public int ChunkLength { get; }
+
+    public StateHash(int length, int chunkLength)
+    {
+        if (length < 0)
+            throw new ArgumentOutOfRangeException(nameof(length));
+
+        if (chunkLength <= 0)
+            throw new ArgumentOutOfRangeException(nameof(chunkLength));
+
+        Length = length;
+        ChunkLength = chunkLength;
+
+        int chunks = (int)(((long)length + chunkLength - 1) / chunkLength);
+        hashes = new ulong[chunks];
+        dirty = new byte[chunks];
+        MarkAllDirty();
+    }
+
+    public void MarkDirty(int index)
+    {
+        if ((uint)index >= (uint)Length)
+            throw new ArgumentOutOfRangeException(nameof(index));
+
+        dirty[index / ChunkLength] = 1;
+    }
+
+    public void MarkDirty(int start, int count)
+    {
+        if (start < 0 || count < 0 || start > Length - count)
+            throw new ArgumentOutOfRangeException();
+
+        if (count == 0)
+            return;
+
+        for (int chunk = start / ChunkLength; chunk <= (start + count - 1) / ChunkLength; chunk++)
+        {
+            dirty[chunk] = 1;
+        }
+    }
+
+    public void MarkAllDirty()
+    {
+        for (int i = 0; i < dirty.Length; i++)
+        {
+            dirty[i] = 1;
+        }
+    }
+
+    public unsafe ulong Hash(dfloat[] buffer, Mathd.HashFlags flags = Mathd.HashFlags.None)
+    {
+        CheckLength(buffer);
+
+        fixed (dfloat* pBuffer = buffer)
+        fixed (byte* pDirty = dirty)
+        fixed (ulong* pHashes = hashes)
+        {
+            return dfloat_hash_chunks((uint*)pBuffer, (UIntPtr)Length, (UIntPtr)ChunkLength, flags, pDirty, pHashes);
+        }
+    }
+
+    public unsafe ulong Hash(ddouble[] buffer, Mathd.HashFlags flags = Mathd.HashFlags.None)
+    {
+        CheckLength(buffer);
+
+        fixed (ddouble* pBuffer = buffer)
+        fixed (byte* pDirty = dirty)
+        fixed (ulong* pHashes = hashes)
+        {
+            return ddouble_hash_chunks((ulong*)pBuffer, (UIntPtr)Length, (UIntPtr)ChunkLength, flags, pDirty, pHashes);
+        }
+    }
+
+    private void CheckLength(Array buffer)
+    {
+        if (buffer.Length != Length)
+            throw new ArgumentException("The buffer must have the length the hash was created with.");
+    }
+}
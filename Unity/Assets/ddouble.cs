@@ -0,0 +1,28 @@
+/// <summary>
+/// A 64-bit float whose arithmetic is done by the native library, see <see cref="Mathd"/>.
+/// </summary>
+[System.Serializable]
+public unsafe struct ddouble
+{
+    public ulong Bits;
+
+    public ddouble(ulong bits)
+    {
+        Bits = bits;
+    }
+
+    public override string ToString()
+    {
+        return AsNonDetermDouble(this).ToString();
+    }
+
+    public static ddouble FromNonDetermDouble(double d)
+    {
+        return new ddouble(*(ulong*)&d);
+    }
+
+    public static double AsNonDetermDouble(ddouble dd)
+    {
+        return *(double*)&dd.Bits;
+    }
+}
@@ -0,0 +1,52 @@
+/// <summary>
+/// A 4x4 matrix of <see cref="dfloat"/>, laid out column-major like Unity's Matrix4x4, so
+/// m<i>rc</i> is row r, column c. Native operations on it are in <see cref="Mathd"/>.
+/// </summary>
+[System.Serializable]
+public struct dmat4
+{
+    // Declared column by column, matching the native layout.
+    public dfloat m00, m10, m20, m30;
+    public dfloat m01, m11, m21, m31;
+    public dfloat m02, m12, m22, m32;
+    public dfloat m03, m13, m23, m33;
+
+    public dfloat this[int row, int column]
+    {
+        get
+        {
+            return this[column * 4 + row];
+        }
+        set
+        {
+            this[column * 4 + row] = value;
+        }
+    }
+
+    /// <summary>
+    /// Element index in column-major order.
+    /// </summary>
+    public unsafe dfloat this[int index]
+    {
+        get
+        {
+            if (index < 0 || index >= 16)
+                throw new System.IndexOutOfRangeException();
+
+            fixed (dfloat* p = &m00)
+            {
+                return p[index];
+            }
+        }
+        set
+        {
+            if (index < 0 || index >= 16)
+                throw new System.IndexOutOfRangeException();
+
+            fixed (dfloat* p = &m00)
+            {
+                p[index] = value;
+            }
+        }
+    }
+}
@@ -0,0 +1,24 @@
+/// <summary>
+/// A quaternion of <see cref="dfloat"/>, stored (x, y, z, w) like Unity's. Native operations
+/// on it are in <see cref="Mathd"/>.
+/// </summary>
+[System.Serializable]
+public struct dquat
+{
+    public dfloat x, y, z, w;
+
+    public static readonly dquat identity = new dquat(new dfloat(0), new dfloat(0), new dfloat(0), new dfloat(0x3f800000));
+
+    public dquat(dfloat x, dfloat y, dfloat z, dfloat w)
+    {
+        this.x = x;
+        this.y = y;
+        this.z = z;
+        this.w = w;
+    }
+
+    public override string ToString()
+    {
+        return $"({x}, {y}, {z}, {w})";
+    }
+}
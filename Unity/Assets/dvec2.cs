@@ -0,0 +1,19 @@
+/// <summary>
+/// A 2D vector of <see cref="dfloat"/>. Native operations on it are in <see cref="Mathd"/>.
+/// </summary>
+[System.Serializable]
+public struct dvec2
+{
+    public dfloat x, y;
+
+    public dvec2(dfloat x, dfloat y)
+    {
+        this.x = x;
+        this.y = y;
+    }
+
+    public override string ToString()
+    {
+        return $"({x}, {y})";
+    }
+}
@@ -0,0 +1,20 @@
+/// <summary>
+/// A 3D vector of <see cref="dfloat"/>. Native operations on it are in <see cref="Mathd"/>.
+/// </summary>
+[System.Serializable]
+public struct dvec3
+{
+    public dfloat x, y, z;
+
+    public dvec3(dfloat x, dfloat y, dfloat z)
+    {
+        this.x = x;
+        this.y = y;
+        this.z = z;
+    }
+
+    public override string ToString()
+    {
+        return $"({x}, {y}, {z})";
+    }
+}
@@ -0,0 +1,21 @@
+/// <summary>
+/// A 4D vector of <see cref="dfloat"/>. Native operations on it are in <see cref="Mathd"/>.
+/// </summary>
+[System.Serializable]
+public struct dvec4
+{
+    public dfloat x, y, z, w;
+
+    public dvec4(dfloat x, dfloat y, dfloat z, dfloat w)
+    {
+        this.x = x;
+        this.y = y;
+        this.z = z;
+        this.w = w;
+    }
+
+    public override string ToString()
+    {
+        return $"({x}, {y}, {z}, {w})";
+    }
+}